@@ -9,9 +9,93 @@
 
 #include "WifiClient.h"
 
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+#include "nvs.h"
+#include "esp_eap_client.h"
+#include "esp_wnm.h"
+#include "esp_phy_init.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "WifiTrace.h"
+#include "WifiScanner.h"
+#include "WifiOutbox.h"
+#include "WifiLockProfiler.h"
+
 #define LOG_LOCAL_LEVEL ESP_LOG_WARN
 #include "esp_log.h"
 #define TAG "WifiClient"
+#define NVS_NAMESPACE "WifiClient"
+
+//isConnected(), placed in IRAM with CONFIG_WIFICLIENT_IRAM_SAFE
+#if CONFIG_WIFICLIENT_IRAM_SAFE
+#define WIFICLIENT_IRAM IRAM_ATTR
+#else
+#define WIFICLIENT_IRAM
+#endif
+#define NVS_CONFIG_KEY "sta_config"
+#define NVS_SLOT_KEY "slot"
+
+//defaults for phases without measurement
+#define DEFAULT_DRIVER_START_US 300000
+#define DEFAULT_FULL_ASSOCIATION_US 2000000
+#define DEFAULT_RESUMED_ASSOCIATION_US 800000
+#define DEFAULT_FIRST_DHCP_US 1500000
+#define DEFAULT_RENEW_DHCP_US 300000
+
+#define PHY_RECORD_MAGIC 0x50485943
+
+/*!
+ * @brief   Struct which containes the PHY calibration state kept in RTC memory
+ */
+struct PhyRecord{
+    uint32_t magic;         /*!< @brief PHY_RECORD_MAGIC if the record is valid*/
+    int16_t temperatureC;   /*!< @brief temperature at the last full calibration, INT16_MIN if unknown*/
+    uint16_t voltageMv;     /*!< @brief supply voltage at the last full calibration, 0 if unknown*/
+    WifiClient::PhyCalibrationStats stats;  /*!< @brief startup statistics*/
+};
+
+//a constructor would run on every boot and clear the record
+static_assert(std::is_trivially_default_constructible<PhyRecord>::value, "PhyRecord needs a trivial constructor");
+
+//survives deep sleep and resets, lost on power-on
+RTC_NOINIT_ATTR static PhyRecord phyRecord;
+
+/*!
+ * @brief   Adds a sample to a moving average with weight 1/4
+ *
+ * @param   average 0 if no sample was added yet
+ * @param   sample to add
+ */
+static void addSample(uint32_t& average, uint32_t sample)
+{
+    if (average == 0) {
+        average = sample;
+    } else {
+        average = (uint32_t)((3 * (uint64_t)average + sample) / 4);
+    }
+}
+
+/*!
+ * @brief   Derives a slot from the station MAC address
+ *
+ *          FNV-1a spreads neighbouring addresses of one production lot
+ *          over the slots. tools/wifislotsim.py uses the same hash.
+ *
+ * @param   mac station MAC address
+ * @param   count number of slots
+ * @return  uint16_t slot below count
+ */
+static uint16_t macSlot(const uint8_t* mac, uint16_t count)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < 6; i++) {
+        hash = (hash ^ mac[i]) * 16777619u;
+    }
+    return hash % count;
+}
 
 using namespace std;
 
@@ -20,45 +104,50 @@ WifiClient WifiClient::Singleton;
 void WifiClient_event_handler(void* arg, esp_event_base_t event_base,
     int32_t event_id, void* event_data)
 {
-    esp_err_t result;
-
+#if CONFIG_WIFICLIENT_TRACE
+    uint32_t span = WifiTrace::getInstance().begin(event_base == IP_EVENT ? "ip event" : "wifi event",
+        (uint16_t)WifiTrace::Track::HANDLER, event_id);
+#endif
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
         ESP_LOGI(TAG, "received station start event, connecting...");
-
-        result = esp_wifi_connect();
-
-        if (result != ESP_OK) {
-            ESP_LOGE(TAG, "esp_wifi_connect had an error: %s", esp_err_to_name(result));
-        }
+        WifiClient::recordDriverStart();
+        WifiClient::startSlottedAttempt();
 
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
         ESP_LOGI(TAG, "received station disconnected event, reconnecting...");
         if(WifiClient::Singleton.isConnected()){
-            //Station was connected before, fire disconnected event
-            WifiClient::Singleton.fireEvent(WifiClient::Event::DISCONNECTED);
-        }
-        WifiClient::Singleton.setConnected(false);
-        result = esp_wifi_connect();
-        if (result != ESP_OK) {
-            ESP_LOGE(TAG, "esp_wifi_connect had an error: %s", esp_err_to_name(result));
+            //Station was connected before, fire disconnected event or start a handoff
+            WifiClient::connectionLost();
         }
+        WifiClient::startConnectAttempt();
 
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_WIFI_READY) {
         ESP_LOGI(TAG, "received wifi ready event");
 
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        wifi_event_sta_connected_t* event = (wifi_event_sta_connected_t*)event_data;
         ESP_LOGI(TAG, "received wifi station connected event");
+        WifiClient::recordHandshake(event->bssid);
+        WifiClient::recordAssociation(event->bssid);
+
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_BSS_RSSI_LOW) {
+        ESP_LOGI(TAG, "received rssi low event");
+        WifiClient::requestTransition();
 
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*)event_data;
         ESP_LOGI(TAG, "station connected, ip is: " IPSTR,
             IP2STR(&event->ip_info.ip));
+        WifiClient::recordGotIp();
         if(!WifiClient::Singleton.isConnected()){
             //Station was not connected before, fire connected event
             WifiClient::Singleton.fireEvent(WifiClient::Event::CONNECTED);
         }
         WifiClient::Singleton.setConnected(true);
     }
+#if CONFIG_WIFICLIENT_TRACE
+    WifiTrace::getInstance().end(span);
+#endif
 }
 
 WifiClient& WifiClient::getInstance()
@@ -68,15 +157,529 @@ WifiClient& WifiClient::getInstance()
 
 WifiClient::WifiClient()
 {
+    netif = NULL;
+    statsLock = portMUX_INITIALIZER_UNLOCKED;
+    connectAttemptStart = 0;
+    authenticatedBssidCount = 0;
+    enterprise = false;
+    fastTransition = false;
+    handoffGraceMs = 0;
+    roamRssiThreshold = 0;
+    handoffTimer = NULL;
+    handoffActive = false;
+    handoffStart = 0;
+    radioCurrentMa = 0;
+    supplyVoltageMv = 0;
+    driverStartBegin = 0;
+    associatedTime = 0;
+    driverStarted = false;
+    phyFullPending = false;
+    hadIp = false;
+    driverStartAverageUs = 0;
+    fullAssociationAverageUs = 0;
+    resumedAssociationAverageUs = 0;
+    firstDhcpAverageUs = 0;
+    renewDhcpAverageUs = 0;
+    memoryTimer = NULL;
+    memoryLowFree = 0;
+    memoryLowBlock = 0;
+    memoryCriticalFree = 0;
+    memoryCriticalBlock = 0;
+    memoryHysteresis = 0;
+    linkTimer = NULL;
+    linkFairRssi = 0;
+    linkPoorRssi = 0;
+    linkHysteresisDb = 0;
+    rssiAverage = 0;
+    linkQuality = LinkQuality::GOOD;
+    slotTimer = NULL;
+    slotWindowMs = 0;
+    slotCount = 0;
+    slot = 0;
+    slotAssigned = false;
+#if CONFIG_WIFICLIENT_STATIC_ALLOCATION
+    eventReceiverCount = 0;
+    ownedQueueCount = 0;
+#endif
 }
 
 void WifiClient::setConnected(bool connected)
 {
-    xSemaphoreTake(Singleton.connectedMutex, portMAX_DELAY);
+    WIFICLIENT_TAKE(Singleton.connectedMutex, portMAX_DELAY, CLIENT_CONNECTED);
     Singleton.connected = connected;
     xSemaphoreGive(Singleton.connectedMutex);
 }
 
+void WifiClient::startConnectAttempt()
+{
+    portENTER_CRITICAL(&Singleton.statsLock);
+    Singleton.connectAttemptStart = esp_timer_get_time();
+    portEXIT_CRITICAL(&Singleton.statsLock);
+
+    esp_err_t result = esp_wifi_connect();
+    if (result != ESP_OK) {
+        ESP_LOGE(TAG, "esp_wifi_connect had an error: %s", esp_err_to_name(result));
+    }
+}
+
+void WifiClient::startSlottedAttempt()
+{
+    uint32_t delayMs = Singleton.getSlotDelayMs();
+    if (delayMs == 0) {
+        startConnectAttempt();
+        return;
+    }
+
+    ESP_LOGI(TAG, "%s slot %u, connecting in %lu ms", Singleton.slotAssigned ? "assigned" : "mac",
+        Singleton.slot, (unsigned long)delayMs);
+    esp_err_t result = esp_timer_start_once(Singleton.slotTimer, (uint64_t)delayMs * 1000);
+    if (result != ESP_OK) {
+        ESP_LOGE(TAG, "slot timer start had an error: %s", esp_err_to_name(result));
+        startConnectAttempt();
+    }
+}
+
+void WifiClient::slotReached(void* arg)
+{
+    startConnectAttempt();
+}
+
+void WifiClient::recordHandshake(const uint8_t* bssid)
+{
+    const size_t maxBssids = sizeof(Singleton.authenticatedBssids) / sizeof(Singleton.authenticatedBssids[0]);
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&Singleton.statsLock);
+    bool known = false;
+    for (size_t i = 0; i < Singleton.authenticatedBssidCount; i++) {
+        if (memcmp(Singleton.authenticatedBssids[i], bssid, 6) == 0) {
+            known = true;
+            break;
+        }
+    }
+    if (!known) {
+        //keep the most recent BSSIDs, oldest entry is dropped
+        if (Singleton.authenticatedBssidCount == maxBssids) {
+            memmove(Singleton.authenticatedBssids[0], Singleton.authenticatedBssids[1], (maxBssids - 1) * 6);
+            Singleton.authenticatedBssidCount--;
+        }
+        memcpy(Singleton.authenticatedBssids[Singleton.authenticatedBssidCount++], bssid, 6);
+    }
+    Singleton.associatedTime = now;
+
+    //roaming and BSS transitions of the driver have no attempt of their own
+    int64_t start = Singleton.connectAttemptStart;
+    Singleton.connectAttemptStart = 0;
+    if (start == 0) {
+        portEXIT_CRITICAL(&Singleton.statsLock);
+        return;
+    }
+
+    //PSK always runs the full 4-way handshake, only 802.1X and FT have a shortcut
+    bool resumed = (Singleton.enterprise && known) || (Singleton.fastTransition && Singleton.handoffActive);
+    HandshakeTiming& timing = resumed ? Singleton.handshakeStats.resumed : Singleton.handshakeStats.full;
+    uint32_t duration = (uint32_t)(now - start);
+    addSample(resumed ? Singleton.resumedAssociationAverageUs : Singleton.fullAssociationAverageUs, duration);
+    timing.count++;
+    timing.totalUs += duration;
+    timing.lastUs = duration;
+    if (duration > timing.maxUs) {
+        timing.maxUs = duration;
+    }
+    portEXIT_CRITICAL(&Singleton.statsLock);
+
+#if CONFIG_WIFICLIENT_TRACE
+    //scan, authentication and association of the attempt
+    WifiTrace::getInstance().add("associate", (uint16_t)WifiTrace::Track::CONNECTION, start, duration, resumed);
+#endif
+}
+
+void WifiClient::recordDriverStart()
+{
+    int64_t now = esp_timer_get_time();
+    uint32_t duration = 0;
+    bool full = false;
+
+    portENTER_CRITICAL(&Singleton.statsLock);
+    bool first = !Singleton.driverStarted;
+    if (first) {
+        duration = (uint32_t)(now - Singleton.driverStartBegin);
+        full = Singleton.phyFullPending;
+        addSample(Singleton.driverStartAverageUs, duration);
+        Singleton.driverStarted = true;
+
+        //the driver stores a full calibration, later starts use it
+        PhyCalibrationStats& stats = phyRecord.stats;
+        stats.lastStartUs = duration;
+        stats.lastFull = Singleton.phyFullPending;
+        if (Singleton.phyFullPending) {
+            stats.fullStarts++;
+            addSample(stats.fullAverageUs, duration);
+        } else {
+            stats.cachedStarts++;
+            addSample(stats.cachedAverageUs, duration);
+        }
+        Singleton.phyFullPending = false;
+    }
+    portEXIT_CRITICAL(&Singleton.statsLock);
+
+#if CONFIG_WIFICLIENT_TRACE
+    if (first) {
+        WifiTrace::getInstance().add("driver start", (uint16_t)WifiTrace::Track::CONNECTION, now - duration, duration, full);
+    }
+#else
+    (void)full;
+#endif
+}
+
+void WifiClient::preparePhyCalibration(Config const& config)
+{
+    if (phyRecord.magic != PHY_RECORD_MAGIC) {
+        //power-on, the stored calibration is taken as reference
+        memset(&phyRecord, 0, sizeof(PhyRecord));
+        phyRecord.magic = PHY_RECORD_MAGIC;
+        phyRecord.temperatureC = config.phyTemperatureC;
+        phyRecord.voltageMv = config.phyVoltageMv;
+    }
+
+    bool temperatureKnown = config.phyTemperatureC != INT16_MIN && phyRecord.temperatureC != INT16_MIN;
+    bool voltageKnown = config.phyVoltageMv != 0 && phyRecord.voltageMv != 0;
+    bool drift = (temperatureKnown && abs(config.phyTemperatureC - phyRecord.temperatureC) > config.phyMaxTemperatureDriftC)
+        || (voltageKnown && abs(config.phyVoltageMv - phyRecord.voltageMv) > config.phyMaxVoltageDriftMv);
+    bool full = !config.phyCalibrationCache || config.phyForceCalibration || drift;
+
+    if (full) {
+        esp_err_t result = esp_phy_erase_cal_data_in_nvs();
+        if (result != ESP_OK) {
+            //without NVS the driver calibrates fully anyway
+            ESP_LOGW(TAG, "esp_phy_erase_cal_data_in_nvs had an error: %s", esp_err_to_name(result));
+        }
+        if (drift) {
+            phyRecord.stats.driftCalibrations++;
+            ESP_LOGI(TAG, "conditions drifted, full PHY calibration");
+        }
+        phyRecord.temperatureC = config.phyTemperatureC;
+        phyRecord.voltageMv = config.phyVoltageMv;
+    } else {
+        //fill in a reference which was unknown so far
+        if (phyRecord.temperatureC == INT16_MIN) {
+            phyRecord.temperatureC = config.phyTemperatureC;
+        }
+        if (phyRecord.voltageMv == 0) {
+            phyRecord.voltageMv = config.phyVoltageMv;
+        }
+    }
+
+    portENTER_CRITICAL(&Singleton.statsLock);
+    Singleton.phyFullPending = full;
+    portEXIT_CRITICAL(&Singleton.statsLock);
+}
+
+void WifiClient::recordGotIp()
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&Singleton.statsLock);
+    uint32_t duration = (uint32_t)(now - Singleton.associatedTime);
+    bool renew = Singleton.hadIp;
+    addSample(renew ? Singleton.renewDhcpAverageUs : Singleton.firstDhcpAverageUs, duration);
+    Singleton.hadIp = true;
+    portEXIT_CRITICAL(&Singleton.statsLock);
+
+#if CONFIG_WIFICLIENT_TRACE
+    WifiTrace::getInstance().add("dhcp", (uint16_t)WifiTrace::Track::CONNECTION, now - duration, duration, renew);
+#endif
+}
+
+void WifiClient::connectionLost()
+{
+    if (!Singleton.fastTransition) {
+        Singleton.fireEvent(WifiClient::Event::DISCONNECTED);
+        setConnected(false);
+        return;
+    }
+
+    portENTER_CRITICAL(&Singleton.statsLock);
+    bool alreadyActive = Singleton.handoffActive;
+    if (!alreadyActive) {
+        Singleton.handoffActive = true;
+        Singleton.handoffStart = esp_timer_get_time();
+    }
+    portEXIT_CRITICAL(&Singleton.statsLock);
+
+    if (!alreadyActive) {
+        //connected stays set and no event is fired if the handoff succeeds, esp_netif still restarts DHCP
+        esp_timer_start_once(Singleton.handoffTimer, (uint64_t)Singleton.handoffGraceMs * 1000);
+    }
+}
+
+void WifiClient::recordAssociation(const uint8_t* bssid)
+{
+    int64_t now = esp_timer_get_time();
+    bool finished = false;
+
+    portENTER_CRITICAL(&Singleton.statsLock);
+    HandoffStats& stats = Singleton.handoffStats;
+    if (Singleton.handoffActive) {
+        uint32_t gap = (uint32_t)(now - Singleton.handoffStart);
+        Singleton.handoffActive = false;
+        stats.count++;
+        stats.lastGapUs = gap;
+        stats.totalGapUs += gap;
+        if (gap > stats.maxGapUs) {
+            stats.maxGapUs = gap;
+        }
+        finished = true;
+    } else if (Singleton.connected && memcmp(stats.bssid, bssid, 6) != 0) {
+        //driver roamed without a disconnected event
+        stats.seamless++;
+    }
+    memcpy(stats.bssid, bssid, 6);
+    portEXIT_CRITICAL(&Singleton.statsLock);
+
+    if (finished) {
+        esp_timer_stop(Singleton.handoffTimer);
+        ESP_LOGI(TAG, "handoff finished");
+    }
+
+    if (Singleton.fastTransition && Singleton.roamRssiThreshold != 0) {
+        esp_err_t result = esp_wifi_set_rssi_threshold(Singleton.roamRssiThreshold);
+        if (result != ESP_OK) {
+            ESP_LOGE(TAG, "esp_wifi_set_rssi_threshold had an error: %s", esp_err_to_name(result));
+        }
+    }
+}
+
+void WifiClient::handoffTimeout(void* arg)
+{
+    portENTER_CRITICAL(&Singleton.statsLock);
+    bool expired = Singleton.handoffActive;
+    if (expired) {
+        Singleton.handoffActive = false;
+        Singleton.handoffStats.failed++;
+    }
+    portEXIT_CRITICAL(&Singleton.statsLock);
+
+    if (expired) {
+        ESP_LOGW(TAG, "handoff exceeded grace time");
+        Singleton.fireEvent(WifiClient::Event::DISCONNECTED);
+        setConnected(false);
+    }
+}
+
+void WifiClient::requestTransition()
+{
+    if (!Singleton.fastTransition || Singleton.roamRssiThreshold == 0) {
+        return;
+    }
+    //the supplicant roams (with FT) if the AP answers with a candidate
+    if (esp_wnm_send_bss_transition_mgmt_query(REASON_RSSI, NULL, 0) != 0) {
+        ESP_LOGW(TAG, "bss transition query failed");
+    }
+    //threshold event is one-shot
+    esp_wifi_set_rssi_threshold(Singleton.roamRssiThreshold);
+}
+
+void WifiClient::memoryCheck(void* arg)
+{
+    uint32_t freeBytes = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    uint32_t largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    uint32_t hysteresis = Singleton.memoryHysteresis;
+    bool belowCritical = freeBytes < Singleton.memoryCriticalFree || largestBlock < Singleton.memoryCriticalBlock;
+    bool clearOfCritical = freeBytes >= Singleton.memoryCriticalFree + hysteresis
+        && largestBlock >= Singleton.memoryCriticalBlock + hysteresis;
+    bool belowLow = freeBytes < Singleton.memoryLowFree || largestBlock < Singleton.memoryLowBlock;
+    bool clearOfLow = freeBytes >= Singleton.memoryLowFree + hysteresis
+        && largestBlock >= Singleton.memoryLowBlock + hysteresis;
+
+    portENTER_CRITICAL(&Singleton.statsLock);
+    MemoryStats& stats = Singleton.memoryStats;
+    stats.freeBytes = freeBytes;
+    stats.largestBlock = largestBlock;
+    if (stats.minFreeBytes == 0 || freeBytes < stats.minFreeBytes) {
+        stats.minFreeBytes = freeBytes;
+    }
+    if (stats.minLargestBlock == 0 || largestBlock < stats.minLargestBlock) {
+        stats.minLargestBlock = largestBlock;
+    }
+    MemoryPressure previous = stats.pressure;
+    MemoryPressure next;
+    if (belowCritical || (previous == MemoryPressure::CRITICAL && !clearOfCritical)) {
+        next = MemoryPressure::CRITICAL;
+    } else if (belowLow || (previous != MemoryPressure::NORMAL && !clearOfLow)) {
+        next = MemoryPressure::LOW;
+    } else {
+        next = MemoryPressure::NORMAL;
+    }
+    stats.pressure = next;
+    if (next == MemoryPressure::LOW && previous != MemoryPressure::LOW) {
+        stats.lowCount++;
+    } else if (next == MemoryPressure::CRITICAL && previous != MemoryPressure::CRITICAL) {
+        stats.criticalCount++;
+    }
+    portEXIT_CRITICAL(&Singleton.statsLock);
+
+    if (next == previous) {
+        return;
+    }
+    ESP_LOGW(TAG, "memory pressure %d, free %lu, largest block %lu", (int)next,
+        (unsigned long)freeBytes, (unsigned long)largestBlock);
+#if CONFIG_WIFICLIENT_TRACE
+    WifiTrace::getInstance().instant("memory pressure", (uint16_t)WifiTrace::Track::CONNECTION, (uint32_t)next);
+#endif
+
+    //NORMAL to CRITICAL fires LOW first, receivers shed load step by step
+    int level = (int)previous;
+    int step = next > previous ? 1 : -1;
+    while (level != (int)next) {
+        level += step;
+        switch ((MemoryPressure)level) {
+            case MemoryPressure::NORMAL:
+                Singleton.fireEvent(Event::MEMORY_NORMAL);
+                break;
+            case MemoryPressure::LOW:
+                Singleton.fireEvent(Event::MEMORY_LOW);
+                break;
+            case MemoryPressure::CRITICAL:
+                Singleton.fireEvent(Event::MEMORY_CRITICAL);
+                break;
+        }
+    }
+}
+
+void WifiClient::linkCheck(void* arg)
+{
+    wifi_ap_record_t ap;
+    bool sampled = Singleton.isConnected() && esp_wifi_sta_get_ap_info(&ap) == ESP_OK;
+
+    portENTER_CRITICAL(&Singleton.statsLock);
+    if (!sampled) {
+        //next link starts with a fresh average, the level is kept
+        Singleton.rssiAverage = 0;
+        portEXIT_CRITICAL(&Singleton.statsLock);
+        return;
+    }
+    //moving average with weight 1/4 smooths single bad beacons
+    int32_t sample = (int32_t)ap.rssi * 16;
+    Singleton.rssiAverage = Singleton.rssiAverage == 0 ? sample : Singleton.rssiAverage + (sample - Singleton.rssiAverage) / 4;
+    int32_t rssi = Singleton.rssiAverage / 16;
+    int32_t hysteresis = Singleton.linkHysteresisDb;
+
+    LinkQuality previous = Singleton.linkQuality;
+    LinkQuality next;
+    if (rssi < Singleton.linkPoorRssi || (previous == LinkQuality::POOR && rssi < Singleton.linkPoorRssi + hysteresis)) {
+        next = LinkQuality::POOR;
+    } else if (rssi < Singleton.linkFairRssi || (previous != LinkQuality::GOOD && rssi < Singleton.linkFairRssi + hysteresis)) {
+        next = LinkQuality::FAIR;
+    } else {
+        next = LinkQuality::GOOD;
+    }
+    Singleton.linkQuality = next;
+    portEXIT_CRITICAL(&Singleton.statsLock);
+
+    if (next != previous) {
+        ESP_LOGI(TAG, "link quality %d, rssi %ld", (int)next, (long)rssi);
+        Singleton.fireEvent(Event::LINK_QUALITY_CHANGED);
+    }
+}
+
+void WifiClient::configureEnterprise(Enterprise const& enterprise)
+{
+    const static string EXEP_TAG = "WifiClient::configureEnterprise: ";
+    esp_err_t result;
+
+    result = esp_eap_client_set_identity((const unsigned char*)enterprise.identity.c_str(), enterprise.identity.length());
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "set identity failed with error: " + esp_err_to_name(result));
+    }
+
+    if (!enterprise.username.empty()) {
+        result = esp_eap_client_set_username((const unsigned char*)enterprise.username.c_str(), enterprise.username.length());
+        if (result != ESP_OK) {
+            throw runtime_error(EXEP_TAG + "set username failed with error: " + esp_err_to_name(result));
+        }
+        result = esp_eap_client_set_password((const unsigned char*)enterprise.password.c_str(), enterprise.password.length());
+        if (result != ESP_OK) {
+            throw runtime_error(EXEP_TAG + "set password failed with error: " + esp_err_to_name(result));
+        }
+    }
+
+    if (enterprise.caCert != nullptr) {
+        result = esp_eap_client_set_ca_cert(enterprise.caCert, enterprise.caCertLength);
+        if (result != ESP_OK) {
+            throw runtime_error(EXEP_TAG + "set ca cert failed with error: " + esp_err_to_name(result));
+        }
+    }
+
+    if (enterprise.clientCert != nullptr) {
+        result = esp_eap_client_set_certificate_and_key(enterprise.clientCert, enterprise.clientCertLength,
+            enterprise.clientKey, enterprise.clientKeyLength,
+            enterprise.clientKeyPassword.empty() ? NULL : (const unsigned char*)enterprise.clientKeyPassword.c_str(),
+            enterprise.clientKeyPassword.length());
+        if (result != ESP_OK) {
+            throw runtime_error(EXEP_TAG + "set certificate and key failed with error: " + esp_err_to_name(result));
+        }
+    }
+
+    result = esp_wifi_sta_enterprise_enable();
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "enterprise enable failed with error: " + esp_err_to_name(result));
+    }
+}
+
+bool WifiClient::loadStoredConfig(wifi_config_t& wifiConfig)
+{
+    const static string EXEP_TAG = "WifiClient::loadStoredConfig: ";
+    nvs_handle_t handle;
+
+    esp_err_t result = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (result == ESP_ERR_NVS_NOT_FOUND) {
+        //namespace is created on first store
+        return false;
+    }
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "nvs open failed with error: " + esp_err_to_name(result));
+    }
+
+    size_t length = sizeof(wifi_config_t);
+    result = nvs_get_blob(handle, NVS_CONFIG_KEY, &wifiConfig, &length);
+    nvs_close(handle);
+    if (result == ESP_ERR_NVS_NOT_FOUND || (result == ESP_OK && length != sizeof(wifi_config_t))) {
+        return false;
+    }
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "nvs get failed with error: " + esp_err_to_name(result));
+    }
+    return true;
+}
+
+void WifiClient::storeConfig(wifi_config_t const& wifiConfig)
+{
+    const static string EXEP_TAG = "WifiClient::storeConfig: ";
+
+    wifi_config_t storedConfig;
+    memset(&storedConfig, 0, sizeof(wifi_config_t));
+    if (loadStoredConfig(storedConfig) && memcmp(&storedConfig, &wifiConfig, sizeof(wifi_config_t)) == 0) {
+        //unchanged, skip the flash write
+        return;
+    }
+
+    nvs_handle_t handle;
+    esp_err_t result = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "nvs open failed with error: " + esp_err_to_name(result));
+    }
+    result = nvs_set_blob(handle, NVS_CONFIG_KEY, &wifiConfig, sizeof(wifi_config_t));
+    if (result == ESP_OK) {
+        result = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "nvs write failed with error: " + esp_err_to_name(result));
+    }
+    ESP_LOGI(TAG, "stored changed configuration");
+}
+
 void WifiClient::init(Config const& config)
 {
     const static string EXEP_TAG = "WifiClient::init: ";
@@ -88,8 +691,43 @@ void WifiClient::init(Config const& config)
     esp_log_level_set("phy_init",LOG_LOCAL_LEVEL);
     esp_log_level_set("esp_netif_handlers",LOG_LOCAL_LEVEL);
 
+    radioCurrentMa = config.radioCurrentMa;
+    supplyVoltageMv = config.supplyVoltageMv;
+    fastTransition = config.fastTransition;
+    enterprise = !config.enterprise.identity.empty();
+    handoffGraceMs = config.handoffGraceMs;
+    roamRssiThreshold = config.roamRssiThreshold;
+    handoffStats.mobilityDomain = config.mobilityDomain;
+
+    if (config.memoryCriticalFree > config.memoryLowFree || config.memoryCriticalBlock > config.memoryLowBlock) {
+        throw invalid_argument(EXEP_TAG + "memory critical thresholds must not exceed the low thresholds");
+    }
+    memoryLowFree = config.memoryLowFree;
+    memoryLowBlock = config.memoryLowBlock;
+    memoryCriticalFree = config.memoryCriticalFree;
+    memoryCriticalBlock = config.memoryCriticalBlock;
+    memoryHysteresis = config.memoryHysteresis;
+
+    if (config.linkPoorRssi > config.linkFairRssi) {
+        throw invalid_argument(EXEP_TAG + "linkPoorRssi must not exceed linkFairRssi");
+    }
+    linkFairRssi = config.linkFairRssi;
+    linkPoorRssi = config.linkPoorRssi;
+    linkHysteresisDb = config.linkHysteresisDb;
+
+    if (config.slotWindowMs > 0 && config.slotCount == 0) {
+        throw invalid_argument(EXEP_TAG + "slotCount must be greater 0");
+    }
+
     //Create the mutex
+#if CONFIG_WIFICLIENT_STATIC_ALLOCATION
+    connectedMutex = xSemaphoreCreateMutexStatic(&connectedMutexBuffer);
+#else
     connectedMutex = xSemaphoreCreateMutex();
+#endif
+    if (connectedMutex == NULL) {
+        throw runtime_error(EXEP_TAG + "mutex could not be created");
+    }
     
     esp_err_t result;
 
@@ -106,22 +744,137 @@ void WifiClient::init(Config const& config)
     }
 
     //create netif wifi station
-    esp_netif_create_default_wifi_sta();
+    netif = esp_netif_create_default_wifi_sta();
+    if (netif == NULL) {
+        throw runtime_error(EXEP_TAG + "netif wifi station could not be created");
+    }
 
     //initialize wifi
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    if (config.storage == Storage::RAM) {
+        //driver must not touch NVS, so nvs_flash_init is not needed
+        cfg.nvs_enable = 0;
+    }
 
     result = esp_wifi_init(&cfg);
     if (result != ESP_OK) {
         throw runtime_error(EXEP_TAG + "esp wifi init failed with error: " + esp_err_to_name(result));
     }
 
+    //calibration runs in esp_wifi_start, decide before connect
+    preparePhyCalibration(config);
+
+    if (config.storage == Storage::RAM) {
+        result = esp_wifi_set_storage(WIFI_STORAGE_RAM);
+        if (result != ESP_OK) {
+            throw runtime_error(EXEP_TAG + "esp wifi set storage failed with error: " + esp_err_to_name(result));
+        }
+    }
+
     //configure wifi
     wifi_config_t wifiConfig;
     memset(&wifiConfig, 0, sizeof(wifi_config_t));
-    wifiConfig.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
-    memcpy(wifiConfig.sta.ssid, config.ssid.c_str(), config.ssid.length());
-    memcpy(wifiConfig.sta.password, config.password.c_str(), config.password.length());
+    bool persist = config.storage == Storage::RAM && config.persistConfig;
+    if (persist && config.ssid.empty()) {
+        if (!loadStoredConfig(wifiConfig)) {
+            throw runtime_error(EXEP_TAG + "no ssid passed and no stored config found");
+        }
+    } else if (!config.enterprise.identity.empty()) {
+        wifiConfig.sta.threshold.authmode = WIFI_AUTH_WPA2_ENTERPRISE;
+        memcpy(wifiConfig.sta.ssid, config.ssid.c_str(), config.ssid.length());
+        configureEnterprise(config.enterprise);
+    } else {
+        wifiConfig.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+        memcpy(wifiConfig.sta.ssid, config.ssid.c_str(), config.ssid.length());
+        memcpy(wifiConfig.sta.password, config.password.c_str(), config.password.length());
+        if (persist) {
+            storeConfig(wifiConfig);
+        }
+    }
+
+    if (fastTransition) {
+        wifiConfig.sta.ft_enabled = 1;
+        wifiConfig.sta.rm_enabled = 1;
+        wifiConfig.sta.btm_enabled = 1;
+    }
+
+    //created once, a re-init keeps the timer of a running handoff
+    if (fastTransition && handoffTimer == NULL) {
+        esp_timer_create_args_t timerArgs;
+        memset(&timerArgs, 0, sizeof(esp_timer_create_args_t));
+        timerArgs.callback = &WifiClient::handoffTimeout;
+        timerArgs.name = "WifiClientHandoff";
+        result = esp_timer_create(&timerArgs, &handoffTimer);
+        if (result != ESP_OK) {
+            throw runtime_error(EXEP_TAG + "handoff timer create failed with error: " + esp_err_to_name(result));
+        }
+    }
+
+    if (config.memoryCheckMs > 0 && memoryTimer == NULL) {
+        esp_timer_create_args_t timerArgs;
+        memset(&timerArgs, 0, sizeof(esp_timer_create_args_t));
+        timerArgs.callback = &WifiClient::memoryCheck;
+        timerArgs.name = "WifiClientMemory";
+        result = esp_timer_create(&timerArgs, &memoryTimer);
+        if (result == ESP_OK) {
+            result = esp_timer_start_periodic(memoryTimer, (uint64_t)config.memoryCheckMs * 1000);
+        }
+        if (result != ESP_OK) {
+            throw runtime_error(EXEP_TAG + "memory timer create failed with error: " + esp_err_to_name(result));
+        }
+    }
+
+    if (config.linkCheckMs > 0 && linkTimer == NULL) {
+        esp_timer_create_args_t timerArgs;
+        memset(&timerArgs, 0, sizeof(esp_timer_create_args_t));
+        timerArgs.callback = &WifiClient::linkCheck;
+        timerArgs.name = "WifiClientLink";
+        result = esp_timer_create(&timerArgs, &linkTimer);
+        if (result == ESP_OK) {
+            result = esp_timer_start_periodic(linkTimer, (uint64_t)config.linkCheckMs * 1000);
+        }
+        if (result != ESP_OK) {
+            throw runtime_error(EXEP_TAG + "link timer create failed with error: " + esp_err_to_name(result));
+        }
+    }
+
+    if (config.slotWindowMs > 0) {
+        uint8_t mac[6];
+        result = esp_wifi_get_mac(WIFI_IF_STA, mac);
+        if (result != ESP_OK) {
+            throw runtime_error(EXEP_TAG + "esp wifi get mac failed with error: " + esp_err_to_name(result));
+        }
+        uint16_t stationSlot = macSlot(mac, config.slotCount);
+        bool assigned = false;
+
+        //an assigned slot is optional, NVS may not even be initialized with Storage::RAM
+        nvs_handle_t handle;
+        if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+            uint16_t stored;
+            if (nvs_get_u16(handle, NVS_SLOT_KEY, &stored) == ESP_OK && stored < config.slotCount) {
+                stationSlot = stored;
+                assigned = true;
+            }
+            nvs_close(handle);
+        }
+
+        if (slotTimer == NULL) {
+            esp_timer_create_args_t timerArgs;
+            memset(&timerArgs, 0, sizeof(esp_timer_create_args_t));
+            timerArgs.callback = &WifiClient::slotReached;
+            timerArgs.name = "WifiClientSlot";
+            result = esp_timer_create(&timerArgs, &slotTimer);
+            if (result != ESP_OK) {
+                throw runtime_error(EXEP_TAG + "slot timer create failed with error: " + esp_err_to_name(result));
+            }
+        }
+        portENTER_CRITICAL(&statsLock);
+        slotWindowMs = config.slotWindowMs;
+        slotCount = config.slotCount;
+        slot = stationSlot;
+        slotAssigned = assigned;
+        portEXIT_CRITICAL(&statsLock);
+    }
 
     result = esp_wifi_set_mode(WIFI_MODE_STA);
     if (result != ESP_OK) {
@@ -159,6 +912,13 @@ void WifiClient::connect() const
         throw runtime_error(EXEP_TAG + "can't register handler, error: " + esp_err_to_name(result));
     }
 
+    //new driver session, the PMKSA cache and the lease start empty
+    portENTER_CRITICAL(&Singleton.statsLock);
+    Singleton.authenticatedBssidCount = 0;
+    Singleton.hadIp = false;
+    Singleton.driverStartBegin = esp_timer_get_time();
+    portEXIT_CRITICAL(&Singleton.statsLock);
+
     result = esp_wifi_start();
     if (result != ESP_OK) {
         throw runtime_error(EXEP_TAG + "esp_wifi_start returned error: " + esp_err_to_name(result));
@@ -174,7 +934,15 @@ void WifiClient::disconnect() const
         throw runtime_error(EXEP_TAG + "client not initialized");
     }
 
-    if (!isConnected()) {
+    //a pending slotted attempt must not connect after the disconnect
+    bool slotPending = Singleton.slotTimer != NULL && esp_timer_stop(Singleton.slotTimer) == ESP_OK;
+
+    portENTER_CRITICAL(&Singleton.statsLock);
+    bool driverStarted = Singleton.driverStarted;
+    portEXIT_CRITICAL(&Singleton.statsLock);
+
+    //a started driver is stopped even while it still waits for its slot or retries
+    if (!isConnected() && !slotPending && !driverStarted) {
         //Already disconnected
         return;
     }
@@ -184,6 +952,19 @@ void WifiClient::disconnect() const
         throw runtime_error(EXEP_TAG + "esp_wifi_stop returned error: " + esp_err_to_name(result));
     }
 
+    if (Singleton.handoffTimer != NULL) {
+        esp_timer_stop(Singleton.handoffTimer);
+    }
+
+    //stopping the driver flushes the PMKSA cache and the lease
+    portENTER_CRITICAL(&Singleton.statsLock);
+    Singleton.handoffActive = false;
+    Singleton.driverStarted = false;
+    Singleton.connectAttemptStart = 0;
+    Singleton.authenticatedBssidCount = 0;
+    Singleton.hadIp = false;
+    portEXIT_CRITICAL(&Singleton.statsLock);
+
     result = esp_event_handler_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, &WifiClient_event_handler);
     if (result != ESP_OK) {
         throw runtime_error(EXEP_TAG + "can't unregister handler, error: " + esp_err_to_name(result));
@@ -197,31 +978,317 @@ void WifiClient::disconnect() const
     setConnected(false);
 }
 
-bool WifiClient::isConnected() const
+bool WIFICLIENT_IRAM WifiClient::isConnected() const
 {
+#if CONFIG_WIFICLIENT_IRAM_SAFE
+    //single byte read, writers still serialize on the mutex
+    return Singleton.connected;
+#else
     bool result = false;
-    xSemaphoreTake(Singleton.connectedMutex, portMAX_DELAY);
+    WIFICLIENT_TAKE(Singleton.connectedMutex, portMAX_DELAY, CLIENT_CONNECTED);
     result = Singleton.connected;
     xSemaphoreGive(Singleton.connectedMutex);
     return result;
+#endif
 }
 
-void WifiClient::registerEventReceiver(QueueHandle_t& queueHandle, uint8_t queueSize){
+esp_netif_t* WifiClient::getNetif() const
+{
+    return netif;
+}
+
+WifiClient::HandshakeStats WifiClient::getHandshakeStats() const
+{
+    portENTER_CRITICAL(&Singleton.statsLock);
+    HandshakeStats stats = Singleton.handshakeStats;
+    portEXIT_CRITICAL(&Singleton.statsLock);
+    return stats;
+}
+
+WifiClient::ConnectEstimate WifiClient::estimateConnect() const
+{
+    ConnectEstimate estimate;
+
+    if (isConnected()) {
+        return estimate;
+    }
+
+    portENTER_CRITICAL(&Singleton.statsLock);
+    //only 802.1X skips a part of the handshake for a known access point
+    bool knownAp = Singleton.enterprise && Singleton.authenticatedBssidCount > 0;
+    uint32_t driverStartUs = Singleton.driverStarted ? 0 : Singleton.driverStartAverageUs;
+    uint32_t associationUs = knownAp ? Singleton.resumedAssociationAverageUs : Singleton.fullAssociationAverageUs;
+    uint32_t dhcpUs = Singleton.hadIp ? Singleton.renewDhcpAverageUs : Singleton.firstDhcpAverageUs;
+    bool driverStarted = Singleton.driverStarted;
+    bool hadIp = Singleton.hadIp;
+    portEXIT_CRITICAL(&Singleton.statsLock);
+
+    estimate.fromHistory = true;
+    if (!driverStarted && driverStartUs == 0) {
+        driverStartUs = DEFAULT_DRIVER_START_US;
+        estimate.fromHistory = false;
+    }
+    if (associationUs == 0) {
+        associationUs = knownAp ? DEFAULT_RESUMED_ASSOCIATION_US : DEFAULT_FULL_ASSOCIATION_US;
+        estimate.fromHistory = false;
+    }
+    if (dhcpUs == 0) {
+        dhcpUs = hadIp ? DEFAULT_RENEW_DHCP_US : DEFAULT_FIRST_DHCP_US;
+        estimate.fromHistory = false;
+    }
+
+    estimate.driverStartMs = driverStartUs / 1000;
+    estimate.associationMs = associationUs / 1000;
+    estimate.dhcpMs = dhcpUs / 1000;
+    estimate.timeToIpMs = estimate.driverStartMs + estimate.associationMs + estimate.dhcpMs;
+    //ms * mA * mV is nJ
+    estimate.energyMj = (uint32_t)((uint64_t)estimate.timeToIpMs * Singleton.radioCurrentMa
+        * Singleton.supplyVoltageMv / 1000000);
+    return estimate;
+}
+
+WifiClient::HandoffStats WifiClient::getHandoffStats() const
+{
+    portENTER_CRITICAL(&Singleton.statsLock);
+    HandoffStats stats = Singleton.handoffStats;
+    portEXIT_CRITICAL(&Singleton.statsLock);
+    return stats;
+}
+
+WifiClient::PhyCalibrationStats WifiClient::getPhyCalibrationStats() const
+{
+    portENTER_CRITICAL(&Singleton.statsLock);
+    PhyCalibrationStats stats = phyRecord.stats;
+    portEXIT_CRITICAL(&Singleton.statsLock);
+    return stats;
+}
+
+WifiClient::MemoryPressure WifiClient::getMemoryPressure() const
+{
+    portENTER_CRITICAL(&Singleton.statsLock);
+    MemoryPressure pressure = Singleton.memoryStats.pressure;
+    portEXIT_CRITICAL(&Singleton.statsLock);
+    return pressure;
+}
+
+WifiClient::MemoryStats WifiClient::getMemoryStats() const
+{
+    portENTER_CRITICAL(&Singleton.statsLock);
+    MemoryStats stats = Singleton.memoryStats;
+    portEXIT_CRITICAL(&Singleton.statsLock);
+    return stats;
+}
+
+WifiClient::PlacementStats WifiClient::getPlacementStats() const
+{
+    PlacementStats stats;
+    stats.internalSaved = WifiScanner::getInstance().getExternalBytes() + WifiTrace::getInstance().getExternalBytes()
+        + WifiOutbox::getInstance().getExternalBytes();
+    stats.internalFree = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    stats.externalFree = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+#if CONFIG_SPIRAM_TRY_ALLOCATE_WIFI_LWIP
+    stats.driverBuffersExternal = true;
+#endif
+    return stats;
+}
+
+WifiClient::LinkQuality WifiClient::getLinkQuality() const
+{
+    portENTER_CRITICAL(&Singleton.statsLock);
+    LinkQuality quality = Singleton.linkQuality;
+    portEXIT_CRITICAL(&Singleton.statsLock);
+    return quality;
+}
+
+int8_t WifiClient::getRssi() const
+{
+    portENTER_CRITICAL(&Singleton.statsLock);
+    int32_t rssi = Singleton.rssiAverage / 16;
+    portEXIT_CRITICAL(&Singleton.statsLock);
+    return rssi;
+}
+
+void WifiClient::setSlot(uint16_t slot)
+{
+    const static string EXEP_TAG = "WifiClient::setSlot: ";
+
+    if (slotTimer == NULL) {
+        throw runtime_error(EXEP_TAG + "slotting is not enabled");
+    }
+    if (slot >= slotCount) {
+        throw invalid_argument(EXEP_TAG + "slot must be below slotCount");
+    }
+
+    nvs_handle_t handle;
+    esp_err_t result = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "nvs open failed with error: " + esp_err_to_name(result));
+    }
+    result = nvs_set_u16(handle, NVS_SLOT_KEY, slot);
+    if (result == ESP_OK) {
+        result = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "nvs write failed with error: " + esp_err_to_name(result));
+    }
+
+    portENTER_CRITICAL(&statsLock);
+    this->slot = slot;
+    slotAssigned = true;
+    portEXIT_CRITICAL(&statsLock);
+}
+
+void WifiClient::clearSlot()
+{
+    const static string EXEP_TAG = "WifiClient::clearSlot: ";
+
+    if (slotTimer == NULL) {
+        throw runtime_error(EXEP_TAG + "slotting is not enabled");
+    }
+
+    nvs_handle_t handle;
+    esp_err_t result = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "nvs open failed with error: " + esp_err_to_name(result));
+    }
+    result = nvs_erase_key(handle, NVS_SLOT_KEY);
+    if (result == ESP_OK) {
+        result = nvs_commit(handle);
+    } else if (result == ESP_ERR_NVS_NOT_FOUND) {
+        result = ESP_OK;
+    }
+    nvs_close(handle);
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "nvs erase failed with error: " + esp_err_to_name(result));
+    }
+
+    uint8_t mac[6];
+    result = esp_wifi_get_mac(WIFI_IF_STA, mac);
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "esp wifi get mac failed with error: " + esp_err_to_name(result));
+    }
+    portENTER_CRITICAL(&statsLock);
+    slot = macSlot(mac, slotCount);
+    slotAssigned = false;
+    portEXIT_CRITICAL(&statsLock);
+}
+
+uint32_t WifiClient::getSlotDelayMs() const
+{
+    if (Singleton.slotTimer == NULL) {
+        return 0;
+    }
+    portENTER_CRITICAL(&Singleton.statsLock);
+    uint32_t delayMs = (uint64_t)Singleton.slot * Singleton.slotWindowMs / Singleton.slotCount;
+    portEXIT_CRITICAL(&Singleton.statsLock);
+    return delayMs;
+}
+
+uint32_t WifiClient::eventBit(Event event)
+{
+    return 1u << (uint32_t)event;
+}
+
+void WifiClient::registerEventReceiver(QueueHandle_t& queueHandle, uint8_t queueSize, uint32_t events){
     if(queueSize == 0){
         throw invalid_argument("WifiClient::registerEventReceiver: Queue size must be greater 0");
     }
+#if CONFIG_WIFICLIENT_STATIC_ALLOCATION
+    if(queueSize > CONFIG_WIFICLIENT_MAX_EVENT_QUEUE_SIZE){
+        throw invalid_argument("WifiClient::registerEventReceiver: Queue size exceeds CONFIG_WIFICLIENT_MAX_EVENT_QUEUE_SIZE");
+    }
+    if(ownedQueueCount >= CONFIG_WIFICLIENT_MAX_EVENT_RECEIVERS){
+        throw runtime_error("WifiClient::registerEventReceiver: No queue storage left");
+    }
+    if(eventReceiverCount >= CONFIG_WIFICLIENT_MAX_EVENT_RECEIVERS){
+        //checked before the queue takes the storage
+        throw runtime_error("WifiClient::registerEventReceiver: Too many event receivers");
+    }
+    queueHandle = xQueueCreateStatic(queueSize,sizeof(WifiClient::Event),
+        ownedQueueStorage[ownedQueueCount],&ownedQueueBuffers[ownedQueueCount]);
+#else
     queueHandle = xQueueCreate(queueSize,sizeof(WifiClient::Event));
+#endif
+    if(queueHandle == 0){
+        throw runtime_error("WifiClient::registerEventReceiver: Queue could not be created");
+    }
+    addEventReceiver(queueHandle, events);
+#if CONFIG_WIFICLIENT_STATIC_ALLOCATION
+    //storage is only used up once the receiver was added
+    ownedQueueCount++;
+#endif
+}
+
+void WifiClient::registerEventReceiver(QueueHandle_t& queueHandle, uint8_t queueSize,
+    uint8_t* queueStorage, StaticQueue_t* queueBuffer, uint32_t events){
+    if(queueSize == 0){
+        throw invalid_argument("WifiClient::registerEventReceiver: Queue size must be greater 0");
+    }
+    if(queueStorage == nullptr || queueBuffer == nullptr){
+        throw invalid_argument("WifiClient::registerEventReceiver: Queue storage must be provided");
+    }
+    queueHandle = xQueueCreateStatic(queueSize,sizeof(WifiClient::Event),queueStorage,queueBuffer);
     if(queueHandle == 0){
         throw runtime_error("WifiClient::registerEventReceiver: Queue could not be created");
     }
-    eventReceivers.push_back(&queueHandle);
+    addEventReceiver(queueHandle, events);
+}
+
+void WifiClient::setEventMask(QueueHandle_t const& queueHandle, uint32_t events){
+#if CONFIG_WIFICLIENT_STATIC_ALLOCATION
+    for(size_t i = 0; i < eventReceiverCount; i++){
+        EventReceiver& receiver = eventReceivers[i];
+#else
+    for(EventReceiver& receiver: eventReceivers){
+#endif
+        if(receiver.queue == &queueHandle){
+            portENTER_CRITICAL(&statsLock);
+            receiver.events = events;
+            portEXIT_CRITICAL(&statsLock);
+            return;
+        }
+    }
+    throw invalid_argument("WifiClient::setEventMask: Queue is not registered");
+}
+
+void WifiClient::addEventReceiver(QueueHandle_t& queueHandle, uint32_t events){
+    EventReceiver receiver = { &queueHandle, events };
+#if CONFIG_WIFICLIENT_STATIC_ALLOCATION
+    if(eventReceiverCount >= CONFIG_WIFICLIENT_MAX_EVENT_RECEIVERS){
+        throw runtime_error("WifiClient::registerEventReceiver: Too many event receivers");
+    }
+    eventReceivers[eventReceiverCount++] = receiver;
+#else
+    eventReceivers.push_back(receiver);
+#endif
 }
 
 void WifiClient::fireEvent(Event event){
-    for(QueueHandle_t* queue: eventReceivers){
+    uint32_t bit = 1u << (uint32_t)event;
+#if CONFIG_WIFICLIENT_STATIC_ALLOCATION
+    for(size_t i = 0; i < eventReceiverCount; i++){
+        EventReceiver const& receiver = eventReceivers[i];
+#else
+    for(EventReceiver const& receiver: eventReceivers){
+#endif
+        portENTER_CRITICAL(&statsLock);
+        bool wanted = (receiver.events & bit) != 0;
+        portEXIT_CRITICAL(&statsLock);
+        if(!wanted){
+            continue;
+        }
+        QueueHandle_t* queue = receiver.queue;
+#if CONFIG_WIFICLIENT_TRACE
+        int64_t start = esp_timer_get_time();
+#endif
         BaseType_t result = xQueueSend(*queue,&event,0);
         if(result != pdTRUE){
             ESP_LOGE(TAG,"Could not fire event, receive queue is full.");
         }
+#if CONFIG_WIFICLIENT_TRACE
+        WifiTrace::getInstance().add(result == pdTRUE ? "deliver" : "deliver failed", (uint16_t)WifiTrace::Track::DELIVERY,
+            start, (uint32_t)(esp_timer_get_time() - start), (uint32_t)event);
+#endif
     }
 }
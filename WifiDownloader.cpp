@@ -0,0 +1,308 @@
+/*!
+ * @file 	    WifiDownloader.cpp
+ * @brief 	    Singleton resumable HTTP downloader which follows the WifiClient link
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include "WifiDownloader.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+#include "WifiClient.h"
+#include "esp_wifi.h"
+#include "esp_timer.h"
+#include "WifiLockProfiler.h"
+
+#define LOG_LOCAL_LEVEL ESP_LOG_WARN
+#include "esp_log.h"
+#define TAG "WifiDownloader"
+
+#define HTTP_OK 200
+#define HTTP_PARTIAL_CONTENT 206
+#define HTTP_RANGE_NOT_SATISFIABLE 416
+#define HTTP_SERVER_ERROR 500
+
+using namespace std;
+
+WifiDownloader WifiDownloader::Singleton;
+
+WifiDownloader& WifiDownloader::getInstance()
+{
+    return Singleton;
+}
+
+WifiDownloader::WifiDownloader()
+{
+    initalized = false;
+    eventQueue = NULL;
+    mutex = NULL;
+}
+
+void WifiDownloader::init(Config const& config)
+{
+    const static string EXEP_TAG = "WifiDownloader::init: ";
+
+    if (config.minChunk == 0 || config.minChunk > config.initialChunk || config.initialChunk > config.maxChunk) {
+        throw invalid_argument(EXEP_TAG + "chunk sizes must be 0 < minChunk <= initialChunk <= maxChunk");
+    }
+    if (initalized) {
+        this->config = config;
+        return;
+    }
+    this->config = config;
+
+    mutex = xSemaphoreCreateMutexStatic(&mutexBuffer);
+    if (mutex == NULL) {
+        throw runtime_error(EXEP_TAG + "mutex could not be created");
+    }
+    //subscribed only while a download runs
+    WifiClient::getInstance().registerEventReceiver(eventQueue, 2, 0);
+    initalized = true;
+}
+
+WifiDownloader::Result WifiDownloader::download(const char* url, Sink& sink, size_t offset)
+{
+    const static string EXEP_TAG = "WifiDownloader::download: ";
+
+    if (!initalized) {
+        throw runtime_error(EXEP_TAG + "not initialized");
+    }
+
+    Request request;
+    esp_http_client_config_t clientConfig;
+    memset(&clientConfig, 0, sizeof(esp_http_client_config_t));
+    clientConfig.url = url;
+    clientConfig.timeout_ms = config.timeoutMs;
+    clientConfig.event_handler = &WifiDownloader::httpEvent;
+    clientConfig.user_data = &request;
+    clientConfig.keep_alive_enable = true;
+    clientConfig.cert_pem = config.certPem;
+
+    WIFICLIENT_TAKE(mutex, portMAX_DELAY, DOWNLOADER);
+    esp_http_client_handle_t client = esp_http_client_init(&clientConfig);
+    if (client == NULL) {
+        xSemaphoreGive(mutex);
+        throw runtime_error(EXEP_TAG + "http client could not be created");
+    }
+    //events of an earlier download are stale
+    xQueueReset(eventQueue);
+    WifiClient::getInstance().setEventMask(eventQueue,
+        WifiClient::eventBit(WifiClient::Event::CONNECTED) | WifiClient::eventBit(WifiClient::Event::DISCONNECTED)
+        | WifiClient::eventBit(WifiClient::Event::MEMORY_LOW) | WifiClient::eventBit(WifiClient::Event::MEMORY_NORMAL));
+
+    Result result;
+    result.offset = offset;
+    size_t chunk = config.initialChunk;
+    uint32_t failuresInRow = 0;
+    bool finished = false;
+
+    while (!finished) {
+        if (result.total != 0 && result.offset >= result.total) {
+            result.status = Status::DONE;
+            break;
+        }
+        if (linkDropped() || !WifiClient::getInstance().isConnected()) {
+            esp_http_client_close(client);
+            if (!waitForLink(result)) {
+                result.status = Status::LINK_TIMEOUT;
+                break;
+            }
+        }
+        if (WifiClient::getInstance().getMemoryPressure() == WifiClient::MemoryPressure::CRITICAL) {
+            //closing releases the connection and its TLS buffers during the pause
+            esp_http_client_close(client);
+            if (!waitForMemory(result)) {
+                result.status = Status::MEMORY_TIMEOUT;
+                break;
+            }
+        }
+
+        size_t length = linkChunk(chunk);
+        if (result.total != 0 && length > result.total - result.offset) {
+            length = result.total - result.offset;
+        }
+        char range[48];
+        snprintf(range, sizeof(range), "bytes=%u-%u", (unsigned)result.offset, (unsigned)(result.offset + length - 1));
+        esp_http_client_set_header(client, "Range", range);
+        request.rangeTotal = 0;
+
+        bool received = false;
+        bool dropped = false;
+        bool last = false;
+        esp_err_t error = esp_http_client_open(client, 0);
+        if (error == ESP_OK) {
+            int64_t contentLength = esp_http_client_fetch_headers(client);
+            result.httpStatus = esp_http_client_get_status_code(client);
+
+            size_t remaining = 0;
+            if (result.httpStatus == HTTP_PARTIAL_CONTENT) {
+                if (request.rangeTotal != 0) {
+                    result.total = request.rangeTotal;
+                }
+                remaining = contentLength > 0 ? (size_t)contentLength : length;
+                //total unknown (bytes first-last/*): a chunk shorter than requested is the last one
+                last = result.total == 0 && remaining < length;
+            } else if (result.httpStatus == HTTP_RANGE_NOT_SATISFIABLE && result.offset > 0 && result.total == 0) {
+                //the payload ended exactly with the previous chunk
+                result.total = result.offset;
+                result.status = Status::DONE;
+                break;
+            } else if (result.httpStatus == HTTP_OK && result.offset == 0) {
+                //server ignores Range, the whole payload is the only chunk
+                result.total = contentLength > 0 ? (size_t)contentLength : 0;
+                remaining = contentLength > 0 ? (size_t)contentLength : SIZE_MAX;
+            } else if (result.httpStatus == HTTP_OK) {
+                result.status = Status::NO_RANGE;
+                break;
+            } else if (result.httpStatus < HTTP_SERVER_ERROR) {
+                result.status = Status::HTTP_ERROR;
+                break;
+            }
+
+            //read straight into the sink, no intermediate buffer
+            while (remaining > 0) {
+                size_t available = remaining;
+                uint8_t* buffer = sink.acquire(available);
+                if (buffer == nullptr) {
+                    result.status = Status::SINK_ABORTED;
+                    finished = true;
+                    break;
+                }
+                if (available > remaining) {
+                    available = remaining;
+                }
+                int read = esp_http_client_read(client, (char*)buffer, available);
+                //a response without length ends the payload if the total is unknown
+                if (read == 0 && (remaining == SIZE_MAX || result.total == 0) && esp_http_client_is_complete_data_received(client)) {
+                    result.total = result.offset;
+                    remaining = 0;
+                    break;
+                }
+                if (read <= 0) {
+                    break;
+                }
+                if (!sink.commit(read)) {
+                    result.status = Status::SINK_ABORTED;
+                    finished = true;
+                    break;
+                }
+                result.offset += read;
+                if (remaining != SIZE_MAX) {
+                    remaining -= read;
+                }
+                if (linkDropped()) {
+                    dropped = true;
+                    break;
+                }
+            }
+            received = remaining == 0 && result.httpStatus < HTTP_SERVER_ERROR;
+        }
+        if (finished) {
+            break;
+        }
+
+        if (received) {
+            result.chunks++;
+            failuresInRow = 0;
+            chunk = chunk + config.chunkStep < config.maxChunk ? chunk + config.chunkStep : config.maxChunk;
+            if (result.total == 0 && (result.httpStatus == HTTP_OK || last)) {
+                result.total = result.offset;
+            }
+            continue;
+        }
+
+        //bytes received so far are kept, the next request starts behind them
+        esp_http_client_close(client);
+        chunk = chunk / 2 > config.minChunk ? chunk / 2 : config.minChunk;
+        if (dropped) {
+            //pause is counted by waitForLink
+            continue;
+        }
+        result.failures++;
+        failuresInRow++;
+        ESP_LOGW(TAG, "chunk at %u failed, status %d", (unsigned)result.offset, result.httpStatus);
+        if (failuresInRow >= config.maxFailures) {
+            result.status = Status::FAILED;
+            break;
+        }
+    }
+
+    result.lastChunk = chunk;
+    esp_http_client_cleanup(client);
+    WifiClient::getInstance().setEventMask(eventQueue, 0);
+    xSemaphoreGive(mutex);
+    return result;
+}
+
+esp_err_t WifiDownloader::httpEvent(esp_http_client_event_t* event)
+{
+    if (event->event_id == HTTP_EVENT_ON_HEADER && strcasecmp(event->header_key, "Content-Range") == 0) {
+        //bytes first-last/total, total is * if unknown
+        const char* total = strchr(event->header_value, '/');
+        if (total != NULL && total[1] != '*') {
+            ((Request*)event->user_data)->rangeTotal = strtoul(total + 1, NULL, 10);
+        }
+    }
+    return ESP_OK;
+}
+
+bool WifiDownloader::waitForLink(Result& result)
+{
+    WifiClient::Event event;
+    int64_t end = esp_timer_get_time() + (int64_t)config.resumeTimeoutMs * 1000;
+
+    result.pauses++;
+    while (!WifiClient::getInstance().isConnected()) {
+        int64_t remaining = end - esp_timer_get_time();
+        if (remaining <= 0) {
+            return false;
+        }
+        xQueueReceive(eventQueue, &event, pdMS_TO_TICKS(remaining / 1000 + 1));
+    }
+    ESP_LOGI(TAG, "link is back, resuming");
+    return true;
+}
+
+bool WifiDownloader::waitForMemory(Result& result)
+{
+    WifiClient::Event event;
+    int64_t end = esp_timer_get_time() + (int64_t)config.resumeTimeoutMs * 1000;
+
+    result.pauses++;
+    while (WifiClient::getInstance().getMemoryPressure() == WifiClient::MemoryPressure::CRITICAL) {
+        int64_t remaining = end - esp_timer_get_time();
+        if (remaining <= 0) {
+            return false;
+        }
+        xQueueReceive(eventQueue, &event, pdMS_TO_TICKS(remaining / 1000 + 1));
+    }
+    ESP_LOGI(TAG, "memory pressure dropped, resuming");
+    return true;
+}
+
+bool WifiDownloader::linkDropped()
+{
+    WifiClient::Event event;
+    bool dropped = false;
+    while (xQueueReceive(eventQueue, &event, 0) == pdTRUE) {
+        if (event == WifiClient::Event::DISCONNECTED) {
+            dropped = true;
+        }
+    }
+    return dropped;
+}
+
+size_t WifiDownloader::linkChunk(size_t chunk) const
+{
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) == ESP_OK && ap.rssi < config.weakRssi) {
+        return chunk / 2 > config.minChunk ? chunk / 2 : config.minChunk;
+    }
+    return chunk;
+}
@@ -0,0 +1,318 @@
+/*!
+ * @file 	    WifiEspNow.cpp
+ * @brief 	    Singleton ESP-NOW side channel which coexists with the WifiClient station
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include "WifiEspNow.h"
+
+#include "esp_wifi.h"
+#include "esp_timer.h"
+#include "WifiLockProfiler.h"
+
+#define LOG_LOCAL_LEVEL ESP_LOG_WARN
+#include "esp_log.h"
+#define TAG "WifiEspNow"
+
+#define ACK_TIMEOUT_MS 100
+
+using namespace std;
+
+WifiEspNow WifiEspNow::Singleton;
+WifiEspNow::Message WifiEspNow::messagePool[CONFIG_WIFICLIENT_ESPNOW_MESSAGE_POOL];
+uint8_t WifiEspNow::freeMessagesStorage[CONFIG_WIFICLIENT_ESPNOW_MESSAGE_POOL];
+uint8_t WifiEspNow::pendingMessagesStorage[CONFIG_WIFICLIENT_ESPNOW_MESSAGE_POOL];
+StackType_t WifiEspNow::taskStack[TASK_STACK_SIZE];
+
+void WifiEspNow_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data)
+{
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        //station leaves the home channel for reconnecting, hold back messages
+        xEventGroupClearBits(WifiEspNow::Singleton.linkState, WifiEspNow::LINK_READY);
+
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        wifi_event_sta_connected_t* event = (wifi_event_sta_connected_t*)event_data;
+        portENTER_CRITICAL(&WifiEspNow::Singleton.statsLock);
+        uint8_t oldChannel = WifiEspNow::Singleton.channel;
+        WifiEspNow::Singleton.channel = event->channel;
+        portEXIT_CRITICAL(&WifiEspNow::Singleton.statsLock);
+        if (oldChannel != event->channel) {
+            ESP_LOGI(TAG, "home channel changed from %d to %d", oldChannel, event->channel);
+        }
+        xEventGroupSetBits(WifiEspNow::Singleton.linkState, WifiEspNow::LINK_READY);
+    }
+}
+
+WifiEspNow& WifiEspNow::getInstance()
+{
+    return Singleton;
+}
+
+WifiEspNow::WifiEspNow()
+{
+    initalized = false;
+    channel = 0;
+    receiver = nullptr;
+    statsLock = portMUX_INITIALIZER_UNLOCKED;
+    peerCount = 0;
+}
+
+void WifiEspNow::init(Config const& config)
+{
+    const static string EXEP_TAG = "WifiEspNow::init: ";
+    esp_err_t result;
+
+    if (initalized) {
+        return;
+    }
+    this->config = config;
+
+    peerMutex = xSemaphoreCreateMutexStatic(&peerMutexBuffer);
+    freeMessages = xQueueCreateStatic(CONFIG_WIFICLIENT_ESPNOW_MESSAGE_POOL, sizeof(uint8_t),
+        freeMessagesStorage, &freeMessagesBuffer);
+    pendingMessages = xQueueCreateStatic(CONFIG_WIFICLIENT_ESPNOW_MESSAGE_POOL, sizeof(uint8_t),
+        pendingMessagesStorage, &pendingMessagesBuffer);
+    linkState = xEventGroupCreateStatic(&linkStateBuffer);
+    if (peerMutex == NULL || freeMessages == NULL || pendingMessages == NULL || linkState == NULL) {
+        throw runtime_error(EXEP_TAG + "synchronization objects could not be created");
+    }
+    for (uint8_t i = 0; i < CONFIG_WIFICLIENT_ESPNOW_MESSAGE_POOL; i++) {
+        xQueueSend(freeMessages, &i, 0);
+    }
+
+    result = esp_now_init();
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "esp_now_init failed with error: " + esp_err_to_name(result));
+    }
+
+    result = esp_now_register_send_cb(&WifiEspNow::sendCallback);
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "can't register send callback, error: " + esp_err_to_name(result));
+    }
+
+    result = esp_now_register_recv_cb(&WifiEspNow::receiveCallback);
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "can't register receive callback, error: " + esp_err_to_name(result));
+    }
+
+    result = esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &WifiEspNow_event_handler, NULL);
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "can't register handler, error: " + esp_err_to_name(result));
+    }
+
+    result = esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &WifiEspNow_event_handler, NULL);
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "can't register handler, error: " + esp_err_to_name(result));
+    }
+
+    //LINK_READY follows the station connected event, unless the station is already associated
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) == ESP_OK) {
+        portENTER_CRITICAL(&statsLock);
+        channel = ap.primary;
+        portEXIT_CRITICAL(&statsLock);
+        xEventGroupSetBits(linkState, LINK_READY);
+    }
+
+    task = xTaskCreateStatic(&WifiEspNow::transmitTask, "WifiEspNow", TASK_STACK_SIZE, NULL,
+        config.taskPriority, taskStack, &taskBuffer);
+    if (task == NULL) {
+        throw runtime_error(EXEP_TAG + "transmit task could not be created");
+    }
+    initalized = true;
+}
+
+void WifiEspNow::addPeer(const uint8_t* mac)
+{
+    const static string EXEP_TAG = "WifiEspNow::addPeer: ";
+
+    if (!initalized) {
+        throw runtime_error(EXEP_TAG + "not initialized");
+    }
+
+    WIFICLIENT_TAKE(peerMutex, portMAX_DELAY, ESPNOW_PEERS);
+    if (peerCount >= CONFIG_WIFICLIENT_ESPNOW_MAX_PEERS) {
+        xSemaphoreGive(peerMutex);
+        throw runtime_error(EXEP_TAG + "peer table is full");
+    }
+
+    esp_now_peer_info_t peer;
+    memset(&peer, 0, sizeof(esp_now_peer_info_t));
+    memcpy(peer.peer_addr, mac, ESP_NOW_ETH_ALEN);
+    peer.channel = 0;   //current channel, follows the station
+    peer.ifidx = WIFI_IF_STA;
+    peer.encrypt = false;
+
+    esp_err_t result = esp_now_add_peer(&peer);
+    if (result == ESP_OK) {
+        memcpy(peers[peerCount++], mac, ESP_NOW_ETH_ALEN);
+    }
+    xSemaphoreGive(peerMutex);
+
+    if (result != ESP_OK && result != ESP_ERR_ESPNOW_EXIST) {
+        throw runtime_error(EXEP_TAG + "esp_now_add_peer failed with error: " + esp_err_to_name(result));
+    }
+}
+
+void WifiEspNow::removePeer(const uint8_t* mac)
+{
+    const static string EXEP_TAG = "WifiEspNow::removePeer: ";
+
+    if (!initalized) {
+        throw runtime_error(EXEP_TAG + "not initialized");
+    }
+
+    WIFICLIENT_TAKE(peerMutex, portMAX_DELAY, ESPNOW_PEERS);
+    esp_err_t result = esp_now_del_peer(mac);
+    for (size_t i = 0; i < peerCount; i++) {
+        if (memcmp(peers[i], mac, ESP_NOW_ETH_ALEN) == 0) {
+            memcpy(peers[i], peers[--peerCount], ESP_NOW_ETH_ALEN);
+            break;
+        }
+    }
+    xSemaphoreGive(peerMutex);
+
+    if (result != ESP_OK && result != ESP_ERR_ESPNOW_NOT_FOUND) {
+        throw runtime_error(EXEP_TAG + "esp_now_del_peer failed with error: " + esp_err_to_name(result));
+    }
+}
+
+bool WifiEspNow::send(const uint8_t* mac, const uint8_t* data, size_t length)
+{
+    if (!initalized) {
+        throw runtime_error("WifiEspNow::send: not initialized");
+    }
+    if (length == 0 || length > ESP_NOW_MAX_DATA_LEN) {
+        throw invalid_argument("WifiEspNow::send: length must be between 1 and ESP_NOW_MAX_DATA_LEN");
+    }
+
+    uint8_t index;
+    if (xQueueReceive(freeMessages, &index, 0) != pdTRUE) {
+        portENTER_CRITICAL(&statsLock);
+        stats.poolExhausted++;
+        portEXIT_CRITICAL(&statsLock);
+        return false;
+    }
+
+    Message& message = messagePool[index];
+    memcpy(message.mac, mac, ESP_NOW_ETH_ALEN);
+    memcpy(message.data, data, length);
+    message.length = length;
+    message.attempts = 0;
+    message.enqueued = esp_timer_get_time();
+
+    portENTER_CRITICAL(&statsLock);
+    stats.sent++;
+    portEXIT_CRITICAL(&statsLock);
+
+    //pending queue holds the whole pool, can't be full
+    xQueueSend(pendingMessages, &index, 0);
+    return true;
+}
+
+void WifiEspNow::setReceiveCallback(ReceiveCallback callback)
+{
+    receiver = callback;
+}
+
+uint8_t WifiEspNow::getChannel() const
+{
+    portENTER_CRITICAL(&Singleton.statsLock);
+    uint8_t result = Singleton.channel;
+    portEXIT_CRITICAL(&Singleton.statsLock);
+    return result;
+}
+
+WifiEspNow::Stats WifiEspNow::getStats() const
+{
+    portENTER_CRITICAL(&Singleton.statsLock);
+    Stats result = Singleton.stats;
+    portEXIT_CRITICAL(&Singleton.statsLock);
+    return result;
+}
+
+void WifiEspNow::sendCallback(const uint8_t* mac, esp_now_send_status_t status)
+{
+    xTaskNotify(Singleton.task, status, eSetValueWithOverwrite);
+}
+
+void WifiEspNow::receiveCallback(const esp_now_recv_info_t* info, const uint8_t* data, int length)
+{
+    ReceiveCallback callback = Singleton.receiver;
+    if (callback != nullptr) {
+        callback(info->src_addr, data, length);
+    }
+}
+
+void WifiEspNow::transmitTask(void* arg)
+{
+    uint8_t index;
+
+    while (true) {
+        if (xQueueReceive(Singleton.pendingMessages, &index, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        Message& message = messagePool[index];
+        bool held = false;
+        bool done = false;
+
+        while (!done) {
+            if ((xEventGroupGetBits(Singleton.linkState) & LINK_READY) == 0) {
+                //station is switching channels, wait until it is back or the message expires
+                int64_t heldMs = (esp_timer_get_time() - message.enqueued) / 1000;
+                TickType_t remaining = heldMs < Singleton.config.holdTimeoutMs ?
+                    pdMS_TO_TICKS(Singleton.config.holdTimeoutMs - heldMs) : 0;
+                if (!held) {
+                    held = true;
+                    portENTER_CRITICAL(&Singleton.statsLock);
+                    Singleton.stats.held++;
+                    portEXIT_CRITICAL(&Singleton.statsLock);
+                }
+                EventBits_t bits = xEventGroupWaitBits(Singleton.linkState, LINK_READY, pdFALSE, pdTRUE, remaining);
+                if ((bits & LINK_READY) == 0) {
+                    portENTER_CRITICAL(&Singleton.statsLock);
+                    Singleton.stats.expired++;
+                    portEXIT_CRITICAL(&Singleton.statsLock);
+                    break;
+                }
+            }
+
+            //clear a stale notification of a timed out transmission
+            xTaskNotifyWait(0, UINT32_MAX, NULL, 0);
+            message.attempts++;
+            uint32_t status = ESP_NOW_SEND_FAIL;
+            esp_err_t result = esp_now_send(message.mac, message.data, message.length);
+            if (result != ESP_OK) {
+                ESP_LOGW(TAG, "esp_now_send had an error: %s", esp_err_to_name(result));
+            } else if (xTaskNotifyWait(0, UINT32_MAX, &status, pdMS_TO_TICKS(ACK_TIMEOUT_MS)) != pdTRUE) {
+                status = ESP_NOW_SEND_FAIL;
+            }
+
+            portENTER_CRITICAL(&Singleton.statsLock);
+            if (status == ESP_NOW_SEND_SUCCESS) {
+                uint32_t latency = (uint32_t)(esp_timer_get_time() - message.enqueued);
+                Singleton.stats.delivered++;
+                Singleton.stats.totalLatencyUs += latency;
+                if (Singleton.stats.minLatencyUs == 0 || latency < Singleton.stats.minLatencyUs) {
+                    Singleton.stats.minLatencyUs = latency;
+                }
+                if (latency > Singleton.stats.maxLatencyUs) {
+                    Singleton.stats.maxLatencyUs = latency;
+                }
+                done = true;
+            } else if (message.attempts > Singleton.config.retransmits) {
+                Singleton.stats.failed++;
+                done = true;
+            } else {
+                Singleton.stats.retransmits++;
+            }
+            portEXIT_CRITICAL(&Singleton.statsLock);
+        }
+
+        xQueueSend(Singleton.freeMessages, &index, 0);
+    }
+}
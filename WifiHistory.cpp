@@ -0,0 +1,733 @@
+/*!
+ * @file 	    WifiHistory.cpp
+ * @brief 	    Singleton log-structured connectivity history in a flash partition
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include "WifiHistory.h"
+
+#include <cstring>
+#include <ctime>
+
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+#include "WifiLockProfiler.h"
+
+#define LOG_LOCAL_LEVEL ESP_LOG_WARN
+#include "esp_log.h"
+#define TAG "WifiHistory"
+
+#define SECTOR_SIZE 4096
+//changed with the record layout, sectors of an older layout count as unused
+#define SECTOR_MAGIC 0x57484936
+#define SECONDS_PER_DAY 86400
+//times before 2020-01-01 are not set by SNTP yet
+#define MIN_VALID_TIME 1577836800
+
+#define ENTRY_ERASED 0xFF
+#define ENTRY_CONNECT 1
+#define ENTRY_DISCONNECT 2
+#define ENTRY_AGGREGATE 3
+#define ENTRY_TIME 4
+
+#define MAX_DELTA 0xFFFF
+#define MIN_AGGREGATE_SECTORS 2
+
+#define TIME_TO_IP_UNKNOWN 0xFFFF
+
+using namespace std;
+
+//upper bounds of the time to ip buckets in ms
+static const uint32_t TIME_TO_IP_BOUNDS[WifiHistory::TIME_TO_IP_BUCKETS] =
+    { 250, 500, 1000, 2000, 4000, 8000, 16000, UINT32_MAX };
+
+WifiHistory WifiHistory::Singleton;
+StackType_t WifiHistory::taskStack[TASK_STACK_SIZE];
+uint8_t WifiHistory::eventStorage[EVENT_QUEUE_SIZE * sizeof(Event)];
+uint8_t WifiHistory::readBuffer[396];
+
+//sequence a was written after sequence b, survives the overflow
+static bool isAfter(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) > 0;
+}
+
+//upper bound of the bucket which containes the percentile
+static uint32_t percentile(const uint32_t* histogram, uint32_t total, uint32_t percent)
+{
+    uint32_t target = (total * percent + 99) / 100;
+    uint32_t count = 0;
+    for (size_t i = 0; i < WifiHistory::TIME_TO_IP_BUCKETS; i++) {
+        count += histogram[i];
+        if (count >= target) {
+            return TIME_TO_IP_BOUNDS[i];
+        }
+    }
+    return 0;
+}
+
+void WifiHistory_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data)
+{
+    WifiHistory& history = WifiHistory::Singleton;
+    int64_t now = esp_timer_get_time();
+    WifiHistory::Event event;
+    bool record = false;
+
+    memset(&event, 0, sizeof(event));
+    event.time = (uint32_t)time(NULL);
+    event.uptime = now;
+
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
+        portENTER_CRITICAL(&history.lock);
+        history.linkUp = false;
+        history.attemptStart = now;
+        portEXIT_CRITICAL(&history.lock);
+
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        wifi_event_sta_disconnected_t* disconnected = (wifi_event_sta_disconnected_t*)event_data;
+        portENTER_CRITICAL(&history.lock);
+        //retries keep the start of the connect phase
+        record = history.linkUp;
+        history.linkUp = false;
+        if (record) {
+            history.attemptStart = now;
+        }
+        portEXIT_CRITICAL(&history.lock);
+        event.type = ENTRY_DISCONNECT;
+        event.reason = disconnected->reason;
+
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        portENTER_CRITICAL(&history.lock);
+        record = !history.linkUp;
+        history.linkUp = true;
+        int64_t start = history.attemptStart;
+        portEXIT_CRITICAL(&history.lock);
+        event.type = ENTRY_CONNECT;
+        event.timeToIp = TIME_TO_IP_UNKNOWN;
+        if (start != 0) {
+            int64_t timeToIp = (now - start) / 10000;
+            event.timeToIp = timeToIp < TIME_TO_IP_UNKNOWN ? (uint16_t)timeToIp : TIME_TO_IP_UNKNOWN - 1;
+        }
+    }
+
+    if (record && xQueueSend(history.events, &event, 0) != pdTRUE) {
+        portENTER_CRITICAL(&history.lock);
+        history.stats.dropped++;
+        portEXIT_CRITICAL(&history.lock);
+    }
+}
+
+WifiHistory& WifiHistory::getInstance()
+{
+    return Singleton;
+}
+
+WifiHistory::WifiHistory()
+{
+    static_assert(sizeof(Record) == 6 && sizeof(TimeRecord) == sizeof(Record), "raw entries are 6 bytes");
+    static_assert(sizeof(readBuffer) % sizeof(Record) == 0 && sizeof(readBuffer) % sizeof(Aggregate) == 0,
+        "read buffer holds whole entries");
+
+    initalized = false;
+    partition = NULL;
+    memset(&rawRing, 0, sizeof(Ring));
+    memset(&aggregateRing, 0, sizeof(Ring));
+    lastTime = 0;
+    compactedSequence = 0;
+    compactedValid = false;
+    heldCount = 0;
+    linkUp = false;
+    attemptStart = 0;
+    mutex = NULL;
+    events = NULL;
+    lock = portMUX_INITIALIZER_UNLOCKED;
+}
+
+void WifiHistory::init(const char* partitionLabel, UBaseType_t taskPriority)
+{
+    const static string EXEP_TAG = "WifiHistory::init: ";
+    esp_err_t result;
+
+    if (initalized) {
+        return;
+    }
+
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, partitionLabel);
+    if (partition == NULL) {
+        throw runtime_error(EXEP_TAG + "partition " + partitionLabel + " not found");
+    }
+    uint32_t sectors = partition->size / SECTOR_SIZE;
+    if (sectors < 4) {
+        throw runtime_error(EXEP_TAG + "partition needs at least 4 sectors");
+    }
+
+    rawRing.entrySize = sizeof(Record);
+    aggregateRing.entrySize = sizeof(Aggregate);
+    aggregateRing.sectors = sectors / 4 > MIN_AGGREGATE_SECTORS ? sectors / 4 : MIN_AGGREGATE_SECTORS;
+    rawRing.sectors = sectors - aggregateRing.sectors;
+    rawRing.firstSector = 0;
+    aggregateRing.firstSector = rawRing.sectors;
+
+    result = mount(aggregateRing);
+    if (result == ESP_OK) {
+        result = mount(rawRing);
+    }
+    //last aggregate tells which raw sector was compacted last
+    if (result == ESP_OK && !aggregateRing.empty) {
+        result = readEntries(aggregateRing, aggregateRing.head, [](void* context, const uint8_t* entry) {
+            Singleton.compactedSequence = ((const Aggregate*)entry)->source;
+            Singleton.compactedValid = true;
+        }, NULL, NULL);
+    }
+    //deltas of the newest records add up to the time of the last one
+    SectorHeader header;
+    if (result == ESP_OK && !rawRing.empty) {
+        result = readHeader(rawRing, rawRing.head, header);
+    }
+    if (result == ESP_OK && !rawRing.empty) {
+        lastTime = header.baseTime;
+        result = readEntries(rawRing, rawRing.head, [](void* context, const uint8_t* entry) {
+            Singleton.lastTime = timeOf(Singleton.lastTime, *(const Record*)entry);
+        }, NULL, NULL);
+    }
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "partition read failed with error: " + esp_err_to_name(result));
+    }
+
+    mutex = xSemaphoreCreateMutexStatic(&mutexBuffer);
+    events = xQueueCreateStatic(EVENT_QUEUE_SIZE, sizeof(Event), eventStorage, &eventsBuffer);
+    if (mutex == NULL || events == NULL) {
+        throw runtime_error(EXEP_TAG + "synchronization objects could not be created");
+    }
+
+    result = esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_START, &WifiHistory_event_handler, NULL);
+    if (result == ESP_OK) {
+        result = esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &WifiHistory_event_handler, NULL);
+    }
+    if (result == ESP_OK) {
+        result = esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &WifiHistory_event_handler, NULL);
+    }
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "can't register handler, error: " + esp_err_to_name(result));
+    }
+
+    TaskHandle_t task = xTaskCreateStatic(&WifiHistory::writerTask, "WifiHistory",
+        TASK_STACK_SIZE, NULL, taskPriority, taskStack, &taskBuffer);
+    if (task == NULL) {
+        throw runtime_error(EXEP_TAG + "writer task could not be created");
+    }
+    initalized = true;
+}
+
+bool WifiHistory::getDay(uint32_t day, DayStats& stats) const
+{
+    const static string EXEP_TAG = "WifiHistory::getDay: ";
+
+    struct Query{
+        uint32_t day;
+        uint32_t time;
+        bool found;
+        DayStats stats;
+        uint32_t histogram[TIME_TO_IP_BUCKETS];
+    };
+
+    //aggregates and raw records are merged the same way
+    static const EntryVisitor addAggregate = [](void* context, const uint8_t* entry) {
+        Query* query = (Query*)context;
+        const Aggregate* aggregate = (const Aggregate*)entry;
+        if (aggregate->day != query->day) {
+            return;
+        }
+        query->found = true;
+        query->stats.connects += aggregate->connects;
+        query->stats.disconnects += aggregate->disconnects;
+        for (size_t i = 0; i < (size_t)Reason::COUNT; i++) {
+            query->stats.reasons[i] += aggregate->reasons[i];
+        }
+        for (size_t i = 0; i < TIME_TO_IP_BUCKETS; i++) {
+            query->histogram[i] += aggregate->timeToIp[i];
+        }
+    };
+
+    if (!initalized) {
+        throw runtime_error(EXEP_TAG + "not initialized");
+    }
+
+    Query query = {};
+    query.day = day;
+    query.stats.day = day;
+
+    esp_err_t result = ESP_OK;
+    SectorHeader header;
+
+    WIFICLIENT_TAKE(mutex, portMAX_DELAY, HISTORY);
+    for (uint32_t i = 0; i < aggregateRing.sectors && result == ESP_OK; i++) {
+        result = readHeader(aggregateRing, i, header);
+        if (result == ESP_OK) {
+            result = readEntries(aggregateRing, i, addAggregate, &query, NULL);
+        }
+        if (result == ESP_ERR_NOT_FOUND) {
+            result = ESP_OK;
+        }
+    }
+    for (uint32_t i = 0; i < rawRing.sectors && result == ESP_OK; i++) {
+        result = readHeader(rawRing, i, header);
+        if (result == ESP_OK && !isCompacted(header.sequence)) {
+            query.time = header.baseTime;
+            result = readEntries(rawRing, i, [](void* context, const uint8_t* entry) {
+                Query* query = (Query*)context;
+                const Record* record = (const Record*)entry;
+                query->time = timeOf(query->time, *record);
+                if (record->type != ENTRY_TIME && query->time / SECONDS_PER_DAY == query->day) {
+                    Aggregate aggregate;
+                    memset(&aggregate, 0, sizeof(Aggregate));
+                    aggregate.day = query->day;
+                    addToAggregate(aggregate, *record);
+                    addAggregate(context, (const uint8_t*)&aggregate);
+                }
+            }, &query, NULL);
+        }
+        if (result == ESP_ERR_NOT_FOUND) {
+            result = ESP_OK;
+        }
+    }
+    xSemaphoreGive(mutex);
+
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "partition read failed with error: " + esp_err_to_name(result));
+    }
+
+    uint32_t total = 0;
+    for (size_t i = 0; i < TIME_TO_IP_BUCKETS; i++) {
+        total += query.histogram[i];
+    }
+    if (total > 0) {
+        query.stats.timeToIpP50Ms = percentile(query.histogram, total, 50);
+        query.stats.timeToIpP90Ms = percentile(query.histogram, total, 90);
+        query.stats.timeToIpP99Ms = percentile(query.histogram, total, 99);
+    }
+    stats = query.stats;
+    return query.found;
+}
+
+WifiHistory::Stats WifiHistory::getStats() const
+{
+    portENTER_CRITICAL(&Singleton.lock);
+    Stats result = Singleton.stats;
+    portEXIT_CRITICAL(&Singleton.lock);
+    return result;
+}
+
+void WifiHistory::clear()
+{
+    const static string EXEP_TAG = "WifiHistory::clear: ";
+
+    if (!initalized) {
+        throw runtime_error(EXEP_TAG + "not initialized");
+    }
+
+    uint32_t sectors = rawRing.sectors + aggregateRing.sectors;
+
+    WIFICLIENT_TAKE(mutex, portMAX_DELAY, HISTORY);
+    esp_err_t result = esp_partition_erase_range(partition, 0, sectors * SECTOR_SIZE);
+    rawRing.empty = true;
+    aggregateRing.empty = true;
+    lastTime = 0;
+    compactedValid = false;
+    xSemaphoreGive(mutex);
+
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "erase failed with error: " + esp_err_to_name(result));
+    }
+    portENTER_CRITICAL(&lock);
+    stats.sectorsErased += sectors;
+    portEXIT_CRITICAL(&lock);
+}
+
+void WifiHistory::writerTask(void* arg)
+{
+    Event event;
+
+    while (true) {
+        //the system time is polled while events are held
+        TickType_t wait = Singleton.heldCount > 0 ? pdMS_TO_TICKS(TIME_POLL_MS) : portMAX_DELAY;
+        bool received = xQueueReceive(Singleton.events, &event, wait) == pdTRUE;
+
+        if (received && event.time < MIN_VALID_TIME) {
+            received = false;
+            portENTER_CRITICAL(&Singleton.lock);
+            if (Singleton.heldCount < HELD_EVENTS) {
+                Singleton.held[Singleton.heldCount++] = event;
+                Singleton.stats.held = Singleton.heldCount;
+            } else {
+                Singleton.stats.dropped++;
+            }
+            portEXIT_CRITICAL(&Singleton.lock);
+        }
+        //held events are older, they go first
+        if (Singleton.heldCount > 0) {
+            Singleton.releaseHeld();
+        }
+        if (received) {
+            Singleton.writeEvent(event);
+        }
+    }
+}
+
+void WifiHistory::writeEvent(Event const& event)
+{
+    WIFICLIENT_TAKE(mutex, portMAX_DELAY, HISTORY);
+    esp_err_t result = appendEvent(event);
+    xSemaphoreGive(mutex);
+
+    if (result != ESP_OK) {
+        portENTER_CRITICAL(&lock);
+        stats.flashErrors++;
+        portEXIT_CRITICAL(&lock);
+        ESP_LOGE(TAG, "record could not be written: %s", esp_err_to_name(result));
+    }
+}
+
+void WifiHistory::releaseHeld()
+{
+    uint32_t now = (uint32_t)time(NULL);
+    if (now < MIN_VALID_TIME) {
+        return;
+    }
+    int64_t uptime = esp_timer_get_time();
+
+    for (uint32_t i = 0; i < heldCount; i++) {
+        Event event = held[i];
+        uint32_t age = (uint32_t)((uptime - event.uptime) / 1000000);
+        event.time = age < now - MIN_VALID_TIME ? now - age : MIN_VALID_TIME;
+        writeEvent(event);
+    }
+    portENTER_CRITICAL(&lock);
+    heldCount = 0;
+    stats.held = 0;
+    portEXIT_CRITICAL(&lock);
+}
+
+WifiHistory::Reason WifiHistory::groupReason(uint8_t reason)
+{
+    switch (reason) {
+    case WIFI_REASON_BEACON_TIMEOUT:
+        return Reason::BEACON_TIMEOUT;
+    case WIFI_REASON_NO_AP_FOUND:
+        return Reason::NO_AP_FOUND;
+    case WIFI_REASON_AUTH_FAIL:
+    case WIFI_REASON_ASSOC_FAIL:
+    case WIFI_REASON_HANDSHAKE_TIMEOUT:
+    case WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT:
+    case WIFI_REASON_MIC_FAILURE:
+        return Reason::AUTH;
+    case WIFI_REASON_AUTH_EXPIRE:
+    case WIFI_REASON_ASSOC_EXPIRE:
+        return Reason::INACTIVITY;
+    case WIFI_REASON_AUTH_LEAVE:
+    case WIFI_REASON_ASSOC_LEAVE:
+        return Reason::AP_LEAVE;
+    default:
+        return Reason::OTHER;
+    }
+}
+
+void WifiHistory::addToAggregate(Aggregate& aggregate, Record const& record)
+{
+    aggregate.type = ENTRY_AGGREGATE;
+    if (record.type == ENTRY_DISCONNECT) {
+        aggregate.disconnects++;
+        aggregate.reasons[(size_t)groupReason(record.reason)]++;
+        return;
+    }
+
+    aggregate.connects++;
+    if (record.timeToIp == TIME_TO_IP_UNKNOWN) {
+        return;
+    }
+    uint32_t timeToIpMs = (uint32_t)record.timeToIp * 10;
+    size_t bucket = 0;
+    while (timeToIpMs > TIME_TO_IP_BOUNDS[bucket]) {
+        bucket++;
+    }
+    aggregate.timeToIp[bucket]++;
+}
+
+uint32_t WifiHistory::timeOf(uint32_t previous, Record const& record)
+{
+    if (record.type == ENTRY_TIME) {
+        const TimeRecord* time = (const TimeRecord*)&record;
+        return (uint32_t)time->timeHigh << 16 | time->timeLow;
+    }
+    return previous + record.delta;
+}
+
+esp_err_t WifiHistory::mount(Ring& ring)
+{
+    SectorHeader header;
+
+    ring.empty = true;
+    for (uint32_t i = 0; i < ring.sectors; i++) {
+        esp_err_t result = readHeader(ring, i, header);
+        if (result == ESP_ERR_NOT_FOUND) {
+            continue;
+        }
+        if (result != ESP_OK) {
+            return result;
+        }
+        if (ring.empty || isAfter(header.sequence, ring.sequence)) {
+            ring.empty = false;
+            ring.head = i;
+            ring.sequence = header.sequence;
+        }
+    }
+
+    if (ring.empty) {
+        return ESP_OK;
+    }
+    return readEntries(ring, ring.head, [](void* context, const uint8_t* entry) {}, NULL, &ring.offset);
+}
+
+esp_err_t WifiHistory::readHeader(Ring const& ring, uint32_t sector, SectorHeader& header) const
+{
+    esp_err_t result = esp_partition_read(partition, (ring.firstSector + sector) * SECTOR_SIZE,
+        &header, sizeof(SectorHeader));
+    if (result == ESP_OK && header.magic != SECTOR_MAGIC) {
+        result = ESP_ERR_NOT_FOUND;
+    }
+    return result;
+}
+
+esp_err_t WifiHistory::readEntries(Ring const& ring, uint32_t sector, EntryVisitor visitor, void* context, uint32_t* end) const
+{
+    uint32_t base = (ring.firstSector + sector) * SECTOR_SIZE;
+    uint32_t chunk = (sizeof(readBuffer) / ring.entrySize) * ring.entrySize;
+    uint32_t offset = sizeof(SectorHeader);
+
+    while (offset + ring.entrySize <= SECTOR_SIZE) {
+        uint32_t length = ((SECTOR_SIZE - offset) / ring.entrySize) * ring.entrySize;
+        if (length > chunk) {
+            length = chunk;
+        }
+        esp_err_t result = esp_partition_read(partition, base + offset, readBuffer, length);
+        if (result != ESP_OK) {
+            return result;
+        }
+        for (uint32_t i = 0; i < length; i += ring.entrySize) {
+            //entries are appended, the first erased one ends the sector
+            if (readBuffer[i] == ENTRY_ERASED) {
+                if (end != NULL) {
+                    *end = offset + i;
+                }
+                return ESP_OK;
+            }
+            visitor(context, readBuffer + i);
+        }
+        offset += length;
+    }
+
+    if (end != NULL) {
+        *end = offset;
+    }
+    return ESP_OK;
+}
+
+esp_err_t WifiHistory::nextSector(Ring& ring, uint32_t time)
+{
+    uint32_t next = ring.empty ? 0 : (ring.head + 1) % ring.sectors;
+    esp_err_t result;
+
+    if (&ring == &rawRing) {
+        result = compact(next);
+        if (result != ESP_OK) {
+            return result;
+        }
+    }
+
+    result = esp_partition_erase_range(partition, (ring.firstSector + next) * SECTOR_SIZE, SECTOR_SIZE);
+    if (result != ESP_OK) {
+        return result;
+    }
+
+    SectorHeader header;
+    header.magic = SECTOR_MAGIC;
+    header.sequence = ring.empty ? 1 : ring.sequence + 1;
+    header.baseTime = time;
+    header.reserved = 0xFFFFFFFF;
+    result = esp_partition_write(partition, (ring.firstSector + next) * SECTOR_SIZE, &header, sizeof(SectorHeader));
+
+    portENTER_CRITICAL(&lock);
+    stats.sectorsErased++;
+    if (result == ESP_OK) {
+        stats.bytesWritten += sizeof(SectorHeader);
+    }
+    portEXIT_CRITICAL(&lock);
+
+    //a failed header leaves the sector erased, mount ignores it
+    if (result == ESP_OK) {
+        ring.empty = false;
+        ring.head = next;
+        ring.sequence = header.sequence;
+        ring.offset = sizeof(SectorHeader);
+    }
+    return result;
+}
+
+esp_err_t WifiHistory::writeEntry(Ring& ring, const void* entry)
+{
+    esp_err_t result = esp_partition_write(partition, (ring.firstSector + ring.head) * SECTOR_SIZE + ring.offset,
+        entry, ring.entrySize);
+    //skip the entry on failure, a partly written entry must not be overwritten
+    ring.offset += ring.entrySize;
+    if (result == ESP_OK) {
+        portENTER_CRITICAL(&lock);
+        stats.bytesWritten += ring.entrySize;
+        portEXIT_CRITICAL(&lock);
+    }
+    return result;
+}
+
+esp_err_t WifiHistory::compact(uint32_t sector)
+{
+    struct Compaction{
+        uint32_t time;
+        uint32_t source;
+        Aggregate aggregate;
+        esp_err_t result;
+    };
+
+    SectorHeader header;
+    esp_err_t result = readHeader(rawRing, sector, header);
+    if (result == ESP_ERR_NOT_FOUND) {
+        return ESP_OK;
+    }
+    if (result != ESP_OK || isCompacted(header.sequence)) {
+        return result;
+    }
+
+    Compaction compaction;
+    memset(&compaction, 0, sizeof(Compaction));
+    compaction.time = header.baseTime;
+    compaction.source = header.sequence;
+    compaction.aggregate.type = ENTRY_ERASED;
+
+    //records are in time order, so every day is one run of records
+    result = readEntries(rawRing, sector, [](void* context, const uint8_t* entry) {
+        Compaction* compaction = (Compaction*)context;
+        const Record* record = (const Record*)entry;
+        compaction->time = timeOf(compaction->time, *record);
+        if (record->type == ENTRY_TIME) {
+            return;
+        }
+        uint32_t day = compaction->time / SECONDS_PER_DAY;
+
+        if (compaction->aggregate.type != ENTRY_ERASED && compaction->aggregate.day != day) {
+            if (compaction->result == ESP_OK) {
+                compaction->result = Singleton.appendAggregate(compaction->aggregate, compaction->time);
+            }
+            compaction->aggregate.type = ENTRY_ERASED;
+        }
+        if (compaction->aggregate.type == ENTRY_ERASED) {
+            memset(&compaction->aggregate, 0, sizeof(Aggregate));
+            compaction->aggregate.reserved = 0xFF;
+            compaction->aggregate.day = day;
+            compaction->aggregate.source = compaction->source;
+        }
+        addToAggregate(compaction->aggregate, *record);
+    }, &compaction, NULL);
+
+    if (result == ESP_OK) {
+        result = compaction.result;
+    }
+    if (result == ESP_OK && compaction.aggregate.type != ENTRY_ERASED) {
+        result = appendAggregate(compaction.aggregate, compaction.time);
+    }
+    if (result != ESP_OK) {
+        return result;
+    }
+
+    compactedSequence = header.sequence;
+    compactedValid = true;
+    portENTER_CRITICAL(&lock);
+    stats.compactions++;
+    portEXIT_CRITICAL(&lock);
+    return ESP_OK;
+}
+
+esp_err_t WifiHistory::appendAggregate(Aggregate const& aggregate, uint32_t time)
+{
+    esp_err_t result = ESP_OK;
+    if (aggregateRing.empty || aggregateRing.offset + sizeof(Aggregate) > SECTOR_SIZE) {
+        result = nextSector(aggregateRing, time);
+    }
+    if (result == ESP_OK) {
+        result = writeEntry(aggregateRing, &aggregate);
+    }
+    if (result == ESP_OK) {
+        portENTER_CRITICAL(&lock);
+        stats.aggregatesWritten++;
+        portEXIT_CRITICAL(&lock);
+    }
+    return result;
+}
+
+esp_err_t WifiHistory::appendEvent(Event const& event)
+{
+    esp_err_t result = ESP_OK;
+
+    //time never runs backwards in the log
+    uint32_t time = event.time > lastTime ? event.time : lastTime;
+
+    //a delta above 16 bit needs a time record in front, a new sector has its base time
+    bool gap = time - lastTime > MAX_DELTA;
+    uint32_t needed = gap ? sizeof(TimeRecord) + sizeof(Record) : sizeof(Record);
+    if (rawRing.empty || rawRing.offset + needed > SECTOR_SIZE) {
+        result = nextSector(rawRing, time);
+        if (result != ESP_OK) {
+            return result;
+        }
+        lastTime = time;
+        gap = false;
+    }
+
+    if (gap) {
+        TimeRecord timeRecord;
+        timeRecord.type = ENTRY_TIME;
+        timeRecord.reserved = 0xFF;
+        timeRecord.timeLow = (uint16_t)time;
+        timeRecord.timeHigh = (uint16_t)(time >> 16);
+        result = writeEntry(rawRing, &timeRecord);
+        if (result != ESP_OK) {
+            return result;
+        }
+        lastTime = time;
+    }
+
+    Record record;
+    record.type = event.type;
+    record.reason = event.reason;
+    record.timeToIp = event.timeToIp;
+    record.delta = (uint16_t)(time - lastTime);
+
+    result = writeEntry(rawRing, &record);
+    if (result != ESP_OK) {
+        return result;
+    }
+    lastTime = time;
+
+    portENTER_CRITICAL(&lock);
+    stats.recordsAppended++;
+    stats.payloadBytes += sizeof(Record);
+    portEXIT_CRITICAL(&lock);
+    return ESP_OK;
+}
+
+bool WifiHistory::isCompacted(uint32_t sequence) const
+{
+    return compactedValid && !isAfter(sequence, compactedSequence);
+}
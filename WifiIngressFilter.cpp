@@ -0,0 +1,240 @@
+/*!
+ * @file 	    WifiIngressFilter.cpp
+ * @brief 	    Singleton early drop filter for broadcast noise on the station netif
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include "WifiIngressFilter.h"
+
+#include "WifiClient.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+//private driver API, see the class description
+#include "esp_private/wifi.h"
+
+#define LOG_LOCAL_LEVEL ESP_LOG_WARN
+#include "esp_log.h"
+#define TAG "WifiIngressFilter"
+
+#define ETH_HEADER_LEN 14
+#define ETHERTYPE_IPV4 0x0800
+#define ETHERTYPE_IPV6 0x86DD
+#define IPV6_HEADER_LEN 40
+#define IP_PROTO_UDP 17
+#define DHCP_CLIENT_PORT 68
+#define DHCP6_CLIENT_PORT 546
+
+using namespace std;
+
+WifiIngressFilter WifiIngressFilter::Singleton;
+
+const WifiIngressFilter::Rule WifiIngressFilter::DEFAULT_RULES[] = {
+    { 5353, "mDNS" },
+    { 1900, "SSDP" },
+    { 137, "NetBIOS-NS" },
+    { 138, "NetBIOS-DGM" },
+    { 5355, "LLMNR" }
+};
+
+void WifiIngressFilter_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data)
+{
+    //handler runs after the default wifi handlers, which registered lwIP
+    esp_err_t result = WifiIngressFilter::hook();
+    if (result != ESP_OK) {
+        ESP_LOGE(TAG, "esp_wifi_internal_reg_rxcb had an error: %s", esp_err_to_name(result));
+    }
+}
+
+WifiIngressFilter& WifiIngressFilter::getInstance()
+{
+    return Singleton;
+}
+
+WifiIngressFilter::WifiIngressFilter()
+{
+    initalized = false;
+    enabled = true;
+    ruleCount = 0;
+    for (size_t i = 0; i < MAX_RULES; i++) {
+        hits[i] = 0;
+        hitBytes[i] = 0;
+    }
+    inspected = 0;
+    passed = 0;
+    dropped = 0;
+    droppedBytes = 0;
+    pressureDropped = 0;
+    lock = portMUX_INITIALIZER_UNLOCKED;
+}
+
+void WifiIngressFilter::init(const Rule* rules, size_t count)
+{
+    const static string EXEP_TAG = "WifiIngressFilter::init: ";
+    esp_err_t result;
+
+    if (rules == nullptr) {
+        rules = DEFAULT_RULES;
+        count = sizeof(DEFAULT_RULES) / sizeof(Rule);
+    }
+    if (count > MAX_RULES) {
+        throw invalid_argument(EXEP_TAG + "too many rules");
+    }
+#if !CONFIG_WIFICLIENT_INGRESS_FILTER
+    throw runtime_error(EXEP_TAG + "disabled by CONFIG_WIFICLIENT_INGRESS_FILTER");
+#endif
+    if (WifiClient::getInstance().getNetif() == NULL) {
+        throw runtime_error(EXEP_TAG + "WifiClient is not initialized");
+    }
+
+    portENTER_CRITICAL(&lock);
+    for (size_t i = 0; i < count; i++) {
+        ports[i] = rules[i].port;
+        names[i] = rules[i].name;
+        hits[i] = 0;
+        hitBytes[i] = 0;
+    }
+    ruleCount = count;
+    portEXIT_CRITICAL(&lock);
+
+    if (initalized) {
+        return;
+    }
+
+    result = esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_START, &WifiIngressFilter_event_handler, NULL);
+    if (result == ESP_OK) {
+        result = esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &WifiIngressFilter_event_handler, NULL);
+    }
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "can't register handler, error: " + esp_err_to_name(result));
+    }
+
+    //driver may run already
+    if (WifiClient::getInstance().isConnected()) {
+        hook();
+    }
+    initalized = true;
+}
+
+void WifiIngressFilter::setEnabled(bool enabled)
+{
+    portENTER_CRITICAL(&lock);
+    this->enabled = enabled;
+    portEXIT_CRITICAL(&lock);
+}
+
+size_t WifiIngressFilter::getRuleStats(RuleStats* ruleStats, size_t maxRules) const
+{
+    portENTER_CRITICAL(&Singleton.lock);
+    size_t count = ruleCount < maxRules ? ruleCount : maxRules;
+    for (size_t i = 0; i < count; i++) {
+        ruleStats[i].port = ports[i];
+        ruleStats[i].name = names[i];
+        ruleStats[i].hits = hits[i].load(memory_order_relaxed);
+        ruleStats[i].bytes = hitBytes[i].load(memory_order_relaxed);
+    }
+    portEXIT_CRITICAL(&Singleton.lock);
+    return count;
+}
+
+WifiIngressFilter::Stats WifiIngressFilter::getStats() const
+{
+    Stats result;
+    result.inspected = inspected.load(memory_order_relaxed);
+    result.passed = passed.load(memory_order_relaxed);
+    result.dropped = dropped.load(memory_order_relaxed);
+    result.droppedBytes = droppedBytes.load(memory_order_relaxed);
+    result.pressureDropped = pressureDropped.load(memory_order_relaxed);
+    return result;
+}
+
+esp_err_t WifiIngressFilter::hook()
+{
+#if CONFIG_WIFICLIENT_INGRESS_FILTER
+    return esp_wifi_internal_reg_rxcb(WIFI_IF_STA, &WifiIngressFilter::receive);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+int WifiIngressFilter::match(const uint8_t* frame, uint16_t length, bool strict) const
+{
+    if (length < ETH_HEADER_LEN) {
+        return -1;
+    }
+
+    uint16_t type = (frame[12] << 8) | frame[13];
+    const uint8_t* ip = frame + ETH_HEADER_LEN;
+    uint16_t udpOffset;
+
+    if (type == ETHERTYPE_IPV4) {
+        if (length < ETH_HEADER_LEN + 20 || ip[9] != IP_PROTO_UDP) {
+            return -1;
+        }
+        //only the first fragment carries the UDP header
+        if ((((ip[6] & 0x1F) << 8) | ip[7]) != 0) {
+            return -1;
+        }
+        udpOffset = ETH_HEADER_LEN + (ip[0] & 0x0F) * 4;
+    } else if (type == ETHERTYPE_IPV6) {
+        //extension headers are passed, discovery protocols don't use them
+        if (length < ETH_HEADER_LEN + IPV6_HEADER_LEN || ip[6] != IP_PROTO_UDP) {
+            return -1;
+        }
+        udpOffset = ETH_HEADER_LEN + IPV6_HEADER_LEN;
+    } else {
+        return -1;
+    }
+
+    if (length < udpOffset + 4) {
+        return -1;
+    }
+    uint16_t port = (frame[udpOffset + 2] << 8) | frame[udpOffset + 3];
+    for (size_t i = 0; i < ruleCount; i++) {
+        if (ports[i] == port) {
+            return i;
+        }
+    }
+    if (strict && port != DHCP_CLIENT_PORT && port != DHCP6_CLIENT_PORT) {
+        return MAX_RULES;
+    }
+    return -1;
+}
+
+esp_err_t WifiIngressFilter::receive(void* buffer, uint16_t length, void* eb)
+{
+    WifiIngressFilter& filter = Singleton;
+    esp_netif_t* netif = WifiClient::getInstance().getNetif();
+
+    filter.inspected.fetch_add(1, memory_order_relaxed);
+    //unicast, the common case, costs one byte and no lock
+    if (length == 0 || (((const uint8_t*)buffer)[0] & 0x01) == 0) {
+        filter.passed.fetch_add(1, memory_order_relaxed);
+        return esp_netif_receive(netif, buffer, length, eb);
+    }
+
+    bool strict = WifiClient::getInstance().getMemoryPressure() == WifiClient::MemoryPressure::CRITICAL;
+
+    portENTER_CRITICAL(&filter.lock);
+    int rule = filter.enabled ? filter.match((const uint8_t*)buffer, length, strict) : -1;
+    portEXIT_CRITICAL(&filter.lock);
+
+    if (rule < 0) {
+        filter.passed.fetch_add(1, memory_order_relaxed);
+        return esp_netif_receive(netif, buffer, length, eb);
+    }
+
+    filter.dropped.fetch_add(1, memory_order_relaxed);
+    filter.droppedBytes.fetch_add(length, memory_order_relaxed);
+    if (rule == (int)MAX_RULES) {
+        filter.pressureDropped.fetch_add(1, memory_order_relaxed);
+    } else {
+        filter.hits[rule].fetch_add(1, memory_order_relaxed);
+        filter.hitBytes[rule].fetch_add(length, memory_order_relaxed);
+    }
+    esp_wifi_internal_free_rx_buffer(eb);
+    return ESP_OK;
+}
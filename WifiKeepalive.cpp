@@ -0,0 +1,226 @@
+/*!
+ * @file 	    WifiKeepalive.cpp
+ * @brief 	    Singleton keepalive scheduler which avoids idle disassociations
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include "WifiKeepalive.h"
+
+#include <cstring>
+
+#include "WifiClient.h"
+#include "esp_attr.h"
+#include "lwip/tcpip.h"
+#include "lwip/etharp.h"
+
+#define LOG_LOCAL_LEVEL ESP_LOG_WARN
+#include "esp_log.h"
+#define TAG "WifiKeepalive"
+
+using namespace std;
+
+WifiKeepalive WifiKeepalive::Singleton;
+
+//learned idle timeout survives deep sleep
+RTC_DATA_ATTR static uint32_t learnedTimeoutMs = 0;
+
+void WifiKeepalive_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data)
+{
+    WifiKeepalive& keepalive = WifiKeepalive::Singleton;
+
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        portENTER_CRITICAL(&keepalive.lock);
+        keepalive.associated = esp_timer_get_time();
+        keepalive.lastActivity = keepalive.associated;
+        portEXIT_CRITICAL(&keepalive.lock);
+
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        ip_event_got_ip_t* event = (ip_event_got_ip_t*)event_data;
+        portENTER_CRITICAL(&keepalive.lock);
+        keepalive.gateway.addr = event->ip_info.gw.addr;
+        keepalive.linkUp = true;
+        portEXIT_CRITICAL(&keepalive.lock);
+        WifiKeepalive::schedule();
+
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        wifi_event_sta_disconnected_t* event = (wifi_event_sta_disconnected_t*)event_data;
+        int64_t now = esp_timer_get_time();
+
+        portENTER_CRITICAL(&keepalive.lock);
+        bool wasUp = keepalive.linkUp;
+        keepalive.linkUp = false;
+        uint32_t idleMs = (uint32_t)((now - keepalive.lastActivity) / 1000);
+        bool kicked = wasUp && (event->reason == WIFI_REASON_ASSOC_EXPIRE || event->reason == WIFI_REASON_AUTH_EXPIRE);
+        if (kicked) {
+            keepalive.stats.idleKicks++;
+            if (idleMs >= keepalive.config.minTimeoutMs && (learnedTimeoutMs == 0 || idleMs < learnedTimeoutMs)) {
+                learnedTimeoutMs = idleMs;
+            }
+        }
+        portEXIT_CRITICAL(&keepalive.lock);
+
+        esp_timer_stop(keepalive.timer);
+        if (kicked) {
+            ESP_LOGI(TAG, "disassociated after %lu ms idle", (unsigned long)idleMs);
+        }
+    }
+}
+
+WifiKeepalive& WifiKeepalive::getInstance()
+{
+    return Singleton;
+}
+
+WifiKeepalive::WifiKeepalive()
+{
+    running = false;
+    linkUp = false;
+    associated = 0;
+    lastActivity = 0;
+    gateway.addr = 0;
+    timer = NULL;
+    lock = portMUX_INITIALIZER_UNLOCKED;
+}
+
+void WifiKeepalive::start(Config const& config)
+{
+    const static string EXEP_TAG = "WifiKeepalive::start: ";
+    esp_err_t result;
+
+    if (config.marginPercent == 0 || config.marginPercent > 100) {
+        throw invalid_argument(EXEP_TAG + "marginPercent must be between 1 and 100");
+    }
+
+    if (timer == NULL) {
+        esp_timer_create_args_t timerArgs;
+        memset(&timerArgs, 0, sizeof(esp_timer_create_args_t));
+        timerArgs.callback = &WifiKeepalive::keepaliveTimer;
+        timerArgs.name = "WifiKeepalive";
+        result = esp_timer_create(&timerArgs, &timer);
+        if (result != ESP_OK) {
+            throw runtime_error(EXEP_TAG + "timer create failed with error: " + esp_err_to_name(result));
+        }
+
+        result = esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &WifiKeepalive_event_handler, NULL);
+        if (result == ESP_OK) {
+            result = esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &WifiKeepalive_event_handler, NULL);
+        }
+        if (result == ESP_OK) {
+            result = esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &WifiKeepalive_event_handler, NULL);
+        }
+        if (result != ESP_OK) {
+            throw runtime_error(EXEP_TAG + "can't register handler, error: " + esp_err_to_name(result));
+        }
+    }
+
+    portENTER_CRITICAL(&lock);
+    this->config = config;
+    running = true;
+    portEXIT_CRITICAL(&lock);
+
+    schedule();
+}
+
+void WifiKeepalive::stop()
+{
+    portENTER_CRITICAL(&lock);
+    running = false;
+    portEXIT_CRITICAL(&lock);
+
+    if (timer != NULL) {
+        esp_timer_stop(timer);
+    }
+}
+
+void WifiKeepalive::notifyActivity()
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&lock);
+    lastActivity = now;
+    portEXIT_CRITICAL(&lock);
+}
+
+WifiKeepalive::Stats WifiKeepalive::getStats() const
+{
+    portENTER_CRITICAL(&Singleton.lock);
+    Stats result = Singleton.stats;
+    result.timeoutMs = Singleton.config.idleTimeoutMs != 0 ? Singleton.config.idleTimeoutMs : learnedTimeoutMs;
+    portEXIT_CRITICAL(&Singleton.lock);
+    return result;
+}
+
+int64_t WifiKeepalive::dueTime()
+{
+    portENTER_CRITICAL(&Singleton.lock);
+    uint32_t timeoutMs = Singleton.config.idleTimeoutMs != 0 ? Singleton.config.idleTimeoutMs : learnedTimeoutMs;
+    bool active = Singleton.running && Singleton.linkUp && timeoutMs != 0;
+    int64_t due = Singleton.lastActivity + (int64_t)timeoutMs * Singleton.config.marginPercent * 10;
+    int64_t wakeInterval = (int64_t)Singleton.config.wakeIntervalMs * 1000;
+    int64_t associated = Singleton.associated;
+    portEXIT_CRITICAL(&Singleton.lock);
+
+    if (!active) {
+        return 0;
+    }
+    //last wake window before the due time
+    if (wakeInterval > 0 && due > associated) {
+        due = associated + ((due - associated) / wakeInterval) * wakeInterval;
+    }
+    return due;
+}
+
+void WifiKeepalive::schedule()
+{
+    int64_t due = dueTime();
+    if (due == 0) {
+        return;
+    }
+    int64_t delay = due - esp_timer_get_time();
+    esp_timer_stop(Singleton.timer);
+    esp_timer_start_once(Singleton.timer, delay > 0 ? delay : 0);
+}
+
+void WifiKeepalive::keepaliveTimer(void* arg)
+{
+    int64_t due = dueTime();
+    if (due == 0) {
+        return;
+    }
+    if (due > esp_timer_get_time() + 1000) {
+        //activity since the timer was armed moved the due time
+        schedule();
+        return;
+    }
+
+    if (tcpip_callback(&WifiKeepalive::sendKeepalive, NULL) != ERR_OK) {
+        portENTER_CRITICAL(&Singleton.lock);
+        Singleton.stats.sendErrors++;
+        portEXIT_CRITICAL(&Singleton.lock);
+    }
+    Singleton.notifyActivity();
+    schedule();
+}
+
+void WifiKeepalive::sendKeepalive(void* arg)
+{
+    esp_netif_t* netif = WifiClient::getInstance().getNetif();
+    struct netif* lwipNetif = netif != NULL ? (struct netif*)esp_netif_get_netif_impl(netif) : NULL;
+
+    portENTER_CRITICAL(&Singleton.lock);
+    ip4_addr_t gateway = Singleton.gateway;
+    portEXIT_CRITICAL(&Singleton.lock);
+
+    bool sent = lwipNetif != NULL && etharp_request(lwipNetif, &gateway) == ERR_OK;
+
+    portENTER_CRITICAL(&Singleton.lock);
+    if (sent) {
+        Singleton.stats.keepalives++;
+    } else {
+        Singleton.stats.sendErrors++;
+    }
+    portEXIT_CRITICAL(&Singleton.lock);
+}
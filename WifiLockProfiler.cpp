@@ -0,0 +1,118 @@
+/*!
+ * @file 	    WifiLockProfiler.cpp
+ * @brief 	    Singleton contention profiler for the mutexes of the component
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include "WifiLockProfiler.h"
+
+#include "esp_timer.h"
+
+#define LOG_LOCAL_LEVEL ESP_LOG_WARN
+#include "esp_log.h"
+#define TAG "WifiLockProfiler"
+
+using namespace std;
+
+static const char* const LOCK_NAMES[WifiLockProfiler::LOCK_COUNT] = {
+    "WifiClient.connected", "WifiDownloader", "WifiEspNow.peers", "WifiHistory", "WifiOutbox",
+    "WifiScanner.results", "WifiStageGraph", "WifiTcpTuner", "WifiTxBatch"
+};
+
+WifiLockProfiler WifiLockProfiler::Singleton;
+
+WifiLockProfiler& WifiLockProfiler::getInstance()
+{
+    return Singleton;
+}
+
+WifiLockProfiler::WifiLockProfiler()
+{
+    thresholdUs = 1000;
+    lock = portMUX_INITIALIZER_UNLOCKED;
+    for (size_t i = 0; i < LOCK_COUNT; i++) {
+        stats[i].name = LOCK_NAMES[i];
+    }
+}
+
+BaseType_t WifiLockProfiler::take(SemaphoreHandle_t mutex, TickType_t wait, Lock id)
+{
+    LockStats& lockStats = stats[(size_t)id];
+
+    if (xSemaphoreTake(mutex, 0) == pdTRUE) {
+        portENTER_CRITICAL(&lock);
+        lockStats.takes++;
+        portEXIT_CRITICAL(&lock);
+        return pdTRUE;
+    }
+    if (wait == 0) {
+        //a try-lock which found the mutex taken
+        portENTER_CRITICAL(&lock);
+        lockStats.contended++;
+        lockStats.timeouts++;
+        portEXIT_CRITICAL(&lock);
+        return pdFALSE;
+    }
+
+    //only the handle, the holder may be deleted any time and its name with it
+    TaskHandle_t holder = xSemaphoreGetMutexHolder(mutex);
+
+    int64_t start = esp_timer_get_time();
+    BaseType_t result = xSemaphoreTake(mutex, wait);
+    uint32_t waitedUs = (uint32_t)(esp_timer_get_time() - start);
+
+    portENTER_CRITICAL(&lock);
+    lockStats.contended++;
+    lockStats.totalWaitUs += waitedUs;
+    if (waitedUs > lockStats.maxWaitUs) {
+        lockStats.maxWaitUs = waitedUs;
+    }
+    if (result == pdTRUE) {
+        lockStats.takes++;
+    } else {
+        lockStats.timeouts++;
+    }
+    bool slow = waitedUs >= thresholdUs;
+    if (slow) {
+        lockStats.slowWaits++;
+        lockStats.lastSlowWaitUs = waitedUs;
+        lockStats.lastHolder = holder;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (slow) {
+        ESP_LOGD(TAG, "%s waited %lu us for task %p", LOCK_NAMES[(size_t)id], (unsigned long)waitedUs, holder);
+    }
+    return result;
+}
+
+void WifiLockProfiler::setThreshold(uint32_t thresholdUs)
+{
+    portENTER_CRITICAL(&lock);
+    this->thresholdUs = thresholdUs;
+    portEXIT_CRITICAL(&lock);
+}
+
+size_t WifiLockProfiler::snapshot(LockStats* snapshot, size_t maxLocks) const
+{
+    size_t count = maxLocks < LOCK_COUNT ? maxLocks : LOCK_COUNT;
+    portENTER_CRITICAL(&Singleton.lock);
+    for (size_t i = 0; i < count; i++) {
+        snapshot[i] = stats[i];
+    }
+    portEXIT_CRITICAL(&Singleton.lock);
+    return count;
+}
+
+void WifiLockProfiler::reset()
+{
+    portENTER_CRITICAL(&lock);
+    for (size_t i = 0; i < LOCK_COUNT; i++) {
+        stats[i] = LockStats();
+        stats[i].name = LOCK_NAMES[i];
+    }
+    portEXIT_CRITICAL(&lock);
+}
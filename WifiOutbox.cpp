@@ -0,0 +1,427 @@
+/*!
+ * @file 	    WifiOutbox.cpp
+ * @brief 	    Singleton store-and-forward outbox for messages produced while offline
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include "WifiOutbox.h"
+
+#include <cstring>
+
+#include "WifiClient.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_memory_utils.h"
+#include "WifiLockProfiler.h"
+
+#define LOG_LOCAL_LEVEL ESP_LOG_WARN
+#include "esp_log.h"
+#define TAG "WifiOutbox"
+
+#define SECTOR_SIZE 4096
+
+using namespace std;
+
+WifiOutbox WifiOutbox::Singleton;
+#if CONFIG_WIFICLIENT_PSRAM_POOLS
+EXT_RAM_BSS_ATTR
+#endif
+WifiOutbox::Message WifiOutbox::messagePool[CONFIG_WIFICLIENT_OUTBOX_SLOTS];
+StackType_t WifiOutbox::taskStack[TASK_STACK_SIZE];
+
+void WifiOutbox_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data)
+{
+    WifiOutbox& outbox = WifiOutbox::Singleton;
+
+    if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        WIFICLIENT_TAKE(outbox.mutex, portMAX_DELAY, OUTBOX);
+        outbox.linkUp = true;
+        xSemaphoreGive(outbox.mutex);
+        xTaskNotifyGive(outbox.task);
+
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        WIFICLIENT_TAKE(outbox.mutex, portMAX_DELAY, OUTBOX);
+        outbox.linkUp = false;
+        xSemaphoreGive(outbox.mutex);
+    }
+}
+
+WifiOutbox& WifiOutbox::getInstance()
+{
+    return Singleton;
+}
+
+WifiOutbox::WifiOutbox()
+{
+    initalized = false;
+    linkUp = false;
+    sequence = 0;
+    tokens = 0;
+    lastRefill = 0;
+    task = NULL;
+    mutex = NULL;
+}
+
+void WifiOutbox::init(Config const& config)
+{
+    const static string EXEP_TAG = "WifiOutbox::init: ";
+    esp_err_t result;
+
+    if (initalized) {
+        return;
+    }
+    if (config.flushRate == 0 || config.flushBurst == 0) {
+        throw invalid_argument(EXEP_TAG + "flushRate and flushBurst must be above 0");
+    }
+    this->config = config;
+
+    if (config.spillPartition != nullptr) {
+        spill.partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+            config.spillPartition);
+        if (spill.partition == NULL) {
+            throw runtime_error(EXEP_TAG + "partition " + config.spillPartition + " not found");
+        }
+        uint32_t sectors = spill.partition->size / SECTOR_SIZE;
+        if (sectors < 2) {
+            throw runtime_error(EXEP_TAG + "spill partition needs at least 2 sectors");
+        }
+        spill.slotsPerSector = SECTOR_SIZE / sizeof(Message);
+        spill.slots = sectors * spill.slotsPerSector;
+    }
+
+    mutex = xSemaphoreCreateMutexStatic(&mutexBuffer);
+    if (mutex == NULL) {
+        throw runtime_error(EXEP_TAG + "mutex could not be created");
+    }
+    tokens = config.flushBurst;
+    lastRefill = esp_timer_get_time();
+    linkUp = WifiClient::getInstance().isConnected();
+
+    task = xTaskCreateStatic(&WifiOutbox::flushTask, "WifiOutbox", TASK_STACK_SIZE, NULL,
+        config.taskPriority, taskStack, &taskBuffer);
+    if (task == NULL) {
+        throw runtime_error(EXEP_TAG + "flush task could not be created");
+    }
+
+    result = esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &WifiOutbox_event_handler, NULL);
+    if (result == ESP_OK) {
+        result = esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &WifiOutbox_event_handler, NULL);
+    }
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "can't register handler, error: " + esp_err_to_name(result));
+    }
+    initalized = true;
+}
+
+int WifiOutbox::addChannel(Deliver deliver, void* context)
+{
+    const static string EXEP_TAG = "WifiOutbox::addChannel: ";
+
+    if (deliver == nullptr) {
+        throw invalid_argument(EXEP_TAG + "deliver must not be nullptr");
+    }
+    if (!initalized) {
+        throw runtime_error(EXEP_TAG + "not initialized");
+    }
+
+    WIFICLIENT_TAKE(mutex, portMAX_DELAY, OUTBOX);
+    for (size_t i = 0; i < MAX_CHANNELS; i++) {
+        if (channels[i].deliver == nullptr) {
+            channels[i].deliver = deliver;
+            channels[i].context = context;
+            xSemaphoreGive(mutex);
+            return i;
+        }
+    }
+    xSemaphoreGive(mutex);
+    throw runtime_error(EXEP_TAG + "no channel left");
+}
+
+WifiOutbox::Result WifiOutbox::post(int channel, const void* data, size_t length, uint8_t priority, uint32_t ttlMs)
+{
+    if (!initalized) {
+        throw runtime_error("WifiOutbox::post: not initialized");
+    }
+    if (channel < 0 || channel >= (int)MAX_CHANNELS || channels[channel].deliver == nullptr) {
+        throw invalid_argument("WifiOutbox::post: invalid channel");
+    }
+    if (length == 0 || length > CONFIG_WIFICLIENT_OUTBOX_PAYLOAD) {
+        throw invalid_argument("WifiOutbox::post: length must be between 1 and CONFIG_WIFICLIENT_OUTBOX_PAYLOAD");
+    }
+
+    int64_t now = esp_timer_get_time();
+    Result result = Result::QUEUED;
+
+    WIFICLIENT_TAKE(mutex, portMAX_DELAY, OUTBOX);
+    dropExpired(now);
+    if (stats.queued >= config.highWater || spill.count > 0) {
+        stats.backpressured++;
+    }
+
+    size_t slot = CONFIG_WIFICLIENT_OUTBOX_SLOTS;
+    for (size_t i = 0; i < CONFIG_WIFICLIENT_OUTBOX_SLOTS; i++) {
+        if (messagePool[i].state == State::FREE) {
+            slot = i;
+            break;
+        }
+    }
+
+    Message* message = &scratch;
+    if (slot < CONFIG_WIFICLIENT_OUTBOX_SLOTS) {
+        message = &messagePool[slot];
+    } else {
+        //the least important message leaves the pool, which may be the new one
+        size_t lowest = victim();
+        if (lowest < CONFIG_WIFICLIENT_OUTBOX_SLOTS && messagePool[lowest].priority < priority) {
+            if (spillWrite(messagePool[lowest])) {
+                result = Result::SPILLED;
+            } else {
+                stats.droppedFull++;
+            }
+            messagePool[lowest].state = State::FREE;
+            stats.queued--;
+            message = &messagePool[lowest];
+        }
+    }
+
+    message->state = State::PENDING;
+    message->channel = channel;
+    message->priority = priority;
+    message->reserved = 0;
+    message->length = length;
+    message->sequence = sequence++;
+    message->expiry = ttlMs == 0 ? INT64_MAX : now + (int64_t)ttlMs * 1000;
+    memcpy(message->data, data, length);
+    stats.posted++;
+
+    if (message == &scratch) {
+        if (spillWrite(scratch)) {
+            result = Result::SPILLED;
+        } else {
+            stats.droppedFull++;
+            result = Result::DROPPED;
+        }
+    } else {
+        stats.queued++;
+        if (stats.queued > stats.maxQueued) {
+            stats.maxQueued = stats.queued;
+        }
+    }
+    xSemaphoreGive(mutex);
+
+    xTaskNotifyGive(task);
+    return result;
+}
+
+bool WifiOutbox::isBackpressured() const
+{
+    if (!initalized) {
+        return false;
+    }
+    WIFICLIENT_TAKE(Singleton.mutex, portMAX_DELAY, OUTBOX);
+    bool result = Singleton.stats.queued >= config.highWater || Singleton.spill.count > 0;
+    xSemaphoreGive(Singleton.mutex);
+    return result;
+}
+
+size_t WifiOutbox::getExternalBytes() const
+{
+    return esp_ptr_external_ram(messagePool) ? sizeof(messagePool) : 0;
+}
+
+WifiOutbox::Stats WifiOutbox::getStats() const
+{
+    if (!initalized) {
+        return Stats();
+    }
+    WIFICLIENT_TAKE(Singleton.mutex, portMAX_DELAY, OUTBOX);
+    Stats result = Singleton.stats;
+    xSemaphoreGive(Singleton.mutex);
+    return result;
+}
+
+void WifiOutbox::dropExpired(int64_t now)
+{
+    for (size_t i = 0; i < CONFIG_WIFICLIENT_OUTBOX_SLOTS; i++) {
+        if (messagePool[i].state == State::PENDING && messagePool[i].expiry <= now) {
+            messagePool[i].state = State::FREE;
+            stats.queued--;
+            stats.droppedExpired++;
+        }
+    }
+}
+
+size_t WifiOutbox::next() const
+{
+    size_t result = CONFIG_WIFICLIENT_OUTBOX_SLOTS;
+    for (size_t i = 0; i < CONFIG_WIFICLIENT_OUTBOX_SLOTS; i++) {
+        Message const& message = messagePool[i];
+        if (message.state != State::PENDING) {
+            continue;
+        }
+        //sequence differences stay correct across the wrap
+        if (result == CONFIG_WIFICLIENT_OUTBOX_SLOTS || message.priority > messagePool[result].priority ||
+            (message.priority == messagePool[result].priority &&
+            (int32_t)(message.sequence - messagePool[result].sequence) < 0)) {
+            result = i;
+        }
+    }
+    return result;
+}
+
+size_t WifiOutbox::victim() const
+{
+    size_t result = CONFIG_WIFICLIENT_OUTBOX_SLOTS;
+    for (size_t i = 0; i < CONFIG_WIFICLIENT_OUTBOX_SLOTS; i++) {
+        Message const& message = messagePool[i];
+        if (message.state != State::PENDING) {
+            continue;
+        }
+        if (result == CONFIG_WIFICLIENT_OUTBOX_SLOTS || message.priority < messagePool[result].priority ||
+            (message.priority == messagePool[result].priority &&
+            (int32_t)(message.sequence - messagePool[result].sequence) > 0)) {
+            result = i;
+        }
+    }
+    return result;
+}
+
+bool WifiOutbox::spillWrite(Message const& message)
+{
+    //one sector stays free, it is erased before the ring enters it
+    if (spill.partition == nullptr || spill.count >= spill.slots - spill.slotsPerSector) {
+        return false;
+    }
+
+    uint32_t slot = (spill.read + spill.count) % spill.slots;
+    uint32_t sector = slot / spill.slotsPerSector;
+    esp_err_t result = ESP_OK;
+    if (slot % spill.slotsPerSector == 0) {
+        result = esp_partition_erase_range(spill.partition, sector * SECTOR_SIZE, SECTOR_SIZE);
+    }
+    if (result == ESP_OK) {
+        result = esp_partition_write(spill.partition,
+            sector * SECTOR_SIZE + (slot % spill.slotsPerSector) * sizeof(Message), &message, sizeof(Message));
+    }
+    if (result != ESP_OK) {
+        ESP_LOGW(TAG, "spill write failed with error: %s", esp_err_to_name(result));
+        stats.spillErrors++;
+        return false;
+    }
+
+    spill.count++;
+    stats.spilled++;
+    stats.spillQueued = spill.count;
+    return true;
+}
+
+void WifiOutbox::restore(int64_t now)
+{
+    size_t slot = 0;
+    while (spill.count > 0) {
+        while (slot < CONFIG_WIFICLIENT_OUTBOX_SLOTS && messagePool[slot].state != State::FREE) {
+            slot++;
+        }
+        if (slot == CONFIG_WIFICLIENT_OUTBOX_SLOTS) {
+            break;
+        }
+
+        Message& message = messagePool[slot];
+        uint32_t sector = spill.read / spill.slotsPerSector;
+        esp_err_t result = esp_partition_read(spill.partition,
+            sector * SECTOR_SIZE + (spill.read % spill.slotsPerSector) * sizeof(Message), &message, sizeof(Message));
+        spill.read = (spill.read + 1) % spill.slots;
+        spill.count--;
+        stats.spillQueued = spill.count;
+
+        if (result != ESP_OK || message.channel >= MAX_CHANNELS || message.length > CONFIG_WIFICLIENT_OUTBOX_PAYLOAD) {
+            ESP_LOGW(TAG, "spilled message lost, error: %s", esp_err_to_name(result));
+            message.state = State::FREE;
+            stats.spillErrors++;
+        } else if (message.expiry <= now) {
+            message.state = State::FREE;
+            stats.droppedExpired++;
+        } else {
+            message.state = State::PENDING;
+            stats.restored++;
+            stats.queued++;
+            if (stats.queued > stats.maxQueued) {
+                stats.maxQueued = stats.queued;
+            }
+        }
+    }
+}
+
+void WifiOutbox::flushTask(void* arg)
+{
+    const Config& config = Singleton.config;
+    int64_t tokenInterval = 1000000 / config.flushRate;
+
+    while (true) {
+        int64_t now = esp_timer_get_time();
+        size_t index = CONFIG_WIFICLIENT_OUTBOX_SLOTS;
+        TickType_t wait = portMAX_DELAY;
+
+        WIFICLIENT_TAKE(Singleton.mutex, portMAX_DELAY, OUTBOX);
+        Singleton.dropExpired(now);
+        Singleton.restore(now);
+
+        if (Singleton.linkUp) {
+            //token bucket, full after an idle time
+            uint32_t refill = (now - Singleton.lastRefill) / tokenInterval;
+            if (Singleton.tokens + refill >= config.flushBurst) {
+                Singleton.tokens = config.flushBurst;
+                Singleton.lastRefill = now;
+            } else if (refill > 0) {
+                Singleton.tokens += refill;
+                Singleton.lastRefill += refill * tokenInterval;
+            }
+
+            index = Singleton.next();
+            if (index < CONFIG_WIFICLIENT_OUTBOX_SLOTS && Singleton.tokens == 0) {
+                wait = pdMS_TO_TICKS((Singleton.lastRefill + tokenInterval - now + 999) / 1000);
+                if (wait == 0) {
+                    wait = 1;
+                }
+                index = CONFIG_WIFICLIENT_OUTBOX_SLOTS;
+            } else if (index < CONFIG_WIFICLIENT_OUTBOX_SLOTS) {
+                Singleton.tokens--;
+                messagePool[index].state = State::SENDING;
+            }
+        }
+        xSemaphoreGive(Singleton.mutex);
+
+        if (index == CONFIG_WIFICLIENT_OUTBOX_SLOTS) {
+            //post() and the ip event wake the task early
+            ulTaskNotifyTake(pdTRUE, wait);
+            continue;
+        }
+
+        //the slot is SENDING, nobody else touches it while the callback runs
+        Message& message = messagePool[index];
+        Channel channel = Singleton.channels[message.channel];
+        bool delivered = channel.deliver(channel.context, message.data, message.length);
+
+        WIFICLIENT_TAKE(Singleton.mutex, portMAX_DELAY, OUTBOX);
+        if (delivered) {
+            message.state = State::FREE;
+            Singleton.stats.queued--;
+            Singleton.stats.delivered++;
+        } else {
+            message.state = State::PENDING;
+            Singleton.stats.deliverFailures++;
+        }
+        xSemaphoreGive(Singleton.mutex);
+
+        if (!delivered) {
+            ESP_LOGW(TAG, "delivery on channel %u failed", (unsigned)message.channel);
+            vTaskDelay(pdMS_TO_TICKS(config.retryMs));
+        }
+    }
+}
@@ -0,0 +1,312 @@
+/*!
+ * @file 	    WifiScanner.cpp
+ * @brief 	    Singleton background scanner which scans one channel per slice
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include "WifiScanner.h"
+
+#include <algorithm>
+
+#include "WifiClient.h"
+#include "esp_attr.h"
+#include "esp_memory_utils.h"
+#include "WifiLockProfiler.h"
+#if CONFIG_WIFICLIENT_TRACE
+#include "WifiTrace.h"
+#endif
+
+#define LOG_LOCAL_LEVEL ESP_LOG_WARN
+#include "esp_log.h"
+#define TAG "WifiScanner"
+
+#define MAX_CHANNEL 14
+
+using namespace std;
+
+WifiScanner WifiScanner::Singleton;
+#if CONFIG_WIFICLIENT_PSRAM_POOLS
+EXT_RAM_BSS_ATTR
+#endif
+WifiScanner::Result WifiScanner::results[CONFIG_WIFICLIENT_SCAN_CACHE_SIZE];
+wifi_ap_record_t WifiScanner::records[RECORDS_PER_SLICE];
+
+void WifiScanner_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data)
+{
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_SCAN_DONE) {
+        wifi_event_sta_scan_done_t* event = (wifi_event_sta_scan_done_t*)event_data;
+
+        portENTER_CRITICAL(&WifiScanner::Singleton.stateLock);
+        bool ownSlice = WifiScanner::Singleton.scanning;
+        portEXIT_CRITICAL(&WifiScanner::Singleton.stateLock);
+
+        if (ownSlice) {
+            WifiScanner::sliceDone(event->status == 0);
+        }
+    }
+}
+
+WifiScanner& WifiScanner::getInstance()
+{
+    return Singleton;
+}
+
+WifiScanner::WifiScanner()
+{
+    running = false;
+    latencyCritical = false;
+    scanning = false;
+    channel = 1;
+    sliceStart = 0;
+    complete = false;
+    resultCount = 0;
+    resultMutex = NULL;
+    timer = NULL;
+    stateLock = portMUX_INITIALIZER_UNLOCKED;
+}
+
+void WifiScanner::start(Config const& config)
+{
+    const static string EXEP_TAG = "WifiScanner::start: ";
+    esp_err_t result;
+
+    if ((config.channelMask & (((1 << MAX_CHANNEL) - 1) << 1)) == 0) {
+        throw invalid_argument(EXEP_TAG + "channelMask selects no channel");
+    }
+
+    if (timer == NULL) {
+        resultMutex = xSemaphoreCreateMutexStatic(&resultMutexBuffer);
+        if (resultMutex == NULL) {
+            throw runtime_error(EXEP_TAG + "mutex could not be created");
+        }
+
+        esp_timer_create_args_t timerArgs;
+        memset(&timerArgs, 0, sizeof(esp_timer_create_args_t));
+        timerArgs.callback = &WifiScanner::sliceTimer;
+        timerArgs.name = "WifiScanner";
+        result = esp_timer_create(&timerArgs, &timer);
+        if (result != ESP_OK) {
+            throw runtime_error(EXEP_TAG + "timer create failed with error: " + esp_err_to_name(result));
+        }
+
+        result = esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_SCAN_DONE, &WifiScanner_event_handler, NULL);
+        if (result != ESP_OK) {
+            throw runtime_error(EXEP_TAG + "can't register handler, error: " + esp_err_to_name(result));
+        }
+    }
+
+    portENTER_CRITICAL(&stateLock);
+    this->config = config;
+    channel = 1;
+    while ((config.channelMask & (1 << channel)) == 0) {
+        channel++;
+    }
+    complete = false;
+    running = true;
+    portEXIT_CRITICAL(&stateLock);
+
+    scheduleSlice();
+}
+
+void WifiScanner::stop()
+{
+    portENTER_CRITICAL(&stateLock);
+    running = false;
+    bool abort = scanning;
+    scanning = false;
+    portEXIT_CRITICAL(&stateLock);
+
+    if (timer != NULL) {
+        esp_timer_stop(timer);
+    }
+    if (abort) {
+        esp_wifi_scan_stop();
+        esp_wifi_clear_ap_list();
+    }
+}
+
+void WifiScanner::setLatencyCritical(bool critical)
+{
+    portENTER_CRITICAL(&stateLock);
+    latencyCritical = critical;
+    bool abort = critical && scanning;
+    if (abort) {
+        scanning = false;
+    }
+    portEXIT_CRITICAL(&stateLock);
+
+    if (abort) {
+        //return to the home channel now, the channel is scanned again later
+        esp_wifi_scan_stop();
+        esp_wifi_clear_ap_list();
+        scheduleSlice();
+    }
+}
+
+size_t WifiScanner::getExternalBytes() const
+{
+    return esp_ptr_external_ram(results) ? sizeof(results) : 0;
+}
+
+size_t WifiScanner::getResults(Result* results, size_t maxResults) const
+{
+    if (resultMutex == NULL) {
+        return 0;
+    }
+
+    WIFICLIENT_TAKE(resultMutex, portMAX_DELAY, SCANNER_RESULTS);
+    size_t count = min(resultCount, maxResults);
+    //partial sort, so the strongest results are copied if maxResults is smaller
+    partial_sort_copy(WifiScanner::results, WifiScanner::results + resultCount, results, results + count,
+        [](Result const& a, Result const& b) { return a.rssi > b.rssi; });
+    xSemaphoreGive(resultMutex);
+    return count;
+}
+
+bool WifiScanner::isComplete() const
+{
+    portENTER_CRITICAL(&Singleton.stateLock);
+    bool result = Singleton.complete;
+    portEXIT_CRITICAL(&Singleton.stateLock);
+    return result;
+}
+
+void WifiScanner::scheduleSlice()
+{
+    portENTER_CRITICAL(&Singleton.stateLock);
+    bool running = Singleton.running;
+    uint32_t interval = Singleton.config.sliceIntervalMs;
+    portEXIT_CRITICAL(&Singleton.stateLock);
+
+    if (running) {
+        esp_timer_stop(Singleton.timer);
+        esp_timer_start_once(Singleton.timer, (uint64_t)interval * 1000);
+    }
+}
+
+void WifiScanner::sliceTimer(void* arg)
+{
+    portENTER_CRITICAL(&Singleton.stateLock);
+    bool start = Singleton.running && !Singleton.latencyCritical && !Singleton.scanning;
+    uint8_t channel = Singleton.channel;
+    uint16_t dwell = Singleton.config.dwellMs;
+    bool passive = Singleton.config.passive;
+    portEXIT_CRITICAL(&Singleton.stateLock);
+
+    //while disconnected the driver scans for the AP anyway, under memory
+    //pressure the driver can't allocate the result list
+    WifiClient& client = WifiClient::getInstance();
+    if (!start || !client.isConnected() || client.getMemoryPressure() != WifiClient::MemoryPressure::NORMAL) {
+        scheduleSlice();
+        return;
+    }
+
+    wifi_scan_config_t scanConfig;
+    memset(&scanConfig, 0, sizeof(wifi_scan_config_t));
+    scanConfig.channel = channel;
+    scanConfig.show_hidden = false;
+    if (passive) {
+        scanConfig.scan_type = WIFI_SCAN_TYPE_PASSIVE;
+        scanConfig.scan_time.passive = dwell;
+    } else {
+        scanConfig.scan_type = WIFI_SCAN_TYPE_ACTIVE;
+        scanConfig.scan_time.active.min = 0;
+        scanConfig.scan_time.active.max = dwell;
+    }
+
+    portENTER_CRITICAL(&Singleton.stateLock);
+    Singleton.scanning = true;
+    Singleton.sliceStart = esp_timer_get_time();
+    portEXIT_CRITICAL(&Singleton.stateLock);
+
+    esp_err_t result = esp_wifi_scan_start(&scanConfig, false);
+    if (result != ESP_OK) {
+        ESP_LOGW(TAG, "esp_wifi_scan_start had an error: %s", esp_err_to_name(result));
+        portENTER_CRITICAL(&Singleton.stateLock);
+        Singleton.scanning = false;
+        portEXIT_CRITICAL(&Singleton.stateLock);
+        scheduleSlice();
+    }
+}
+
+void WifiScanner::sliceDone(bool success)
+{
+    uint16_t number = RECORDS_PER_SLICE;
+    if (!success || esp_wifi_scan_get_ap_records(&number, records) != ESP_OK) {
+        number = 0;
+        esp_wifi_clear_ap_list();
+    }
+
+    int64_t now = esp_timer_get_time();
+    WIFICLIENT_TAKE(Singleton.resultMutex, portMAX_DELAY, SCANNER_RESULTS);
+    for (uint16_t i = 0; i < number; i++) {
+        wifi_ap_record_t const& record = records[i];
+        size_t slot = Singleton.resultCount;
+        size_t oldest = 0;
+        for (size_t j = 0; j < Singleton.resultCount; j++) {
+            if (memcmp(results[j].bssid, record.bssid, 6) == 0) {
+                slot = j;
+                break;
+            }
+            if (results[j].lastSeen < results[oldest].lastSeen) {
+                oldest = j;
+            }
+        }
+        if (slot == Singleton.resultCount) {
+            if (Singleton.resultCount < CONFIG_WIFICLIENT_SCAN_CACHE_SIZE) {
+                Singleton.resultCount++;
+            } else {
+                slot = oldest;
+            }
+        }
+        Result& entry = results[slot];
+        memcpy(entry.bssid, record.bssid, 6);
+        memcpy(entry.ssid, record.ssid, sizeof(entry.ssid));
+        entry.ssid[sizeof(entry.ssid) - 1] = '\0';
+        entry.channel = record.primary;
+        entry.rssi = record.rssi;
+        entry.authmode = record.authmode;
+        entry.lastSeen = now;
+    }
+
+    //remove outdated results
+    int64_t maxAge = (int64_t)Singleton.config.resultMaxAgeMs * 1000;
+    for (size_t j = 0; j < Singleton.resultCount;) {
+        if (now - results[j].lastSeen > maxAge) {
+            results[j] = results[--Singleton.resultCount];
+        } else {
+            j++;
+        }
+    }
+    xSemaphoreGive(Singleton.resultMutex);
+
+    portENTER_CRITICAL(&Singleton.stateLock);
+#if CONFIG_WIFICLIENT_TRACE
+    int64_t sliceStart = Singleton.sliceStart;
+    uint8_t sliceChannel = Singleton.channel;
+#endif
+    Singleton.scanning = false;
+    if (success) {
+        uint8_t previous = Singleton.channel;
+        uint8_t next = previous;
+        do {
+            next = next >= MAX_CHANNEL ? 1 : next + 1;
+        } while ((Singleton.config.channelMask & (1 << next)) == 0);
+        if (next <= previous) {
+            Singleton.complete = true;
+        }
+        Singleton.channel = next;
+    }
+    portEXIT_CRITICAL(&Singleton.stateLock);
+
+#if CONFIG_WIFICLIENT_TRACE
+    WifiTrace::getInstance().add(success ? "scan slice" : "scan slice failed", (uint16_t)WifiTrace::Track::CONNECTION,
+        sliceStart, (uint32_t)(now - sliceStart), sliceChannel);
+#endif
+
+    scheduleSlice();
+}
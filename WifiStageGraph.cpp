@@ -0,0 +1,241 @@
+/*!
+ * @file 	    WifiStageGraph.cpp
+ * @brief 	    Singleton graph of post-connect stages which run concurrently
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include "WifiStageGraph.h"
+
+#include "WifiClient.h"
+#include "esp_timer.h"
+#include "WifiLockProfiler.h"
+
+#define LOG_LOCAL_LEVEL ESP_LOG_WARN
+#include "esp_log.h"
+#define TAG "WifiStageGraph"
+
+using namespace std;
+
+WifiStageGraph WifiStageGraph::Singleton;
+StackType_t WifiStageGraph::controlStack[CONTROL_STACK_SIZE];
+StackType_t WifiStageGraph::workerStacks[CONFIG_WIFICLIENT_STAGE_WORKERS][CONFIG_WIFICLIENT_STAGE_STACK_SIZE];
+uint8_t WifiStageGraph::jobStorage[CONFIG_WIFICLIENT_MAX_STAGES * sizeof(Job)];
+
+WifiStageGraph& WifiStageGraph::getInstance()
+{
+    return Singleton;
+}
+
+WifiStageGraph::WifiStageGraph()
+{
+    started = false;
+    stageCount = 0;
+    run = 0;
+    cancelled = false;
+    runStart = 0;
+    eventQueue = NULL;
+    jobs = NULL;
+    mutex = NULL;
+}
+
+uint8_t WifiStageGraph::addStage(const char* name, StageFunction function, void* arg, uint32_t dependencies)
+{
+    const static string EXEP_TAG = "WifiStageGraph::addStage: ";
+
+    if (started) {
+        throw runtime_error(EXEP_TAG + "stages can't be added after start");
+    }
+    if (stageCount >= CONFIG_WIFICLIENT_MAX_STAGES) {
+        throw runtime_error(EXEP_TAG + "too many stages");
+    }
+    //dependencies must be registered before, so the graph can't have cycles
+    if ((dependencies >> stageCount) != 0) {
+        throw invalid_argument(EXEP_TAG + "dependency is not registered");
+    }
+
+    Stage& stage = stages[stageCount];
+    stage.name = name;
+    stage.function = function;
+    stage.arg = arg;
+    stage.dependencies = dependencies;
+    stage.timing = StageTiming();
+    stage.timing.name = name;
+    return stageCount++;
+}
+
+void WifiStageGraph::start(UBaseType_t taskPriority)
+{
+    const static string EXEP_TAG = "WifiStageGraph::start: ";
+
+    if (started) {
+        return;
+    }
+
+    mutex = xSemaphoreCreateMutexStatic(&mutexBuffer);
+    jobs = xQueueCreateStatic(CONFIG_WIFICLIENT_MAX_STAGES, sizeof(Job), jobStorage, &jobsBuffer);
+    if (mutex == NULL || jobs == NULL) {
+        throw runtime_error(EXEP_TAG + "synchronization objects could not be created");
+    }
+
+    WifiClient::getInstance().registerEventReceiver(eventQueue, 2,
+        WifiClient::eventBit(WifiClient::Event::CONNECTED) | WifiClient::eventBit(WifiClient::Event::DISCONNECTED));
+
+    for (int i = 0; i < CONFIG_WIFICLIENT_STAGE_WORKERS; i++) {
+        TaskHandle_t worker = xTaskCreateStatic(&WifiStageGraph::workerTask, "WifiStageWorker",
+            CONFIG_WIFICLIENT_STAGE_STACK_SIZE, NULL, taskPriority, workerStacks[i], &workerTaskBuffers[i]);
+        if (worker == NULL) {
+            throw runtime_error(EXEP_TAG + "worker task could not be created");
+        }
+    }
+
+    TaskHandle_t control = xTaskCreateStatic(&WifiStageGraph::controlTask, "WifiStageControl",
+        CONTROL_STACK_SIZE, NULL, taskPriority, controlStack, &controlTaskBuffer);
+    if (control == NULL) {
+        throw runtime_error(EXEP_TAG + "control task could not be created");
+    }
+    started = true;
+}
+
+bool WifiStageGraph::isCancelled(uint32_t run) const
+{
+    if (mutex == NULL) {
+        //no run exists before start
+        return true;
+    }
+    WIFICLIENT_TAKE(mutex, portMAX_DELAY, STAGE_GRAPH);
+    bool result = run != this->run || cancelled;
+    xSemaphoreGive(mutex);
+    return result;
+}
+
+size_t WifiStageGraph::getTimings(StageTiming* timings, size_t maxTimings) const
+{
+    if (mutex == NULL) {
+        return 0;
+    }
+
+    WIFICLIENT_TAKE(mutex, portMAX_DELAY, STAGE_GRAPH);
+    size_t count = stageCount < maxTimings ? stageCount : maxTimings;
+    for (size_t i = 0; i < count; i++) {
+        timings[i] = stages[i].timing;
+    }
+    xSemaphoreGive(mutex);
+    return count;
+}
+
+void WifiStageGraph::dispatchReady()
+{
+    uint32_t now = (uint32_t)(esp_timer_get_time() - runStart);
+    uint32_t done = 0;
+    uint32_t broken = 0;
+    for (size_t i = 0; i < stageCount; i++) {
+        State state = stages[i].timing.state;
+        if (state == State::DONE) {
+            done |= 1u << i;
+        } else if (state == State::FAILED || state == State::SKIPPED) {
+            broken |= 1u << i;
+        }
+    }
+
+    //dependencies always have lower ids, so one pass propagates skips
+    for (size_t i = 0; i < stageCount; i++) {
+        Stage& stage = stages[i];
+        if (stage.timing.state != State::PENDING) {
+            continue;
+        }
+        if ((stage.dependencies & broken) != 0) {
+            stage.timing.state = State::SKIPPED;
+            broken |= 1u << i;
+        } else if ((stage.dependencies & done) == stage.dependencies) {
+            Job job = { (uint8_t)i, run };
+            stage.timing.queuedUs = now;
+            //every stage is queued once per run, stale runs are reset, so this only fails on a broken queue
+            if (xQueueSend(jobs, &job, 0) == pdTRUE) {
+                stage.timing.state = State::QUEUED;
+            } else {
+                ESP_LOGE(TAG, "stage %s could not be queued", stage.name);
+                stage.timing.state = State::FAILED;
+                broken |= 1u << i;
+            }
+        }
+    }
+}
+
+void WifiStageGraph::controlTask(void* arg)
+{
+    WifiClient::Event event;
+
+    while (true) {
+        if (xQueueReceive(Singleton.eventQueue, &event, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        WIFICLIENT_TAKE(Singleton.mutex, portMAX_DELAY, STAGE_GRAPH);
+        if (event == WifiClient::Event::CONNECTED) {
+            //a new run replaces an old one, jobs taken before the reset are dropped by the workers
+            xQueueReset(Singleton.jobs);
+            Singleton.run++;
+            Singleton.cancelled = false;
+            Singleton.runStart = esp_timer_get_time();
+            for (size_t i = 0; i < Singleton.stageCount; i++) {
+                Singleton.stages[i].timing = StageTiming();
+                Singleton.stages[i].timing.name = Singleton.stages[i].name;
+                Singleton.stages[i].timing.state = State::PENDING;
+            }
+            Singleton.dispatchReady();
+        } else if (event == WifiClient::Event::DISCONNECTED && Singleton.run != 0 && !Singleton.cancelled) {
+            Singleton.cancelled = true;
+            for (size_t i = 0; i < Singleton.stageCount; i++) {
+                State& state = Singleton.stages[i].timing.state;
+                if (state == State::PENDING || state == State::QUEUED) {
+                    state = State::CANCELLED;
+                }
+            }
+            ESP_LOGI(TAG, "run %lu cancelled", (unsigned long)Singleton.run);
+        }
+        xSemaphoreGive(Singleton.mutex);
+    }
+}
+
+void WifiStageGraph::workerTask(void* arg)
+{
+    Job job;
+
+    while (true) {
+        if (xQueueReceive(Singleton.jobs, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        WIFICLIENT_TAKE(Singleton.mutex, portMAX_DELAY, STAGE_GRAPH);
+        Stage& stage = Singleton.stages[job.stage];
+        bool current = job.run == Singleton.run && stage.timing.state == State::QUEUED;
+        if (current) {
+            stage.timing.state = State::RUNNING;
+            stage.timing.startUs = (uint32_t)(esp_timer_get_time() - Singleton.runStart);
+        }
+        xSemaphoreGive(Singleton.mutex);
+
+        if (!current) {
+            continue;
+        }
+
+        int64_t begin = esp_timer_get_time();
+        bool success = stage.function(stage.arg, job.run);
+        uint32_t duration = (uint32_t)(esp_timer_get_time() - begin);
+
+        WIFICLIENT_TAKE(Singleton.mutex, portMAX_DELAY, STAGE_GRAPH);
+        if (job.run == Singleton.run) {
+            stage.timing.durationUs = duration;
+            if (Singleton.cancelled) {
+                stage.timing.state = State::CANCELLED;
+            } else {
+                stage.timing.state = success ? State::DONE : State::FAILED;
+                Singleton.dispatchReady();
+            }
+        }
+        xSemaphoreGive(Singleton.mutex);
+    }
+}
@@ -0,0 +1,193 @@
+/*!
+ * @file 	    WifiTcpTuner.cpp
+ * @brief 	    Singleton TCP socket tuning driven by the WifiClient link quality
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include "WifiTcpTuner.h"
+
+#include <sys/time.h>
+
+#include "WifiClient.h"
+#include "lwip/sockets.h"
+#include "WifiLockProfiler.h"
+
+#define LOG_LOCAL_LEVEL ESP_LOG_WARN
+#include "esp_log.h"
+#define TAG "WifiTcpTuner"
+
+using namespace std;
+
+WifiTcpTuner WifiTcpTuner::Singleton;
+StackType_t WifiTcpTuner::taskStack[TASK_STACK_SIZE];
+
+WifiTcpTuner& WifiTcpTuner::getInstance()
+{
+    return Singleton;
+}
+
+WifiTcpTuner::WifiTcpTuner()
+{
+    initalized = false;
+    eventQueue = NULL;
+    task = NULL;
+    mutex = NULL;
+}
+
+void WifiTcpTuner::init(Config const& config)
+{
+    const static string EXEP_TAG = "WifiTcpTuner::init: ";
+
+    if (initalized) {
+        return;
+    }
+    this->config = config;
+
+    mutex = xSemaphoreCreateMutexStatic(&mutexBuffer);
+    if (mutex == NULL) {
+        throw runtime_error(EXEP_TAG + "mutex could not be created");
+    }
+    WifiClient::getInstance().registerEventReceiver(eventQueue, 2,
+        WifiClient::eventBit(WifiClient::Event::LINK_QUALITY_CHANGED));
+
+    task = xTaskCreateStatic(&WifiTcpTuner::tuneTask, "WifiTcpTuner", TASK_STACK_SIZE, NULL,
+        config.taskPriority, taskStack, &taskBuffer);
+    if (task == NULL) {
+        throw runtime_error(EXEP_TAG + "tuning task could not be created");
+    }
+    stats.lastQuality = (int)WifiClient::getInstance().getLinkQuality();
+    initalized = true;
+}
+
+void WifiTcpTuner::add(int socket, uint8_t options)
+{
+    const static string EXEP_TAG = "WifiTcpTuner::add: ";
+
+    if (!initalized) {
+        throw runtime_error(EXEP_TAG + "not initialized");
+    }
+    if (options == 0 || (options & ~ALL_OPTIONS) != 0) {
+        throw invalid_argument(EXEP_TAG + "options must be a combination of NO_DELAY, KEEPALIVE and SEND_TIMEOUT");
+    }
+
+    WIFICLIENT_TAKE(mutex, portMAX_DELAY, TCP_TUNER);
+    size_t slot = MAX_SOCKETS;
+    for (size_t i = 0; i < MAX_SOCKETS; i++) {
+        if (sockets[i].socket == socket) {
+            slot = i;
+            break;
+        }
+        if (sockets[i].socket < 0 && slot == MAX_SOCKETS) {
+            slot = i;
+        }
+    }
+    if (slot == MAX_SOCKETS) {
+        xSemaphoreGive(mutex);
+        throw runtime_error(EXEP_TAG + "no socket slot left");
+    }
+    sockets[slot].socket = socket;
+    sockets[slot].options = options;
+    apply(sockets[slot], currentProfile());
+    xSemaphoreGive(mutex);
+}
+
+void WifiTcpTuner::remove(int socket)
+{
+    if (!initalized) {
+        return;
+    }
+    WIFICLIENT_TAKE(mutex, portMAX_DELAY, TCP_TUNER);
+    for (size_t i = 0; i < MAX_SOCKETS; i++) {
+        if (sockets[i].socket == socket) {
+            sockets[i] = Socket();
+        }
+    }
+    xSemaphoreGive(mutex);
+}
+
+WifiTcpTuner::Stats WifiTcpTuner::getStats() const
+{
+    WIFICLIENT_TAKE(mutex, portMAX_DELAY, TCP_TUNER);
+    Stats result = stats;
+    xSemaphoreGive(mutex);
+    return result;
+}
+
+void WifiTcpTuner::tuneTask(void* arg)
+{
+    WifiClient::Event event;
+
+    while (true) {
+        //the receiver only gets LINK_QUALITY_CHANGED
+        if (xQueueReceive(Singleton.eventQueue, &event, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        WIFICLIENT_TAKE(Singleton.mutex, portMAX_DELAY, TCP_TUNER);
+        Profile const& profile = Singleton.currentProfile();
+        for (size_t i = 0; i < MAX_SOCKETS; i++) {
+            if (Singleton.sockets[i].socket >= 0) {
+                Singleton.apply(Singleton.sockets[i], profile);
+            }
+        }
+        Singleton.stats.changes++;
+        Singleton.stats.lastQuality = (int)WifiClient::getInstance().getLinkQuality();
+        xSemaphoreGive(Singleton.mutex);
+        ESP_LOGI(TAG, "link quality %d applied", Singleton.stats.lastQuality);
+    }
+}
+
+WifiTcpTuner::Profile const& WifiTcpTuner::currentProfile() const
+{
+    switch (WifiClient::getInstance().getLinkQuality()) {
+        case WifiClient::LinkQuality::POOR:
+            return config.poor;
+        case WifiClient::LinkQuality::FAIR:
+            return config.fair;
+        default:
+            return config.good;
+    }
+}
+
+void WifiTcpTuner::apply(Socket const& socket, Profile const& profile)
+{
+    int noDelay = profile.noDelay ? 1 : 0;
+    int keepAlive = 1;
+    int keepIdle = profile.keepIdleS;
+    int keepInterval = profile.keepIntervalS;
+    int keepCount = profile.keepCount;
+    struct timeval sendTimeout;
+    sendTimeout.tv_sec = profile.sendTimeoutMs / 1000;
+    sendTimeout.tv_usec = (profile.sendTimeoutMs % 1000) * 1000;
+    int s = socket.socket;
+
+    //options the socket is not registered for and 0 values keep the value of the application
+    uint32_t errors = 0;
+    if (socket.options & NO_DELAY) {
+        errors += setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay)) != 0;
+    }
+    if (socket.options & KEEPALIVE) {
+        errors += setsockopt(s, SOL_SOCKET, SO_KEEPALIVE, &keepAlive, sizeof(keepAlive)) != 0;
+        if (keepIdle > 0) {
+            errors += setsockopt(s, IPPROTO_TCP, TCP_KEEPIDLE, &keepIdle, sizeof(keepIdle)) != 0;
+        }
+        if (keepInterval > 0) {
+            errors += setsockopt(s, IPPROTO_TCP, TCP_KEEPINTVL, &keepInterval, sizeof(keepInterval)) != 0;
+        }
+        if (keepCount > 0) {
+            errors += setsockopt(s, IPPROTO_TCP, TCP_KEEPCNT, &keepCount, sizeof(keepCount)) != 0;
+        }
+    }
+    if ((socket.options & SEND_TIMEOUT) && profile.sendTimeoutMs > 0) {
+        errors += setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout)) != 0;
+    }
+
+    if (errors > 0) {
+        ESP_LOGW(TAG, "socket %d rejected %lu options", s, (unsigned long)errors);
+    }
+    stats.optionErrors += errors;
+    stats.applied++;
+}
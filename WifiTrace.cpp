@@ -0,0 +1,231 @@
+/*!
+ * @file 	    WifiTrace.cpp
+ * @brief 	    Singleton span recorder with Chrome trace event export
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include "WifiTrace.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_memory_utils.h"
+
+#define LOG_LOCAL_LEVEL ESP_LOG_WARN
+#include "esp_log.h"
+#define TAG "WifiTrace"
+
+using namespace std;
+
+WifiTrace WifiTrace::Singleton;
+#if CONFIG_WIFICLIENT_PSRAM_POOLS
+EXT_RAM_BSS_ATTR
+#endif
+WifiTrace::Span WifiTrace::spans[CONFIG_WIFICLIENT_TRACE_SPANS];
+
+/*!
+ * @brief   Writes a zero terminated string
+ */
+static void write(WifiTrace::Writer writer, void* context, const char* text)
+{
+    writer(context, text, strlen(text));
+}
+
+WifiTrace& WifiTrace::getInstance()
+{
+    return Singleton;
+}
+
+WifiTrace::WifiTrace()
+{
+    enabled = true;
+    //id 0 is returned for spans which are not recorded
+    nextId = 1;
+    lock = portMUX_INITIALIZER_UNLOCKED;
+}
+
+void WifiTrace::setEnabled(bool enabled)
+{
+    portENTER_CRITICAL(&lock);
+    this->enabled = enabled;
+    portEXIT_CRITICAL(&lock);
+}
+
+uint32_t WifiTrace::begin(const char* name, uint16_t track, uint32_t arg)
+{
+    return record(name, track, esp_timer_get_time(), OPEN, arg, false);
+}
+
+void WifiTrace::end(uint32_t id)
+{
+    int64_t now = esp_timer_get_time();
+    if (id == 0) {
+        return;
+    }
+
+    portENTER_CRITICAL(&lock);
+    Span& span = spans[id % CONFIG_WIFICLIENT_TRACE_SPANS];
+    if (span.id == id && span.durationUs == OPEN) {
+        span.durationUs = (uint32_t)(now - span.startUs);
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void WifiTrace::add(const char* name, uint16_t track, int64_t startUs, uint32_t durationUs, uint32_t arg)
+{
+    record(name, track, startUs, durationUs, arg, false);
+}
+
+void WifiTrace::instant(const char* name, uint16_t track, uint32_t arg)
+{
+    record(name, track, esp_timer_get_time(), 0, arg, true);
+}
+
+size_t WifiTrace::getExternalBytes() const
+{
+    return esp_ptr_external_ram(spans) ? sizeof(spans) : 0;
+}
+
+void WifiTrace::clear()
+{
+    portENTER_CRITICAL(&lock);
+    for (size_t i = 0; i < CONFIG_WIFICLIENT_TRACE_SPANS; i++) {
+        spans[i].id = 0;
+    }
+    nextId = 1;
+    portEXIT_CRITICAL(&lock);
+}
+
+size_t WifiTrace::exportJson(Writer writer, void* context) const
+{
+    //enough for one event with a full name
+    char buffer[192];
+    uint32_t first;
+    uint32_t next = range(first, NULL);
+    size_t count = 0;
+
+    write(writer, context, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    snprintf(buffer, sizeof(buffer),
+        "{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\",\"args\":{\"name\":\"WifiClient\"}},"
+        "{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":\"connection\"}},",
+        (unsigned)Track::CONNECTION);
+    write(writer, context, buffer);
+    snprintf(buffer, sizeof(buffer),
+        "{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":\"handler\"}},"
+        "{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":\"delivery\"}}",
+        (unsigned)Track::HANDLER, (unsigned)Track::DELIVERY);
+    write(writer, context, buffer);
+
+    for (uint32_t id = first; id != next; id++) {
+        Span span;
+        if (!copy(id, span)) {
+            continue;
+        }
+        //names are written by the component or the application, quotes are replaced
+        for (size_t i = 0; span.name[i] != '\0'; i++) {
+            if (span.name[i] == '"' || span.name[i] == '\\' || (uint8_t)span.name[i] < 0x20) {
+                span.name[i] = '_';
+            }
+        }
+
+        int length;
+        if (span.instant) {
+            length = snprintf(buffer, sizeof(buffer),
+                ",{\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"name\":\"%s\",\"ts\":%lld,\"args\":{\"arg\":%lu}}",
+                span.track, span.name, (long long)span.startUs, (unsigned long)span.arg);
+        } else if (span.durationUs == OPEN) {
+            length = snprintf(buffer, sizeof(buffer),
+                ",{\"ph\":\"B\",\"pid\":1,\"tid\":%u,\"name\":\"%s\",\"ts\":%lld,\"args\":{\"arg\":%lu}}",
+                span.track, span.name, (long long)span.startUs, (unsigned long)span.arg);
+        } else {
+            length = snprintf(buffer, sizeof(buffer),
+                ",{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"name\":\"%s\",\"ts\":%lld,\"dur\":%lu,\"args\":{\"arg\":%lu}}",
+                span.track, span.name, (long long)span.startUs, (unsigned long)span.durationUs, (unsigned long)span.arg);
+        }
+        writer(context, buffer, length);
+        count++;
+    }
+
+    write(writer, context, "]}\n");
+    return count;
+}
+
+size_t WifiTrace::dump(Writer writer, void* context) const
+{
+    uint32_t first;
+    uint32_t dropped;
+    uint32_t next = range(first, &dropped);
+
+    DumpHeader header;
+    header.magic = DUMP_MAGIC;
+    header.version = 1;
+    header.spanSize = sizeof(Span);
+    header.count = next - first;
+    header.dropped = dropped;
+    writer(context, (const char*)&header, sizeof(DumpHeader));
+
+    //count is fixed by the header, overwritten spans are sent with id 0
+    size_t count = 0;
+    for (uint32_t id = first; id != next; id++) {
+        Span span;
+        if (copy(id, span)) {
+            count++;
+        } else {
+            span = Span();
+        }
+        writer(context, (const char*)&span, sizeof(Span));
+    }
+    return count;
+}
+
+uint32_t WifiTrace::record(const char* name, uint16_t track, int64_t startUs, uint32_t durationUs, uint32_t arg, bool instant)
+{
+    portENTER_CRITICAL(&lock);
+    if (!enabled) {
+        portEXIT_CRITICAL(&lock);
+        return 0;
+    }
+    uint32_t id = nextId++;
+    if (nextId == 0) {
+        nextId = 1;
+    }
+    Span& span = spans[id % CONFIG_WIFICLIENT_TRACE_SPANS];
+    span.startUs = startUs;
+    span.durationUs = durationUs;
+    span.id = id;
+    span.arg = arg;
+    span.track = track;
+    span.instant = instant ? 1 : 0;
+    span.reserved = 0;
+    strncpy(span.name, name, NAME_LENGTH - 1);
+    span.name[NAME_LENGTH - 1] = '\0';
+    portEXIT_CRITICAL(&lock);
+    return id;
+}
+
+bool WifiTrace::copy(uint32_t id, Span& span) const
+{
+    portENTER_CRITICAL(&Singleton.lock);
+    span = spans[id % CONFIG_WIFICLIENT_TRACE_SPANS];
+    portEXIT_CRITICAL(&Singleton.lock);
+    return span.id == id;
+}
+
+uint32_t WifiTrace::range(uint32_t& first, uint32_t* dropped) const
+{
+    portENTER_CRITICAL(&Singleton.lock);
+    uint32_t next = nextId;
+    portEXIT_CRITICAL(&Singleton.lock);
+
+    uint32_t recorded = next - 1;
+    first = recorded > CONFIG_WIFICLIENT_TRACE_SPANS ? next - CONFIG_WIFICLIENT_TRACE_SPANS : 1;
+    if (dropped != NULL) {
+        *dropped = first - 1;
+    }
+    return next;
+}
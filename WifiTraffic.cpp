@@ -0,0 +1,155 @@
+/*!
+ * @file 	    WifiTraffic.cpp
+ * @brief 	    Singleton traffic classes with DSCP/WMM tagging
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include "WifiTraffic.h"
+
+#include <cstring>
+
+#define LOG_LOCAL_LEVEL ESP_LOG_WARN
+#include "esp_log.h"
+#define TAG "WifiTraffic"
+
+#define MAX_DSCP 63
+
+using namespace std;
+
+WifiTraffic WifiTraffic::Singleton;
+
+WifiTraffic& WifiTraffic::getInstance()
+{
+    return Singleton;
+}
+
+WifiTraffic::WifiTraffic()
+{
+    lock = portMUX_INITIALIZER_UNLOCKED;
+}
+
+void WifiTraffic::init(Config const& config)
+{
+    for (size_t i = 0; i < CLASS_COUNT; i++) {
+        if (config.dscp[i] > MAX_DSCP) {
+            throw invalid_argument("WifiTraffic::init: DSCP must be between 0 and 63");
+        }
+    }
+    portENTER_CRITICAL(&lock);
+    this->config = config;
+    portEXIT_CRITICAL(&lock);
+}
+
+uint8_t WifiTraffic::getTos(TrafficClass trafficClass) const
+{
+    portENTER_CRITICAL(&Singleton.lock);
+    //DSCP is the upper 6 bits, ECN stays 0
+    uint8_t tos = config.dscp[(size_t)trafficClass] << 2;
+    portEXIT_CRITICAL(&Singleton.lock);
+    return tos;
+}
+
+void WifiTraffic::setClass(int socket, TrafficClass trafficClass)
+{
+    const static string EXEP_TAG = "WifiTraffic::setClass: ";
+
+    //the slot is selected and claimed at once, a concurrent call can't take it
+    portENTER_CRITICAL(&lock);
+    size_t slot = MAX_SOCKETS;
+    for (size_t i = 0; i < MAX_SOCKETS; i++) {
+        if (sockets[i].socket == socket) {
+            slot = i;
+            break;
+        }
+        if (sockets[i].socket < 0 && slot == MAX_SOCKETS) {
+            slot = i;
+        }
+    }
+    Socket previous;
+    int tos = 0;
+    if (slot < MAX_SOCKETS) {
+        previous = sockets[slot];
+        sockets[slot].socket = socket;
+        sockets[slot].trafficClass = trafficClass;
+        //DSCP is the upper 6 bits, ECN stays 0
+        tos = config.dscp[(size_t)trafficClass] << 2;
+    }
+    portEXIT_CRITICAL(&lock);
+    if (slot == MAX_SOCKETS) {
+        throw runtime_error(EXEP_TAG + "no socket slot left");
+    }
+
+    if (setsockopt(socket, IPPROTO_IP, IP_TOS, &tos, sizeof(tos)) != 0) {
+        int error = errno;
+        portENTER_CRITICAL(&lock);
+        if (sockets[slot].socket == socket && sockets[slot].trafficClass == trafficClass) {
+            sockets[slot] = previous;
+        }
+        portEXIT_CRITICAL(&lock);
+        throw runtime_error(EXEP_TAG + "IP_TOS could not be set, errno: " + strerror(error));
+    }
+}
+
+void WifiTraffic::forget(int socket)
+{
+    portENTER_CRITICAL(&lock);
+    for (size_t i = 0; i < MAX_SOCKETS; i++) {
+        if (sockets[i].socket == socket) {
+            sockets[i] = Socket();
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+int WifiTraffic::send(int socket, const void* data, size_t length, int flags)
+{
+    int result = ::send(socket, data, length, flags);
+    record(classOf(socket), result > 0 ? result : 0, result >= 0);
+    return result;
+}
+
+int WifiTraffic::sendTo(int socket, const void* data, size_t length, int flags,
+    const struct sockaddr* address, socklen_t addressLength)
+{
+    int result = ::sendto(socket, data, length, flags, address, addressLength);
+    record(classOf(socket), result > 0 ? result : 0, result >= 0);
+    return result;
+}
+
+WifiTraffic::ClassStats WifiTraffic::getStats(TrafficClass trafficClass) const
+{
+    portENTER_CRITICAL(&Singleton.lock);
+    ClassStats result = stats[(size_t)trafficClass];
+    portEXIT_CRITICAL(&Singleton.lock);
+    return result;
+}
+
+WifiTraffic::TrafficClass WifiTraffic::classOf(int socket) const
+{
+    TrafficClass result = TrafficClass::BEST_EFFORT;
+    portENTER_CRITICAL(&Singleton.lock);
+    for (size_t i = 0; i < MAX_SOCKETS; i++) {
+        if (sockets[i].socket == socket) {
+            result = sockets[i].trafficClass;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&Singleton.lock);
+    return result;
+}
+
+void WifiTraffic::record(TrafficClass trafficClass, size_t length, bool success)
+{
+    portENTER_CRITICAL(&lock);
+    ClassStats& classStats = stats[(size_t)trafficClass];
+    if (success) {
+        classStats.packets++;
+        classStats.bytes += length;
+    } else {
+        classStats.errors++;
+    }
+    portEXIT_CRITICAL(&lock);
+}
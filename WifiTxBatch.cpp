@@ -0,0 +1,275 @@
+/*!
+ * @file 	    WifiTxBatch.cpp
+ * @brief 	    Singleton transmit batching aligned to the station wake windows
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include "WifiTxBatch.h"
+
+#include <cstring>
+
+#include "WifiKeepalive.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "WifiLockProfiler.h"
+
+#define LOG_LOCAL_LEVEL ESP_LOG_WARN
+#include "esp_log.h"
+#define TAG "WifiTxBatch"
+
+using namespace std;
+
+WifiTxBatch WifiTxBatch::Singleton;
+WifiTxBatch::Message WifiTxBatch::messagePool[CONFIG_WIFICLIENT_TXBATCH_POOL];
+StackType_t WifiTxBatch::taskStack[TASK_STACK_SIZE];
+
+void WifiTxBatch_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data)
+{
+    WifiTxBatch& batch = WifiTxBatch::Singleton;
+
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        WIFICLIENT_TAKE(batch.mutex, portMAX_DELAY, TX_BATCH);
+        batch.associated = esp_timer_get_time();
+        xSemaphoreGive(batch.mutex);
+
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        WIFICLIENT_TAKE(batch.mutex, portMAX_DELAY, TX_BATCH);
+        batch.linkUp = true;
+        xSemaphoreGive(batch.mutex);
+        //held back messages may be due already
+        xTaskNotifyGive(batch.task);
+
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        WIFICLIENT_TAKE(batch.mutex, portMAX_DELAY, TX_BATCH);
+        batch.linkUp = false;
+        xSemaphoreGive(batch.mutex);
+    }
+}
+
+WifiTxBatch& WifiTxBatch::getInstance()
+{
+    return Singleton;
+}
+
+WifiTxBatch::WifiTxBatch()
+{
+    initalized = false;
+    udpSocket = -1;
+    linkUp = false;
+    flushRequested = false;
+    associated = 0;
+    task = NULL;
+    mutex = NULL;
+}
+
+void WifiTxBatch::init(Config const& config)
+{
+    const static string EXEP_TAG = "WifiTxBatch::init: ";
+    esp_err_t result;
+
+    if (initalized) {
+        return;
+    }
+    this->config = config;
+
+    mutex = xSemaphoreCreateMutexStatic(&mutexBuffer);
+    if (mutex == NULL) {
+        throw runtime_error(EXEP_TAG + "mutex could not be created");
+    }
+
+    udpSocket = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (udpSocket < 0) {
+        throw runtime_error(EXEP_TAG + "socket could not be created");
+    }
+    WifiTraffic::getInstance().setClass(udpSocket, config.trafficClass);
+
+    task = xTaskCreateStatic(&WifiTxBatch::flushTask, "WifiTxBatch", TASK_STACK_SIZE, NULL,
+        config.taskPriority, taskStack, &taskBuffer);
+    if (task == NULL) {
+        throw runtime_error(EXEP_TAG + "flush task could not be created");
+    }
+
+    result = esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &WifiTxBatch_event_handler, NULL);
+    if (result == ESP_OK) {
+        result = esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &WifiTxBatch_event_handler, NULL);
+    }
+    if (result == ESP_OK) {
+        result = esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &WifiTxBatch_event_handler, NULL);
+    }
+    if (result != ESP_OK) {
+        throw runtime_error(EXEP_TAG + "can't register handler, error: " + esp_err_to_name(result));
+    }
+    initalized = true;
+}
+
+bool WifiTxBatch::send(ip4_addr_t address, uint16_t port, const void* data, size_t length, uint32_t maxDelayMs)
+{
+    if (!initalized) {
+        throw runtime_error("WifiTxBatch::send: not initialized");
+    }
+    if (length == 0 || length > CONFIG_WIFICLIENT_TXBATCH_PAYLOAD) {
+        throw invalid_argument("WifiTxBatch::send: length must be between 1 and CONFIG_WIFICLIENT_TXBATCH_PAYLOAD");
+    }
+
+    int64_t now = esp_timer_get_time();
+    size_t free = CONFIG_WIFICLIENT_TXBATCH_POOL;
+    size_t pending = 0;
+
+    WIFICLIENT_TAKE(mutex, portMAX_DELAY, TX_BATCH);
+    for (size_t i = 0; i < CONFIG_WIFICLIENT_TXBATCH_POOL; i++) {
+        if (messagePool[i].state == State::FREE) {
+            if (free == CONFIG_WIFICLIENT_TXBATCH_POOL) {
+                free = i;
+            }
+        } else {
+            pending++;
+        }
+    }
+    if (free == CONFIG_WIFICLIENT_TXBATCH_POOL) {
+        stats.poolExhausted++;
+        flushRequested = true;
+        xSemaphoreGive(mutex);
+        xTaskNotifyGive(task);
+        return false;
+    }
+
+    Message& message = messagePool[free];
+    message.state = State::PENDING;
+    message.address = address;
+    message.port = port;
+    message.length = length;
+    message.enqueued = now;
+    message.deadline = now + (int64_t)maxDelayMs * 1000;
+    memcpy(message.data, data, length);
+    //a full pool can't wait for the window, the next send would fail
+    if (pending + 1 == CONFIG_WIFICLIENT_TXBATCH_POOL) {
+        flushRequested = true;
+    }
+    xSemaphoreGive(mutex);
+
+    //flush task recalculates its wake up time
+    xTaskNotifyGive(task);
+    return true;
+}
+
+void WifiTxBatch::flush()
+{
+    if (!initalized) {
+        return;
+    }
+    WIFICLIENT_TAKE(mutex, portMAX_DELAY, TX_BATCH);
+    flushRequested = true;
+    xSemaphoreGive(mutex);
+    xTaskNotifyGive(task);
+}
+
+WifiTxBatch::Stats WifiTxBatch::getStats() const
+{
+    if (!initalized) {
+        return Stats();
+    }
+    WIFICLIENT_TAKE(Singleton.mutex, portMAX_DELAY, TX_BATCH);
+    Stats result = Singleton.stats;
+    xSemaphoreGive(Singleton.mutex);
+    return result;
+}
+
+int64_t WifiTxBatch::dueTime() const
+{
+    int64_t deadline = INT64_MAX;
+    for (size_t i = 0; i < CONFIG_WIFICLIENT_TXBATCH_POOL; i++) {
+        if (messagePool[i].state == State::PENDING && messagePool[i].deadline < deadline) {
+            deadline = messagePool[i].deadline;
+        }
+    }
+    if (!linkUp || deadline == INT64_MAX) {
+        return INT64_MAX;
+    }
+    if (flushRequested) {
+        return 0;
+    }
+
+    //last wake window before the earliest deadline
+    int64_t wakeInterval = (int64_t)config.wakeIntervalMs * 1000;
+    if (wakeInterval > 0 && deadline > associated) {
+        deadline = associated + ((deadline - associated) / wakeInterval) * wakeInterval;
+    }
+    return deadline;
+}
+
+void WifiTxBatch::flushTask(void* arg)
+{
+    size_t batch[CONFIG_WIFICLIENT_TXBATCH_POOL];
+
+    while (true) {
+        WIFICLIENT_TAKE(Singleton.mutex, portMAX_DELAY, TX_BATCH);
+        int64_t due = Singleton.dueTime();
+        xSemaphoreGive(Singleton.mutex);
+
+        int64_t now = esp_timer_get_time();
+        if (due > now) {
+            TickType_t wait = due == INT64_MAX ? portMAX_DELAY : pdMS_TO_TICKS((due - now + 999) / 1000);
+            //send() and link changes wake the task early to recalculate
+            ulTaskNotifyTake(pdTRUE, wait);
+            continue;
+        }
+
+        //take every pending message, they all share this wake window
+        size_t count = 0;
+        WIFICLIENT_TAKE(Singleton.mutex, portMAX_DELAY, TX_BATCH);
+        Singleton.flushRequested = false;
+        for (size_t i = 0; i < CONFIG_WIFICLIENT_TXBATCH_POOL; i++) {
+            if (messagePool[i].state == State::PENDING) {
+                messagePool[i].state = State::SENDING;
+                batch[count++] = i;
+            }
+        }
+        xSemaphoreGive(Singleton.mutex);
+
+        uint32_t errors = 0;
+        int64_t sent = esp_timer_get_time();
+        for (size_t i = 0; i < count; i++) {
+            Message& message = messagePool[batch[i]];
+            struct sockaddr_in destination;
+            memset(&destination, 0, sizeof(destination));
+            destination.sin_family = AF_INET;
+            destination.sin_port = htons(message.port);
+            destination.sin_addr.s_addr = message.address.addr;
+            if (WifiTraffic::getInstance().sendTo(Singleton.udpSocket, message.data, message.length, 0,
+                (struct sockaddr*)&destination, sizeof(destination)) < 0) {
+                errors++;
+            }
+        }
+        if (count > 0) {
+            WifiKeepalive::getInstance().notifyActivity();
+        }
+
+        WIFICLIENT_TAKE(Singleton.mutex, portMAX_DELAY, TX_BATCH);
+        if (count > 0) {
+            Singleton.stats.flushes++;
+            Singleton.stats.messages += count - errors;
+            Singleton.stats.sendErrors += errors;
+            Singleton.stats.wakeupsSaved += count - 1;
+        }
+        for (size_t i = 0; i < count; i++) {
+            Message& message = messagePool[batch[i]];
+            uint32_t latency = (uint32_t)(sent - message.enqueued);
+            Singleton.stats.totalAddedLatencyUs += latency;
+            if (latency > Singleton.stats.maxAddedLatencyUs) {
+                Singleton.stats.maxAddedLatencyUs = latency;
+            }
+            message.state = State::FREE;
+        }
+        xSemaphoreGive(Singleton.mutex);
+
+        if (errors > 0) {
+            ESP_LOGW(TAG, "%lu of %u messages not sent", (unsigned long)errors, (unsigned)count);
+        }
+    }
+}
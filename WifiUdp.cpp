@@ -0,0 +1,334 @@
+/*!
+ * @file 	    WifiUdp.cpp
+ * @brief 	    Singleton zero-copy UDP endpoints on the station netif
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include "WifiUdp.h"
+
+#include "WifiClient.h"
+#include "WifiKeepalive.h"
+#include "esp_netif.h"
+
+#define LOG_LOCAL_LEVEL ESP_LOG_WARN
+#include "esp_log.h"
+#define TAG "WifiUdp"
+
+using namespace std;
+
+WifiUdp WifiUdp::Singleton;
+WifiUdp::TxBuffer WifiUdp::txPool[CONFIG_WIFICLIENT_UDP_TX_BUFFERS];
+
+WifiUdp& WifiUdp::getInstance()
+{
+    return Singleton;
+}
+
+WifiUdp::WifiUdp()
+{
+    initalized = false;
+    lock = portMUX_INITIALIZER_UNLOCKED;
+}
+
+void WifiUdp::init(Config const& config)
+{
+    const static string EXEP_TAG = "WifiUdp::init: ";
+
+    if (config.txBuffers == 0 || config.txBuffers > CONFIG_WIFICLIENT_UDP_TX_BUFFERS) {
+        throw invalid_argument(EXEP_TAG + "txBuffers must be between 1 and CONFIG_WIFICLIENT_UDP_TX_BUFFERS");
+    }
+    if (WifiClient::getInstance().getNetif() == NULL) {
+        throw runtime_error(EXEP_TAG + "WifiClient is not initialized");
+    }
+
+    portENTER_CRITICAL(&lock);
+    this->config = config;
+    initalized = true;
+    portEXIT_CRITICAL(&lock);
+}
+
+int WifiUdp::open(uint16_t port, ReceiveCallback callback, void* context)
+{
+    const static string EXEP_TAG = "WifiUdp::open: ";
+
+    if (!initalized) {
+        throw runtime_error(EXEP_TAG + "not initialized");
+    }
+
+    portENTER_CRITICAL(&lock);
+    size_t index = MAX_ENDPOINTS;
+    for (size_t i = 0; i < MAX_ENDPOINTS; i++) {
+        if (!endpoints[i].used) {
+            index = i;
+            break;
+        }
+    }
+    if (index < MAX_ENDPOINTS) {
+        //reserves the slot until the pcb is created
+        endpoints[index].used = true;
+        endpoints[index].callback = callback;
+        endpoints[index].context = context;
+    }
+    portEXIT_CRITICAL(&lock);
+    if (index == MAX_ENDPOINTS) {
+        throw runtime_error(EXEP_TAG + "no endpoint left");
+    }
+
+    Call call;
+    call.endpoint = &endpoints[index];
+    call.port = port;
+    err_t result = tcpip_api_call(&WifiUdp::openInCore, &call.base);
+    if (result != ERR_OK) {
+        portENTER_CRITICAL(&lock);
+        endpoints[index] = Endpoint();
+        portEXIT_CRITICAL(&lock);
+        throw runtime_error(EXEP_TAG + "pcb could not be bound, lwIP error: " + to_string(result));
+    }
+    return index;
+}
+
+void WifiUdp::close(int endpoint)
+{
+    const static string EXEP_TAG = "WifiUdp::close: ";
+
+    bool open = false;
+    if (endpoint >= 0 && endpoint < (int)MAX_ENDPOINTS) {
+        portENTER_CRITICAL(&lock);
+        open = endpoints[endpoint].pcb != nullptr;
+        portEXIT_CRITICAL(&lock);
+    }
+    if (!open) {
+        throw invalid_argument(EXEP_TAG + "endpoint is not open");
+    }
+    Call call;
+    call.endpoint = &endpoints[endpoint];
+    call.port = 0;
+    if (tcpip_api_call(&WifiUdp::closeInCore, &call.base) != ERR_OK) {
+        throw invalid_argument(EXEP_TAG + "endpoint was closed concurrently");
+    }
+}
+
+void WifiUdp::setTrafficClass(int endpoint, WifiTraffic::TrafficClass trafficClass)
+{
+    if (endpoint < 0 || endpoint >= (int)MAX_ENDPOINTS || !endpoints[endpoint].used) {
+        throw invalid_argument("WifiUdp::setTrafficClass: endpoint is not open");
+    }
+    portENTER_CRITICAL(&lock);
+    endpoints[endpoint].trafficClass = trafficClass;
+    portEXIT_CRITICAL(&lock);
+}
+
+struct pbuf* WifiUdp::acquire(uint16_t length)
+{
+    if (length == 0 || length > CONFIG_WIFICLIENT_UDP_PAYLOAD) {
+        throw invalid_argument("WifiUdp::acquire: length must be between 1 and CONFIG_WIFICLIENT_UDP_PAYLOAD");
+    }
+
+    portENTER_CRITICAL(&lock);
+    TxBuffer* buffer = nullptr;
+    for (size_t i = 0; i < config.txBuffers; i++) {
+        if (!txPool[i].used) {
+            buffer = &txPool[i];
+            buffer->used = true;
+            stats.txInUse++;
+            break;
+        }
+    }
+    if (buffer == nullptr) {
+        stats.poolExhausted++;
+    }
+    portEXIT_CRITICAL(&lock);
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+
+    buffer->custom.custom_free_function = &WifiUdp::freeTxBuffer;
+    //payload starts behind the headroom, lwIP prepends the headers in place
+    struct pbuf* datagram = pbuf_alloced_custom(PBUF_TRANSPORT, length, PBUF_RAM, &buffer->custom,
+        buffer->storage, sizeof(buffer->storage));
+    if (datagram == NULL) {
+        freeTxBuffer(&buffer->custom.pbuf);
+    }
+    return datagram;
+}
+
+bool WifiUdp::send(int endpoint, struct pbuf* datagram, ip4_addr_t address, uint16_t port)
+{
+    const static string EXEP_TAG = "WifiUdp::send: ";
+
+    TxBuffer* buffer = txBufferOf(datagram);
+    if (buffer == nullptr) {
+        throw invalid_argument(EXEP_TAG + "datagram was not acquired from the pool");
+    }
+
+    bool open = false;
+    portENTER_CRITICAL(&lock);
+    if (endpoint >= 0 && endpoint < (int)MAX_ENDPOINTS && endpoints[endpoint].pcb != nullptr) {
+        open = true;
+        buffer->endpoint = endpoint;
+        buffer->trafficClass = endpoints[endpoint].trafficClass;
+    }
+    portEXIT_CRITICAL(&lock);
+    if (!open) {
+        pbuf_free(datagram);
+        throw invalid_argument(EXEP_TAG + "endpoint is not open");
+    }
+    ip_addr_copy_from_ip4(buffer->address, address);
+    buffer->port = port;
+    buffer->tos = WifiTraffic::getInstance().getTos(buffer->trafficClass);
+
+    if (tcpip_callback(&WifiUdp::sendInCore, buffer) != ERR_OK) {
+        WifiTraffic::getInstance().record(buffer->trafficClass, 0, false);
+        pbuf_free(datagram);
+        portENTER_CRITICAL(&lock);
+        stats.sendErrors++;
+        portEXIT_CRITICAL(&lock);
+        return false;
+    }
+    WifiKeepalive::getInstance().notifyActivity();
+    return true;
+}
+
+void WifiUdp::release(struct pbuf* datagram)
+{
+    bool received = txBufferOf(datagram) == nullptr;
+    if (received) {
+        portENTER_CRITICAL(&lock);
+        stats.rxHeld--;
+        portEXIT_CRITICAL(&lock);
+    }
+    pbuf_free(datagram);
+}
+
+WifiUdp::Stats WifiUdp::getStats() const
+{
+    portENTER_CRITICAL(&Singleton.lock);
+    Stats result = Singleton.stats;
+    portEXIT_CRITICAL(&Singleton.lock);
+    return result;
+}
+
+err_t WifiUdp::openInCore(struct tcpip_api_call_data* arg)
+{
+    Call* call = (Call*)arg;
+    esp_netif_t* netif = WifiClient::getInstance().getNetif();
+    struct netif* lwipNetif = (struct netif*)esp_netif_get_netif_impl(netif);
+
+    struct udp_pcb* pcb = udp_new();
+    if (pcb == NULL) {
+        return ERR_MEM;
+    }
+    err_t result = udp_bind(pcb, IP_ADDR_ANY, call->port);
+    if (result != ERR_OK) {
+        udp_remove(pcb);
+        return result;
+    }
+    udp_bind_netif(pcb, lwipNetif);
+    udp_recv(pcb, &WifiUdp::receive, call->endpoint);
+
+    portENTER_CRITICAL(&Singleton.lock);
+    call->endpoint->pcb = pcb;
+    portEXIT_CRITICAL(&Singleton.lock);
+    return ERR_OK;
+}
+
+err_t WifiUdp::closeInCore(struct tcpip_api_call_data* arg)
+{
+    Call* call = (Call*)arg;
+
+    portENTER_CRITICAL(&Singleton.lock);
+    struct udp_pcb* pcb = call->endpoint->pcb;
+    *call->endpoint = Endpoint();
+    portEXIT_CRITICAL(&Singleton.lock);
+    if (pcb == nullptr) {
+        return ERR_ARG;
+    }
+    udp_remove(pcb);
+    return ERR_OK;
+}
+
+void WifiUdp::sendInCore(void* arg)
+{
+    TxBuffer* buffer = (TxBuffer*)arg;
+    struct pbuf* datagram = &buffer->custom.pbuf;
+    esp_netif_t* netif = WifiClient::getInstance().getNetif();
+    uint16_t length = datagram->tot_len;
+    //the buffer may be reused as soon as it is freed
+    WifiTraffic::TrafficClass trafficClass = buffer->trafficClass;
+
+    //closeInCore runs in this thread too, the pcb can't go away while it is used
+    portENTER_CRITICAL(&Singleton.lock);
+    struct udp_pcb* pcb = Singleton.endpoints[buffer->endpoint].pcb;
+    portEXIT_CRITICAL(&Singleton.lock);
+
+    err_t result = ERR_ARG;
+    if (pcb != nullptr) {
+        //pcbs are only touched in the lwIP thread, the TOS is set per datagram
+        pcb->tos = buffer->tos;
+        result = udp_sendto_if(pcb, datagram, &buffer->address, buffer->port,
+            (struct netif*)esp_netif_get_netif_impl(netif));
+    }
+    //the driver holds its own reference until the frame is out
+    pbuf_free(datagram);
+    WifiTraffic::getInstance().record(trafficClass, length, result == ERR_OK);
+
+    portENTER_CRITICAL(&Singleton.lock);
+    if (result == ERR_OK) {
+        Singleton.stats.sent++;
+    } else {
+        Singleton.stats.sendErrors++;
+    }
+    portEXIT_CRITICAL(&Singleton.lock);
+}
+
+void WifiUdp::receive(void* arg, struct udp_pcb* pcb, struct pbuf* p, const ip_addr_t* address, uint16_t port)
+{
+    Endpoint* endpoint = (Endpoint*)arg;
+
+    portENTER_CRITICAL(&Singleton.lock);
+    bool accepted = Singleton.stats.rxHeld < Singleton.config.maxHeldRx;
+    if (accepted) {
+        //counted as held until the callback declines it
+        Singleton.stats.rxHeld++;
+        Singleton.stats.received++;
+    } else {
+        Singleton.stats.receiveDropped++;
+    }
+    ReceiveCallback callback = endpoint->callback;
+    void* context = endpoint->context;
+    portEXIT_CRITICAL(&Singleton.lock);
+
+    if (!accepted || callback == nullptr) {
+        if (accepted) {
+            Singleton.release(p);
+        } else {
+            pbuf_free(p);
+        }
+        return;
+    }
+    if (!callback(context, p, address, port)) {
+        Singleton.release(p);
+    }
+}
+
+WifiUdp::TxBuffer* WifiUdp::txBufferOf(struct pbuf* p)
+{
+    if (p == nullptr || (p->flags & PBUF_FLAG_IS_CUSTOM) == 0
+        || ((struct pbuf_custom*)p)->custom_free_function != &WifiUdp::freeTxBuffer) {
+        return nullptr;
+    }
+    return (TxBuffer*)p;
+}
+
+void WifiUdp::freeTxBuffer(struct pbuf* p)
+{
+    TxBuffer* buffer = (TxBuffer*)p;
+
+    portENTER_CRITICAL(&Singleton.lock);
+    buffer->used = false;
+    Singleton.stats.txInUse--;
+    portEXIT_CRITICAL(&Singleton.lock);
+}
@@ -0,0 +1,116 @@
+/*!
+ * @file 	    esp_event.cpp
+ * @brief 	    Host mock of the default event loop
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "esp_event.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "host_mock.h"
+
+using namespace std;
+
+ESP_EVENT_DEFINE_BASE(WIFI_EVENT);
+ESP_EVENT_DEFINE_BASE(IP_EVENT);
+
+struct Registration{
+    esp_event_base_t base;
+    int32_t id;
+    esp_event_handler_t handler;
+    void* arg;
+};
+
+static mutex registryLock;
+static vector<Registration*> registry;
+
+esp_err_t esp_event_loop_create_default(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t event_base, int32_t event_id,
+    esp_event_handler_t event_handler, void* event_handler_arg, esp_event_handler_instance_t* instance)
+{
+    Registration* registration = new Registration{ event_base, event_id, event_handler, event_handler_arg };
+    lock_guard<mutex> guard(registryLock);
+    registry.push_back(registration);
+    if (instance != NULL) {
+        *instance = registration;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t event_base, int32_t event_id,
+    esp_event_handler_t event_handler, void* event_handler_arg)
+{
+    {
+        //like the event loop, a second registration only updates the argument
+        lock_guard<mutex> guard(registryLock);
+        for (Registration* registration : registry) {
+            if (registration->base == event_base && registration->id == event_id && registration->handler == event_handler) {
+                registration->arg = event_handler_arg;
+                return ESP_OK;
+            }
+        }
+    }
+    return esp_event_handler_instance_register(event_base, event_id, event_handler, event_handler_arg, NULL);
+}
+
+esp_err_t esp_event_handler_unregister(esp_event_base_t event_base, int32_t event_id,
+    esp_event_handler_t event_handler)
+{
+    lock_guard<mutex> guard(registryLock);
+    for (size_t i = 0; i < registry.size(); i++) {
+        Registration* registration = registry[i];
+        if (registration->base == event_base && registration->id == event_id && registration->handler == event_handler) {
+            registry.erase(registry.begin() + i);
+            return ESP_OK;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_instance_unregister(esp_event_base_t event_base, int32_t event_id,
+    esp_event_handler_instance_t instance)
+{
+    lock_guard<mutex> guard(registryLock);
+    for (size_t i = 0; i < registry.size(); i++) {
+        if (registry[i] == instance) {
+            registry.erase(registry.begin() + i);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id,
+    const void* event_data, size_t event_data_size, TickType_t ticks_to_wait)
+{
+    HostMock::dispatchEvent(event_base, event_id, (void*)event_data);
+    return ESP_OK;
+}
+
+void HostMock::dispatchEvent(esp_event_base_t base, int32_t id, void* data)
+{
+    //handlers may register or unregister while the event is delivered
+    vector<Registration> matching;
+    {
+        lock_guard<mutex> guard(registryLock);
+        for (Registration* registration : registry) {
+            if (registration->base == base && (registration->id == ESP_EVENT_ANY_ID || registration->id == id)) {
+                matching.push_back(*registration);
+            }
+        }
+    }
+    for (Registration const& registration : matching) {
+        registration.handler(registration.arg, base, id, data);
+    }
+}
@@ -0,0 +1,204 @@
+/*!
+ * @file 	    esp_http_client.cpp
+ * @brief 	    Host mock of esp_http_client with a Range capable server and injected connection drops
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <strings.h>
+
+#include "esp_http_client.h"
+#include "host_mock.h"
+
+using namespace std;
+
+#define HTTP_PARTIAL_CONTENT 206
+#define HTTP_RANGE_NOT_SATISFIABLE 416
+
+struct esp_http_client{
+    esp_http_client_config_t config;
+    string range;
+    bool open = false;
+    bool broken = false;    //connection dropped, reads fail until close
+    int status = 0;
+    size_t first = 0;
+    size_t position = 0;
+    size_t end = 0;
+    size_t request = 0;     //index in requests
+};
+
+static mutex httpLock;
+static size_t payloadSize = 0;
+static bool payloadTotalKnown = true;
+static size_t dropOffset = SIZE_MAX;
+static function<void()> dropAction;
+static vector<HostMock::HttpRequest> requests;
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t* config)
+{
+    if (config == NULL || config->url == NULL) {
+        return NULL;
+    }
+    esp_http_client* client = new esp_http_client();
+    client->config = *config;
+    return client;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char* key, const char* value)
+{
+    if (strcasecmp(key, "Range") == 0) {
+        client->range = value;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len)
+{
+    unsigned long first = 0;
+    unsigned long last = 0;
+    if (sscanf(client->range.c_str(), "bytes=%lu-%lu", &first, &last) != 2 || last < first) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    lock_guard<mutex> guard(httpLock);
+    HostMock::HttpRequest request;
+    request.first = first;
+    request.length = last - first + 1;
+    if (first >= payloadSize) {
+        request.status = HTTP_RANGE_NOT_SATISFIABLE;
+        client->end = first;
+    } else {
+        request.status = HTTP_PARTIAL_CONTENT;
+        client->end = last + 1 < payloadSize ? last + 1 : payloadSize;
+    }
+    client->open = true;
+    client->broken = false;
+    client->status = request.status;
+    client->first = first;
+    client->position = first;
+    client->request = requests.size();
+    requests.push_back(request);
+    return ESP_OK;
+}
+
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client)
+{
+    if (!client->open) {
+        return -1;
+    }
+    char value[64];
+    bool totalKnown;
+    {
+        lock_guard<mutex> guard(httpLock);
+        totalKnown = payloadTotalKnown;
+        if (client->status == HTTP_PARTIAL_CONTENT && totalKnown) {
+            snprintf(value, sizeof(value), "bytes %zu-%zu/%zu", client->first, client->end - 1, payloadSize);
+        } else if (client->status == HTTP_PARTIAL_CONTENT) {
+            snprintf(value, sizeof(value), "bytes %zu-%zu/*", client->first, client->end - 1);
+        } else {
+            snprintf(value, sizeof(value), "bytes */%zu", totalKnown ? payloadSize : 0);
+        }
+    }
+
+    //headers are passed to the handler while they are parsed
+    if (client->config.event_handler != NULL && (client->status == HTTP_PARTIAL_CONTENT || totalKnown)) {
+        char key[] = "Content-Range";
+        esp_http_client_event_t event;
+        memset(&event, 0, sizeof(event));
+        event.event_id = HTTP_EVENT_ON_HEADER;
+        event.client = client;
+        event.user_data = client->config.user_data;
+        event.header_key = key;
+        event.header_value = value;
+        client->config.event_handler(&event);
+    }
+    return (int64_t)(client->end - client->first);
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client)
+{
+    return client->status;
+}
+
+int esp_http_client_read(esp_http_client_handle_t client, char* buffer, int len)
+{
+    function<void()> drop;
+    size_t length;
+    {
+        lock_guard<mutex> guard(httpLock);
+        if (!client->open || client->broken) {
+            return -1;
+        }
+        length = client->end - client->position < (size_t)len ? client->end - client->position : (size_t)len;
+        //the connection breaks in the middle of the response
+        if (dropOffset > client->position && dropOffset <= client->position + length) {
+            length = dropOffset - client->position;
+            client->broken = true;
+            drop = move(dropAction);
+            dropOffset = SIZE_MAX;
+            dropAction = nullptr;
+        }
+        for (size_t i = 0; i < length; i++) {
+            buffer[i] = (char)HostMock::getHttpPayloadByte(client->position + i);
+        }
+        client->position += length;
+        requests[client->request].read += length;
+    }
+    if (drop) {
+        drop();
+    }
+    return (int)length;
+}
+
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client)
+{
+    lock_guard<mutex> guard(httpLock);
+    return client->open && !client->broken && client->position == client->end;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client)
+{
+    lock_guard<mutex> guard(httpLock);
+    client->open = false;
+    client->broken = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
+{
+    delete client;
+    return ESP_OK;
+}
+
+void HostMock::setHttpPayload(size_t size, bool totalKnown)
+{
+    lock_guard<mutex> guard(httpLock);
+    payloadSize = size;
+    payloadTotalKnown = totalKnown;
+    requests.clear();
+}
+
+uint8_t HostMock::getHttpPayloadByte(size_t offset)
+{
+    //no period of a power of two, a shifted resume does not match
+    return (uint8_t)((offset * 31 + offset / 251) ^ 0x5a);
+}
+
+void HostMock::dropHttpAt(size_t offset, function<void()> drop)
+{
+    lock_guard<mutex> guard(httpLock);
+    dropOffset = offset;
+    dropAction = move(drop);
+}
+
+vector<HostMock::HttpRequest> HostMock::getHttpRequests()
+{
+    lock_guard<mutex> guard(httpLock);
+    return requests;
+}
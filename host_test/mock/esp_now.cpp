@@ -0,0 +1,76 @@
+/*!
+ * @file 	    esp_now.cpp
+ * @brief 	    Host mock of ESP-NOW, transmissions take the airtime set by the test
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <atomic>
+
+#include "esp_now.h"
+#include "host_mock.h"
+
+using namespace std;
+
+static atomic<esp_now_send_cb_t> sendCallback(nullptr);
+static atomic<uint32_t> airtimeUs(0);
+static atomic<bool> acknowledged(true);
+static atomic<uint32_t> sends(0);
+
+esp_err_t esp_now_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_now_deinit(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb)
+{
+    sendCallback.store(cb);
+    return ESP_OK;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t* peer)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_now_del_peer(const uint8_t* peer_addr)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_now_send(const uint8_t* peer_addr, const uint8_t* data, size_t len)
+{
+    //the frame is on air, the status follows like from the wifi task
+    if (airtimeUs.load() > 0) {
+        HostMock::advanceTime(airtimeUs.load());
+    }
+    sends++;
+    esp_now_send_cb_t callback = sendCallback.load();
+    if (callback != nullptr) {
+        callback(peer_addr, acknowledged.load() ? ESP_NOW_SEND_SUCCESS : ESP_NOW_SEND_FAIL);
+    }
+    return ESP_OK;
+}
+
+void HostMock::setEspNowLink(uint32_t airtime, bool acknowledge)
+{
+    airtimeUs.store(airtime);
+    acknowledged.store(acknowledge);
+}
+
+uint32_t HostMock::getEspNowSends()
+{
+    return sends.load();
+}
@@ -0,0 +1,150 @@
+/*!
+ * @file 	    esp_partition.cpp
+ * @brief 	    Host mock of esp_partition, emulates NOR flash in RAM
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "esp_partition.h"
+#include "host_mock.h"
+
+using namespace std;
+
+#define SECTOR_SIZE 4096
+
+struct Flash{
+    esp_partition_t partition;
+    vector<uint8_t> data;
+    vector<uint32_t> sectorErases;
+    HostMock::FlashStats stats;
+};
+
+static mutex flashLock;
+static vector<Flash*> flashes;
+
+//flashLock has to be taken
+static Flash* findFlash(const esp_partition_t* partition)
+{
+    for (Flash* flash : flashes) {
+        if (&flash->partition == partition) {
+            return flash;
+        }
+    }
+    return nullptr;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label)
+{
+    lock_guard<mutex> guard(flashLock);
+    for (Flash* flash : flashes) {
+        if ((type == ESP_PARTITION_TYPE_ANY || flash->partition.type == type)
+            && (label == NULL || strcmp(flash->partition.label, label) == 0)) {
+            return &flash->partition;
+        }
+    }
+    return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size)
+{
+    lock_guard<mutex> guard(flashLock);
+    Flash* flash = findFlash(partition);
+    if (flash == nullptr || dst == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (src_offset + size > flash->data.size()) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(dst, flash->data.data() + src_offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size)
+{
+    lock_guard<mutex> guard(flashLock);
+    Flash* flash = findFlash(partition);
+    if (flash == nullptr || src == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (dst_offset + size > flash->data.size()) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    //NOR flash only clears bits, setting one needs an erase
+    const uint8_t* bytes = (const uint8_t*)src;
+    bool overwrite = false;
+    for (size_t i = 0; i < size; i++) {
+        uint8_t& cell = flash->data[dst_offset + i];
+        if ((bytes[i] & ~cell) != 0) {
+            overwrite = true;
+        }
+        cell &= bytes[i];
+    }
+    flash->stats.writes++;
+    flash->stats.bytesWritten += size;
+    if (overwrite) {
+        flash->stats.overwrites++;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size)
+{
+    lock_guard<mutex> guard(flashLock);
+    Flash* flash = findFlash(partition);
+    if (flash == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (offset % SECTOR_SIZE != 0 || size % SECTOR_SIZE != 0 || offset + size > flash->data.size()) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memset(flash->data.data() + offset, 0xFF, size);
+    for (size_t sector = offset / SECTOR_SIZE; sector < (offset + size) / SECTOR_SIZE; sector++) {
+        flash->sectorErases[sector]++;
+        flash->stats.erases++;
+    }
+    return ESP_OK;
+}
+
+void HostMock::addPartition(const char* label, uint32_t size)
+{
+    Flash* flash = new Flash();
+    memset(&flash->partition, 0, sizeof(esp_partition_t));
+    flash->partition.type = ESP_PARTITION_TYPE_DATA;
+    flash->partition.subtype = ESP_PARTITION_SUBTYPE_ANY;
+    flash->partition.size = size;
+    flash->partition.erase_size = SECTOR_SIZE;
+    strncpy(flash->partition.label, label, sizeof(flash->partition.label) - 1);
+    flash->data.assign(size, 0xFF);
+    flash->sectorErases.assign(size / SECTOR_SIZE, 0);
+
+    lock_guard<mutex> guard(flashLock);
+    flash->partition.address = 0x110000;
+    for (Flash* other : flashes) {
+        flash->partition.address += other->partition.size;
+    }
+    flashes.push_back(flash);
+}
+
+HostMock::FlashStats HostMock::getFlashStats(const char* label)
+{
+    lock_guard<mutex> guard(flashLock);
+    for (Flash* flash : flashes) {
+        if (strcmp(flash->partition.label, label) != 0) {
+            continue;
+        }
+        FlashStats stats = flash->stats;
+        stats.minSectorErases = UINT32_MAX;
+        for (uint32_t erases : flash->sectorErases) {
+            stats.minSectorErases = erases < stats.minSectorErases ? erases : stats.minSectorErases;
+            stats.maxSectorErases = erases > stats.maxSectorErases ? erases : stats.maxSectorErases;
+        }
+        return stats;
+    }
+    return FlashStats();
+}
@@ -0,0 +1,145 @@
+/*!
+ * @file 	    esp_system.cpp
+ * @brief 	    Host mock of logging, heap, netif and the wall clock
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+#include "host_mock.h"
+
+using namespace std;
+
+struct esp_netif_obj{
+    int unused;
+};
+
+static esp_netif_obj stationNetif;
+static atomic<time_t> wallTime(0);
+
+const char* esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:
+            return "ESP_OK";
+        case ESP_FAIL:
+            return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:
+            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:
+            return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:
+            return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:
+            return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:
+            return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_TIMEOUT:
+            return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_NVS_NOT_FOUND:
+            return "ESP_ERR_NVS_NOT_FOUND";
+        default:
+            return "UNKNOWN ERROR";
+    }
+}
+
+void esp_log_level_set(const char* tag, esp_log_level_t level)
+{
+}
+
+void host_log(char level, const char* tag, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "%c (%lld) %s: ", level, (long long)(esp_timer_get_time() / 1000), tag);
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    return (caps & MALLOC_CAP_SPIRAM) ? 0 : 200000;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    return (caps & MALLOC_CAP_SPIRAM) ? 0 : 100000;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    return heap_caps_get_free_size(caps);
+}
+
+void* heap_caps_malloc(size_t size, uint32_t caps)
+{
+    return malloc(size);
+}
+
+void heap_caps_free(void* ptr)
+{
+    free(ptr);
+}
+
+esp_err_t esp_netif_init(void)
+{
+    return ESP_OK;
+}
+
+esp_netif_t* esp_netif_create_default_wifi_sta(void)
+{
+    return &stationNetif;
+}
+
+esp_err_t esp_netif_get_ip_info(esp_netif_t* esp_netif, esp_netif_ip_info_t* ip_info)
+{
+    ip_info->ip.addr = 0x0201a8c0;
+    ip_info->netmask.addr = 0x00ffffff;
+    ip_info->gw.addr = 0x0101a8c0;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_receive(esp_netif_t* esp_netif, void* buffer, size_t len, void* eb)
+{
+    return ESP_OK;
+}
+
+//time() of the component is linked to this with --wrap=time
+extern "C" time_t __wrap_time(time_t* result)
+{
+    time_t now = wallTime.load();
+    if (result != NULL) {
+        *result = now;
+    }
+    return now;
+}
+
+void HostMock::setWallTime(time_t time)
+{
+    wallTime.store(time);
+}
+
+bool HostMock::waitFor(function<bool()> condition, uint32_t timeoutMs)
+{
+    for (uint32_t i = 0; i < timeoutMs; i++) {
+        if (condition()) {
+            return true;
+        }
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    return condition();
+}
@@ -0,0 +1,212 @@
+/*!
+ * @file 	    esp_timer.cpp
+ * @brief 	    Host mock of esp_timer with a controllable clock
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "esp_timer.h"
+#include "host_mock.h"
+
+using namespace std;
+
+struct esp_timer{
+    esp_timer_cb_t callback;
+    void* arg;
+    bool active;
+    int64_t deadline;
+    uint64_t period;
+};
+
+//esp_timer starts counting at boot, the mock boots one second before the test
+#define BOOT_OFFSET_US 1000000
+
+static mutex clockLock;
+static condition_variable clockChanged;
+static const chrono::steady_clock::time_point hostStart = chrono::steady_clock::now();
+static bool frozen = false;
+static int64_t frozenTime = 0;
+static int64_t offset = BOOT_OFFSET_US;
+static vector<esp_timer*> timers;
+static uint64_t requested = 0;
+static uint64_t processed = 0;
+static bool dispatcherRunning = false;
+
+//clockLock has to be taken
+static int64_t now()
+{
+    if (frozen) {
+        return frozenTime;
+    }
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - hostStart).count() + offset;
+}
+
+static void dispatcher()
+{
+    unique_lock<mutex> guard(clockLock);
+    while (true) {
+        uint64_t generation = requested;
+        esp_timer* due = nullptr;
+        for (esp_timer* timer : timers) {
+            if (timer->active && timer->deadline <= now() && (due == nullptr || timer->deadline < due->deadline)) {
+                due = timer;
+            }
+        }
+
+        if (due != nullptr) {
+            if (due->period > 0) {
+                due->deadline += due->period;
+            } else {
+                due->active = false;
+            }
+            esp_timer_cb_t callback = due->callback;
+            void* arg = due->arg;
+            guard.unlock();
+            callback(arg);
+            guard.lock();
+            continue;
+        }
+
+        processed = generation;
+        clockChanged.notify_all();
+        clockChanged.wait_for(guard, chrono::milliseconds(1));
+    }
+}
+
+//clockLock has to be taken
+static void startDispatcher()
+{
+    if (!dispatcherRunning) {
+        dispatcherRunning = true;
+        thread(dispatcher).detach();
+    }
+}
+
+int64_t esp_timer_get_time(void)
+{
+    lock_guard<mutex> guard(clockLock);
+    return now();
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args, esp_timer_handle_t* out_handle)
+{
+    if (create_args == NULL || create_args->callback == NULL || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_timer* timer = new esp_timer();
+    timer->callback = create_args->callback;
+    timer->arg = create_args->arg;
+    timer->active = false;
+    timer->deadline = 0;
+    timer->period = 0;
+
+    lock_guard<mutex> guard(clockLock);
+    timers.push_back(timer);
+    startDispatcher();
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    lock_guard<mutex> guard(clockLock);
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = true;
+    timer->deadline = now() + (int64_t)timeout_us;
+    timer->period = 0;
+    clockChanged.notify_all();
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    lock_guard<mutex> guard(clockLock);
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = true;
+    timer->deadline = now() + (int64_t)period;
+    timer->period = period;
+    clockChanged.notify_all();
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    lock_guard<mutex> guard(clockLock);
+    if (!timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    lock_guard<mutex> guard(clockLock);
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (size_t i = 0; i < timers.size(); i++) {
+        if (timers[i] == timer) {
+            timers.erase(timers.begin() + i);
+            break;
+        }
+    }
+    delete timer;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    lock_guard<mutex> guard(clockLock);
+    return timer->active;
+}
+
+size_t HostMock::getTimerCount()
+{
+    lock_guard<mutex> guard(clockLock);
+    return timers.size();
+}
+
+void HostMock::freezeTime(bool freeze)
+{
+    lock_guard<mutex> guard(clockLock);
+    if (freeze == frozen) {
+        return;
+    }
+    if (freeze) {
+        frozenTime = now();
+        frozen = true;
+    } else {
+        frozen = false;
+        offset += frozenTime - now();
+    }
+}
+
+void HostMock::advanceTime(int64_t us)
+{
+    unique_lock<mutex> guard(clockLock);
+    if (frozen) {
+        frozenTime += us;
+    } else {
+        offset += us;
+    }
+    if (!dispatcherRunning) {
+        return;
+    }
+    //wait for a dispatcher pass which started after the clock moved
+    uint64_t generation = ++requested;
+    clockChanged.notify_all();
+    clockChanged.wait(guard, [generation]() { return processed >= generation; });
+}
@@ -0,0 +1,239 @@
+/*!
+ * @file 	    esp_wifi.cpp
+ * @brief 	    Host mock of the wifi driver, records the calls of the component
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <cstring>
+#include <mutex>
+
+#include "esp_wifi.h"
+#include "esp_timer.h"
+#include "esp_eap_client.h"
+#include "esp_wnm.h"
+#include "esp_phy_init.h"
+#include "host_mock.h"
+
+using namespace std;
+
+static mutex wifiLock;
+static HostMock::WifiCalls calls;
+static uint8_t stationMac[6] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x01 };
+static wifi_config_t stationConfig;
+static bool started = false;
+static int8_t apRssi = -50;
+static uint8_t apChannel = 1;
+static bool associated = false;
+
+esp_err_t esp_wifi_init(const wifi_init_config_t* config)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_storage(wifi_storage_t storage)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t* conf)
+{
+    lock_guard<mutex> guard(wifiLock);
+    stationConfig = *conf;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t* conf)
+{
+    lock_guard<mutex> guard(wifiLock);
+    *conf = stationConfig;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void)
+{
+    lock_guard<mutex> guard(wifiLock);
+    calls.start++;
+    started = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_stop(void)
+{
+    lock_guard<mutex> guard(wifiLock);
+    calls.stop++;
+    started = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_connect(void)
+{
+    int64_t now = esp_timer_get_time();
+    lock_guard<mutex> guard(wifiLock);
+    if (!started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    calls.connect++;
+    calls.lastConnectUs = now;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_disconnect(void)
+{
+    lock_guard<mutex> guard(wifiLock);
+    calls.disconnect++;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_start(const wifi_scan_config_t* config, bool block)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_stop(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_get_ap_num(uint16_t* number)
+{
+    *number = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_get_ap_records(uint16_t* number, wifi_ap_record_t* ap_records)
+{
+    *number = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_clear_ap_list(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t* ap_info)
+{
+    lock_guard<mutex> guard(wifiLock);
+    if (!associated) {
+        return ESP_ERR_WIFI_NOT_CONNECT;
+    }
+    memset(ap_info, 0, sizeof(wifi_ap_record_t));
+    ap_info->rssi = apRssi;
+    ap_info->primary = apChannel;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_channel(uint8_t* primary, wifi_second_chan_t* second)
+{
+    lock_guard<mutex> guard(wifiLock);
+    *primary = apChannel;
+    *second = WIFI_SECOND_CHAN_NONE;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t interface, uint8_t mac[6])
+{
+    lock_guard<mutex> guard(wifiLock);
+    memcpy(mac, stationMac, 6);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_ps(wifi_ps_type_t* type)
+{
+    *type = WIFI_PS_MIN_MODEM;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_rssi_threshold(int32_t rssi)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_bandwidth(wifi_interface_t interface, wifi_bandwidth_t bw)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_enterprise_enable(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_enterprise_disable(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_eap_client_set_identity(const unsigned char* identity, int len)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_eap_client_set_username(const unsigned char* username, int len)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_eap_client_set_password(const unsigned char* password, int len)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_eap_client_set_ca_cert(const unsigned char* ca_cert, int ca_cert_len)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_eap_client_set_certificate_and_key(const unsigned char* client_cert, int client_cert_len,
+    const unsigned char* private_key, int private_key_len, const unsigned char* private_key_password, int private_key_passwd_len)
+{
+    return ESP_OK;
+}
+
+int esp_wnm_send_bss_transition_mgmt_query(enum btm_query_reason query_reason, const char* btm_candidates, int cand_list)
+{
+    return 0;
+}
+
+esp_err_t esp_phy_erase_cal_data_in_nvs(void)
+{
+    return ESP_OK;
+}
+
+HostMock::WifiCalls HostMock::getWifiCalls()
+{
+    lock_guard<mutex> guard(wifiLock);
+    return calls;
+}
+
+void HostMock::setMac(const uint8_t* mac)
+{
+    lock_guard<mutex> guard(wifiLock);
+    memcpy(stationMac, mac, 6);
+}
+
+void HostMock::setAccessPoint(int8_t rssi, uint8_t channel)
+{
+    lock_guard<mutex> guard(wifiLock);
+    apRssi = rssi;
+    apChannel = channel;
+}
+
+void HostMock::setAssociated(bool associated)
+{
+    lock_guard<mutex> guard(wifiLock);
+    ::associated = associated;
+}
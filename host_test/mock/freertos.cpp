@@ -0,0 +1,384 @@
+/*!
+ * @file 	    freertos.cpp
+ * @brief 	    Host mock of FreeRTOS tasks, queues, semaphores and critical sections
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+using namespace std;
+
+struct tskTaskControlBlock{
+    char name[configMAX_TASK_NAME_LEN];
+    mutex lock;
+    condition_variable notified;
+    uint32_t notification = 0;
+    bool pending = false;
+};
+
+struct QueueDefinition{
+    mutex lock;
+    condition_variable changed;
+    size_t itemSize;
+    size_t length;
+    deque<vector<uint8_t>> items;
+    bool isMutex = false;
+    TaskHandle_t holder = NULL;
+};
+
+struct EventGroupDef_t{
+    mutex lock;
+    condition_variable changed;
+    EventBits_t bits = 0;
+};
+
+static recursive_mutex criticalSection;
+static thread_local TaskHandle_t currentTask = NULL;
+static const chrono::steady_clock::time_point bootTime = chrono::steady_clock::now();
+
+//waits on a condition variable for ticks (1 ms), portMAX_DELAY waits forever
+template <typename Predicate>
+static bool waitTicks(condition_variable& condition, unique_lock<mutex>& guard, TickType_t ticks, Predicate predicate)
+{
+    if (ticks == portMAX_DELAY) {
+        condition.wait(guard, predicate);
+        return true;
+    }
+    return condition.wait_for(guard, chrono::milliseconds(ticks), predicate);
+}
+
+void vPortEnterCritical(portMUX_TYPE* mux)
+{
+    criticalSection.lock();
+}
+
+void vPortExitCritical(portMUX_TYPE* mux)
+{
+    criticalSection.unlock();
+}
+
+/** tasks **/
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t function, const char* name, uint32_t stackDepth,
+    void* arg, UBaseType_t priority, StackType_t* stack, StaticTask_t* taskBuffer)
+{
+    TaskHandle_t task = new tskTaskControlBlock();
+    strncpy(task->name, name, sizeof(task->name) - 1);
+    task->name[sizeof(task->name) - 1] = '\0';
+    thread([task, function, arg]() {
+        currentTask = task;
+        function(arg);
+    }).detach();
+    return task;
+}
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth,
+    void* arg, UBaseType_t priority, StackType_t* stack, StaticTask_t* taskBuffer, BaseType_t core)
+{
+    return xTaskCreateStatic(function, name, stackDepth, arg, priority, stack, taskBuffer);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    //only self deletion is supported, the control block is kept
+    if (task == NULL || task == xTaskGetCurrentTaskHandle()) {
+        while (true) {
+            this_thread::sleep_for(chrono::hours(1));
+        }
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    this_thread::sleep_for(chrono::milliseconds(ticks));
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - bootTime).count();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (currentTask == NULL) {
+        //threads not created by xTaskCreateStatic, e.g. the test main
+        currentTask = new tskTaskControlBlock();
+        strncpy(currentTask->name, "main", sizeof(currentTask->name));
+    }
+    return currentTask;
+}
+
+char* pcTaskGetName(TaskHandle_t task)
+{
+    if (task == NULL) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    return task->name;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+    BaseType_t result = pdPASS;
+    {
+        lock_guard<mutex> guard(task->lock);
+        switch (action) {
+            case eSetBits:
+                task->notification |= value;
+                break;
+            case eIncrement:
+                task->notification++;
+                break;
+            case eSetValueWithOverwrite:
+                task->notification = value;
+                break;
+            case eSetValueWithoutOverwrite:
+                if (task->pending) {
+                    result = pdFAIL;
+                } else {
+                    task->notification = value;
+                }
+                break;
+            default:
+                break;
+        }
+        task->pending = true;
+    }
+    task->notified.notify_all();
+    return result;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* value, TickType_t ticks)
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    unique_lock<mutex> guard(task->lock);
+    if (!task->pending) {
+        task->notification &= ~clearOnEntry;
+    }
+    if (!waitTicks(task->notified, guard, ticks, [task]() { return task->pending; })) {
+        if (value != NULL) {
+            *value = task->notification;
+        }
+        return pdFALSE;
+    }
+    if (value != NULL) {
+        *value = task->notification;
+    }
+    task->notification &= ~clearOnExit;
+    task->pending = false;
+    return pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks)
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    unique_lock<mutex> guard(task->lock);
+    waitTicks(task->notified, guard, ticks, [task]() { return task->notification != 0; });
+    uint32_t value = task->notification;
+    if (value != 0) {
+        task->notification = clearOnExit ? 0 : value - 1;
+    }
+    task->pending = task->notification != 0;
+    return value;
+}
+
+/** queues **/
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    QueueHandle_t queue = new QueueDefinition();
+    queue->itemSize = itemSize;
+    queue->length = length;
+    return queue;
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t itemSize, uint8_t* storage, StaticQueue_t* queueBuffer)
+{
+    return xQueueCreate(length, itemSize);
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    delete queue;
+}
+
+static BaseType_t queueSend(QueueHandle_t queue, const void* item, TickType_t ticks, bool front)
+{
+    unique_lock<mutex> guard(queue->lock);
+    if (!waitTicks(queue->changed, guard, ticks, [queue]() { return queue->items.size() < queue->length; })) {
+        return errQUEUE_FULL;
+    }
+    vector<uint8_t> copy(queue->itemSize);
+    if (queue->itemSize > 0) {
+        memcpy(copy.data(), item, queue->itemSize);
+    }
+    if (front) {
+        queue->items.push_front(move(copy));
+    } else {
+        queue->items.push_back(move(copy));
+    }
+    if (queue->isMutex) {
+        queue->holder = NULL;
+    }
+    guard.unlock();
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks)
+{
+    return queueSend(queue, item, ticks, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void* item, TickType_t ticks)
+{
+    return queueSend(queue, item, ticks, true);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* higherPriorityTaskWoken)
+{
+    if (higherPriorityTaskWoken != NULL) {
+        *higherPriorityTaskWoken = pdFALSE;
+    }
+    return queueSend(queue, item, 0, false);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks)
+{
+    unique_lock<mutex> guard(queue->lock);
+    if (!waitTicks(queue->changed, guard, ticks, [queue]() { return !queue->items.empty(); })) {
+        return pdFALSE;
+    }
+    if (queue->itemSize > 0) {
+        memcpy(item, queue->items.front().data(), queue->itemSize);
+    }
+    queue->items.pop_front();
+    if (queue->isMutex) {
+        queue->holder = xTaskGetCurrentTaskHandle();
+    }
+    guard.unlock();
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    {
+        lock_guard<mutex> guard(queue->lock);
+        queue->items.clear();
+    }
+    queue->changed.notify_all();
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    lock_guard<mutex> guard(queue->lock);
+    return queue->items.size();
+}
+
+/** semaphores **/
+
+SemaphoreHandle_t xSemaphoreCreateCountingStatic(UBaseType_t maxCount, UBaseType_t initialCount, StaticSemaphore_t* buffer)
+{
+    SemaphoreHandle_t semaphore = xQueueCreate(maxCount, 0);
+    for (UBaseType_t i = 0; i < initialCount; i++) {
+        semaphore->items.emplace_back();
+    }
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t* buffer)
+{
+    return xSemaphoreCreateCountingStatic(1, 0, buffer);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t semaphore = xSemaphoreCreateCountingStatic(1, 1, NULL);
+    semaphore->isMutex = true;
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t* buffer)
+{
+    return xSemaphoreCreateMutex();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+    return xQueueReceive(semaphore, NULL, ticks);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    return xQueueSend(semaphore, NULL, 0);
+}
+
+TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t semaphore)
+{
+    lock_guard<mutex> guard(semaphore->lock);
+    return semaphore->holder;
+}
+
+/** event groups **/
+
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t* buffer)
+{
+    return new EventGroupDef_t();
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    EventBits_t result;
+    {
+        lock_guard<mutex> guard(group->lock);
+        group->bits |= bits;
+        result = group->bits;
+    }
+    group->changed.notify_all();
+    return result;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    lock_guard<mutex> guard(group->lock);
+    EventBits_t result = group->bits;
+    group->bits &= ~bits;
+    return result;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+    lock_guard<mutex> guard(group->lock);
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clearOnExit,
+    BaseType_t waitForAll, TickType_t ticks)
+{
+    unique_lock<mutex> guard(group->lock);
+    auto satisfied = [group, bits, waitForAll]() {
+        return waitForAll ? (group->bits & bits) == bits : (group->bits & bits) != 0;
+    };
+    bool result = waitTicks(group->changed, guard, ticks, satisfied);
+    EventBits_t value = group->bits;
+    if (result && clearOnExit) {
+        group->bits &= ~bits;
+    }
+    return value;
+}
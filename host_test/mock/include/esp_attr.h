@@ -0,0 +1,16 @@
+/*!
+ * @file 	    esp_attr.h
+ * @brief 	    Host mock, memory placement attributes are empty
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+#define EXT_RAM_BSS_ATTR
@@ -0,0 +1,21 @@
+/*!
+ * @file 	    esp_eap_client.h
+ * @brief 	    Host mock of the WPA2-Enterprise supplicant configuration
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+esp_err_t esp_wifi_sta_enterprise_enable(void);
+esp_err_t esp_wifi_sta_enterprise_disable(void);
+esp_err_t esp_eap_client_set_identity(const unsigned char* identity, int len);
+esp_err_t esp_eap_client_set_username(const unsigned char* username, int len);
+esp_err_t esp_eap_client_set_password(const unsigned char* password, int len);
+esp_err_t esp_eap_client_set_ca_cert(const unsigned char* ca_cert, int ca_cert_len);
+esp_err_t esp_eap_client_set_certificate_and_key(const unsigned char* client_cert, int client_cert_len,
+    const unsigned char* private_key, int private_key_len, const unsigned char* private_key_password, int private_key_passwd_len);
@@ -0,0 +1,38 @@
+/*!
+ * @file 	    esp_log.h
+ * @brief 	    Host mock of the ESP-IDF logging, filtered by LOG_LOCAL_LEVEL
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#pragma once
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+#ifndef LOG_LOCAL_LEVEL
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#endif
+
+void esp_log_level_set(const char* tag, esp_log_level_t level);
+void host_log(char level, const char* tag, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+#define HOST_LOG(level, letter, tag, format, ...) \
+    do { if (LOG_LOCAL_LEVEL >= level) host_log(letter, tag, format, ##__VA_ARGS__); } while (0)
+
+#define ESP_LOGE(tag, format, ...) HOST_LOG(ESP_LOG_ERROR, 'E', tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HOST_LOG(ESP_LOG_WARN, 'W', tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HOST_LOG(ESP_LOG_INFO, 'I', tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) HOST_LOG(ESP_LOG_DEBUG, 'D', tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) HOST_LOG(ESP_LOG_VERBOSE, 'V', tag, format, ##__VA_ARGS__)
+#define ESP_DRAM_LOGE(tag, format, ...) HOST_LOG(ESP_LOG_ERROR, 'E', tag, format, ##__VA_ARGS__)
+#define ESP_DRAM_LOGW(tag, format, ...) HOST_LOG(ESP_LOG_WARN, 'W', tag, format, ##__VA_ARGS__)
+#define ESP_DRAM_LOGI(tag, format, ...) HOST_LOG(ESP_LOG_INFO, 'I', tag, format, ##__VA_ARGS__)
@@ -0,0 +1,17 @@
+/*!
+ * @file 	    esp_memory_utils.h
+ * @brief 	    Host mock, all memory is internal
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+static inline bool esp_ptr_external_ram(const void* p)
+{
+    return false;
+}
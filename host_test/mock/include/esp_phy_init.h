@@ -0,0 +1,14 @@
+/*!
+ * @file 	    esp_phy_init.h
+ * @brief 	    Host mock of the PHY calibration storage
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+esp_err_t esp_phy_erase_cal_data_in_nvs(void);
@@ -0,0 +1,18 @@
+/*!
+ * @file 	    esp_wnm.h
+ * @brief 	    Host mock of the 802.11v BSS transition query
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#pragma once
+
+enum btm_query_reason {
+    REASON_UNSPECIFIED = 0,
+    REASON_FRAME_LOSS = 1,
+    REASON_RSSI = 5
+};
+
+int esp_wnm_send_bss_transition_mgmt_query(enum btm_query_reason query_reason, const char* btm_candidates, int cand_list);
@@ -0,0 +1,23 @@
+/*!
+ * @file 	    event_groups.h
+ * @brief 	    Host mock of the FreeRTOS event groups
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct EventGroupDef_t* EventGroupHandle_t;
+typedef uint32_t EventBits_t;
+typedef struct { uint8_t unused[32]; } StaticEventGroup_t;
+
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t* buffer);
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group);
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clearOnExit,
+    BaseType_t waitForAll, TickType_t ticks);
@@ -0,0 +1,317 @@
+/*!
+ * @file 	    host_mock.h
+ * @brief 	    Test control of the host mocks (clock, events, driver, flash, NVS)
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#ifndef HostMock_H_
+#define HostMock_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <vector>
+
+#include "esp_event.h"
+#include "esp_partition.h"
+
+/*!
+ * @class   HostMock
+ * @brief   Static Class which controls the mocked ESP-IDF of the host tests
+ *
+ *          esp_timer_get_time() follows the host clock plus the time added
+ *          by advanceTime(). A frozen clock only moves with advanceTime(),
+ *          so measured durations are exact. Timer callbacks run in one
+ *          dispatcher thread like the esp_timer task. Events are delivered
+ *          synchronously in the calling thread by dispatchEvent(). time()
+ *          returns the wall time set by setWallTime(). lwIP runs its
+ *          core calls in one worker thread like the tcpip task, sent
+ *          frames end in a mocked driver which copies them.
+ */
+class HostMock {
+
+/** ******************/
+/** PUBLIC TYPEDEFS **/
+/** ******************/
+public:
+    /*!
+     * @brief   Struct which containes the recorded driver calls
+     */
+    struct WifiCalls{
+        uint32_t start = 0;         /*!< @brief esp_wifi_start*/
+        uint32_t stop = 0;          /*!< @brief esp_wifi_stop*/
+        uint32_t connect = 0;       /*!< @brief esp_wifi_connect*/
+        uint32_t disconnect = 0;    /*!< @brief esp_wifi_disconnect*/
+        int64_t lastConnectUs = 0;  /*!< @brief esp_timer time of the last esp_wifi_connect*/
+    };
+
+    /*!
+     * @brief   Struct which containes the usage of an emulated partition
+     */
+    struct FlashStats{
+        uint64_t bytesWritten = 0;      /*!< @brief bytes passed to esp_partition_write*/
+        uint32_t writes = 0;            /*!< @brief esp_partition_write calls*/
+        uint32_t erases = 0;            /*!< @brief erased sectors*/
+        uint32_t minSectorErases = 0;   /*!< @brief erases of the least erased sector*/
+        uint32_t maxSectorErases = 0;   /*!< @brief erases of the most erased sector*/
+        uint32_t overwrites = 0;        /*!< @brief writes which needed a 0 to 1 bit change (NOR violation)*/
+    };
+
+    /*!
+     * @brief   Struct which containes the work of the mocked lwIP
+     */
+    struct LwipStats{
+        uint64_t stackCopiedBytes = 0;  /*!< @brief payload bytes the socket layer copied (sendto, recvfrom)*/
+        uint32_t pbufAllocs = 0;        /*!< @brief pbuf_alloc calls*/
+        uint32_t headerAllocs = 0;      /*!< @brief header pbufs chained in front, the payload had no headroom*/
+        uint32_t frames = 0;            /*!< @brief frames passed to the driver*/
+        uint64_t frameBytes = 0;        /*!< @brief bytes passed to the driver, headers included*/
+        uint32_t coreCalls = 0;         /*!< @brief messages to the lwIP thread*/
+        uint32_t coreWaits = 0;         /*!< @brief messages the caller waited for*/
+    };
+
+    /*!
+     * @brief   Struct which containes a request served by the mocked esp_http_client
+     */
+    struct HttpRequest{
+        size_t first = 0;   /*!< @brief first byte of the Range*/
+        size_t length = 0;  /*!< @brief requested length*/
+        int status = 0;     /*!< @brief HTTP status of the response*/
+        size_t read = 0;    /*!< @brief payload bytes the client read*/
+    };
+
+    /*!
+     * @brief   Struct which containes the path between the TCP sockets and their peer
+     */
+    struct TcpLink{
+        uint32_t rttMs = 10;        /*!< @brief round trip time*/
+        uint8_t lossPercent = 0;    /*!< @brief lost segments, every 100 / lossPercent-th is retransmitted*/
+    };
+
+    /*!
+     * @brief   Struct which containes the traffic of a TCP socket
+     */
+    struct TcpStats{
+        uint32_t writes = 0;            /*!< @brief send calls*/
+        uint32_t segments = 0;          /*!< @brief segments sent, retransmissions excluded*/
+        uint32_t retransmissions = 0;   /*!< @brief lost segments sent again*/
+        uint64_t frameBytes = 0;        /*!< @brief bytes on the air, headers and retransmissions included*/
+        uint64_t deliveredBytes = 0;    /*!< @brief payload bytes the peer received*/
+        uint64_t latencyUs = 0;         /*!< @brief sum of the times from send to the delivery of each write*/
+        uint32_t maxLatencyUs = 0;      /*!< @brief longest time from send to delivery*/
+        int64_t lastDeliveryUs = 0;     /*!< @brief esp_timer time the peer received the last byte*/
+    };
+
+/** ************************/
+/** PUBLIC STATIC METHODS **/
+/** ************************/
+public:
+    /*!
+     * @brief   Stops or resumes the host clock part of esp_timer_get_time()
+     *
+     * @param   frozen true if only advanceTime() moves the clock
+     */
+    static void freezeTime(bool frozen);
+
+    /*!
+     * @brief   Moves the esp_timer clock forward
+     *
+     *          Returns after the callbacks of all timers which expired
+     *          until the new time have run.
+     *
+     * @param   us time to add
+     */
+    static void advanceTime(int64_t us);
+
+    /*!
+     * @brief   Returns the number of created and not deleted esp_timers
+     *
+     * @return  size_t timers
+     */
+    static size_t getTimerCount();
+
+    /*!
+     * @brief   Sets the wall time returned by time(), 0 is not synchronized
+     *
+     * @param   time seconds since the epoch
+     */
+    static void setWallTime(time_t time);
+
+    /*!
+     * @brief   Calls all handlers registered for an event
+     *
+     * @param   base event base
+     * @param   id event id
+     * @param   data event data, can be NULL
+     */
+    static void dispatchEvent(esp_event_base_t base, int32_t id, void* data = nullptr);
+
+    /*!
+     * @brief   Returns the recorded driver calls
+     *
+     * @return  WifiCalls copy of the counters
+     */
+    static WifiCalls getWifiCalls();
+
+    /*!
+     * @brief   Sets the station MAC address returned by esp_wifi_get_mac
+     *
+     * @param   mac 6 bytes
+     */
+    static void setMac(const uint8_t* mac);
+
+    /*!
+     * @brief   Sets the access point returned by esp_wifi_sta_get_ap_info
+     *
+     * @param   rssi signal of the access point
+     * @param   channel primary channel
+     */
+    static void setAccessPoint(int8_t rssi, uint8_t channel);
+
+    /*!
+     * @brief   Sets whether the station is associated
+     *
+     *          esp_wifi_sta_get_ap_info fails while it is not.
+     *
+     * @param   associated true after the connected event
+     */
+    static void setAssociated(bool associated);
+
+    /*!
+     * @brief   Sets the behaviour of esp_now_send
+     *
+     * @param   airtime time in us the esp_timer clock moves per transmission
+     * @param   acknowledge status passed to the send callback
+     */
+    static void setEspNowLink(uint32_t airtime, bool acknowledge);
+
+    /*!
+     * @brief   Returns the number of esp_now_send calls
+     *
+     * @return  uint32_t transmissions
+     */
+    static uint32_t getEspNowSends();
+
+    /*!
+     * @brief   Adds an erased data partition
+     *
+     * @param   label partition label
+     * @param   size size in bytes, multiple of 4096
+     */
+    static void addPartition(const char* label, uint32_t size);
+
+    /*!
+     * @brief   Returns the usage of a partition added by addPartition()
+     *
+     * @param   label partition label
+     * @return  FlashStats copy of the counters
+     */
+    static FlashStats getFlashStats(const char* label);
+
+    /*!
+     * @brief   Returns the number of nvs_commit calls
+     *
+     * @return  uint32_t commits
+     */
+    static uint32_t getNvsCommits();
+
+    /*!
+     * @brief   Passes a received UDP datagram to the pcb bound to a port
+     *
+     *          Runs the receive callback in the lwIP thread and returns
+     *          after it. The frame of the driver is not counted in
+     *          LwipStats.
+     *
+     * @param   port local port
+     * @param   payload datagram
+     * @param   length size of payload
+     * @return  true if a pcb was bound to port
+     */
+    static bool deliverUdp(uint16_t port, const void* payload, uint16_t length);
+
+    /*!
+     * @brief   Waits until the lwIP thread ran all messages posted before
+     */
+    static void flushLwip();
+
+    /*!
+     * @brief   Returns the work of the mocked lwIP since the start
+     *
+     * @return  LwipStats copy of the counters
+     */
+    static LwipStats getLwipStats();
+
+    /*!
+     * @brief   Sets the payload every url of esp_http_client serves
+     *
+     *          Range requests get 206 with Content-Range, a range behind
+     *          the payload gets 416. Clears the recorded requests.
+     *
+     * @param   size payload size
+     * @param   totalKnown false sends the total of Content-Range as *
+     */
+    static void setHttpPayload(size_t size, bool totalKnown);
+
+    /*!
+     * @brief   Returns a byte of the served payload
+     *
+     * @param   offset position in the payload
+     * @return  uint8_t byte
+     */
+    static uint8_t getHttpPayloadByte(size_t offset);
+
+    /*!
+     * @brief   Breaks the connection of the response which reaches an offset
+     *
+     *          esp_http_client_read returns the bytes up to offset, calls
+     *          drop and fails until the connection is closed.
+     *
+     * @param   offset position in the payload
+     * @param   drop called in the reading task, e.g. to dispatch a disconnect
+     */
+    static void dropHttpAt(size_t offset, std::function<void()> drop);
+
+    /*!
+     * @brief   Returns the requests served since setHttpPayload
+     *
+     * @return  std::vector<HttpRequest> requests in order
+     */
+    static std::vector<HttpRequest> getHttpRequests();
+
+    /*!
+     * @brief   Sets the path of all TCP sockets for the following sends
+     *
+     *          TCP sockets are connected to a peer behind this path. A
+     *          send leaves at once with TCP_NODELAY, without it Nagle holds
+     *          small writes until the outstanding data is acknowledged.
+     *          There is no congestion window and no fast retransmit,
+     *          sends never block and a lost segment delays itself and all
+     *          segments behind it by the retransmission timeout.
+     *
+     * @param   link round trip time and loss
+     */
+    static void setTcpLink(TcpLink const& link);
+
+    /*!
+     * @brief   Returns the traffic of a TCP socket up to the current esp_timer time
+     *
+     * @param   socket TCP socket
+     * @return  TcpStats copy of the counters
+     */
+    static TcpStats getTcpStats(int socket);
+
+    /*!
+     * @brief   Polls a condition, e.g. the result of a component task
+     *
+     * @param   condition polled every ms
+     * @param   timeoutMs maximum wait
+     * @return  true if the condition became true
+     */
+    static bool waitFor(std::function<bool()> condition, uint32_t timeoutMs = 2000);
+};
+
+#endif /* HostMock_H_ */
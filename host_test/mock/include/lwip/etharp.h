@@ -0,0 +1,15 @@
+/*!
+ * @file 	    etharp.h
+ * @brief 	    Host mock of the lwIP ARP module
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#pragma once
+
+#include "lwip/ip4_addr.h"
+#include "lwip/netif.h"
+
+err_t etharp_request(struct netif* netif, const ip4_addr_t* ipaddr);
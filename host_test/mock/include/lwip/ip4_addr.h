@@ -0,0 +1,20 @@
+/*!
+ * @file 	    ip4_addr.h
+ * @brief 	    Host mock of the lwIP IPv4 address
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef struct ip4_addr {
+    uint32_t addr;
+} ip4_addr_t;
+
+#define IP4_ADDR(ipaddr, a, b, c, d) ((ipaddr)->addr = ((uint32_t)((d) & 0xff) << 24) | ((uint32_t)((c) & 0xff) << 16) \
+    | ((uint32_t)((b) & 0xff) << 8) | (uint32_t)((a) & 0xff))
+#define ip4_addr_get_u32(ipaddr) ((ipaddr)->addr)
@@ -0,0 +1,28 @@
+/*!
+ * @file 	    ip_addr.h
+ * @brief 	    Host mock of the lwIP dual stack address, IPv4 only
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#pragma once
+
+#include "lwip/ip4_addr.h"
+
+#define IPADDR_TYPE_V4 0U
+
+typedef struct {
+    union {
+        ip4_addr_t ip4;
+    } u_addr;
+    uint8_t type;
+} ip_addr_t;
+
+extern const ip_addr_t ip_addr_any;
+
+#define IP_ADDR_ANY (&ip_addr_any)
+#define ip_2_ip4(ipaddr) (&((ipaddr)->u_addr.ip4))
+#define ip_addr_copy_from_ip4(dest, src) ((dest).u_addr.ip4 = (src), (dest).type = IPADDR_TYPE_V4)
+#define ip_addr_set_ip4_u32(ipaddr, val) ((ipaddr)->u_addr.ip4.addr = (val), (ipaddr)->type = IPADDR_TYPE_V4)
@@ -0,0 +1,19 @@
+/*!
+ * @file 	    netif.h
+ * @brief 	    Host mock of the lwIP network interface
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#pragma once
+
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+
+struct netif {
+    struct netif* next;
+    ip_addr_t ip_addr;
+    uint16_t mtu;
+};
@@ -0,0 +1,70 @@
+/*!
+ * @file 	    pbuf.h
+ * @brief 	    Host mock of lwIP pbufs, contiguous RAM and custom pbufs
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lwip/err.h"
+
+//header sizes of an IPv4/IPv6 build like ESP-IDF
+#define PBUF_LINK_ENCAPSULATION_HLEN 0
+#define PBUF_LINK_HLEN 14
+#define PBUF_IP_HLEN 40
+#define PBUF_TRANSPORT_HLEN 20
+
+#define MEM_ALIGNMENT 4
+#define LWIP_MEM_ALIGN_SIZE(size) (((size) + MEM_ALIGNMENT - 1U) & ~(MEM_ALIGNMENT - 1U))
+
+//the layer is the headroom in front of the payload
+typedef enum {
+    PBUF_TRANSPORT = PBUF_LINK_ENCAPSULATION_HLEN + PBUF_LINK_HLEN + PBUF_IP_HLEN + PBUF_TRANSPORT_HLEN,
+    PBUF_IP = PBUF_LINK_ENCAPSULATION_HLEN + PBUF_LINK_HLEN + PBUF_IP_HLEN,
+    PBUF_LINK = PBUF_LINK_ENCAPSULATION_HLEN + PBUF_LINK_HLEN,
+    PBUF_RAW_TX = PBUF_LINK_ENCAPSULATION_HLEN,
+    PBUF_RAW = 0
+} pbuf_layer;
+
+typedef enum {
+    PBUF_RAM,
+    PBUF_ROM,
+    PBUF_REF,
+    PBUF_POOL
+} pbuf_type;
+
+#define PBUF_FLAG_IS_CUSTOM 0x02U
+
+struct pbuf {
+    struct pbuf* next;
+    void* payload;
+    uint16_t tot_len;
+    uint16_t len;
+    uint8_t type_internal;
+    uint8_t flags;
+    uint16_t ref;
+    uint8_t if_idx;
+};
+
+typedef void (*pbuf_free_custom_fn)(struct pbuf* p);
+
+struct pbuf_custom {
+    struct pbuf pbuf;
+    pbuf_free_custom_fn custom_free_function;
+};
+
+struct pbuf* pbuf_alloc(pbuf_layer layer, uint16_t length, pbuf_type type);
+struct pbuf* pbuf_alloced_custom(pbuf_layer layer, uint16_t length, pbuf_type type, struct pbuf_custom* p,
+    void* payload_mem, uint16_t payload_mem_len);
+uint8_t pbuf_free(struct pbuf* p);
+void pbuf_ref(struct pbuf* p);
+uint8_t pbuf_add_header(struct pbuf* p, size_t header_size_increment);
+uint8_t pbuf_remove_header(struct pbuf* p, size_t header_size);
+void pbuf_chain(struct pbuf* head, struct pbuf* tail);
+uint16_t pbuf_copy_partial(const struct pbuf* p, void* dataptr, uint16_t len, uint16_t offset);
@@ -0,0 +1,82 @@
+/*!
+ * @file 	    sockets.h
+ * @brief 	    Host mock of the lwIP BSD socket layer for UDP
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lwip/ip4_addr.h"
+
+typedef uint32_t socklen_t;
+typedef uint32_t in_addr_t;
+typedef uint8_t sa_family_t;
+typedef uint16_t in_port_t;
+
+struct in_addr {
+    in_addr_t s_addr;
+};
+
+struct sockaddr {
+    uint8_t sa_len;
+    sa_family_t sa_family;
+    char sa_data[14];
+};
+
+struct sockaddr_in {
+    uint8_t sin_len;
+    sa_family_t sin_family;
+    in_port_t sin_port;
+    struct in_addr sin_addr;
+    char sin_zero[8];
+};
+
+#define AF_INET 2
+#define SOCK_STREAM 1
+#define SOCK_DGRAM 2
+#define IPPROTO_IP 0
+#define IPPROTO_TCP 6
+#define IPPROTO_UDP 17
+#define IP_TOS 1
+#define SOL_SOCKET 0xfff
+#define SO_KEEPALIVE 0x0008
+#define SO_SNDBUF 0x1001
+#define SO_SNDTIMEO 0x1005
+#define TCP_NODELAY 0x01
+#define TCP_KEEPIDLE 0x03
+#define TCP_KEEPINTVL 0x04
+#define TCP_KEEPCNT 0x05
+#define MSG_DONTWAIT 0x08
+
+uint16_t lwip_htons(uint16_t n);
+uint32_t lwip_htonl(uint32_t n);
+
+int lwip_socket(int domain, int type, int protocol);
+int lwip_close(int s);
+int lwip_bind(int s, const struct sockaddr* name, socklen_t namelen);
+int lwip_send(int s, const void* dataptr, size_t size, int flags);
+int lwip_sendto(int s, const void* dataptr, size_t size, int flags, const struct sockaddr* to, socklen_t tolen);
+int lwip_recvfrom(int s, void* mem, size_t len, int flags, struct sockaddr* from, socklen_t* fromlen);
+int lwip_setsockopt(int s, int level, int optname, const void* optval, socklen_t optlen);
+int lwip_getsockopt(int s, int level, int optname, void* optval, socklen_t* optlen);
+
+//LWIP_COMPAT_SOCKETS names
+#define htons(x) lwip_htons(x)
+#define ntohs(x) lwip_htons(x)
+#define htonl(x) lwip_htonl(x)
+#define ntohl(x) lwip_htonl(x)
+#define socket(domain, type, protocol) lwip_socket(domain, type, protocol)
+#define closesocket(s) lwip_close(s)
+#define bind(s, name, namelen) lwip_bind(s, name, namelen)
+#define send(s, dataptr, size, flags) lwip_send(s, dataptr, size, flags)
+#define sendto(s, dataptr, size, flags, to, tolen) lwip_sendto(s, dataptr, size, flags, to, tolen)
+#define recvfrom(s, mem, len, flags, from, fromlen) lwip_recvfrom(s, mem, len, flags, from, fromlen)
+#define setsockopt(s, level, optname, opval, optlen) lwip_setsockopt(s, level, optname, opval, optlen)
+#define getsockopt(s, level, optname, opval, optlen) lwip_getsockopt(s, level, optname, opval, optlen)
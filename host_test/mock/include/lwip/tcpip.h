@@ -0,0 +1,23 @@
+/*!
+ * @file 	    tcpip.h
+ * @brief 	    Host mock of the lwIP thread, one worker thread runs all core calls
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#pragma once
+
+#include "lwip/err.h"
+
+typedef void (*tcpip_callback_fn)(void* ctx);
+
+struct tcpip_api_call_data {
+    err_t err;
+};
+
+typedef err_t (*tcpip_api_call_fn)(struct tcpip_api_call_data* call);
+
+err_t tcpip_callback(tcpip_callback_fn function, void* ctx);
+err_t tcpip_api_call(tcpip_api_call_fn fn, struct tcpip_api_call_data* call);
@@ -0,0 +1,36 @@
+/*!
+ * @file 	    udp.h
+ * @brief 	    Host mock of the lwIP raw UDP API
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#pragma once
+
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+#include "lwip/netif.h"
+
+struct udp_pcb;
+
+typedef void (*udp_recv_fn)(void* arg, struct udp_pcb* pcb, struct pbuf* p, const ip_addr_t* addr, uint16_t port);
+
+struct udp_pcb {
+    struct udp_pcb* next;
+    uint16_t local_port;
+    uint8_t tos;
+    uint8_t ttl;
+    const struct netif* netif;
+    udp_recv_fn recv;
+    void* recv_arg;
+};
+
+struct udp_pcb* udp_new(void);
+void udp_remove(struct udp_pcb* pcb);
+err_t udp_bind(struct udp_pcb* pcb, const ip_addr_t* ipaddr, uint16_t port);
+void udp_bind_netif(struct udp_pcb* pcb, const struct netif* netif);
+void udp_recv(struct udp_pcb* pcb, udp_recv_fn recv, void* recv_arg);
+err_t udp_sendto(struct udp_pcb* pcb, struct pbuf* p, const ip_addr_t* dst_ip, uint16_t dst_port);
+err_t udp_sendto_if(struct udp_pcb* pcb, struct pbuf* p, const ip_addr_t* dst_ip, uint16_t dst_port, struct netif* netif);
@@ -0,0 +1,26 @@
+/*!
+ * @file 	    sdkconfig.h
+ * @brief 	    menuconfig defaults of the WifiClient component for the host build
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#pragma once
+
+#define CONFIG_WIFICLIENT_SCAN_CACHE_SIZE 16
+#define CONFIG_WIFICLIENT_MAX_STAGES 8
+#define CONFIG_WIFICLIENT_STAGE_WORKERS 2
+#define CONFIG_WIFICLIENT_STAGE_STACK_SIZE 4096
+#define CONFIG_WIFICLIENT_TXBATCH_POOL 16
+#define CONFIG_WIFICLIENT_TXBATCH_PAYLOAD 128
+#define CONFIG_WIFICLIENT_OUTBOX_SLOTS 16
+#define CONFIG_WIFICLIENT_OUTBOX_PAYLOAD 256
+#define CONFIG_WIFICLIENT_UDP_TX_BUFFERS 4
+#define CONFIG_WIFICLIENT_UDP_PAYLOAD 1472
+#define CONFIG_WIFICLIENT_TRACE_SPANS 128
+#define CONFIG_WIFICLIENT_ESPNOW_MAX_PEERS 8
+#define CONFIG_WIFICLIENT_ESPNOW_MESSAGE_POOL 8
+
+#define CONFIG_FREERTOS_HZ 1000
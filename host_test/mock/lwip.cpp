@@ -0,0 +1,713 @@
+/*!
+ * @file 	    lwip.cpp
+ * @brief 	    Host mock of the lwIP thread, pbufs, raw UDP, the UDP socket layer and a TCP path model
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "lwip/sockets.h"
+#include "lwip/pbuf.h"
+#include "lwip/udp.h"
+#include "lwip/tcpip.h"
+#include "lwip/etharp.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+#include "host_mock.h"
+
+using namespace std;
+
+#define UDP_HLEN 8
+#define IP_HLEN 20
+#define ETH_HLEN 14
+#define TCP_HLEN 20
+#define TCP_MSS 1436
+//lwIP checks retransmissions in the 500 ms slow timer
+#define TCP_RTO_MIN_US 500000
+#define MAX_SOCKETS 16
+#define EPHEMERAL_PORT 49152
+//the payload of a PBUF_RAM pbuf follows the struct, like MEM_ALIGN in lwIP
+#define PBUF_STRUCT_SIZE LWIP_MEM_ALIGN_SIZE(sizeof(struct pbuf))
+
+struct Socket{
+    bool used = false;
+    struct udp_pcb* pcb = nullptr;  //nullptr for TCP sockets
+    int tos = 0;
+    map<pair<int, int>, vector<uint8_t>> options;
+    mutex lock;
+    deque<struct pbuf*> received;
+    //TCP: written bytes not sent yet and their write time, Nagle holds them
+    deque<pair<int64_t, uint32_t>> unsent;
+    uint32_t unsentBytes = 0;
+    int64_t ackUs = 0;              //all sent data is acknowledged at this time
+    HostMock::TcpStats tcp;
+};
+
+struct Core{
+    mutex lock;
+    condition_variable changed;
+    deque<function<void()>> messages;
+    thread worker;
+    thread::id id;
+};
+
+const ip_addr_t ip_addr_any = {};
+
+static struct netif stationLwipNetif = {nullptr, {}, 1500};
+static Core core;
+static once_flag coreStarted;
+static vector<struct udp_pcb*> pcbs;
+static uint16_t nextPort = EPHEMERAL_PORT;
+static Socket sockets[MAX_SOCKETS];
+static mutex tcpLinkLock;
+static HostMock::TcpLink tcpLink;
+//SYS_ARCH_PROTECT of the reference counts, pbufs are freed in any thread
+static mutex pbufLock;
+
+static atomic<uint64_t> stackCopiedBytes(0);
+static atomic<uint32_t> pbufAllocs(0);
+static atomic<uint32_t> headerAllocs(0);
+static atomic<uint32_t> frames(0);
+static atomic<uint64_t> frameBytes(0);
+static atomic<uint32_t> coreCalls(0);
+static atomic<uint32_t> coreWaits(0);
+
+static void coreLoop()
+{
+    unique_lock<mutex> guard(core.lock);
+    while (true) {
+        core.changed.wait(guard, []() { return !core.messages.empty(); });
+        function<void()> message = move(core.messages.front());
+        core.messages.pop_front();
+        guard.unlock();
+        message();
+        guard.lock();
+    }
+}
+
+//posts a message to the lwIP thread, waits for it if requested
+static void runInCore(function<void()> message, bool wait, bool counted = true)
+{
+    call_once(coreStarted, []() {
+        core.worker = thread(coreLoop);
+        core.id = core.worker.get_id();
+        core.worker.detach();
+    });
+    coreCalls += counted;
+    if (this_thread::get_id() == core.id) {
+        message();
+        return;
+    }
+    if (!wait) {
+        lock_guard<mutex> guard(core.lock);
+        core.messages.push_back(move(message));
+        core.changed.notify_all();
+        return;
+    }
+
+    coreWaits += counted;
+    mutex doneLock;
+    condition_variable doneChanged;
+    bool done = false;
+    {
+        lock_guard<mutex> guard(core.lock);
+        core.messages.push_back([&]() {
+            message();
+            lock_guard<mutex> doneGuard(doneLock);
+            done = true;
+            doneChanged.notify_all();
+        });
+        core.changed.notify_all();
+    }
+    unique_lock<mutex> doneGuard(doneLock);
+    doneChanged.wait(doneGuard, [&]() { return done; });
+}
+
+static Socket* socketOf(int s)
+{
+    if (s < 0 || s >= MAX_SOCKETS || !sockets[s].used) {
+        errno = EBADF;
+        return nullptr;
+    }
+    return &sockets[s];
+}
+
+err_t tcpip_callback(tcpip_callback_fn function, void* ctx)
+{
+    runInCore([=]() { function(ctx); }, false);
+    return ERR_OK;
+}
+
+err_t tcpip_api_call(tcpip_api_call_fn fn, struct tcpip_api_call_data* call)
+{
+    err_t result = ERR_OK;
+    runInCore([&]() { result = fn(call); }, true);
+    return result;
+}
+
+//allocates a contiguous pbuf without counting it, the driver of the mock uses it
+static struct pbuf* newPbuf(pbuf_layer layer, uint16_t length, pbuf_type type)
+{
+    size_t offset = LWIP_MEM_ALIGN_SIZE((size_t)layer);
+    struct pbuf* p = (struct pbuf*)malloc(PBUF_STRUCT_SIZE + offset + length);
+    if (p == NULL) {
+        return NULL;
+    }
+    memset(p, 0, sizeof(struct pbuf));
+    p->payload = (uint8_t*)p + PBUF_STRUCT_SIZE + offset;
+    p->tot_len = length;
+    p->len = length;
+    p->type_internal = (uint8_t)type;
+    p->ref = 1;
+    return p;
+}
+
+struct pbuf* pbuf_alloc(pbuf_layer layer, uint16_t length, pbuf_type type)
+{
+    struct pbuf* p = newPbuf(layer, length, type);
+    if (p != NULL) {
+        pbufAllocs++;
+    }
+    return p;
+}
+
+struct pbuf* pbuf_alloced_custom(pbuf_layer layer, uint16_t length, pbuf_type type, struct pbuf_custom* p,
+    void* payload_mem, uint16_t payload_mem_len)
+{
+    size_t offset = LWIP_MEM_ALIGN_SIZE((size_t)layer);
+    if (offset + length > payload_mem_len) {
+        return NULL;
+    }
+    p->pbuf.next = NULL;
+    p->pbuf.payload = (uint8_t*)payload_mem + offset;
+    p->pbuf.tot_len = length;
+    p->pbuf.len = length;
+    p->pbuf.type_internal = (uint8_t)type;
+    p->pbuf.flags = PBUF_FLAG_IS_CUSTOM;
+    p->pbuf.ref = 1;
+    return &p->pbuf;
+}
+
+uint8_t pbuf_free(struct pbuf* p)
+{
+    uint8_t freed = 0;
+    while (p != NULL) {
+        {
+            lock_guard<mutex> guard(pbufLock);
+            if (--p->ref > 0) {
+                break;
+            }
+        }
+        struct pbuf* next = p->next;
+        if ((p->flags & PBUF_FLAG_IS_CUSTOM) != 0) {
+            ((struct pbuf_custom*)p)->custom_free_function(p);
+        } else {
+            free(p);
+        }
+        freed++;
+        p = next;
+    }
+    return freed;
+}
+
+void pbuf_ref(struct pbuf* p)
+{
+    lock_guard<mutex> guard(pbufLock);
+    p->ref++;
+}
+
+uint8_t pbuf_add_header(struct pbuf* p, size_t header_size_increment)
+{
+    //like lwIP, the headers may only grow into the room behind the pbuf struct
+    uint8_t* payload = (uint8_t*)p->payload - header_size_increment;
+    if (p->type_internal != PBUF_RAM || payload < (uint8_t*)p + sizeof(struct pbuf)) {
+        return 1;
+    }
+    p->payload = payload;
+    p->len += header_size_increment;
+    p->tot_len += header_size_increment;
+    return 0;
+}
+
+uint8_t pbuf_remove_header(struct pbuf* p, size_t header_size)
+{
+    if (header_size > p->len) {
+        return 1;
+    }
+    p->payload = (uint8_t*)p->payload + header_size;
+    p->len -= header_size;
+    p->tot_len -= header_size;
+    return 0;
+}
+
+void pbuf_chain(struct pbuf* head, struct pbuf* tail)
+{
+    struct pbuf* last = head;
+    for (; last->next != NULL; last = last->next) {
+        last->tot_len += tail->tot_len;
+    }
+    last->tot_len += tail->tot_len;
+    last->next = tail;
+    pbuf_ref(tail);
+}
+
+uint16_t pbuf_copy_partial(const struct pbuf* p, void* dataptr, uint16_t len, uint16_t offset)
+{
+    uint16_t copied = 0;
+    for (; p != NULL && copied < len; p = p->next) {
+        if (offset >= p->len) {
+            offset -= p->len;
+            continue;
+        }
+        uint16_t part = min<uint16_t>(p->len - offset, len - copied);
+        memcpy((uint8_t*)dataptr + copied, (const uint8_t*)p->payload + offset, part);
+        copied += part;
+        offset = 0;
+    }
+    return copied;
+}
+
+struct udp_pcb* udp_new(void)
+{
+    struct udp_pcb* pcb = new udp_pcb();
+    pcb->ttl = 64;
+    pcbs.push_back(pcb);
+    return pcb;
+}
+
+void udp_remove(struct udp_pcb* pcb)
+{
+    for (auto it = pcbs.begin(); it != pcbs.end(); ++it) {
+        if (*it == pcb) {
+            pcbs.erase(it);
+            break;
+        }
+    }
+    delete pcb;
+}
+
+err_t udp_bind(struct udp_pcb* pcb, const ip_addr_t* ipaddr, uint16_t port)
+{
+    if (port == 0) {
+        port = nextPort++;
+    }
+    for (struct udp_pcb* bound : pcbs) {
+        if (bound != pcb && bound->local_port == port) {
+            return ERR_USE;
+        }
+    }
+    pcb->local_port = port;
+    return ERR_OK;
+}
+
+void udp_bind_netif(struct udp_pcb* pcb, const struct netif* netif)
+{
+    pcb->netif = netif;
+}
+
+void udp_recv(struct udp_pcb* pcb, udp_recv_fn recv, void* recv_arg)
+{
+    pcb->recv = recv;
+    pcb->recv_arg = recv_arg;
+}
+
+err_t udp_sendto_if(struct udp_pcb* pcb, struct pbuf* p, const ip_addr_t* dst_ip, uint16_t dst_port, struct netif* netif)
+{
+    static uint8_t driverBuffer[1600];
+
+    if (netif == NULL) {
+        return ERR_RTE;
+    }
+    if (p->tot_len + UDP_HLEN > netif->mtu - IP_HLEN) {
+        return ERR_VAL;
+    }
+    //the UDP header goes in front of the payload or into a new pbuf
+    struct pbuf* q = p;
+    if (pbuf_add_header(p, UDP_HLEN) != 0) {
+        q = pbuf_alloc(PBUF_IP, UDP_HLEN, PBUF_RAM);
+        if (q == NULL) {
+            return ERR_MEM;
+        }
+        headerAllocs++;
+        pbuf_chain(q, p);
+    }
+    if (pbuf_add_header(q, IP_HLEN) != 0 || pbuf_add_header(q, ETH_HLEN) != 0) {
+        if (q != p) {
+            pbuf_free(q);
+        } else {
+            pbuf_remove_header(p, UDP_HLEN);
+        }
+        return ERR_BUF;
+    }
+    memset(q->payload, 0, ETH_HLEN + IP_HLEN + UDP_HLEN);
+
+    //the driver copies the frame into its transmit buffer
+    pbuf_copy_partial(q, driverBuffer, q->tot_len, 0);
+    frames++;
+    frameBytes += q->tot_len;
+
+    pbuf_remove_header(q, ETH_HLEN + IP_HLEN);
+    if (q != p) {
+        pbuf_free(q);
+    } else {
+        pbuf_remove_header(p, UDP_HLEN);
+    }
+    return ERR_OK;
+}
+
+err_t udp_sendto(struct udp_pcb* pcb, struct pbuf* p, const ip_addr_t* dst_ip, uint16_t dst_port)
+{
+    return udp_sendto_if(pcb, p, dst_ip, dst_port, &stationLwipNetif);
+}
+
+err_t etharp_request(struct netif* netif, const ip4_addr_t* ipaddr)
+{
+    frames++;
+    frameBytes += 42;
+    return ERR_OK;
+}
+
+void* esp_netif_get_netif_impl(esp_netif_t* esp_netif)
+{
+    return esp_netif != NULL ? &stationLwipNetif : NULL;
+}
+
+uint16_t lwip_htons(uint16_t n)
+{
+    return (uint16_t)((n << 8) | (n >> 8));
+}
+
+uint32_t lwip_htonl(uint32_t n)
+{
+    return __builtin_bswap32(n);
+}
+
+//the netconn of a socket queues the received pbufs
+static void socketReceive(void* arg, struct udp_pcb* pcb, struct pbuf* p, const ip_addr_t* addr, uint16_t port)
+{
+    Socket* socket = (Socket*)arg;
+    lock_guard<mutex> guard(socket->lock);
+    socket->received.push_back(p);
+}
+
+int lwip_socket(int domain, int type, int protocol)
+{
+    if (domain != AF_INET || (type != SOCK_DGRAM && type != SOCK_STREAM)) {
+        errno = EAFNOSUPPORT;
+        return -1;
+    }
+    int s = -1;
+    runInCore([&]() {
+        for (int i = 0; i < MAX_SOCKETS; i++) {
+            if (!sockets[i].used) {
+                sockets[i].used = true;
+                sockets[i].tos = 0;
+                sockets[i].options.clear();
+                sockets[i].unsent.clear();
+                sockets[i].unsentBytes = 0;
+                sockets[i].ackUs = 0;
+                sockets[i].tcp = HostMock::TcpStats();
+                if (type == SOCK_DGRAM) {
+                    sockets[i].pcb = udp_new();
+                    udp_recv(sockets[i].pcb, &socketReceive, &sockets[i]);
+                }
+                s = i;
+                break;
+            }
+        }
+    }, true);
+    if (s < 0) {
+        errno = ENFILE;
+    }
+    return s;
+}
+
+int lwip_close(int s)
+{
+    Socket* socket = socketOf(s);
+    if (socket == nullptr) {
+        return -1;
+    }
+    runInCore([=]() {
+        if (socket->pcb != nullptr) {
+            udp_remove(socket->pcb);
+        }
+        for (struct pbuf* p : socket->received) {
+            pbuf_free(p);
+        }
+        socket->received.clear();
+        socket->pcb = nullptr;
+        socket->used = false;
+    }, true);
+    return 0;
+}
+
+int lwip_bind(int s, const struct sockaddr* name, socklen_t namelen)
+{
+    Socket* socket = socketOf(s);
+    if (socket == nullptr) {
+        return -1;
+    }
+    const struct sockaddr_in* address = (const struct sockaddr_in*)name;
+    if (socket->pcb == nullptr) {
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+    err_t result = ERR_OK;
+    runInCore([&]() { result = udp_bind(socket->pcb, IP_ADDR_ANY, ntohs(address->sin_port)); }, true);
+    if (result != ERR_OK) {
+        errno = EADDRINUSE;
+        return -1;
+    }
+    return 0;
+}
+
+//sends all unsent bytes at time now, socket->lock has to be taken
+static void tcpTransmit(Socket* socket, int64_t now)
+{
+    HostMock::TcpLink link;
+    {
+        lock_guard<mutex> guard(tcpLinkLock);
+        link = tcpLink;
+    }
+    int64_t rttUs = (int64_t)link.rttMs * 1000;
+    //in order delivery, a retransmission holds back the segments behind it
+    int64_t deliveryUs = max(now, socket->tcp.lastDeliveryUs);
+    uint32_t remaining = socket->unsentBytes;
+    while (remaining > 0) {
+        uint32_t length = min<uint32_t>(remaining, TCP_MSS);
+        remaining -= length;
+        uint32_t frameLength = length + TCP_HLEN + IP_HLEN + ETH_HLEN;
+        socket->tcp.segments++;
+        socket->tcp.frameBytes += frameLength;
+        int64_t segmentUs = now + rttUs / 2;
+        //every n-th segment is lost and repeated after the retransmission timeout
+        if (link.lossPercent > 0 && socket->tcp.segments % (100 / link.lossPercent) == 0) {
+            socket->tcp.retransmissions++;
+            socket->tcp.frameBytes += frameLength;
+            segmentUs += max<int64_t>(TCP_RTO_MIN_US, 2 * rttUs);
+        }
+        deliveryUs = max(deliveryUs, segmentUs);
+    }
+    for (auto const& write : socket->unsent) {
+        uint32_t latencyUs = (uint32_t)(deliveryUs - write.first);
+        socket->tcp.latencyUs += latencyUs;
+        socket->tcp.maxLatencyUs = max(socket->tcp.maxLatencyUs, latencyUs);
+    }
+    socket->tcp.deliveredBytes += socket->unsentBytes;
+    socket->tcp.lastDeliveryUs = deliveryUs;
+    socket->unsent.clear();
+    socket->unsentBytes = 0;
+    socket->ackUs = deliveryUs + rttUs / 2;
+}
+
+//sends the bytes Nagle held back once the outstanding data is acknowledged
+static void tcpProgress(Socket* socket, int64_t now)
+{
+    if (!socket->unsent.empty() && socket->ackUs <= now) {
+        tcpTransmit(socket, max(socket->ackUs, socket->unsent.front().first));
+    }
+}
+
+int lwip_send(int s, const void* dataptr, size_t size, int flags)
+{
+    Socket* socket = socketOf(s);
+    if (socket == nullptr) {
+        return -1;
+    }
+    if (socket->pcb != nullptr) {
+        //UDP sockets of the mock are never connected
+        errno = EDESTADDRREQ;
+        return -1;
+    }
+
+    //TCP: the socket is connected to a peer behind the TcpLink, sends never block
+    int64_t now = esp_timer_get_time();
+    lock_guard<mutex> guard(socket->lock);
+    tcpProgress(socket, now);
+    auto option = socket->options.find(make_pair(IPPROTO_TCP, TCP_NODELAY));
+    bool noDelay = option != socket->options.end() && option->second.size() >= sizeof(int) && *(const int*)option->second.data() != 0;
+    socket->unsent.push_back(make_pair(now, (uint32_t)size));
+    socket->unsentBytes += size;
+    socket->tcp.writes++;
+    stackCopiedBytes += size;
+    //Nagle: small segments wait while data is unacknowledged
+    if (noDelay || socket->ackUs <= now || socket->unsentBytes >= TCP_MSS) {
+        tcpTransmit(socket, now);
+    }
+    return (int)size;
+}
+
+int lwip_sendto(int s, const void* dataptr, size_t size, int flags, const struct sockaddr* to, socklen_t tolen)
+{
+    Socket* socket = socketOf(s);
+    if (socket == nullptr) {
+        return -1;
+    }
+    const struct sockaddr_in* address = (const struct sockaddr_in*)to;
+    if (socket->pcb == nullptr) {
+        errno = ENOTCONN;
+        return -1;
+    }
+    if (address == NULL || tolen < sizeof(struct sockaddr_in) || address->sin_family != AF_INET) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (size > 0xffff - PBUF_TRANSPORT) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    //netconn_send: the data is copied into a pbuf, the caller waits for the lwIP thread
+    struct pbuf* p = pbuf_alloc(PBUF_TRANSPORT, (uint16_t)size, PBUF_RAM);
+    if (p == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    memcpy(p->payload, dataptr, size);
+    stackCopiedBytes += size;
+    ip_addr_t destination;
+    ip_addr_set_ip4_u32(&destination, address->sin_addr.s_addr);
+    uint16_t port = ntohs(address->sin_port);
+    err_t result = ERR_OK;
+    runInCore([&]() {
+        socket->pcb->tos = (uint8_t)socket->tos;
+        result = udp_sendto(socket->pcb, p, &destination, port);
+        pbuf_free(p);
+    }, true);
+    if (result != ERR_OK) {
+        errno = result == ERR_MEM ? ENOMEM : EIO;
+        return -1;
+    }
+    return (int)size;
+}
+
+int lwip_recvfrom(int s, void* mem, size_t len, int flags, struct sockaddr* from, socklen_t* fromlen)
+{
+    Socket* socket = socketOf(s);
+    if (socket == nullptr) {
+        return -1;
+    }
+    //the mock does not block, an empty socket behaves like MSG_DONTWAIT
+    struct pbuf* p = nullptr;
+    {
+        lock_guard<mutex> guard(socket->lock);
+        if (!socket->received.empty()) {
+            p = socket->received.front();
+            socket->received.pop_front();
+        }
+    }
+    if (p == nullptr) {
+        errno = EWOULDBLOCK;
+        return -1;
+    }
+    uint16_t copied = pbuf_copy_partial(p, mem, (uint16_t)min<size_t>(len, p->tot_len), 0);
+    stackCopiedBytes += copied;
+    pbuf_free(p);
+    return copied;
+}
+
+int lwip_setsockopt(int s, int level, int optname, const void* optval, socklen_t optlen)
+{
+    Socket* socket = socketOf(s);
+    if (socket == nullptr) {
+        return -1;
+    }
+    if (level == IPPROTO_IP && optname == IP_TOS) {
+        if (optlen < sizeof(int)) {
+            errno = EINVAL;
+            return -1;
+        }
+        socket->tos = *(const int*)optval;
+    }
+    //any other option is stored as set, getsockopt returns it
+    lock_guard<mutex> guard(socket->lock);
+    socket->options[make_pair(level, optname)].assign((const uint8_t*)optval, (const uint8_t*)optval + optlen);
+    return 0;
+}
+
+int lwip_getsockopt(int s, int level, int optname, void* optval, socklen_t* optlen)
+{
+    Socket* socket = socketOf(s);
+    if (socket == nullptr) {
+        return -1;
+    }
+    lock_guard<mutex> guard(socket->lock);
+    auto option = socket->options.find(make_pair(level, optname));
+    if (option == socket->options.end()) {
+        //never set, lwIP defaults are 0 for the options of the tests
+        memset(optval, 0, *optlen);
+        return 0;
+    }
+    *optlen = min<socklen_t>(*optlen, option->second.size());
+    memcpy(optval, option->second.data(), *optlen);
+    return 0;
+}
+
+bool HostMock::deliverUdp(uint16_t port, const void* payload, uint16_t length)
+{
+    bool delivered = false;
+    runInCore([&]() {
+        //the received frame, wrapped by the netif without a copy on the target
+        struct pbuf* p = newPbuf(PBUF_RAW, length, PBUF_RAM);
+        memcpy(p->payload, payload, length);
+        for (struct udp_pcb* pcb : pcbs) {
+            if (pcb->local_port == port && pcb->recv != nullptr) {
+                ip_addr_t source;
+                ip_addr_set_ip4_u32(&source, stationLwipNetif.ip_addr.u_addr.ip4.addr);
+                pcb->recv(pcb->recv_arg, pcb, p, &source, port);
+                delivered = true;
+                return;
+            }
+        }
+        pbuf_free(p);
+    }, true, false);
+    return delivered;
+}
+
+void HostMock::flushLwip()
+{
+    runInCore([]() {}, true, false);
+}
+
+void HostMock::setTcpLink(TcpLink const& link)
+{
+    lock_guard<mutex> guard(tcpLinkLock);
+    tcpLink = link;
+}
+
+HostMock::TcpStats HostMock::getTcpStats(int s)
+{
+    Socket* socket = socketOf(s);
+    if (socket == nullptr) {
+        return TcpStats();
+    }
+    lock_guard<mutex> guard(socket->lock);
+    tcpProgress(socket, esp_timer_get_time());
+    return socket->tcp;
+}
+
+HostMock::LwipStats HostMock::getLwipStats()
+{
+    LwipStats stats;
+    stats.stackCopiedBytes = stackCopiedBytes;
+    stats.pbufAllocs = pbufAllocs;
+    stats.headerAllocs = headerAllocs;
+    stats.frames = frames;
+    stats.frameBytes = frameBytes;
+    stats.coreCalls = coreCalls;
+    stats.coreWaits = coreWaits;
+    return stats;
+}
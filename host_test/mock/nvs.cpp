@@ -0,0 +1,139 @@
+/*!
+ * @file 	    nvs.cpp
+ * @brief 	    Host mock of NVS, namespaces and keys in a map
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "nvs.h"
+#include "host_mock.h"
+
+using namespace std;
+
+static mutex nvsLock;
+static map<string, map<string, vector<uint8_t>>> namespaces;
+static vector<string> handles;
+static uint32_t commits = 0;
+
+//nvsLock has to be taken
+static map<string, vector<uint8_t>>* findNamespace(nvs_handle_t handle)
+{
+    if (handle == 0 || handle > handles.size()) {
+        return nullptr;
+    }
+    return &namespaces[handles[handle - 1]];
+}
+
+static esp_err_t getValue(nvs_handle_t handle, const char* key, void* out_value, size_t* length)
+{
+    lock_guard<mutex> guard(nvsLock);
+    map<string, vector<uint8_t>>* entries = findNamespace(handle);
+    if (entries == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    auto entry = entries->find(key);
+    if (entry == entries->end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (out_value == NULL) {
+        *length = entry->second.size();
+        return ESP_OK;
+    }
+    if (*length < entry->second.size()) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *length = entry->second.size();
+    memcpy(out_value, entry->second.data(), entry->second.size());
+    return ESP_OK;
+}
+
+static esp_err_t setValue(nvs_handle_t handle, const char* key, const void* value, size_t length)
+{
+    lock_guard<mutex> guard(nvsLock);
+    map<string, vector<uint8_t>>* entries = findNamespace(handle);
+    if (entries == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const uint8_t* bytes = (const uint8_t*)value;
+    (*entries)[key] = vector<uint8_t>(bytes, bytes + length);
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle)
+{
+    lock_guard<mutex> guard(nvsLock);
+    if (open_mode == NVS_READONLY && namespaces.find(name) == namespaces.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    namespaces[name];
+    handles.push_back(name);
+    *out_handle = handles.size();
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length)
+{
+    return getValue(handle, key, out_value, length);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length)
+{
+    return setValue(handle, key, value, length);
+}
+
+esp_err_t nvs_get_u16(nvs_handle_t handle, const char* key, uint16_t* out_value)
+{
+    size_t length = sizeof(uint16_t);
+    return getValue(handle, key, out_value, &length);
+}
+
+esp_err_t nvs_set_u16(nvs_handle_t handle, const char* key, uint16_t value)
+{
+    return setValue(handle, key, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char* key, uint32_t* out_value)
+{
+    size_t length = sizeof(uint32_t);
+    return getValue(handle, key, out_value, &length);
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char* key, uint32_t value)
+{
+    return setValue(handle, key, &value, sizeof(value));
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key)
+{
+    lock_guard<mutex> guard(nvsLock);
+    map<string, vector<uint8_t>>* entries = findNamespace(handle);
+    if (entries == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return entries->erase(key) > 0 ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    lock_guard<mutex> guard(nvsLock);
+    commits++;
+    return ESP_OK;
+}
+
+uint32_t HostMock::getNvsCommits()
+{
+    lock_guard<mutex> guard(nvsLock);
+    return commits;
+}
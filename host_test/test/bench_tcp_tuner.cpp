@@ -0,0 +1,172 @@
+/*!
+ * @file 	    bench_tcp_tuner.cpp
+ * @brief 	    Host benchmark of the WifiTcpTuner profiles on emulated links, latency and frames
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <cstdio>
+
+#include "host_test.h"
+#include "host_mock.h"
+#include "WifiClient.h"
+#include "WifiTcpTuner.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "lwip/sockets.h"
+
+#define LINK_CHECK_MS 1000
+//telemetry stream: a small record every 10 ms for 10 s
+#define WRITES 1000
+#define WRITE_SIZE 32
+#define WRITE_INTERVAL_MS 10
+//longer than any retransmission of the slowest link
+#define DRAIN_MS 5000
+
+/*!
+ * @brief   Struct which containes an emulated link of one link quality
+ */
+struct LinkProfile{
+    const char* name;
+    WifiClient::LinkQuality quality;
+    int8_t rssi;
+    HostMock::TcpLink link;
+};
+
+static const LinkProfile PROFILES[] = {
+    { "GOOD", WifiClient::LinkQuality::GOOD, -50, { 10, 0 } },
+    { "FAIR", WifiClient::LinkQuality::FAIR, -72, { 40, 2 } },
+    { "POOR", WifiClient::LinkQuality::POOR, -85, { 150, 10 } },
+};
+
+static int tunedSocket;
+static int fixedSocket;
+
+static void enterQuality(LinkProfile const& profile)
+{
+    WifiTcpTuner& tuner = WifiTcpTuner::getInstance();
+    HostMock::setAccessPoint(profile.rssi, 6);
+    //the smoothed RSSI needs a few samples to cross a threshold
+    for (int i = 0; i < 20 && tuner.getStats().lastQuality != (int)profile.quality; i++) {
+        uint32_t changes = tuner.getStats().changes;
+        HostMock::advanceTime(LINK_CHECK_MS * 1000);
+        if (WifiClient::getInstance().getLinkQuality() != (WifiClient::LinkQuality)tuner.getStats().lastQuality) {
+            HostMock::waitFor([changes]() { return WifiTcpTuner::getInstance().getStats().changes > changes; });
+        }
+    }
+    TEST_ASSERT_EQUAL((int)profile.quality, tuner.getStats().lastQuality);
+    HostMock::setTcpLink(profile.link);
+}
+
+static void report(const char* path, HostMock::TcpStats const& before, HostMock::TcpStats const& after, int64_t startUs)
+{
+    uint32_t writes = after.writes - before.writes;
+    uint64_t delivered = after.deliveredBytes - before.deliveredBytes;
+    double seconds = (after.lastDeliveryUs - startUs) / 1e6;
+    printf("    %-6s segments %5u  retransmits %3u  air %7llu B  overhead %5.1f %%  latency avg %6.1f ms max %6.1f ms  %7.0f B/s\n",
+        path, after.segments - before.segments, after.retransmissions - before.retransmissions,
+        (unsigned long long)(after.frameBytes - before.frameBytes),
+        100.0 * (after.frameBytes - before.frameBytes - delivered) / (after.frameBytes - before.frameBytes),
+        (after.latencyUs - before.latencyUs) / 1000.0 / writes, after.maxLatencyUs / 1000.0, delivered / seconds);
+}
+
+static void run(LinkProfile const& profile, HostMock::TcpStats& tuned, HostMock::TcpStats& fixed)
+{
+    enterQuality(profile);
+    HostMock::TcpStats tunedBefore = HostMock::getTcpStats(tunedSocket);
+    HostMock::TcpStats fixedBefore = HostMock::getTcpStats(fixedSocket);
+    uint8_t record[WRITE_SIZE] = {};
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < WRITES; i++) {
+        record[0] = (uint8_t)i;
+        TEST_ASSERT_EQUAL(WRITE_SIZE, send(tunedSocket, record, sizeof(record), 0));
+        TEST_ASSERT_EQUAL(WRITE_SIZE, send(fixedSocket, record, sizeof(record), 0));
+        HostMock::advanceTime(WRITE_INTERVAL_MS * 1000);
+    }
+    HostMock::advanceTime(DRAIN_MS * 1000);
+    tuned = HostMock::getTcpStats(tunedSocket);
+    fixed = HostMock::getTcpStats(fixedSocket);
+
+    printf("  %s: rtt %lu ms, loss %u %%\n", profile.name, (unsigned long)profile.link.rttMs, profile.link.lossPercent);
+    report("tuned", tunedBefore, tuned, start);
+    report("fixed", fixedBefore, fixed, start);
+    TEST_ASSERT_EQUAL((uint64_t)WRITES * WRITE_SIZE, tuned.deliveredBytes - tunedBefore.deliveredBytes);
+    TEST_ASSERT_EQUAL((uint64_t)WRITES * WRITE_SIZE, fixed.deliveredBytes - fixedBefore.deliveredBytes);
+
+    //the following profile starts from zero
+    tuned.segments -= tunedBefore.segments;
+    tuned.frameBytes -= tunedBefore.frameBytes;
+    tuned.latencyUs -= tunedBefore.latencyUs;
+    fixed.segments -= fixedBefore.segments;
+    fixed.frameBytes -= fixedBefore.frameBytes;
+    fixed.latencyUs -= fixedBefore.latencyUs;
+}
+
+static void test_good_link()
+{
+    HostMock::TcpStats tuned;
+    HostMock::TcpStats fixed;
+    run(PROFILES[0], tuned, fixed);
+
+    //Nagle is off, every record leaves at once and arrives after half the round trip
+    TEST_ASSERT_EQUAL(WRITES, tuned.segments);
+    TEST_ASSERT_EQUAL((uint64_t)WRITES * PROFILES[0].link.rttMs * 500, tuned.latencyUs);
+    TEST_ASSERT_EQUAL(fixed.frameBytes, tuned.frameBytes);
+}
+
+static void test_fair_link()
+{
+    HostMock::TcpStats tuned;
+    HostMock::TcpStats fixed;
+    run(PROFILES[1], tuned, fixed);
+
+    //the FAIR profile keeps Nagle off, only the probes and the send timeout differ
+    TEST_ASSERT_EQUAL(fixed.segments, tuned.segments);
+    TEST_ASSERT_EQUAL(fixed.latencyUs, tuned.latencyUs);
+}
+
+static void test_poor_link()
+{
+    HostMock::TcpStats tuned;
+    HostMock::TcpStats fixed;
+    run(PROFILES[2], tuned, fixed);
+
+    //Nagle coalesces the records of a round trip into one frame, the latency depends on the retransmissions
+    TEST_ASSERT_TRUE(tuned.segments * 5 < fixed.segments);
+    TEST_ASSERT_TRUE(tuned.frameBytes * 2 < fixed.frameBytes);
+}
+
+int main()
+{
+    HostMock::freezeTime(true);
+    WifiClient& client = WifiClient::getInstance();
+    WifiClient::Config config;
+    config.ssid = "host";
+    config.linkCheckMs = LINK_CHECK_MS;
+    client.init(config);
+    client.connect();
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_START);
+    HostMock::setAssociated(true);
+    HostMock::setAccessPoint(PROFILES[0].rssi, 6);
+    wifi_event_sta_connected_t connected = {};
+    connected.channel = 6;
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &connected);
+    ip_event_got_ip_t gotIp = {};
+    HostMock::dispatchEvent(IP_EVENT, IP_EVENT_STA_GOT_IP, &gotIp);
+    WifiTcpTuner::getInstance().init(WifiTcpTuner::Config());
+
+    //one socket follows the link, the other keeps the GOOD setting of the application
+    tunedSocket = socket(AF_INET, SOCK_STREAM, 0);
+    WifiTcpTuner::getInstance().add(tunedSocket, WifiTcpTuner::ALL_OPTIONS);
+    fixedSocket = socket(AF_INET, SOCK_STREAM, 0);
+    int noDelay = 1;
+    setsockopt(fixedSocket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    printf("%d writes of %d bytes every %d ms\n", WRITES, WRITE_SIZE, WRITE_INTERVAL_MS);
+    RUN_TEST(test_good_link);
+    RUN_TEST(test_fair_link);
+    RUN_TEST(test_poor_link);
+    return hostTestEnd();
+}
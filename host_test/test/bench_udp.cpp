@@ -0,0 +1,261 @@
+/*!
+ * @file 	    bench_udp.cpp
+ * @brief 	    Host benchmark of WifiUdp against the BSD socket path, copies and throughput
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include "host_test.h"
+#include "host_mock.h"
+#include "WifiClient.h"
+#include "WifiTraffic.h"
+#include "WifiUdp.h"
+#include "lwip/sockets.h"
+
+#define DATAGRAMS 20000
+#define PAYLOAD 256
+//UDP, IPv4 and Ethernet header
+#define FRAME_HEADERS 42
+#define BSD_PORT 5000
+#define ZERO_COPY_PORT 5001
+
+/*!
+ * @brief   Struct which containes a sample, the application data of a datagram
+ */
+struct Sample{
+    uint32_t sequence;
+    uint32_t uptimeMs;
+    int16_t readings[(PAYLOAD - 8) / 2];
+};
+
+static_assert(sizeof(Sample) == PAYLOAD, "a sample fills a datagram");
+
+static uint64_t receivedBytes = 0;
+
+static void fill(Sample* sample, uint32_t sequence)
+{
+    sample->sequence = sequence;
+    sample->uptimeMs = sequence * 10;
+    for (size_t i = 0; i < sizeof(sample->readings) / sizeof(sample->readings[0]); i++) {
+        sample->readings[i] = (int16_t)(sequence + i);
+    }
+}
+
+static double elapsedSeconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void report(const char* path, HostMock::LwipStats const& before, HostMock::LwipStats const& after, double seconds)
+{
+    printf("  %-22s copied %9llu B  pbufs %6u  waits %6u  %9.0f datagrams/s  %7.1f MB/s\n", path,
+        (unsigned long long)(after.stackCopiedBytes - before.stackCopiedBytes), after.pbufAllocs - before.pbufAllocs,
+        after.coreWaits - before.coreWaits, DATAGRAMS / seconds, DATAGRAMS * (double)PAYLOAD / seconds / 1e6);
+}
+
+static bool countReceived(void* context, struct pbuf* datagram, const ip_addr_t* address, uint16_t port)
+{
+    //the sample is read in place
+    const Sample* sample = (const Sample*)datagram->payload;
+    if (sample->sequence == 1) {
+        receivedBytes += datagram->tot_len;
+    }
+    return false;
+}
+
+static void test_send_copies_and_throughput()
+{
+    WifiUdp& udp = WifiUdp::getInstance();
+    struct sockaddr_in to = {};
+    to.sin_len = sizeof(to);
+    to.sin_family = AF_INET;
+    to.sin_port = htons(BSD_PORT);
+    to.sin_addr.s_addr = htonl(0xc0a80164);
+    ip4_addr_t address;
+    address.addr = to.sin_addr.s_addr;
+
+    //BSD: the sample is built in an application buffer, sendto copies it into a pbuf
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    TEST_ASSERT_TRUE(s >= 0);
+    WifiTraffic::getInstance().setClass(s, WifiTraffic::TrafficClass::TELEMETRY);
+    Sample sample;
+    HostMock::LwipStats bsdBefore = HostMock::getLwipStats();
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < DATAGRAMS; i++) {
+        fill(&sample, i);
+        TEST_ASSERT_EQUAL(PAYLOAD, WifiTraffic::getInstance().sendTo(s, &sample, sizeof(sample), 0,
+            (struct sockaddr*)&to, sizeof(to)));
+    }
+    double seconds = elapsedSeconds(start);
+    HostMock::LwipStats bsd = HostMock::getLwipStats();
+    report("BSD sendto", bsdBefore, bsd, seconds);
+    WifiTraffic::getInstance().forget(s);
+    closesocket(s);
+
+    TEST_ASSERT_EQUAL((uint64_t)DATAGRAMS * PAYLOAD, bsd.stackCopiedBytes - bsdBefore.stackCopiedBytes);
+    TEST_ASSERT_EQUAL(DATAGRAMS, bsd.pbufAllocs - bsdBefore.pbufAllocs);
+    TEST_ASSERT_EQUAL(DATAGRAMS, bsd.coreWaits - bsdBefore.coreWaits);
+    TEST_ASSERT_EQUAL(DATAGRAMS, bsd.frames - bsdBefore.frames);
+    TEST_ASSERT_EQUAL((uint64_t)DATAGRAMS * (PAYLOAD + FRAME_HEADERS), bsd.frameBytes - bsdBefore.frameBytes);
+
+    //zero-copy: the sample is built in the pool buffer lwIP sends
+    int endpoint = udp.open(0, nullptr, nullptr);
+    udp.setTrafficClass(endpoint, WifiTraffic::TrafficClass::TELEMETRY);
+    HostMock::LwipStats before = HostMock::getLwipStats();
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < DATAGRAMS; i++) {
+        struct pbuf* datagram;
+        while ((datagram = udp.acquire(PAYLOAD)) == nullptr) {
+            std::this_thread::yield();
+        }
+        fill((Sample*)datagram->payload, i);
+        TEST_ASSERT_TRUE(udp.send(endpoint, datagram, address, BSD_PORT));
+    }
+    HostMock::flushLwip();
+    seconds = elapsedSeconds(start);
+    HostMock::LwipStats zeroCopy = HostMock::getLwipStats();
+    report("WifiUdp acquire/send", before, zeroCopy, seconds);
+    udp.close(endpoint);
+
+    TEST_ASSERT_EQUAL(0, zeroCopy.stackCopiedBytes - before.stackCopiedBytes);
+    TEST_ASSERT_EQUAL(0, zeroCopy.pbufAllocs - before.pbufAllocs);
+    TEST_ASSERT_EQUAL(0, zeroCopy.headerAllocs - before.headerAllocs);
+    TEST_ASSERT_EQUAL(0, zeroCopy.coreWaits - before.coreWaits);
+    TEST_ASSERT_EQUAL(DATAGRAMS, zeroCopy.frames - before.frames);
+    //both paths put the same frames on the air
+    TEST_ASSERT_EQUAL(bsd.frameBytes - bsdBefore.frameBytes, zeroCopy.frameBytes - before.frameBytes);
+    TEST_ASSERT_EQUAL(DATAGRAMS, udp.getStats().sent);
+    TEST_ASSERT_EQUAL(0, udp.getStats().sendErrors);
+    TEST_ASSERT_EQUAL(0, udp.getStats().txInUse);
+    TEST_ASSERT_EQUAL(2 * DATAGRAMS, WifiTraffic::getInstance().getStats(WifiTraffic::TrafficClass::TELEMETRY).packets);
+}
+
+static void test_receive_copies_and_throughput()
+{
+    WifiUdp& udp = WifiUdp::getInstance();
+    Sample sample;
+    fill(&sample, 1);
+
+    //BSD: recvfrom copies the pbuf into the application buffer
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in local = {};
+    local.sin_len = sizeof(local);
+    local.sin_family = AF_INET;
+    local.sin_port = htons(BSD_PORT);
+    TEST_ASSERT_EQUAL(0, bind(s, (struct sockaddr*)&local, sizeof(local)));
+    HostMock::LwipStats before = HostMock::getLwipStats();
+    auto start = std::chrono::steady_clock::now();
+    Sample received;
+    for (uint32_t i = 0; i < DATAGRAMS; i++) {
+        TEST_ASSERT_TRUE(HostMock::deliverUdp(BSD_PORT, &sample, sizeof(sample)));
+        TEST_ASSERT_EQUAL(PAYLOAD, recvfrom(s, &received, sizeof(received), MSG_DONTWAIT, nullptr, nullptr));
+    }
+    double seconds = elapsedSeconds(start);
+    HostMock::LwipStats bsd = HostMock::getLwipStats();
+    report("BSD recvfrom", before, bsd, seconds);
+    closesocket(s);
+    TEST_ASSERT_EQUAL((uint64_t)DATAGRAMS * PAYLOAD, bsd.stackCopiedBytes - before.stackCopiedBytes);
+
+    //zero-copy: the callback reads the received pbuf
+    uint32_t receivedBefore = udp.getStats().received;
+    int endpoint = udp.open(ZERO_COPY_PORT, &countReceived, nullptr);
+    receivedBytes = 0;
+    before = HostMock::getLwipStats();
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < DATAGRAMS; i++) {
+        TEST_ASSERT_TRUE(HostMock::deliverUdp(ZERO_COPY_PORT, &sample, sizeof(sample)));
+    }
+    seconds = elapsedSeconds(start);
+    HostMock::LwipStats zeroCopy = HostMock::getLwipStats();
+    report("WifiUdp callback", before, zeroCopy, seconds);
+    udp.close(endpoint);
+
+    TEST_ASSERT_EQUAL(0, zeroCopy.stackCopiedBytes - before.stackCopiedBytes);
+    TEST_ASSERT_EQUAL((uint64_t)DATAGRAMS * PAYLOAD, receivedBytes);
+    TEST_ASSERT_EQUAL(receivedBefore + DATAGRAMS, udp.getStats().received);
+    TEST_ASSERT_EQUAL(0, udp.getStats().rxHeld);
+}
+
+static void foreignFree(struct pbuf* p)
+{
+    TEST_ASSERT_MESSAGE(false, "foreign pbuf freed by WifiUdp");
+}
+
+static void test_foreign_pbuf_rejected()
+{
+    WifiUdp& udp = WifiUdp::getInstance();
+    int endpoint = udp.open(0, nullptr, nullptr);
+    ip4_addr_t address = { 0x0101a8c0 };
+    uint8_t storage[LWIP_MEM_ALIGN_SIZE(PBUF_TRANSPORT) + 64];
+
+    //a custom pbuf of another owner, e.g. the receive buffer of the driver
+    struct pbuf_custom custom;
+    custom.custom_free_function = &foreignFree;
+    struct pbuf* foreign = pbuf_alloced_custom(PBUF_TRANSPORT, 64, PBUF_RAM, &custom, storage, sizeof(storage));
+    struct pbuf* plain = pbuf_alloc(PBUF_TRANSPORT, 64, PBUF_RAM);
+    for (struct pbuf* datagram : { foreign, plain }) {
+        bool thrown = false;
+        try {
+            udp.send(endpoint, datagram, address, BSD_PORT);
+        } catch (std::invalid_argument const&) {
+            thrown = true;
+        }
+        TEST_ASSERT_TRUE(thrown);
+        //the caller keeps its reference
+        TEST_ASSERT_EQUAL(1, datagram->ref);
+    }
+    pbuf_free(plain);
+    udp.close(endpoint);
+}
+
+static void test_close_twice()
+{
+    WifiUdp& udp = WifiUdp::getInstance();
+    int endpoint = udp.open(0, nullptr, nullptr);
+    udp.close(endpoint);
+
+    bool thrown = false;
+    try {
+        udp.close(endpoint);
+    } catch (std::invalid_argument const&) {
+        thrown = true;
+    }
+    TEST_ASSERT_TRUE(thrown);
+
+    //a send on the closed endpoint returns the buffer to the pool
+    struct pbuf* datagram = udp.acquire(PAYLOAD);
+    thrown = false;
+    try {
+        udp.send(endpoint, datagram, ip4_addr_t{ 0x0101a8c0 }, BSD_PORT);
+    } catch (std::invalid_argument const&) {
+        thrown = true;
+    }
+    TEST_ASSERT_TRUE(thrown);
+    TEST_ASSERT_EQUAL(0, udp.getStats().txInUse);
+}
+
+int main()
+{
+    WifiClient::Config config;
+    config.ssid = "host";
+    config.memoryCheckMs = 0;
+    config.linkCheckMs = 0;
+    WifiClient::getInstance().init(config);
+    WifiTraffic::getInstance().init(WifiTraffic::Config());
+    WifiUdp::getInstance().init(WifiUdp::Config());
+
+    printf("%d datagrams of %d bytes\n", DATAGRAMS, PAYLOAD);
+    RUN_TEST(test_send_copies_and_throughput);
+    RUN_TEST(test_receive_copies_and_throughput);
+    RUN_TEST(test_foreign_pbuf_rejected);
+    RUN_TEST(test_close_twice);
+    return hostTestEnd();
+}
@@ -0,0 +1,79 @@
+/*!
+ * @file 	    host_test.h
+ * @brief 	    Minimal assertions of the host tests, Unity naming
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#ifndef HostTest_H_
+#define HostTest_H_
+
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+//failures of the running test
+static int hostTestFailures = 0;
+//failed tests
+static int hostTestFailed = 0;
+
+#define TEST_ASSERT_MESSAGE(condition, message) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, message); \
+            hostTestFailures++; \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) TEST_ASSERT_MESSAGE(condition, #condition)
+#define TEST_ASSERT_TRUE(condition) TEST_ASSERT_MESSAGE(condition, #condition)
+#define TEST_ASSERT_FALSE(condition) TEST_ASSERT_MESSAGE(!(condition), "!(" #condition ")")
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        long long hostExpected = (long long)(expected); \
+        long long hostActual = (long long)(actual); \
+        if (hostExpected != hostActual) { \
+            fprintf(stderr, "%s:%d: %s expected %lld, was %lld\n", __FILE__, __LINE__, #actual, hostExpected, hostActual); \
+            hostTestFailures++; \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_INT_WITHIN(delta, expected, actual) \
+    do { \
+        long long hostExpected = (long long)(expected); \
+        long long hostActual = (long long)(actual); \
+        if (llabs(hostExpected - hostActual) > (long long)(delta)) { \
+            fprintf(stderr, "%s:%d: %s expected %lld +- %lld, was %lld\n", __FILE__, __LINE__, #actual, \
+                hostExpected, (long long)(delta), hostActual); \
+            hostTestFailures++; \
+        } \
+    } while (0)
+
+#define RUN_TEST(test) \
+    do { \
+        hostTestFailures = 0; \
+        test(); \
+        printf("%s %s\n", hostTestFailures == 0 ? "PASS" : "FAIL", #test); \
+        hostTestFailed += hostTestFailures != 0; \
+    } while (0)
+
+/*!
+ * @brief   Ends the test program
+ *
+ *          The component tasks run forever and the singletons are never
+ *          destroyed on the target, so the process ends without static
+ *          destructors.
+ *
+ * @return  int exit code of the test program
+ */
+static inline int hostTestEnd()
+{
+    fflush(stdout);
+    fflush(stderr);
+    _exit(hostTestFailed == 0 ? 0 : 1);
+}
+
+#endif /* HostTest_H_ */
@@ -0,0 +1,173 @@
+/*!
+ * @file 	    test_connect_timing.cpp
+ * @brief 	    Host test of the handshake timing of WifiClient with a frozen clock
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <cstring>
+
+#include "host_test.h"
+#include "host_mock.h"
+#include "WifiClient.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+
+static const uint8_t BSSID_A[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x0a };
+static const uint8_t BSSID_B[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x0b };
+static const uint8_t BSSID_C[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x0c };
+
+static void associate(const uint8_t* bssid)
+{
+    wifi_event_sta_connected_t connected = {};
+    memcpy(connected.bssid, bssid, 6);
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &connected);
+}
+
+static void gotIp()
+{
+    ip_event_got_ip_t gotIp = {};
+    HostMock::dispatchEvent(IP_EVENT, IP_EVENT_STA_GOT_IP, &gotIp);
+}
+
+static void lost(uint8_t reason)
+{
+    wifi_event_sta_disconnected_t disconnected = {};
+    disconnected.reason = reason;
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &disconnected);
+}
+
+static void test_first_attempt_is_full()
+{
+    WifiClient& client = WifiClient::getInstance();
+
+    client.connect();
+    HostMock::advanceTime(250000);
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_START);
+    HostMock::advanceTime(1200000);
+    associate(BSSID_A);
+    HostMock::advanceTime(400000);
+    gotIp();
+
+    WifiClient::HandshakeStats stats = client.getHandshakeStats();
+    TEST_ASSERT_EQUAL(1, stats.full.count);
+    TEST_ASSERT_EQUAL(1200000, stats.full.lastUs);
+    TEST_ASSERT_EQUAL(0, stats.resumed.count);
+    TEST_ASSERT_TRUE(client.isConnected());
+}
+
+static void test_roam_without_attempt_is_not_recorded()
+{
+    WifiClient& client = WifiClient::getInstance();
+
+    //driver roams on its own, the attempt start is long gone
+    HostMock::advanceTime(60000000);
+    associate(BSSID_B);
+    HostMock::advanceTime(1000);
+    associate(BSSID_B);
+
+    WifiClient::HandshakeStats stats = client.getHandshakeStats();
+    TEST_ASSERT_EQUAL(1, stats.full.count);
+    TEST_ASSERT_EQUAL(1200000, stats.full.maxUs);
+    TEST_ASSERT_EQUAL(0, stats.resumed.count);
+    TEST_ASSERT_EQUAL(1, client.getHandoffStats().seamless);
+}
+
+static void test_handoff_is_resumed()
+{
+    WifiClient& client = WifiClient::getInstance();
+
+    lost(WIFI_REASON_BEACON_TIMEOUT);
+    HostMock::advanceTime(80000);
+    associate(BSSID_C);
+
+    WifiClient::HandshakeStats stats = client.getHandshakeStats();
+    TEST_ASSERT_EQUAL(1, stats.full.count);
+    TEST_ASSERT_EQUAL(1, stats.resumed.count);
+    TEST_ASSERT_EQUAL(80000, stats.resumed.lastUs);
+    TEST_ASSERT_EQUAL(1, client.getHandoffStats().count);
+}
+
+static void test_known_bssid_is_resumed_with_8021x()
+{
+    WifiClient& client = WifiClient::getInstance();
+
+    //grace time passes, the connection is lost for good
+    lost(WIFI_REASON_BEACON_TIMEOUT);
+    HostMock::advanceTime(3000000);
+    TEST_ASSERT_FALSE(client.isConnected());
+
+    //the failed attempt restarts the measurement
+    lost(WIFI_REASON_NO_AP_FOUND);
+    HostMock::advanceTime(150000);
+    associate(BSSID_A);
+
+    WifiClient::HandshakeStats stats = client.getHandshakeStats();
+    TEST_ASSERT_EQUAL(1, stats.full.count);
+    TEST_ASSERT_EQUAL(2, stats.resumed.count);
+    TEST_ASSERT_EQUAL(150000, stats.resumed.lastUs);
+    TEST_ASSERT_EQUAL(230000, stats.resumed.totalUs);
+}
+
+static void test_estimate_from_samples()
+{
+    WifiClient& client = WifiClient::getInstance();
+
+    //driver running, known BSSID: resumed average of 80 and 150 ms, no renewal measured yet
+    WifiClient::ConnectEstimate estimate = client.estimateConnect();
+    TEST_ASSERT_EQUAL(0, estimate.driverStartMs);
+    TEST_ASSERT_EQUAL(97, estimate.associationMs);
+    TEST_ASSERT_EQUAL(300, estimate.dhcpMs);
+    TEST_ASSERT_FALSE(estimate.fromHistory);
+
+    HostMock::advanceTime(120000);
+    gotIp();
+    TEST_ASSERT_EQUAL(0, client.estimateConnect().timeToIpMs);
+
+    //a new driver session starts without cache, the roam did not pollute the full average
+    client.disconnect();
+    estimate = client.estimateConnect();
+    TEST_ASSERT_EQUAL(250, estimate.driverStartMs);
+    TEST_ASSERT_EQUAL(1200, estimate.associationMs);
+    TEST_ASSERT_EQUAL(400, estimate.dhcpMs);
+    TEST_ASSERT_EQUAL(1850, estimate.timeToIpMs);
+    TEST_ASSERT_EQUAL(1850 * 120 * 3300 / 1000000, estimate.energyMj);
+    TEST_ASSERT_TRUE(estimate.fromHistory);
+}
+
+static WifiClient::Config clientConfig()
+{
+    WifiClient::Config config;
+    config.ssid = "host";
+    config.enterprise.identity = "device";
+    config.enterprise.username = "device";
+    config.enterprise.password = "password";
+    config.fastTransition = true;
+    config.memoryCheckMs = 0;
+    config.linkCheckMs = 0;
+    return config;
+}
+
+static void test_reinit_keeps_timers()
+{
+    //the handoff timer is created once like the other timers
+    size_t timers = HostMock::getTimerCount();
+    WifiClient::getInstance().init(clientConfig());
+    TEST_ASSERT_EQUAL(timers, HostMock::getTimerCount());
+}
+
+int main()
+{
+    HostMock::freezeTime(true);
+    WifiClient::getInstance().init(clientConfig());
+
+    RUN_TEST(test_first_attempt_is_full);
+    RUN_TEST(test_roam_without_attempt_is_not_recorded);
+    RUN_TEST(test_handoff_is_resumed);
+    RUN_TEST(test_known_bssid_is_resumed_with_8021x);
+    RUN_TEST(test_estimate_from_samples);
+    RUN_TEST(test_reinit_keeps_timers);
+    return hostTestEnd();
+}
@@ -0,0 +1,181 @@
+/*!
+ * @file 	    test_downloader.cpp
+ * @brief 	    Host test of the resumable chunked downloads of WifiDownloader
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "host_test.h"
+#include "host_mock.h"
+#include "WifiClient.h"
+#include "WifiDownloader.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+
+#define URL "http://host/firmware.bin"
+#define GOOD_RSSI -50
+#define WEAK_RSSI -85
+
+/*!
+ * @brief   Sink which collects the payload in RAM, reads at most 1 KB at once
+ */
+class VectorSink : public WifiDownloader::Sink {
+public:
+    std::vector<uint8_t> data;
+
+    uint8_t* acquire(size_t& length) override
+    {
+        //bytes of a failed read were never committed
+        data.resize(committed);
+        length = length < 1024 ? length : 1024;
+        data.resize(committed + length);
+        return data.data() + committed;
+    }
+
+    bool commit(size_t length) override
+    {
+        committed += length;
+        data.resize(committed);
+        return true;
+    }
+
+private:
+    size_t committed = 0;
+};
+
+static void connected()
+{
+    wifi_event_sta_connected_t connected = {};
+    connected.channel = 6;
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &connected);
+    ip_event_got_ip_t gotIp = {};
+    HostMock::dispatchEvent(IP_EVENT, IP_EVENT_STA_GOT_IP, &gotIp);
+}
+
+static bool samePayload(VectorSink const& sink, size_t size)
+{
+    if (sink.data.size() != size) {
+        return false;
+    }
+    for (size_t i = 0; i < size; i++) {
+        if (sink.data[i] != HostMock::getHttpPayloadByte(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_resume_after_drop()
+{
+    const size_t size = 200000;
+    const size_t dropAt = 20000;
+    VectorSink sink;
+    std::thread reconnect;
+    HostMock::setHttpPayload(size, true);
+    HostMock::setAccessPoint(GOOD_RSSI, 6);
+
+    //the link drops in the middle of the second chunk and comes back weak
+    HostMock::dropHttpAt(dropAt, [&reconnect]() {
+        wifi_event_sta_disconnected_t disconnected = {};
+        disconnected.reason = WIFI_REASON_BEACON_TIMEOUT;
+        HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &disconnected);
+        reconnect = std::thread([]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            HostMock::setAccessPoint(WEAK_RSSI, 6);
+            connected();
+        });
+    });
+    WifiDownloader::Result result = WifiDownloader::getInstance().download(URL, sink);
+    reconnect.join();
+
+    TEST_ASSERT_TRUE(result.status == WifiDownloader::Status::DONE);
+    TEST_ASSERT_EQUAL(size, result.offset);
+    TEST_ASSERT_EQUAL(size, result.total);
+    TEST_ASSERT_EQUAL(1, result.pauses);
+    TEST_ASSERT_EQUAL(0, result.failures);
+    TEST_ASSERT_TRUE(samePayload(sink, size));
+
+    std::vector<HostMock::HttpRequest> requests = HostMock::getHttpRequests();
+    TEST_ASSERT_TRUE(requests.size() > 3);
+    TEST_ASSERT_EQUAL(16384, requests[0].length);
+    TEST_ASSERT_EQUAL(24576, requests[1].length);
+    TEST_ASSERT_EQUAL(dropAt - 16384, requests[1].read);
+    //resumed at the first missing byte, halved after the drop and again for the weak link
+    TEST_ASSERT_EQUAL(dropAt, requests[2].first);
+    TEST_ASSERT_EQUAL(24576 / 4, requests[2].length);
+
+    //every request starts behind the bytes read before, no byte is fetched twice
+    size_t read = 0;
+    for (HostMock::HttpRequest const& request : requests) {
+        TEST_ASSERT_EQUAL(read, request.first);
+        TEST_ASSERT_EQUAL(206, request.status);
+        read += request.read;
+    }
+    TEST_ASSERT_EQUAL(size, read);
+    HostMock::setAccessPoint(GOOD_RSSI, 6);
+}
+
+static void test_unknown_total_ends_with_short_chunk()
+{
+    //16384 + 24576 + 9040, Content-Range bytes first-last/*
+    const size_t size = 50000;
+    VectorSink sink;
+    HostMock::setHttpPayload(size, false);
+
+    WifiDownloader::Result result = WifiDownloader::getInstance().download(URL, sink);
+    TEST_ASSERT_TRUE(result.status == WifiDownloader::Status::DONE);
+    TEST_ASSERT_EQUAL(size, result.offset);
+    TEST_ASSERT_EQUAL(size, result.total);
+    TEST_ASSERT_EQUAL(206, result.httpStatus);
+    TEST_ASSERT_TRUE(samePayload(sink, size));
+
+    std::vector<HostMock::HttpRequest> requests = HostMock::getHttpRequests();
+    TEST_ASSERT_EQUAL(3, requests.size());
+    TEST_ASSERT_EQUAL(9040, requests[2].read);
+}
+
+static void test_unknown_total_ends_on_chunk_boundary()
+{
+    //the payload ends with the second chunk, the third request is behind it
+    const size_t size = 16384 + 24576;
+    VectorSink sink;
+    HostMock::setHttpPayload(size, false);
+
+    WifiDownloader::Result result = WifiDownloader::getInstance().download(URL, sink);
+    TEST_ASSERT_TRUE(result.status == WifiDownloader::Status::DONE);
+    TEST_ASSERT_EQUAL(size, result.offset);
+    TEST_ASSERT_EQUAL(size, result.total);
+    TEST_ASSERT_EQUAL(416, result.httpStatus);
+    TEST_ASSERT_TRUE(samePayload(sink, size));
+    TEST_ASSERT_EQUAL(3, HostMock::getHttpRequests().size());
+}
+
+int main()
+{
+    WifiClient& client = WifiClient::getInstance();
+    WifiClient::Config config;
+    config.ssid = "host";
+    config.memoryCheckMs = 0;
+    config.linkCheckMs = 0;
+    client.init(config);
+    client.connect();
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_START);
+    HostMock::setAssociated(true);
+    HostMock::setAccessPoint(GOOD_RSSI, 6);
+    connected();
+
+    WifiDownloader::Config downloaderConfig;
+    downloaderConfig.resumeTimeoutMs = 2000;
+    WifiDownloader::getInstance().init(downloaderConfig);
+
+    RUN_TEST(test_resume_after_drop);
+    RUN_TEST(test_unknown_total_ends_with_short_chunk);
+    RUN_TEST(test_unknown_total_ends_on_chunk_boundary);
+    return hostTestEnd();
+}
@@ -0,0 +1,126 @@
+/*!
+ * @file 	    test_espnow.cpp
+ * @brief 	    Host test of the link state and the delivery latency of WifiEspNow
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include "host_test.h"
+#include "host_mock.h"
+#include "WifiEspNow.h"
+#include "esp_wifi.h"
+
+#define AIRTIME_US 2000
+#define HOLD_TIMEOUT_MS 100
+
+static const uint8_t PEER[6] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x02 };
+static const uint8_t PAYLOAD[32] = { 1, 2, 3 };
+
+static void associate(uint8_t channel)
+{
+    wifi_event_sta_connected_t connected = {};
+    connected.channel = channel;
+    HostMock::setAssociated(true);
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &connected);
+}
+
+static void lost()
+{
+    wifi_event_sta_disconnected_t disconnected = {};
+    disconnected.reason = WIFI_REASON_BEACON_TIMEOUT;
+    HostMock::setAssociated(false);
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &disconnected);
+}
+
+static WifiEspNow::Stats stats()
+{
+    return WifiEspNow::getInstance().getStats();
+}
+
+static void test_held_until_associated()
+{
+    WifiEspNow& espNow = WifiEspNow::getInstance();
+
+    //init before the station is associated, nothing may go out on a random channel
+    TEST_ASSERT_TRUE(espNow.send(PEER, PAYLOAD, sizeof(PAYLOAD)));
+    TEST_ASSERT_TRUE(HostMock::waitFor([]() { return stats().held == 1; }));
+    HostMock::advanceTime(30000);
+    TEST_ASSERT_EQUAL(0, HostMock::getEspNowSends());
+
+    associate(6);
+    TEST_ASSERT_TRUE(HostMock::waitFor([]() { return stats().delivered == 1; }));
+    TEST_ASSERT_EQUAL(6, espNow.getChannel());
+    TEST_ASSERT_EQUAL(1, HostMock::getEspNowSends());
+    //held time plus airtime
+    TEST_ASSERT_EQUAL(30000 + AIRTIME_US, stats().maxLatencyUs);
+}
+
+static void test_latency_while_associated()
+{
+    const uint32_t messages = 100;
+    WifiEspNow::Stats before = stats();
+
+    for (uint32_t i = 0; i < messages; i++) {
+        TEST_ASSERT_TRUE(WifiEspNow::getInstance().send(PEER, PAYLOAD, sizeof(PAYLOAD)));
+        TEST_ASSERT_TRUE(HostMock::waitFor([=]() { return stats().delivered == before.delivered + i + 1; }));
+    }
+
+    WifiEspNow::Stats after = stats();
+    TEST_ASSERT_EQUAL(before.held, after.held);
+    TEST_ASSERT_EQUAL(AIRTIME_US, after.minLatencyUs);
+    TEST_ASSERT_EQUAL((uint64_t)messages * AIRTIME_US, after.totalLatencyUs - before.totalLatencyUs);
+    printf("latency %u us per message on the home channel\n",
+        (unsigned)((after.totalLatencyUs - before.totalLatencyUs) / messages));
+}
+
+static void test_disconnect_holds_and_expires()
+{
+    WifiEspNow::Stats before = stats();
+    uint32_t sends = HostMock::getEspNowSends();
+
+    lost();
+    TEST_ASSERT_TRUE(WifiEspNow::getInstance().send(PEER, PAYLOAD, sizeof(PAYLOAD)));
+    TEST_ASSERT_TRUE(HostMock::waitFor([=]() { return stats().expired == before.expired + 1; }));
+    TEST_ASSERT_EQUAL(before.held + 1, stats().held);
+    TEST_ASSERT_EQUAL(sends, HostMock::getEspNowSends());
+
+    //a reconnect on another channel releases the next message
+    TEST_ASSERT_TRUE(WifiEspNow::getInstance().send(PEER, PAYLOAD, sizeof(PAYLOAD)));
+    TEST_ASSERT_TRUE(HostMock::waitFor([=]() { return stats().held == before.held + 2; }));
+    associate(11);
+    TEST_ASSERT_TRUE(HostMock::waitFor([=]() { return stats().delivered == before.delivered + 1; }));
+    TEST_ASSERT_EQUAL(11, WifiEspNow::getInstance().getChannel());
+}
+
+static void test_retransmits()
+{
+    WifiEspNow::Stats before = stats();
+    uint32_t sends = HostMock::getEspNowSends();
+
+    HostMock::setEspNowLink(AIRTIME_US, false);
+    TEST_ASSERT_TRUE(WifiEspNow::getInstance().send(PEER, PAYLOAD, sizeof(PAYLOAD)));
+    TEST_ASSERT_TRUE(HostMock::waitFor([=]() { return stats().failed == before.failed + 1; }));
+    HostMock::setEspNowLink(AIRTIME_US, true);
+
+    TEST_ASSERT_EQUAL(sends + 4, HostMock::getEspNowSends());
+    TEST_ASSERT_EQUAL(before.retransmits + 3, stats().retransmits);
+}
+
+int main()
+{
+    HostMock::freezeTime(true);
+    HostMock::setEspNowLink(AIRTIME_US, true);
+
+    WifiEspNow::Config config;
+    config.holdTimeoutMs = HOLD_TIMEOUT_MS;
+    WifiEspNow::getInstance().init(config);
+    WifiEspNow::getInstance().addPeer(PEER);
+
+    RUN_TEST(test_held_until_associated);
+    RUN_TEST(test_latency_while_associated);
+    RUN_TEST(test_disconnect_holds_and_expires);
+    RUN_TEST(test_retransmits);
+    return hostTestEnd();
+}
@@ -0,0 +1,175 @@
+/*!
+ * @file 	    test_history.cpp
+ * @brief 	    Host test of the WifiHistory flash log
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include "host_test.h"
+#include "host_mock.h"
+#include "WifiHistory.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+
+#define HISTORY_SECTORS 8
+#define SECONDS_PER_DAY 86400
+//2026-01-01
+#define FIRST_DAY 20454
+
+static void connectAfter(uint32_t timeToIpMs)
+{
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_START);
+    HostMock::advanceTime((int64_t)timeToIpMs * 1000);
+    ip_event_got_ip_t gotIp = {};
+    HostMock::dispatchEvent(IP_EVENT, IP_EVENT_STA_GOT_IP, &gotIp);
+}
+
+static void disconnect(uint8_t reason)
+{
+    wifi_event_sta_disconnected_t disconnected = {};
+    disconnected.reason = reason;
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &disconnected);
+}
+
+static bool waitForRecords(uint32_t records)
+{
+    return HostMock::waitFor([=]() { return WifiHistory::getInstance().getStats().recordsAppended == records; });
+}
+
+static void test_day_roundtrip()
+{
+    WifiHistory& history = WifiHistory::getInstance();
+    HostMock::setWallTime((time_t)FIRST_DAY * SECONDS_PER_DAY + 3600);
+
+    connectAfter(300);
+    disconnect(WIFI_REASON_BEACON_TIMEOUT);
+    connectAfter(3000);
+    disconnect(WIFI_REASON_AUTH_LEAVE);
+    TEST_ASSERT_TRUE(waitForRecords(4));
+
+    WifiHistory::DayStats stats;
+    TEST_ASSERT_TRUE(history.getDay(FIRST_DAY, stats));
+    TEST_ASSERT_EQUAL(FIRST_DAY, stats.day);
+    TEST_ASSERT_EQUAL(2, stats.connects);
+    TEST_ASSERT_EQUAL(2, stats.disconnects);
+    TEST_ASSERT_EQUAL(1, stats.reasons[(size_t)WifiHistory::Reason::BEACON_TIMEOUT]);
+    TEST_ASSERT_EQUAL(1, stats.reasons[(size_t)WifiHistory::Reason::AP_LEAVE]);
+    //bucket bounds of 300 ms and 3 s
+    TEST_ASSERT_EQUAL(500, stats.timeToIpP50Ms);
+    TEST_ASSERT_EQUAL(4000, stats.timeToIpP90Ms);
+
+    TEST_ASSERT_FALSE(history.getDay(FIRST_DAY + 1, stats));
+    TEST_ASSERT_EQUAL(0, HostMock::getFlashStats("wifihist").overwrites);
+}
+
+static void test_held_until_time_is_set()
+{
+    WifiHistory& history = WifiHistory::getInstance();
+    uint32_t records = history.getStats().recordsAppended;
+    //after a reset, before SNTP
+    HostMock::setWallTime(0);
+
+    connectAfter(400);
+    HostMock::advanceTime(7200 * 1000000LL);
+    disconnect(WIFI_REASON_BEACON_TIMEOUT);
+    TEST_ASSERT_TRUE(HostMock::waitFor([]() { return WifiHistory::getInstance().getStats().held == 2; }));
+    TEST_ASSERT_EQUAL(records, history.getStats().recordsAppended);
+
+    //the connect was two hours before the time got set, on the previous day
+    HostMock::advanceTime(60 * 1000000LL);
+    HostMock::setWallTime((time_t)(FIRST_DAY + 3) * SECONDS_PER_DAY + 3600);
+    TEST_ASSERT_TRUE(waitForRecords(records + 2));
+    TEST_ASSERT_EQUAL(0, history.getStats().held);
+
+    WifiHistory::DayStats stats;
+    TEST_ASSERT_FALSE(history.getDay(0, stats));
+    TEST_ASSERT_TRUE(history.getDay(FIRST_DAY + 2, stats));
+    TEST_ASSERT_EQUAL(1, stats.connects);
+    TEST_ASSERT_EQUAL(0, stats.disconnects);
+    TEST_ASSERT_TRUE(history.getDay(FIRST_DAY + 3, stats));
+    TEST_ASSERT_EQUAL(0, stats.connects);
+    TEST_ASSERT_EQUAL(1, stats.disconnects);
+}
+
+static void test_long_gap()
+{
+    WifiHistory& history = WifiHistory::getInstance();
+    uint32_t records = history.getStats().recordsAppended;
+    uint32_t bytes = history.getStats().bytesWritten;
+
+    //months without the station, the delta does not fit 16 bit
+    HostMock::setWallTime((time_t)(FIRST_DAY + 400) * SECONDS_PER_DAY + 3600);
+    connectAfter(300);
+    TEST_ASSERT_TRUE(waitForRecords(records + 1));
+    //a time record and the record, the sector is not left
+    TEST_ASSERT_EQUAL(bytes + 12, history.getStats().bytesWritten);
+
+    WifiHistory::DayStats stats;
+    TEST_ASSERT_TRUE(history.getDay(FIRST_DAY + 400, stats));
+    TEST_ASSERT_EQUAL(1, stats.connects);
+    TEST_ASSERT_EQUAL(0, stats.disconnects);
+    TEST_ASSERT_FALSE(history.getDay(FIRST_DAY + 399, stats));
+
+    //the following record is delta-encoded again
+    disconnect(WIFI_REASON_BEACON_TIMEOUT);
+    TEST_ASSERT_TRUE(waitForRecords(records + 2));
+    TEST_ASSERT_EQUAL(bytes + 18, history.getStats().bytesWritten);
+    TEST_ASSERT_TRUE(history.getDay(FIRST_DAY + 400, stats));
+    TEST_ASSERT_EQUAL(1, stats.disconnects);
+}
+
+static void test_write_amplification_and_wear()
+{
+    WifiHistory& history = WifiHistory::getInstance();
+    const uint32_t rawSectors = HISTORY_SECTORS - HISTORY_SECTORS / 4;
+    //680 records per raw sector, the raw ring wraps three times
+    const uint32_t pairs = 680 * rawSectors * 3 / 2;
+    time_t start = (time_t)(FIRST_DAY + 10) * SECONDS_PER_DAY;
+    uint32_t records = history.getStats().recordsAppended;
+
+    //one connect and disconnect per hour, 4 pairs fill the event queue
+    for (uint32_t i = 0; i < pairs; i++) {
+        HostMock::setWallTime(start + (time_t)i * 3600);
+        connectAfter(300);
+        disconnect(WIFI_REASON_BEACON_TIMEOUT);
+        if (i % 4 == 3) {
+            TEST_ASSERT_TRUE(waitForRecords(records + (i + 1) * 2));
+        }
+    }
+    TEST_ASSERT_TRUE(waitForRecords(records + pairs * 2));
+
+    WifiHistory::Stats stats = history.getStats();
+    HostMock::FlashStats flash = HostMock::getFlashStats("wifihist");
+    TEST_ASSERT_EQUAL(0, stats.flashErrors);
+    TEST_ASSERT_EQUAL(0, stats.dropped);
+    TEST_ASSERT_EQUAL(stats.bytesWritten, flash.bytesWritten);
+    TEST_ASSERT_EQUAL(stats.sectorsErased, flash.erases);
+    TEST_ASSERT_EQUAL(0, flash.overwrites);
+    TEST_ASSERT_TRUE(stats.compactions >= rawSectors * 2);
+
+    //headers and daily aggregates add less than 15 % to the records
+    TEST_ASSERT_TRUE((uint64_t)stats.bytesWritten * 100 < (uint64_t)stats.payloadBytes * 115);
+    //the rings spread the erases, no sector is erased more than once above its share
+    TEST_ASSERT_TRUE(flash.maxSectorErases * rawSectors <= stats.sectorsErased + rawSectors);
+
+    //a compacted day still adds up, the raw ring holds the last 85 days
+    WifiHistory::DayStats day;
+    TEST_ASSERT_TRUE(history.getDay(FIRST_DAY + 150, day));
+    TEST_ASSERT_EQUAL(24, day.connects);
+    TEST_ASSERT_EQUAL(24, day.reasons[(size_t)WifiHistory::Reason::BEACON_TIMEOUT]);
+}
+
+int main()
+{
+    HostMock::freezeTime(true);
+    HostMock::addPartition("wifihist", HISTORY_SECTORS * 4096);
+    WifiHistory::getInstance().init("wifihist");
+
+    RUN_TEST(test_day_roundtrip);
+    RUN_TEST(test_held_until_time_is_set);
+    RUN_TEST(test_write_amplification_and_wear);
+    RUN_TEST(test_long_gap);
+    return hostTestEnd();
+}
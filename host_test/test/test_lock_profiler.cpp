@@ -0,0 +1,86 @@
+/*!
+ * @file 	    test_lock_profiler.cpp
+ * @brief 	    Host test of the contention statistics of WifiLockProfiler
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <atomic>
+#include <thread>
+
+#include "host_test.h"
+#include "host_mock.h"
+#include "WifiLockProfiler.h"
+
+#define HOLD_MS 20
+#define PROFILED WifiLockProfiler::Lock::OUTBOX
+
+static SemaphoreHandle_t mutex;
+static StaticSemaphore_t mutexBuffer;
+static StackType_t holderStack[2048];
+static StaticTask_t holderBuffer;
+static std::atomic<bool> held(false);
+
+static WifiLockProfiler::LockStats statsOf(WifiLockProfiler::Lock id)
+{
+    WifiLockProfiler::LockStats stats[WifiLockProfiler::LOCK_COUNT];
+    WifiLockProfiler::getInstance().snapshot(stats, WifiLockProfiler::LOCK_COUNT);
+    return stats[(size_t)id];
+}
+
+//holds the mutex for HOLD_MS and ends itself
+static void holderTask(void* arg)
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    held = true;
+    vTaskDelay(pdMS_TO_TICKS(HOLD_MS));
+    xSemaphoreGive(mutex);
+    vTaskDelete(NULL);
+}
+
+static void test_failed_try_lock_is_contended()
+{
+    WifiLockProfiler& profiler = WifiLockProfiler::getInstance();
+    profiler.reset();
+    TEST_ASSERT_EQUAL(pdTRUE, profiler.take(mutex, 0, PROFILED));
+
+    std::thread other([&]() { TEST_ASSERT_EQUAL(pdFALSE, profiler.take(mutex, 0, PROFILED)); });
+    other.join();
+    xSemaphoreGive(mutex);
+
+    WifiLockProfiler::LockStats stats = statsOf(PROFILED);
+    TEST_ASSERT_EQUAL(1, stats.takes);
+    TEST_ASSERT_EQUAL(1, stats.contended);
+    TEST_ASSERT_EQUAL(1, stats.timeouts);
+    TEST_ASSERT_EQUAL(0, stats.slowWaits);
+}
+
+static void test_slow_wait_records_the_holder_handle()
+{
+    WifiLockProfiler& profiler = WifiLockProfiler::getInstance();
+    profiler.reset();
+    profiler.setThreshold(HOLD_MS * 1000 / 2);
+    TaskHandle_t holder = xTaskCreateStatic(&holderTask, "holder", 2048, NULL, 5, holderStack, &holderBuffer);
+    TEST_ASSERT_TRUE(HostMock::waitFor([]() { return held.load(); }));
+
+    TEST_ASSERT_EQUAL(pdTRUE, profiler.take(mutex, portMAX_DELAY, PROFILED));
+    xSemaphoreGive(mutex);
+
+    WifiLockProfiler::LockStats stats = statsOf(PROFILED);
+    TEST_ASSERT_EQUAL(1, stats.takes);
+    TEST_ASSERT_EQUAL(1, stats.contended);
+    TEST_ASSERT_EQUAL(1, stats.slowWaits);
+    TEST_ASSERT_TRUE(stats.lastSlowWaitUs >= HOLD_MS * 1000 / 2);
+    TEST_ASSERT_TRUE(stats.lastHolder == holder);
+}
+
+int main()
+{
+    mutex = xSemaphoreCreateMutexStatic(&mutexBuffer);
+
+    RUN_TEST(test_failed_try_lock_is_contended);
+    RUN_TEST(test_slow_wait_records_the_holder_handle);
+    return hostTestEnd();
+}
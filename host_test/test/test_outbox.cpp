@@ -0,0 +1,186 @@
+/*!
+ * @file 	    test_outbox.cpp
+ * @brief 	    Host test of the WifiOutbox pool and its spill ring
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "host_test.h"
+#include "host_mock.h"
+#include "WifiClient.h"
+#include "WifiOutbox.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+
+#define SPILL_SECTORS 3
+//280 byte records, 14 per sector, one sector stays free
+#define SPILL_CAPACITY ((SPILL_SECTORS - 1) * (4096 / 280))
+
+struct Delivered{
+    uint8_t priority;
+    uint32_t number;
+};
+
+static std::mutex deliveredLock;
+static std::vector<Delivered> delivered;
+static int channel = -1;
+
+static bool deliver(void* context, const void* data, size_t length)
+{
+    Delivered message;
+    message.priority = ((const uint8_t*)data)[0];
+    memcpy(&message.number, (const uint8_t*)data + 1, sizeof(uint32_t));
+    std::lock_guard<std::mutex> guard(deliveredLock);
+    delivered.push_back(message);
+    return true;
+}
+
+static size_t deliveredCount()
+{
+    std::lock_guard<std::mutex> guard(deliveredLock);
+    return delivered.size();
+}
+
+static WifiOutbox::Result post(uint8_t priority, uint32_t number)
+{
+    uint8_t data[16] = {};
+    data[0] = priority;
+    memcpy(data + 1, &number, sizeof(uint32_t));
+    return WifiOutbox::getInstance().post(channel, data, sizeof(data), priority);
+}
+
+static void linkUp()
+{
+    ip_event_got_ip_t gotIp = {};
+    HostMock::dispatchEvent(IP_EVENT, IP_EVENT_STA_GOT_IP, &gotIp);
+}
+
+static void linkDown()
+{
+    wifi_event_sta_disconnected_t disconnected = {};
+    disconnected.reason = WIFI_REASON_BEACON_TIMEOUT;
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &disconnected);
+}
+
+static void test_overflow_spills_then_drops()
+{
+    WifiOutbox& outbox = WifiOutbox::getInstance();
+    uint32_t number = 0;
+
+    for (size_t i = 0; i < CONFIG_WIFICLIENT_OUTBOX_SLOTS; i++) {
+        TEST_ASSERT(post(1, number++) == WifiOutbox::Result::QUEUED);
+    }
+    TEST_ASSERT_TRUE(outbox.isBackpressured());
+
+    //a less important message goes to flash itself
+    TEST_ASSERT(post(0, number++) == WifiOutbox::Result::SPILLED);
+    //a more important one pushes the newest priority 1 message out
+    TEST_ASSERT(post(2, number++) == WifiOutbox::Result::SPILLED);
+    for (size_t i = 2; i < SPILL_CAPACITY; i++) {
+        TEST_ASSERT(post(0, number++) == WifiOutbox::Result::SPILLED);
+    }
+    TEST_ASSERT(post(0, number++) == WifiOutbox::Result::DROPPED);
+
+    WifiOutbox::Stats stats = outbox.getStats();
+    TEST_ASSERT_EQUAL(number, stats.posted);
+    TEST_ASSERT_EQUAL(SPILL_CAPACITY, stats.spilled);
+    TEST_ASSERT_EQUAL(SPILL_CAPACITY, stats.spillQueued);
+    TEST_ASSERT_EQUAL(1, stats.droppedFull);
+    TEST_ASSERT_EQUAL(CONFIG_WIFICLIENT_OUTBOX_SLOTS, stats.queued);
+    TEST_ASSERT_EQUAL(0, deliveredCount());
+
+    HostMock::FlashStats flash = HostMock::getFlashStats("spill");
+    TEST_ASSERT_EQUAL(SPILL_CAPACITY, flash.writes);
+    TEST_ASSERT_EQUAL(SPILL_SECTORS - 1, flash.erases);
+    TEST_ASSERT_EQUAL(0, flash.overwrites);
+}
+
+static void test_link_up_restores_in_priority_order()
+{
+    WifiOutbox& outbox = WifiOutbox::getInstance();
+    size_t expected = CONFIG_WIFICLIENT_OUTBOX_SLOTS + SPILL_CAPACITY;
+
+    linkUp();
+    TEST_ASSERT_TRUE(HostMock::waitFor([&]() { return deliveredCount() == expected; }));
+
+    WifiOutbox::Stats stats = outbox.getStats();
+    TEST_ASSERT_EQUAL(expected, stats.delivered);
+    TEST_ASSERT_EQUAL(SPILL_CAPACITY, stats.restored);
+    TEST_ASSERT_EQUAL(0, stats.spillQueued);
+    TEST_ASSERT_EQUAL(0, stats.queued);
+    TEST_ASSERT_EQUAL(0, stats.spillErrors);
+    TEST_ASSERT_FALSE(outbox.isBackpressured());
+
+    std::lock_guard<std::mutex> guard(deliveredLock);
+    //the pool is delivered first, highest priority first, then the spill in post order
+    TEST_ASSERT_EQUAL(2, delivered[0].priority);
+    for (size_t i = 1; i < CONFIG_WIFICLIENT_OUTBOX_SLOTS; i++) {
+        TEST_ASSERT_EQUAL(1, delivered[i].priority);
+    }
+    for (size_t i = 2; i < CONFIG_WIFICLIENT_OUTBOX_SLOTS; i++) {
+        TEST_ASSERT(delivered[i].number > delivered[i - 1].number);
+    }
+    uint32_t priorityOne = 0;
+    for (size_t i = CONFIG_WIFICLIENT_OUTBOX_SLOTS; i < expected; i++) {
+        priorityOne += delivered[i].priority == 1;
+    }
+    //the pushed out message came back
+    TEST_ASSERT_EQUAL(1, priorityOne);
+    delivered.clear();
+}
+
+static void test_spill_ring_wears_evenly()
+{
+    WifiOutbox& outbox = WifiOutbox::getInstance();
+    const uint32_t rounds = 20;
+    uint32_t number = 0;
+
+    for (uint32_t round = 0; round < rounds; round++) {
+        linkDown();
+        for (size_t i = 0; i < CONFIG_WIFICLIENT_OUTBOX_SLOTS + SPILL_CAPACITY / 2; i++) {
+            post(0, number++);
+        }
+        linkUp();
+        TEST_ASSERT_TRUE(HostMock::waitFor([&]() { return outbox.getStats().queued == 0; }));
+    }
+
+    WifiOutbox::Stats stats = outbox.getStats();
+    TEST_ASSERT_EQUAL(0, stats.spillQueued);
+    TEST_ASSERT_EQUAL(stats.spilled, stats.restored);
+
+    //every record is written once, the ring moves over all sectors
+    HostMock::FlashStats flash = HostMock::getFlashStats("spill");
+    TEST_ASSERT_EQUAL(stats.spilled, flash.writes);
+    TEST_ASSERT_EQUAL(0, flash.overwrites);
+    TEST_ASSERT(flash.maxSectorErases - flash.minSectorErases <= 1);
+    TEST_ASSERT_EQUAL((stats.spilled + 13) / 14, flash.erases);
+}
+
+int main()
+{
+    HostMock::addPartition("spill", SPILL_SECTORS * 4096);
+
+    WifiClient::Config clientConfig;
+    clientConfig.ssid = "host";
+    clientConfig.memoryCheckMs = 0;
+    clientConfig.linkCheckMs = 0;
+    WifiClient::getInstance().init(clientConfig);
+
+    WifiOutbox::Config config;
+    config.flushRate = 10000;
+    config.flushBurst = 64;
+    config.spillPartition = "spill";
+    WifiOutbox::getInstance().init(config);
+    channel = WifiOutbox::getInstance().addChannel(&deliver, nullptr);
+
+    RUN_TEST(test_overflow_spills_then_drops);
+    RUN_TEST(test_link_up_restores_in_priority_order);
+    RUN_TEST(test_spill_ring_wears_evenly);
+    return hostTestEnd();
+}
@@ -0,0 +1,162 @@
+/*!
+ * @file 	    test_slot.cpp
+ * @brief 	    Host test of the connect slots of WifiClient
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <vector>
+
+#include "host_test.h"
+#include "host_mock.h"
+#include "WifiClient.h"
+#include "esp_wifi.h"
+
+#define SLOT_WINDOW_MS 10000
+#define SLOT_COUNT 32
+
+static const uint8_t MAC[6] = { 0x24, 0x0a, 0xc4, 0x12, 0x34, 0x56 };
+
+//reference of the hash, independent of the component
+static uint16_t referenceSlot(const uint8_t* mac, uint16_t count)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < 6; i++) {
+        hash = (hash ^ mac[i]) * 16777619u;
+    }
+    return hash % count;
+}
+
+static uint32_t delayOf(uint16_t slot)
+{
+    return (uint64_t)slot * SLOT_WINDOW_MS / SLOT_COUNT;
+}
+
+static void test_mac_slot()
+{
+    WifiClient& client = WifiClient::getInstance();
+    TEST_ASSERT_EQUAL(delayOf(referenceSlot(MAC, SLOT_COUNT)), client.getSlotDelayMs());
+}
+
+static void test_first_attempt_waits_for_slot()
+{
+    WifiClient& client = WifiClient::getInstance();
+    client.setSlot(5);
+    uint32_t delayMs = client.getSlotDelayMs();
+    TEST_ASSERT_EQUAL(delayOf(5), delayMs);
+
+    client.connect();
+    uint32_t connects = HostMock::getWifiCalls().connect;
+    int64_t start = esp_timer_get_time();
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_START);
+    TEST_ASSERT_EQUAL(connects, HostMock::getWifiCalls().connect);
+
+    HostMock::advanceTime(((int64_t)delayMs - 1) * 1000);
+    TEST_ASSERT_EQUAL(connects, HostMock::getWifiCalls().connect);
+    HostMock::advanceTime(1000);
+    HostMock::WifiCalls calls = HostMock::getWifiCalls();
+    TEST_ASSERT_EQUAL(connects + 1, calls.connect);
+    TEST_ASSERT_EQUAL((int64_t)delayMs * 1000, calls.lastConnectUs - start);
+
+    //retries after a failed attempt are not delayed again
+    wifi_event_sta_disconnected_t disconnected = {};
+    disconnected.reason = WIFI_REASON_NO_AP_FOUND;
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &disconnected);
+    TEST_ASSERT_EQUAL(connects + 2, HostMock::getWifiCalls().connect);
+}
+
+static void test_disconnect_cancels_slot()
+{
+    WifiClient& client = WifiClient::getInstance();
+    uint32_t delayMs = client.getSlotDelayMs();
+    HostMock::WifiCalls before = HostMock::getWifiCalls();
+
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_START);
+    client.disconnect();
+    HostMock::advanceTime((int64_t)delayMs * 2000);
+    HostMock::WifiCalls calls = HostMock::getWifiCalls();
+    TEST_ASSERT_EQUAL(before.connect, calls.connect);
+    //the driver is stopped although the station never got connected
+    TEST_ASSERT_EQUAL(before.stop + 1, calls.stop);
+
+    //a new session starts the driver and waits for its slot again
+    client.connect();
+    TEST_ASSERT_EQUAL(before.start + 1, HostMock::getWifiCalls().start);
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_START);
+    TEST_ASSERT_EQUAL(before.connect, HostMock::getWifiCalls().connect);
+    HostMock::advanceTime((int64_t)delayMs * 1000);
+    TEST_ASSERT_EQUAL(before.connect + 1, HostMock::getWifiCalls().connect);
+    client.disconnect();
+}
+
+static void test_assigned_slot_is_stored()
+{
+    WifiClient& client = WifiClient::getInstance();
+    uint32_t commits = HostMock::getNvsCommits();
+
+    client.setSlot(SLOT_COUNT - 1);
+    TEST_ASSERT_EQUAL(commits + 1, HostMock::getNvsCommits());
+    TEST_ASSERT_EQUAL(delayOf(SLOT_COUNT - 1), client.getSlotDelayMs());
+
+    client.clearSlot();
+    TEST_ASSERT_EQUAL(commits + 2, HostMock::getNvsCommits());
+    TEST_ASSERT_EQUAL(delayOf(referenceSlot(MAC, SLOT_COUNT)), client.getSlotDelayMs());
+
+    bool thrown = false;
+    try {
+        client.setSlot(SLOT_COUNT);
+    } catch (std::invalid_argument const&) {
+        thrown = true;
+    }
+    TEST_ASSERT_TRUE(thrown);
+}
+
+static void test_sequential_macs_are_spread()
+{
+    WifiClient& client = WifiClient::getInstance();
+    const size_t devices = 10 * SLOT_COUNT;
+    std::vector<uint32_t> perSlot(SLOT_COUNT, 0);
+
+    //one production lot, consecutive addresses
+    for (size_t i = 0; i < devices; i++) {
+        uint8_t mac[6] = { MAC[0], MAC[1], MAC[2], MAC[3], (uint8_t)(i >> 8), (uint8_t)i };
+        HostMock::setMac(mac);
+        client.clearSlot();
+        uint32_t delayMs = client.getSlotDelayMs();
+        uint16_t slot = referenceSlot(mac, SLOT_COUNT);
+        TEST_ASSERT_EQUAL(delayOf(slot), delayMs);
+        perSlot[slot]++;
+    }
+    HostMock::setMac(MAC);
+    client.clearSlot();
+
+    for (size_t i = 0; i < SLOT_COUNT; i++) {
+        //10 per slot on average, no slot empty or crowded
+        TEST_ASSERT(perSlot[i] >= 2);
+        TEST_ASSERT(perSlot[i] <= 25);
+    }
+}
+
+int main()
+{
+    HostMock::setMac(MAC);
+    HostMock::freezeTime(true);
+
+    WifiClient::Config config;
+    config.ssid = "host";
+    config.password = "password";
+    config.memoryCheckMs = 0;
+    config.linkCheckMs = 0;
+    config.slotWindowMs = SLOT_WINDOW_MS;
+    config.slotCount = SLOT_COUNT;
+    WifiClient::getInstance().init(config);
+
+    RUN_TEST(test_mac_slot);
+    RUN_TEST(test_first_attempt_waits_for_slot);
+    RUN_TEST(test_disconnect_cancels_slot);
+    RUN_TEST(test_assigned_slot_is_stored);
+    RUN_TEST(test_sequential_macs_are_spread);
+    return hostTestEnd();
+}
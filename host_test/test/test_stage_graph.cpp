@@ -0,0 +1,147 @@
+/*!
+ * @file 	    test_stage_graph.cpp
+ * @brief 	    Host test of WifiStageGraph runs across reconnects and of the event masks
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "host_test.h"
+#include "host_mock.h"
+#include "WifiClient.h"
+#include "WifiStageGraph.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+
+#define INDEPENDENT_STAGES 6
+#define FLAPS 5
+
+static std::atomic<bool> gateOpen(false);
+static QueueHandle_t disconnectedQueue = NULL;
+
+//a stage which hangs (e.g. DNS without answer) and ignores isCancelled
+static bool gatedStage(void* arg, uint32_t run)
+{
+    while (!gateOpen.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+static WifiStageGraph::State stateOf(size_t stage)
+{
+    WifiStageGraph::StageTiming timings[CONFIG_WIFICLIENT_MAX_STAGES];
+    size_t count = WifiStageGraph::getInstance().getTimings(timings, CONFIG_WIFICLIENT_MAX_STAGES);
+    return stage < count ? timings[stage].state : WifiStageGraph::State::IDLE;
+}
+
+//the events reach the receiver queues within the dispatch
+static void linkUp()
+{
+    ip_event_got_ip_t gotIp = {};
+    HostMock::dispatchEvent(IP_EVENT, IP_EVENT_STA_GOT_IP, &gotIp);
+}
+
+static void linkDown()
+{
+    wifi_event_sta_disconnected_t disconnected = {};
+    disconnected.reason = WIFI_REASON_BEACON_TIMEOUT;
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &disconnected);
+}
+
+//the dependent stage is pending in every new run and cancelled with it
+static void graphUp()
+{
+    linkUp();
+    TEST_ASSERT_TRUE(HostMock::waitFor([]() { return stateOf(INDEPENDENT_STAGES) == WifiStageGraph::State::PENDING; }));
+}
+
+static void graphDown()
+{
+    linkDown();
+    TEST_ASSERT_TRUE(HostMock::waitFor([]() { return stateOf(INDEPENDENT_STAGES) == WifiStageGraph::State::CANCELLED; }));
+}
+
+static void test_cancelled_before_start()
+{
+    TEST_ASSERT_TRUE(WifiStageGraph::getInstance().isCancelled(0));
+}
+
+static void test_flapping_link_with_hung_workers()
+{
+    WifiStageGraph& graph = WifiStageGraph::getInstance();
+    graph.start();
+
+    //both workers hang in the first run, every reconnect queues all independent stages again
+    for (int i = 0; i < FLAPS; i++) {
+        graphUp();
+        graphDown();
+    }
+    graphUp();
+
+    gateOpen.store(true);
+    TEST_ASSERT_TRUE(HostMock::waitFor([]() { return stateOf(INDEPENDENT_STAGES) == WifiStageGraph::State::DONE; }));
+    for (size_t i = 0; i <= INDEPENDENT_STAGES; i++) {
+        TEST_ASSERT_EQUAL((int)WifiStageGraph::State::DONE, (int)stateOf(i));
+    }
+}
+
+static void test_event_mask()
+{
+    WifiClient& client = WifiClient::getInstance();
+    WifiClient::Event event;
+
+    //one slot, the CONNECTED events of the flaps must not take it
+    TEST_ASSERT_EQUAL(pdTRUE, xQueueReceive(disconnectedQueue, &event, 0));
+    TEST_ASSERT_EQUAL((int)WifiClient::Event::DISCONNECTED, (int)event);
+    TEST_ASSERT_EQUAL(pdFALSE, xQueueReceive(disconnectedQueue, &event, 0));
+
+    client.setEventMask(disconnectedQueue, 0);
+    linkDown();
+    linkUp();
+    TEST_ASSERT_EQUAL(pdFALSE, xQueueReceive(disconnectedQueue, &event, 0));
+
+    client.setEventMask(disconnectedQueue, WifiClient::ALL_EVENTS);
+    linkDown();
+    TEST_ASSERT_EQUAL(pdTRUE, xQueueReceive(disconnectedQueue, &event, 0));
+    TEST_ASSERT_EQUAL((int)WifiClient::Event::DISCONNECTED, (int)event);
+
+    QueueHandle_t unregistered = NULL;
+    bool thrown = false;
+    try {
+        client.setEventMask(unregistered, 0);
+    } catch (std::invalid_argument const&) {
+        thrown = true;
+    }
+    TEST_ASSERT_TRUE(thrown);
+}
+
+int main()
+{
+    WifiClient& client = WifiClient::getInstance();
+    WifiClient::Config config;
+    config.ssid = "host";
+    config.memoryCheckMs = 0;
+    config.linkCheckMs = 0;
+    client.init(config);
+    client.registerEventReceiver(disconnectedQueue, 1, WifiClient::eventBit(WifiClient::Event::DISCONNECTED));
+    client.connect();
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_START);
+
+    WifiStageGraph& graph = WifiStageGraph::getInstance();
+    uint32_t independent = 0;
+    for (int i = 0; i < INDEPENDENT_STAGES; i++) {
+        independent |= 1u << graph.addStage("gated", &gatedStage);
+    }
+    graph.addStage("dependent", [](void* arg, uint32_t run) { return true; }, nullptr, independent);
+
+    RUN_TEST(test_cancelled_before_start);
+    RUN_TEST(test_flapping_link_with_hung_workers);
+    RUN_TEST(test_event_mask);
+    return hostTestEnd();
+}
@@ -0,0 +1,115 @@
+/*!
+ * @file 	    test_tcp_tuner.cpp
+ * @brief 	    Host test of the options WifiTcpTuner sets on registered sockets
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <stdexcept>
+#include <sys/time.h>
+
+#include "host_test.h"
+#include "host_mock.h"
+#include "WifiClient.h"
+#include "WifiTcpTuner.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "lwip/sockets.h"
+
+#define LINK_CHECK_MS 1000
+
+static int appSocket;
+static int tunedSocket;
+
+static int intOption(int socket, int level, int name)
+{
+    int value = -1;
+    socklen_t length = sizeof(value);
+    getsockopt(socket, level, name, &value, &length);
+    return value;
+}
+
+static uint32_t sendTimeoutMs(int socket)
+{
+    struct timeval timeout = {};
+    socklen_t length = sizeof(timeout);
+    getsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, &length);
+    return timeout.tv_sec * 1000 + timeout.tv_usec / 1000;
+}
+
+static void test_only_registered_options()
+{
+    WifiTcpTuner& tuner = WifiTcpTuner::getInstance();
+
+    //the application configures its socket and only hands Nagle to the tuner
+    appSocket = socket(AF_INET, SOCK_STREAM, 0);
+    struct timeval timeout = { 1, 234000 };
+    setsockopt(appSocket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    tuner.add(appSocket, WifiTcpTuner::NO_DELAY);
+    tunedSocket = socket(AF_INET, SOCK_STREAM, 0);
+    tuner.add(tunedSocket, WifiTcpTuner::ALL_OPTIONS);
+
+    TEST_ASSERT_EQUAL(1, intOption(appSocket, IPPROTO_TCP, TCP_NODELAY));
+    TEST_ASSERT_EQUAL(0, intOption(appSocket, SOL_SOCKET, SO_KEEPALIVE));
+    TEST_ASSERT_EQUAL(1234, sendTimeoutMs(appSocket));
+    TEST_ASSERT_EQUAL(1, intOption(tunedSocket, SOL_SOCKET, SO_KEEPALIVE));
+    TEST_ASSERT_EQUAL(30, intOption(tunedSocket, IPPROTO_TCP, TCP_KEEPIDLE));
+    TEST_ASSERT_EQUAL(3, intOption(tunedSocket, IPPROTO_TCP, TCP_KEEPCNT));
+    TEST_ASSERT_EQUAL(5000, sendTimeoutMs(tunedSocket));
+
+    bool thrown = false;
+    try {
+        tuner.add(appSocket, 0);
+    } catch (std::invalid_argument const&) {
+        thrown = true;
+    }
+    TEST_ASSERT_TRUE(thrown);
+}
+
+static void test_poor_link()
+{
+    WifiTcpTuner& tuner = WifiTcpTuner::getInstance();
+    HostMock::setAccessPoint(-85, 6);
+    HostMock::advanceTime(LINK_CHECK_MS * 1000);
+    TEST_ASSERT_TRUE(HostMock::waitFor([]() { return WifiTcpTuner::getInstance().getStats().changes == 1; }));
+    TEST_ASSERT_EQUAL((int)WifiClient::LinkQuality::POOR, tuner.getStats().lastQuality);
+
+    TEST_ASSERT_EQUAL(0, intOption(appSocket, IPPROTO_TCP, TCP_NODELAY));
+    TEST_ASSERT_EQUAL(0, intOption(appSocket, SOL_SOCKET, SO_KEEPALIVE));
+    TEST_ASSERT_EQUAL(1234, sendTimeoutMs(appSocket));
+    TEST_ASSERT_EQUAL(60, intOption(tunedSocket, IPPROTO_TCP, TCP_KEEPIDLE));
+    //the 0 values of the poor profile keep the previous values
+    TEST_ASSERT_EQUAL(3, intOption(tunedSocket, IPPROTO_TCP, TCP_KEEPCNT));
+    TEST_ASSERT_EQUAL(5000, sendTimeoutMs(tunedSocket));
+    TEST_ASSERT_EQUAL(0, tuner.getStats().optionErrors);
+}
+
+int main()
+{
+    HostMock::freezeTime(true);
+    WifiClient& client = WifiClient::getInstance();
+    WifiClient::Config config;
+    config.ssid = "host";
+    config.linkCheckMs = LINK_CHECK_MS;
+    client.init(config);
+    client.connect();
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_START);
+    HostMock::setAssociated(true);
+    HostMock::setAccessPoint(-50, 6);
+    wifi_event_sta_connected_t connected = {};
+    connected.channel = 6;
+    HostMock::dispatchEvent(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &connected);
+    ip_event_got_ip_t gotIp = {};
+    HostMock::dispatchEvent(IP_EVENT, IP_EVENT_STA_GOT_IP, &gotIp);
+
+    WifiTcpTuner::Config tunerConfig;
+    tunerConfig.poor.keepCount = 0;
+    tunerConfig.poor.sendTimeoutMs = 0;
+    WifiTcpTuner::getInstance().init(tunerConfig);
+
+    RUN_TEST(test_only_registered_options);
+    RUN_TEST(test_poor_link);
+    return hostTestEnd();
+}
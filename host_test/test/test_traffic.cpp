@@ -0,0 +1,92 @@
+/*!
+ * @file 	    test_traffic.cpp
+ * @brief 	    Host test of the socket registration of WifiTraffic
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "host_test.h"
+#include "host_mock.h"
+#include "WifiTraffic.h"
+#include "lwip/sockets.h"
+
+static int sockets[WifiTraffic::MAX_SOCKETS];
+
+static WifiTraffic::TrafficClass classOf(size_t i)
+{
+    return (WifiTraffic::TrafficClass)(i % WifiTraffic::CLASS_COUNT);
+}
+
+static void test_concurrent_registration()
+{
+    WifiTraffic& traffic = WifiTraffic::getInstance();
+    for (size_t i = 0; i < WifiTraffic::MAX_SOCKETS; i++) {
+        sockets[i] = socket(AF_INET, SOCK_DGRAM, 0);
+        TEST_ASSERT_TRUE(sockets[i] >= 0);
+    }
+
+    //every socket gets its own slot, none is overwritten by a concurrent call
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < WifiTraffic::MAX_SOCKETS; i++) {
+        threads.emplace_back([=]() { WifiTraffic::getInstance().setClass(sockets[i], classOf(i)); });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    struct sockaddr_in to = {};
+    to.sin_len = sizeof(to);
+    to.sin_family = AF_INET;
+    to.sin_port = htons(5000);
+    for (size_t i = 0; i < WifiTraffic::MAX_SOCKETS; i++) {
+        int tos = -1;
+        socklen_t length = sizeof(tos);
+        TEST_ASSERT_EQUAL(0, getsockopt(sockets[i], IPPROTO_IP, IP_TOS, &tos, &length));
+        TEST_ASSERT_EQUAL(traffic.getTos(classOf(i)), tos);
+        TEST_ASSERT_EQUAL(1, traffic.sendTo(sockets[i], "x", 1, 0, (struct sockaddr*)&to, sizeof(to)));
+    }
+    for (size_t c = 0; c < WifiTraffic::CLASS_COUNT; c++) {
+        TEST_ASSERT_EQUAL(WifiTraffic::MAX_SOCKETS / WifiTraffic::CLASS_COUNT,
+            traffic.getStats((WifiTraffic::TrafficClass)c).packets);
+    }
+}
+
+static void test_full_and_failed_registration()
+{
+    WifiTraffic& traffic = WifiTraffic::getInstance();
+    bool thrown = false;
+    try {
+        traffic.setClass(WifiTraffic::MAX_SOCKETS + 100, WifiTraffic::TrafficClass::BULK);
+    } catch (std::runtime_error const&) {
+        thrown = true;
+    }
+    TEST_ASSERT_TRUE(thrown);
+
+    //a failed IP_TOS gives the slot back
+    traffic.forget(sockets[0]);
+    closesocket(sockets[0]);
+    thrown = false;
+    try {
+        traffic.setClass(sockets[0], WifiTraffic::TrafficClass::BULK);
+    } catch (std::runtime_error const&) {
+        thrown = true;
+    }
+    TEST_ASSERT_TRUE(thrown);
+    sockets[0] = socket(AF_INET, SOCK_DGRAM, 0);
+    traffic.setClass(sockets[0], WifiTraffic::TrafficClass::CONTROL);
+}
+
+int main()
+{
+    WifiTraffic::getInstance().init(WifiTraffic::Config());
+
+    RUN_TEST(test_concurrent_registration);
+    RUN_TEST(test_full_and_failed_registration);
+    return hostTestEnd();
+}
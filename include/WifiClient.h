@@ -15,9 +15,14 @@
 #include <cstring>
 #include <vector>
 
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
 #include "esp_err.h"
 #include "esp_event.h"
 #include "esp_wifi.h"
+#include "esp_timer.h"
 
 /*!
  * @brief   Event Handler for esp_wifi
@@ -44,12 +49,194 @@ friend void WifiClient_event_handler(void* arg, esp_event_base_t event_base,
 /** PUBLIC TYPEDEFS **/
 /** ******************/
 public:
+    /*!
+     * @brief   Enum Class which selects where the wifi driver stores its
+     *          configuration.
+     */
+    enum class Storage{
+        FLASH,  /*!< @brief Driver persists the configuration in NVS (esp_wifi default)*/
+        RAM     /*!< @brief Driver keeps the configuration in RAM only, no NVS access*/
+    };
+
+    /*!
+     * @brief   Struct which containes the WPA2-Enterprise (802.1X) credentials
+     *
+     *          Enterprise mode is used if identity is not empty. Certificates
+     *          and key are PEM or DER buffers, they must stay valid until
+     *          the client is disconnected. PEM lengths include the
+     *          terminating zero.
+     */
+    struct Enterprise{
+        std::string identity = "";  /*!< @brief EAP outer identity*/
+        std::string username = "";  /*!< @brief PEAP/TTLS inner username, empty for EAP-TLS*/
+        std::string password = "";  /*!< @brief PEAP/TTLS inner password, empty for EAP-TLS*/
+        const uint8_t* caCert = nullptr;    /*!< @brief CA certificate to validate the server, optional*/
+        size_t caCertLength = 0;            /*!< @brief length of caCert*/
+        const uint8_t* clientCert = nullptr;    /*!< @brief client certificate for EAP-TLS*/
+        size_t clientCertLength = 0;            /*!< @brief length of clientCert*/
+        const uint8_t* clientKey = nullptr;     /*!< @brief client private key for EAP-TLS*/
+        size_t clientKeyLength = 0;             /*!< @brief length of clientKey*/
+        std::string clientKeyPassword = "";     /*!< @brief password of clientKey, empty if not encrypted*/
+    };
+
     /*!
      * @brief   Struct which containes the Configuration values
      */
     struct Config{
         std::string ssid = "";      /*!< @brief WIFI SSID*/
-        std::string password = "";  /*!< @brief WIFI PASSWORD*/
+        std::string password = "";  /*!< @brief WIFI PASSWORD, not used with enterprise*/
+        Enterprise enterprise;      /*!< @brief WPA2-Enterprise credentials*/
+        Storage storage = Storage::FLASH;   /*!< @brief Driver configuration storage*/
+        bool persistConfig = false; /*!< @brief Component persists the configuration in NVS if it changed, only used with Storage::RAM*/
+        bool fastTransition = false;    /*!< @brief enable 802.11r FT (over the air) with 802.11k/v roaming*/
+        uint16_t mobilityDomain = 0;    /*!< @brief mobility domain id of the ESS, only reported in HandoffStats*/
+        uint16_t handoffGraceMs = 2000; /*!< @brief with fastTransition, a reconnect within this time is a handoff and no events are fired*/
+        int8_t roamRssiThreshold = 0;   /*!< @brief with fastTransition, ask the AP for a BSS transition below this RSSI, 0 disables*/
+        uint16_t radioCurrentMa = 120;  /*!< @brief average supply current while connecting, used for energy estimates*/
+        uint16_t supplyVoltageMv = 3300; /*!< @brief supply voltage, used for energy estimates*/
+        bool phyCalibrationCache = true;    /*!< @brief reuse the stored PHY calibration, false calibrates fully on every init*/
+        bool phyForceCalibration = false;   /*!< @brief calibrate fully once on this init*/
+        int16_t phyTemperatureC = INT16_MIN;    /*!< @brief measured chip temperature, INT16_MIN if unknown*/
+        uint16_t phyVoltageMv = 0;              /*!< @brief measured supply voltage, 0 if unknown*/
+        uint8_t phyMaxTemperatureDriftC = 20;   /*!< @brief larger drift since the last full calibration calibrates fully*/
+        uint16_t phyMaxVoltageDriftMv = 300;    /*!< @brief larger drift since the last full calibration calibrates fully*/
+        uint32_t memoryCheckMs = 0;         /*!< @brief interval of the internal heap check, 0 (default) disables the memory pressure mode*/
+        uint32_t memoryLowFree = 32768;     /*!< @brief pressure is LOW below this free internal heap*/
+        uint32_t memoryLowBlock = 8192;     /*!< @brief pressure is LOW below this largest free internal block*/
+        uint32_t memoryCriticalFree = 16384;    /*!< @brief pressure is CRITICAL below this free internal heap*/
+        uint32_t memoryCriticalBlock = 4096;    /*!< @brief pressure is CRITICAL below this largest free internal block*/
+        uint32_t memoryHysteresis = 4096;   /*!< @brief a level is left once both values are this far above its thresholds*/
+        uint32_t linkCheckMs = 0;       /*!< @brief RSSI sampling interval of the link quality, 0 (default) disables it, has to be set for WifiTcpTuner*/
+        int8_t linkFairRssi = -67;      /*!< @brief link quality is FAIR below this smoothed RSSI*/
+        int8_t linkPoorRssi = -78;      /*!< @brief link quality is POOR below this smoothed RSSI*/
+        uint8_t linkHysteresisDb = 3;   /*!< @brief a level is left once the RSSI is this far above its threshold*/
+        uint32_t slotWindowMs = 0;      /*!< @brief first connection attempt after the driver start is delayed by its slot within this window, 0 disables slotting*/
+        uint16_t slotCount = 32;        /*!< @brief number of slots in slotWindowMs*/
+    };
+
+    /*!
+     * @brief   Struct which containes the timing of one handshake class
+     */
+    struct HandshakeTiming{
+        uint32_t count = 0;     /*!< @brief number of handshakes*/
+        uint64_t totalUs = 0;   /*!< @brief sum of all handshake durations*/
+        uint32_t lastUs = 0;    /*!< @brief duration of the last handshake*/
+        uint32_t maxUs = 0;     /*!< @brief longest handshake*/
+    };
+
+    /*!
+     * @brief   Struct which containes the handshake statistics
+     *
+     *          A handshake is measured from esp_wifi_connect to the station
+     *          connected event. Associations the driver makes on its own
+     *          (roaming, BSS transition) have no attempt start and are not
+     *          counted. An association is counted as resumed if a shortcut
+     *          is expected: 802.1X to a BSSID which was already
+     *          authenticated since connect() (PMKSA cache) or an 802.11r
+     *          handoff. The driver does not report whether the shortcut was
+     *          taken, resumed is an expectation, not a measurement.
+     */
+    struct HandshakeStats{
+        HandshakeTiming full;       /*!< @brief full authentications*/
+        HandshakeTiming resumed;    /*!< @brief authentications expected to use the PMKSA cache or FT*/
+    };
+
+    /*!
+     * @brief   Struct which containes a time-to-connect estimate
+     *
+     *          Phases which are not needed in the current state (e.g.
+     *          driver start while the driver is running) are 0.
+     */
+    struct ConnectEstimate{
+        uint32_t driverStartMs = 0;     /*!< @brief esp_wifi_start until station start*/
+        uint32_t associationMs = 0;     /*!< @brief scan, authentication and association*/
+        uint32_t dhcpMs = 0;            /*!< @brief station connected until got ip*/
+        uint32_t timeToIpMs = 0;        /*!< @brief sum of all phases*/
+        uint32_t energyMj = 0;          /*!< @brief estimated energy in millijoule*/
+        bool fromHistory = false;       /*!< @brief false if at least one phase has no measurement yet and a default was used*/
+    };
+
+    /*!
+     * @brief   Struct which containes the handoff statistics
+     *
+     *          A handoff is a change of the access point within the
+     *          mobility domain while connected. The gap is measured from
+     *          the disconnected event of the old to the connected event of
+     *          the new access point.
+     */
+    struct HandoffStats{
+        uint16_t mobilityDomain = 0;    /*!< @brief configured mobility domain id*/
+        uint8_t bssid[6] = {0};         /*!< @brief current access point*/
+        uint32_t count = 0;             /*!< @brief handoffs with a measured gap*/
+        uint32_t seamless = 0;          /*!< @brief access point changes without disconnected event*/
+        uint32_t failed = 0;            /*!< @brief handoffs which exceeded handoffGraceMs*/
+        uint32_t lastGapUs = 0;         /*!< @brief gap of the last handoff*/
+        uint32_t maxGapUs = 0;          /*!< @brief longest gap*/
+        uint64_t totalGapUs = 0;        /*!< @brief sum of all gaps*/
+    };
+
+    /*!
+     * @brief   Struct which containes the PHY calibration statistics
+     *
+     *          Startups are measured from esp_wifi_start to the station
+     *          start event, the calibration runs in between. Statistics
+     *          are kept in RTC memory and survive deep sleep and resets.
+     *          Trivially constructible (no member initializers), so the
+     *          RTC_NOINIT copy is not touched by static initialization.
+     */
+    struct PhyCalibrationStats{
+        uint32_t cachedStarts;      /*!< @brief startups with stored calibration (partial or none)*/
+        uint32_t fullStarts;        /*!< @brief startups with full calibration*/
+        uint32_t driftCalibrations; /*!< @brief full calibrations caused by temperature or voltage drift*/
+        uint32_t cachedAverageUs;   /*!< @brief moving average of startups with stored calibration*/
+        uint32_t fullAverageUs;     /*!< @brief moving average of startups with full calibration*/
+        uint32_t lastStartUs;       /*!< @brief duration of the last startup*/
+        bool lastFull;              /*!< @brief last startup calibrated fully*/
+    };
+
+    /*!
+     * @brief   Enum Class which stores the memory pressure levels
+     *
+     *          LOW defers background scans, CRITICAL additionally drops
+     *          all group addressed UDP except DHCP before lwIP and pauses
+     *          WifiDownloader between chunks.
+     */
+    enum class MemoryPressure{
+        NORMAL,     /*!< @brief enough internal heap*/
+        LOW,        /*!< @brief below the low thresholds*/
+        CRITICAL    /*!< @brief below the critical thresholds*/
+    };
+
+    /*!
+     * @brief   Struct which containes the memory pressure statistics
+     */
+    struct MemoryStats{
+        MemoryPressure pressure = MemoryPressure::NORMAL;   /*!< @brief current level*/
+        uint32_t lowCount = 0;          /*!< @brief changes to LOW*/
+        uint32_t criticalCount = 0;     /*!< @brief changes to CRITICAL*/
+        uint32_t freeBytes = 0;         /*!< @brief free internal heap at the last check*/
+        uint32_t largestBlock = 0;      /*!< @brief largest free internal block at the last check*/
+        uint32_t minFreeBytes = 0;      /*!< @brief lowest free internal heap seen by the checks*/
+        uint32_t minLargestBlock = 0;   /*!< @brief smallest largest free internal block seen by the checks*/
+    };
+
+    /*!
+     * @brief   Struct which containes the memory placement of the component
+     */
+    struct PlacementStats{
+        uint32_t internalSaved = 0;     /*!< @brief bytes of component pools placed in PSRAM (CONFIG_WIFICLIENT_PSRAM_POOLS)*/
+        uint32_t internalFree = 0;      /*!< @brief free internal heap*/
+        uint32_t externalFree = 0;      /*!< @brief free PSRAM heap, 0 without PSRAM*/
+        bool driverBuffersExternal = false; /*!< @brief driver and lwIP buffers may be allocated in PSRAM (CONFIG_SPIRAM_TRY_ALLOCATE_WIFI_LWIP)*/
+    };
+
+    /*!
+     * @brief   Enum Class which stores the link quality levels
+     */
+    enum class LinkQuality{
+        GOOD,   /*!< @brief strong signal*/
+        FAIR,   /*!< @brief below linkFairRssi*/
+        POOR    /*!< @brief below linkPoorRssi, expect retries and losses*/
     };
 
     /*!
@@ -57,7 +244,28 @@ public:
      */
     enum class Event{
         CONNECTED,  /*!< @brief Event is fired on client connected*/
-        DISCONNECTED /*< @brief Event is fired on client disconnected*/
+        DISCONNECTED, /*!< @brief Event is fired on client disconnected*/
+        MEMORY_LOW, /*!< @brief Event is fired on memory pressure changes to LOW (from NORMAL or CRITICAL)*/
+        MEMORY_CRITICAL,    /*!< @brief Event is fired on memory pressure changes to CRITICAL*/
+        MEMORY_NORMAL,  /*!< @brief Event is fired on memory pressure changes to NORMAL*/
+        LINK_QUALITY_CHANGED    /*!< @brief Event is fired on link quality changes, see getLinkQuality()*/
+    };
+
+    /*!
+     * @brief   Event mask which receives every event
+     */
+    static const uint32_t ALL_EVENTS = UINT32_MAX;
+
+/** *******************/
+/** PRIVATE TYPEDEFS **/
+/** *******************/
+private:
+    /*!
+     * @brief   Struct which containes a registered event receiver
+     */
+    struct EventReceiver{
+        QueueHandle_t* queue;   /*!< @brief queue handle of the receiver*/
+        uint32_t events;        /*!< @brief mask of the events sent to the queue, see eventBit()*/
     };
 
 /** ****************************/
@@ -77,6 +285,16 @@ public:
      */
     static WifiClient& getInstance();
 
+    /*!
+     * @brief   Returns the mask bit of an event
+     *
+     *          Masks of several events are combined with |.
+     * 
+     * @param   event event of the mask
+     * @return  uint32_t mask bit
+     */
+    static uint32_t eventBit(Event event);
+
 /** *************************/
 /** PRIVATE STATIC METHODS **/
 /** *************************/
@@ -91,6 +309,125 @@ private:
      */
     static void setConnected(bool connected); 
 
+    /*!
+     * @brief   Loads the configuration persisted by storeConfig
+     * 
+     * @param   wifiConfig returns the stored configuration
+     * @return  true if a configuration was stored
+     * @return  false if no configuration was stored
+     * @throws  runtime_error if NVS could not be read
+     */
+    static bool loadStoredConfig(wifi_config_t& wifiConfig);
+
+    /*!
+     * @brief   Persists the configuration in NVS
+     *
+     *          The stored configuration is compared first, NVS is
+     *          only written if the configuration changed.
+     * 
+     * @param   wifiConfig configuration to persist
+     * @throws  runtime_error if NVS could not be written
+     */
+    static void storeConfig(wifi_config_t const& wifiConfig);
+
+    /*!
+     * @brief   Calls esp_wifi_connect and stores the attempt start time
+     */
+    static void startConnectAttempt();
+
+    /*!
+     * @brief   Adds the finished handshake of the pending attempt to the handshake statistics
+     * 
+     * @param   bssid of the associated access point
+     */
+    static void recordHandshake(const uint8_t* bssid);
+
+    /*!
+     * @brief   Adds the finished driver start to the phase averages
+     */
+    static void recordDriverStart();
+
+    /*!
+     * @brief   Decides between stored and full PHY calibration
+     *
+     *          Erases the calibration stored in NVS, if the cache is
+     *          disabled, forced or the conditions drifted since the last
+     *          full calibration. The next esp_wifi_start calibrates fully.
+     *
+     * @param   config Config object
+     */
+    static void preparePhyCalibration(Config const& config);
+
+    /*!
+     * @brief   Adds the finished DHCP phase to the phase averages
+     */
+    static void recordGotIp();
+
+    /*!
+     * @brief   Handles a disconnected event while connected
+     *
+     *          With fastTransition a handoff is started and the
+     *          disconnected event is deferred by handoffGraceMs, otherwise
+     *          the disconnected event is fired.
+     */
+    static void connectionLost();
+
+    /*!
+     * @brief   Finishes a running handoff or detects a seamless one
+     * 
+     * @param   bssid of the associated access point
+     */
+    static void recordAssociation(const uint8_t* bssid);
+
+    /*!
+     * @brief   Timer callback, fires the deferred disconnected event
+     *
+     * @param   arg unused
+     */
+    static void handoffTimeout(void* arg);
+
+    /*!
+     * @brief   Asks the access point for a BSS transition and rearms the RSSI threshold
+     */
+    static void requestTransition();
+
+    /*!
+     * @brief   Timer callback, checks the internal heap and changes the memory pressure
+     *
+     *          Every level passed on the way fires its event, the
+     *          application sheds load in the same order.
+     *
+     * @param   arg unused
+     */
+    static void memoryCheck(void* arg);
+
+    /*!
+     * @brief   Timer callback, samples the RSSI and changes the link quality
+     *
+     * @param   arg unused
+     */
+    static void linkCheck(void* arg);
+
+    /*!
+     * @brief   Starts the first connection attempt, delayed to the slot if slotting is enabled
+     */
+    static void startSlottedAttempt();
+
+    /*!
+     * @brief   Timer callback, starts the connection attempt at the slot
+     *
+     * @param   arg unused
+     */
+    static void slotReached(void* arg);
+
+    /*!
+     * @brief   Applies the enterprise credentials to the supplicant
+     * 
+     * @param   enterprise credentials
+     * @throws  runtime_error if the supplicant rejected a value
+     */
+    static void configureEnterprise(Enterprise const& enterprise);
+
 /** **************/
 /** CONSTRUCTOR **/
 /** **************/
@@ -105,9 +442,65 @@ private:
 /** *************/
 private:
     SemaphoreHandle_t connectedMutex;   /*!< @brief Mutex for connected attribute*/
-    bool connected; /*!< @brief connected attribute*/
+#if CONFIG_WIFICLIENT_STATIC_ALLOCATION
+    StaticSemaphore_t connectedMutexBuffer; /*!< @brief Storage of connectedMutex in static allocation mode*/
+#endif
+    volatile bool connected; /*!< @brief connected attribute*/
     bool initalized; /*!< @brief initialized attribute*/
-    std::vector<QueueHandle_t*> eventReceivers; /*!< @brief stors all queue handles which receive the events*/
+    esp_netif_t* netif; /*!< @brief station netif created by init*/
+    portMUX_TYPE statsLock; /*!< @brief Spinlock for the statistics attributes*/
+    HandshakeStats handshakeStats; /*!< @brief handshake statistics*/
+    int64_t connectAttemptStart; /*!< @brief time of the pending esp_wifi_connect call, 0 if no attempt is pending*/
+    uint8_t authenticatedBssids[4][6]; /*!< @brief BSSIDs authenticated since connect(), PMKSA candidates*/
+    size_t authenticatedBssidCount; /*!< @brief number of used entries in authenticatedBssids*/
+    bool enterprise; /*!< @brief 802.1X used, only then the PMKSA cache shortens a reconnect*/
+    bool fastTransition; /*!< @brief 802.11r enabled*/
+    uint16_t handoffGraceMs; /*!< @brief max handoff gap before disconnected is fired*/
+    int8_t roamRssiThreshold; /*!< @brief RSSI for BSS transition queries, 0 if disabled*/
+    esp_timer_handle_t handoffTimer; /*!< @brief fires the deferred disconnected event*/
+    bool handoffActive; /*!< @brief disconnected from the old access point, handoff running*/
+    int64_t handoffStart; /*!< @brief time of the disconnected event of the running handoff*/
+    HandoffStats handoffStats; /*!< @brief handoff statistics*/
+    uint16_t radioCurrentMa; /*!< @brief average supply current while connecting*/
+    uint16_t supplyVoltageMv; /*!< @brief supply voltage*/
+    int64_t driverStartBegin; /*!< @brief time of the last esp_wifi_start call*/
+    int64_t associatedTime; /*!< @brief time of the last station connected event*/
+    bool driverStarted; /*!< @brief station start event received and driver not stopped*/
+    bool hadIp; /*!< @brief got an ip since the driver was started*/
+    bool phyFullPending; /*!< @brief stored PHY calibration was erased, next driver start calibrates fully*/
+    uint32_t driverStartAverageUs; /*!< @brief moving average of the driver start phase, 0 if not measured*/
+    uint32_t fullAssociationAverageUs; /*!< @brief moving average of full associations, 0 if not measured*/
+    uint32_t resumedAssociationAverageUs; /*!< @brief moving average of associations with cached PMKSA, 0 if not measured*/
+    uint32_t firstDhcpAverageUs; /*!< @brief moving average of the first DHCP phase of a driver session, 0 if not measured*/
+    uint32_t renewDhcpAverageUs; /*!< @brief moving average of later DHCP phases (lease known), 0 if not measured*/
+    esp_timer_handle_t memoryTimer; /*!< @brief periodic internal heap check*/
+    uint32_t memoryLowFree; /*!< @brief LOW threshold of the free internal heap*/
+    uint32_t memoryLowBlock; /*!< @brief LOW threshold of the largest free internal block*/
+    uint32_t memoryCriticalFree; /*!< @brief CRITICAL threshold of the free internal heap*/
+    uint32_t memoryCriticalBlock; /*!< @brief CRITICAL threshold of the largest free internal block*/
+    uint32_t memoryHysteresis; /*!< @brief margin above the thresholds to leave a level*/
+    MemoryStats memoryStats; /*!< @brief memory pressure statistics, holds the current level*/
+    esp_timer_handle_t linkTimer; /*!< @brief periodic RSSI sampling*/
+    int8_t linkFairRssi; /*!< @brief FAIR threshold of the smoothed RSSI*/
+    int8_t linkPoorRssi; /*!< @brief POOR threshold of the smoothed RSSI*/
+    uint8_t linkHysteresisDb; /*!< @brief margin above the thresholds to leave a level*/
+    int32_t rssiAverage; /*!< @brief smoothed RSSI in 1/16 dBm, 0 if not sampled since the connect*/
+    LinkQuality linkQuality; /*!< @brief current link quality*/
+    esp_timer_handle_t slotTimer; /*!< @brief delays the first connection attempt, NULL if slotting is disabled*/
+    uint32_t slotWindowMs; /*!< @brief window the attempts are spread over*/
+    uint16_t slotCount; /*!< @brief number of slots in the window*/
+    uint16_t slot; /*!< @brief slot of this station*/
+    bool slotAssigned; /*!< @brief slot was set by setSlot(), otherwise derived from the MAC*/
+#if CONFIG_WIFICLIENT_STATIC_ALLOCATION
+    EventReceiver eventReceivers[CONFIG_WIFICLIENT_MAX_EVENT_RECEIVERS]; /*!< @brief stors all queue handles which receive the events*/
+    size_t eventReceiverCount; /*!< @brief number of used entries in eventReceivers*/
+    size_t ownedQueueCount; /*!< @brief number of used component owned queue buffers*/
+    StaticQueue_t ownedQueueBuffers[CONFIG_WIFICLIENT_MAX_EVENT_RECEIVERS]; /*!< @brief component owned queue control blocks*/
+    uint8_t ownedQueueStorage[CONFIG_WIFICLIENT_MAX_EVENT_RECEIVERS]
+        [CONFIG_WIFICLIENT_MAX_EVENT_QUEUE_SIZE * sizeof(Event)]; /*!< @brief component owned queue item storage*/
+#else
+    std::vector<EventReceiver> eventReceivers; /*!< @brief stors all queue handles which receive the events*/
+#endif
 
 /** *****************/
 /** PUBLIC METHODS **/
@@ -117,11 +510,14 @@ public:
      * @brief   Initializes the singleton object with the passed config
      * 
      *          Sets log level to LOG_LOCAL_LEVEL (defined in cpp file).
-     *          NVS has to be initialized before this method is called.
+     *          NVS has to be initialized before this method is called,
+     *          except for Storage::RAM without persistConfig.
+     *          With Storage::RAM and persistConfig an empty ssid loads the
+     *          persisted configuration.
      * 
      * @throws  runtime_error if initialization failed.
      * 
-     * @param   config Config object, holds ssid and password
+     * @param   config Config object, holds ssid, password and storage
      */
     void init(Config const& config);
 
@@ -145,28 +541,181 @@ public:
      * @brief   Returns the clients connection status
      * 
      *          connected attribute is protected by mutex, method blocks
-     *          for portMAX_DELAY if mutex is taken.
+     *          for portMAX_DELAY if mutex is taken. With
+     *          CONFIG_WIFICLIENT_IRAM_SAFE the attribute is read without
+     *          the mutex, the method runs from IRAM and can be called from
+     *          IRAM interrupt handlers while the flash cache is disabled.
      * 
      * @return  true if client is connected
      * @return  false if client is not connected 
      */
     bool isConnected() const;
 
+    /*!
+     * @brief   Returns the station netif
+     * 
+     * @return  esp_netif_t* netif, NULL if not initialized
+     */
+    esp_netif_t* getNetif() const;
+
+    /*!
+     * @brief   Returns the handshake statistics
+     * 
+     * @return  HandshakeStats copy of the statistics
+     */
+    HandshakeStats getHandshakeStats() const;
+
+    /*!
+     * @brief   Estimates time and energy to get an ip if connect is called now
+     *
+     *          Based on moving averages of the own phase timings and the
+     *          current cache state: running driver, known access point
+     *          (cached PMKSA, 802.1X only) and a lease from this driver
+     *          session. Roaming of the driver is not part of the averages.
+     *          Defaults are used for phases which were not measured yet.
+     * 
+     * @return  ConnectEstimate estimate, all 0 if already connected
+     */
+    ConnectEstimate estimateConnect() const;
+
+    /*!
+     * @brief   Returns the handoff statistics
+     * 
+     * @return  HandoffStats copy of the statistics
+     */
+    HandoffStats getHandoffStats() const;
+
+    /*!
+     * @brief   Returns the PHY calibration statistics
+     * 
+     * @return  PhyCalibrationStats copy of the statistics
+     */
+    PhyCalibrationStats getPhyCalibrationStats() const;
+
+    /*!
+     * @brief   Returns the current memory pressure, does not block
+     * 
+     * @return  MemoryPressure level of the last check, NORMAL if disabled
+     */
+    MemoryPressure getMemoryPressure() const;
+
+    /*!
+     * @brief   Returns the memory pressure statistics
+     * 
+     * @return  MemoryStats copy of the statistics
+     */
+    MemoryStats getMemoryStats() const;
+
+    /*!
+     * @brief   Returns where the large pools of the component are placed
+     *
+     *          Hot event path data (this object, queues, task stacks)
+     *          and the flash read buffer of WifiHistory always stay
+     *          internal.
+     * 
+     * @return  PlacementStats current placement and free heaps
+     */
+    PlacementStats getPlacementStats() const;
+
+    /*!
+     * @brief   Returns the current link quality, does not block
+     * 
+     * @return  LinkQuality level of the last sample, GOOD if not sampled
+     */
+    LinkQuality getLinkQuality() const;
+
+    /*!
+     * @brief   Returns the smoothed RSSI of the link
+     * 
+     * @return  int8_t RSSI in dBm, 0 if not sampled since the connect
+     */
+    int8_t getRssi() const;
+
+    /*!
+     * @brief   Assigns a slot, e.g. handed out by a fleet server
+     *
+     *          The slot is stored in NVS and replaces the slot derived
+     *          from the MAC address, also after a reboot.
+     * 
+     * @param   slot slot below Config::slotCount
+     * @throws  invalid_argument if slot is not below Config::slotCount
+     * @throws  runtime_error if not initialized with slotting or NVS failed
+     */
+    void setSlot(uint16_t slot);
+
+    /*!
+     * @brief   Removes the assigned slot, the slot is derived from the MAC address again
+     * 
+     * @throws  runtime_error if not initialized with slotting or NVS failed
+     */
+    void clearSlot();
+
+    /*!
+     * @brief   Returns the delay of the first connection attempt
+     * 
+     * @return  uint32_t delay in ms, 0 if slotting is disabled
+     */
+    uint32_t getSlotDelayMs() const;
+
     /*!
      * @brief   Register a queue handle in which disconnected/ connected
      *          events are sent in.
      * 
+     *          In static allocation mode (CONFIG_WIFICLIENT_STATIC_ALLOCATION)
+     *          the queue is created in component owned storage, queueSize
+     *          is limited to CONFIG_WIFICLIENT_MAX_EVENT_QUEUE_SIZE.
+     *          A receiver with a small queue should only take the events it
+     *          handles, so frequent events can't push CONNECTED or
+     *          DISCONNECTED out.
+     * 
      * @param   queueHandle returns queueHandle by reference
      * @param   queueSize default is 1
-     * @throws  invalid_argument if queueSize is 0
+     * @param   events mask of eventBit() values sent to the queue, default is all
+     * @throws  invalid_argument if queueSize is 0 or too big
+     * @throws  runtime_error if queue could not be created
+     */
+    void registerEventReceiver(QueueHandle_t& queueHandle, uint8_t queueSize = 1, uint32_t events = ALL_EVENTS);
+
+    /*!
+     * @brief   Register a queue handle in which disconnected/ connected
+     *          events are sent in, created in caller provided storage.
+     * 
+     * @param   queueHandle returns queueHandle by reference
+     * @param   queueSize number of events the queue can hold
+     * @param   queueStorage buffer of at least queueSize * sizeof(Event) bytes
+     * @param   queueBuffer control block of the queue
+     * @param   events mask of eventBit() values sent to the queue, default is all
+     * @throws  invalid_argument if queueSize is 0 or a buffer is missing
      * @throws  runtime_error if queue could not be created
      */
-    void registerEventReceiver(QueueHandle_t& queueHandle, uint8_t queueSize = 1);
+    void registerEventReceiver(QueueHandle_t& queueHandle, uint8_t queueSize,
+        uint8_t* queueStorage, StaticQueue_t* queueBuffer, uint32_t events = ALL_EVENTS);
+
+    /*!
+     * @brief   Changes the events sent to a registered queue
+     *
+     *          A mask of 0 pauses the receiver, nothing piles up in its
+     *          queue while it does not read.
+     * 
+     * @param   queueHandle handle passed to registerEventReceiver()
+     * @param   events mask of eventBit() values
+     * @throws  invalid_argument if the queue is not registered
+     */
+    void setEventMask(QueueHandle_t const& queueHandle, uint32_t events);
 
 /** ******************/
 /** PRIVATE METHODS **/
 /** ******************/
 private:
+    /*!
+     * @brief   Adds a created queue handle to the event receivers
+     * 
+     * @param   queueHandle handle to add
+     * @param   events mask of the events sent to the queue
+     * @throws  runtime_error if no receiver slot is left
+     */
+    void addEventReceiver(QueueHandle_t& queueHandle, uint32_t events);
+
     /*!
      * @brief   Fires a passed event to all registered queues.
      *
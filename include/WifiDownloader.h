@@ -0,0 +1,232 @@
+/*!
+ * @file 	    WifiDownloader.h
+ * @brief 	    Singleton resumable HTTP downloader which follows the WifiClient link
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#ifndef WifiDownloader_H_
+#define WifiDownloader_H_
+
+#include <stdexcept>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+#include "esp_http_client.h"
+
+/*!
+ * @class   WifiDownloader
+ * @brief   Singleton Class which downloads large payloads in resumable chunks
+ *
+ *          The payload is requested in chunks with HTTP Range requests. On a
+ *          WifiClient DISCONNECTED event the download pauses and resumes at
+ *          the received offset after the next CONNECTED event, nothing is
+ *          downloaded twice. Critical memory pressure pauses the download
+ *          the same way. The chunk size grows additively after every
+ *          received chunk and is halved on every failure or weak RSSI. Data
+ *          is read by esp_http_client directly into the buffers of the
+ *          caller provided Sink. If the server does not know the total
+ *          (Content-Range bytes first-last/*), a chunk shorter than
+ *          requested or a 416 behind the received bytes ends the payload.
+ */
+class WifiDownloader {
+
+/** ******************/
+/** PUBLIC TYPEDEFS **/
+/** ******************/
+public:
+    /*!
+     * @class   Sink
+     * @brief   Interface Class for the destination of a download (OTA partition, file, ...)
+     */
+    class Sink {
+    public:
+        virtual ~Sink() {}
+
+        /*!
+         * @brief   Returns a buffer the next bytes are read into
+         *
+         * @param   length in: wanted length, out: length of the buffer
+         * @return  uint8_t* buffer, nullptr aborts the download
+         */
+        virtual uint8_t* acquire(size_t& length) = 0;
+
+        /*!
+         * @brief   Commits bytes read into the acquired buffer
+         *
+         * @param   length number of bytes written to the buffer
+         * @return  false aborts the download
+         */
+        virtual bool commit(size_t length) = 0;
+    };
+
+    /*!
+     * @brief   Struct which containes the Configuration values
+     */
+    struct Config{
+        size_t initialChunk = 16384;    /*!< @brief size of the first chunk*/
+        size_t minChunk = 4096;         /*!< @brief smallest chunk, used after failures*/
+        size_t maxChunk = 131072;       /*!< @brief largest chunk*/
+        size_t chunkStep = 8192;        /*!< @brief additive increase after a received chunk*/
+        int8_t weakRssi = -75;          /*!< @brief chunks are halved below this RSSI*/
+        uint32_t timeoutMs = 10000;     /*!< @brief network timeout of a request*/
+        uint32_t resumeTimeoutMs = 120000;  /*!< @brief longest pause while disconnected*/
+        uint32_t maxFailures = 10;      /*!< @brief failed chunks in a row before giving up*/
+        const char* certPem = nullptr;  /*!< @brief server certificate for https, must stay valid*/
+    };
+
+    /*!
+     * @brief   Enum Class which stores the result of a download
+     */
+    enum class Status{
+        DONE,           /*!< @brief all bytes written to the sink*/
+        SINK_ABORTED,   /*!< @brief sink returned nullptr or false*/
+        LINK_TIMEOUT,   /*!< @brief no connection within resumeTimeoutMs*/
+        MEMORY_TIMEOUT, /*!< @brief critical memory pressure for longer than resumeTimeoutMs*/
+        HTTP_ERROR,     /*!< @brief unexpected HTTP status*/
+        NO_RANGE,       /*!< @brief server ignores Range, download can't be resumed*/
+        FAILED          /*!< @brief maxFailures chunks failed in a row*/
+    };
+
+    /*!
+     * @brief   Struct which containes the result of a download
+     */
+    struct Result{
+        Status status = Status::FAILED; /*!< @brief result*/
+        size_t offset = 0;      /*!< @brief bytes written to the sink, resume offset*/
+        size_t total = 0;       /*!< @brief size of the payload, 0 if unknown*/
+        uint32_t chunks = 0;    /*!< @brief received chunks*/
+        uint32_t failures = 0;  /*!< @brief failed chunks*/
+        uint32_t pauses = 0;    /*!< @brief pauses for a reconnect or memory pressure*/
+        size_t lastChunk = 0;   /*!< @brief chunk size at the end*/
+        int httpStatus = 0;     /*!< @brief last HTTP status*/
+    };
+
+/** *******************/
+/** PRIVATE TYPEDEFS **/
+/** *******************/
+private:
+    /*!
+     * @brief   Struct which containes the state of one request
+     */
+    struct Request{
+        size_t rangeTotal;  /*!< @brief total from Content-Range, 0 if missing*/
+    };
+
+/** ****************************/
+/** PRIVATE STATIC ATTRIBUTES **/
+/** ****************************/
+private:
+    static WifiDownloader Singleton; /*!< @brief Singleton Instance */
+
+/** ************************/
+/** PUBLIC STATIC METHODS **/
+/** ************************/
+public:
+    /*!
+     * @brief   Get the Singleton Instance
+     *
+     * @return  WifiDownloader& Singleton Instance
+     */
+    static WifiDownloader& getInstance();
+
+/** *************************/
+/** PRIVATE STATIC METHODS **/
+/** *************************/
+private:
+    /*!
+     * @brief   HTTP event handler, parses Content-Range
+     *
+     * @param   event HTTP client event
+     * @return  esp_err_t always ESP_OK
+     */
+    static esp_err_t httpEvent(esp_http_client_event_t* event);
+
+/** **************/
+/** CONSTRUCTOR **/
+/** **************/
+private:
+    /*!
+     * @brief   Construct a new Wifi Downloader object
+     */
+    WifiDownloader();
+
+/** *************/
+/** ATTRIBUTES **/
+/** *************/
+private:
+    bool initalized; /*!< @brief event receiver is registered*/
+    Config config; /*!< @brief active configuration*/
+    QueueHandle_t eventQueue; /*!< @brief WifiClient event receiver, masked to 0 between downloads*/
+    SemaphoreHandle_t mutex; /*!< @brief Mutex which serializes downloads*/
+    StaticSemaphore_t mutexBuffer; /*!< @brief Storage of mutex*/
+
+/** *****************/
+/** PUBLIC METHODS **/
+/** *****************/
+public:
+    /*!
+     * @brief   Registers the WifiClient event receiver
+     *
+     * @param   config Config object
+     * @throws  invalid_argument if the chunk sizes are inconsistent
+     * @throws  runtime_error if init failed
+     */
+    void init(Config const& config);
+
+    /*!
+     * @brief   Downloads a payload into a sink, blocks until done or failed
+     *
+     *          Downloads are serialized. Pass Result::offset of a failed
+     *          download as offset to continue it later.
+     *
+     * @param   url http or https url
+     * @param   sink destination of the payload
+     * @param   offset first byte to download
+     * @return  Result of the download
+     * @throws  runtime_error if not initialized or the client could not be created
+     */
+    Result download(const char* url, Sink& sink, size_t offset = 0);
+
+/** ******************/
+/** PRIVATE METHODS **/
+/** ******************/
+private:
+    /*!
+     * @brief   Waits until the station is connected
+     *
+     * @param   result counts the pause
+     * @return  false if resumeTimeoutMs elapsed
+     */
+    bool waitForLink(Result& result);
+
+    /*!
+     * @brief   Waits until the memory pressure is below CRITICAL
+     *
+     * @param   result counts the pause
+     * @return  false if resumeTimeoutMs elapsed
+     */
+    bool waitForMemory(Result& result);
+
+    /*!
+     * @brief   Returns if a DISCONNECTED event was received
+     *
+     * @return  true if the link dropped
+     */
+    bool linkDropped();
+
+    /*!
+     * @brief   Returns the chunk size for the current link quality
+     *
+     * @param   chunk current chunk size
+     * @return  size_t chunk size for the next request
+     */
+    size_t linkChunk(size_t chunk) const;
+};
+
+#endif /* WifiDownloader_H_ */
@@ -0,0 +1,250 @@
+/*!
+ * @file 	    WifiEspNow.h
+ * @brief 	    Singleton ESP-NOW side channel which coexists with the WifiClient station
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#ifndef WifiEspNow_H_
+#define WifiEspNow_H_
+
+#include <stdexcept>
+#include <string>
+#include <cstring>
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_now.h"
+
+/*!
+ * @brief   Event Handler for the station connection events
+ *
+ *          Holds back transmissions while the station is switching
+ *          channels and tracks the home channel.
+ */
+extern "C" void WifiEspNow_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data);
+
+/*!
+ * @class   WifiEspNow
+ * @brief   Singleton Interface Class for ESP-NOW next to the WifiClient station
+ *
+ *          ESP-NOW has to use the channel of the access point the station is
+ *          associated with. Peers are added on the current channel, so they
+ *          follow every channel change of the station. Until the station
+ *          is associated and while it is reconnecting (possibly to another
+ *          channel) messages are held back in a pre-allocated pool and
+ *          sent after the connected event, failed transmissions are
+ *          retransmitted.
+ */
+class WifiEspNow {
+
+/*!
+ * @brief   Event Handler as friend function
+ */
+friend void WifiEspNow_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data);
+
+/** ******************/
+/** PUBLIC TYPEDEFS **/
+/** ******************/
+public:
+    /*!
+     * @brief   Struct which containes the Configuration values
+     */
+    struct Config{
+        uint8_t retransmits = 3;        /*!< @brief Retransmissions of a failed message*/
+        uint32_t holdTimeoutMs = 1000;  /*!< @brief Max time a message is held back during a channel switch*/
+        UBaseType_t taskPriority = 5;   /*!< @brief Priority of the transmit task*/
+    };
+
+    /*!
+     * @brief   Callback for received messages, called in the wifi task
+     */
+    typedef void (*ReceiveCallback)(const uint8_t* mac, const uint8_t* data, size_t length);
+
+    /*!
+     * @brief   Struct which containes the transmit statistics
+     */
+    struct Stats{
+        uint32_t sent = 0;          /*!< @brief messages accepted by send()*/
+        uint32_t delivered = 0;     /*!< @brief messages acknowledged by the peer*/
+        uint32_t failed = 0;        /*!< @brief messages dropped after all retransmits*/
+        uint32_t expired = 0;       /*!< @brief messages dropped after holdTimeoutMs*/
+        uint32_t retransmits = 0;   /*!< @brief number of retransmissions*/
+        uint32_t held = 0;          /*!< @brief messages held back during a channel switch*/
+        uint32_t poolExhausted = 0; /*!< @brief send() calls rejected, pool was full*/
+        uint32_t minLatencyUs = 0;  /*!< @brief min time from send() to delivery*/
+        uint32_t maxLatencyUs = 0;  /*!< @brief max time from send() to delivery*/
+        uint64_t totalLatencyUs = 0;    /*!< @brief sum of all delivery latencies*/
+    };
+
+/** *******************/
+/** PRIVATE TYPEDEFS **/
+/** *******************/
+private:
+    /*!
+     * @brief   Struct which containes one pooled message
+     */
+    struct Message{
+        uint8_t mac[ESP_NOW_ETH_ALEN];      /*!< @brief destination*/
+        uint8_t data[ESP_NOW_MAX_DATA_LEN]; /*!< @brief payload*/
+        uint8_t length;                     /*!< @brief payload length*/
+        uint8_t attempts;                   /*!< @brief transmissions so far*/
+        int64_t enqueued;                   /*!< @brief time of send()*/
+    };
+
+/** ****************************/
+/** PRIVATE STATIC ATTRIBUTES **/
+/** ****************************/
+private:
+    static WifiEspNow Singleton;    /*!< @brief Singleton Instance */
+    static const EventBits_t LINK_READY = 1 << 0;  /*!< @brief station is on its home channel*/
+    static const uint32_t TASK_STACK_SIZE = 3072;   /*!< @brief stack size of the transmit task*/
+    static Message messagePool[CONFIG_WIFICLIENT_ESPNOW_MESSAGE_POOL];  /*!< @brief pre-allocated messages*/
+    static uint8_t freeMessagesStorage[CONFIG_WIFICLIENT_ESPNOW_MESSAGE_POOL];    /*!< @brief storage of freeMessages*/
+    static uint8_t pendingMessagesStorage[CONFIG_WIFICLIENT_ESPNOW_MESSAGE_POOL]; /*!< @brief storage of pendingMessages*/
+    static StackType_t taskStack[TASK_STACK_SIZE];  /*!< @brief stack of the transmit task*/
+
+/** ************************/
+/** PUBLIC STATIC METHODS **/
+/** ************************/
+public:
+    /*!
+     * @brief   Get the Singleton Instance
+     *
+     * @return  WifiEspNow& Singleton Instance
+     */
+    static WifiEspNow& getInstance();
+
+/** *************************/
+/** PRIVATE STATIC METHODS **/
+/** *************************/
+private:
+    /*!
+     * @brief   Transmit task, sends pooled messages in order
+     *
+     * @param   arg unused
+     */
+    static void transmitTask(void* arg);
+
+    /*!
+     * @brief   ESP-NOW send callback, passes the status to the transmit task
+     */
+    static void sendCallback(const uint8_t* mac, esp_now_send_status_t status);
+
+    /*!
+     * @brief   ESP-NOW receive callback, forwards to the registered callback
+     */
+    static void receiveCallback(const esp_now_recv_info_t* info, const uint8_t* data, int length);
+
+/** **************/
+/** CONSTRUCTOR **/
+/** **************/
+private:
+    /*!
+     * @brief   Construct a new Wifi Esp Now object
+     */
+    WifiEspNow();
+
+/** *************/
+/** ATTRIBUTES **/
+/** *************/
+private:
+    Config config;  /*!< @brief active configuration*/
+    bool initalized; /*!< @brief initialized attribute*/
+    uint8_t channel; /*!< @brief home channel of the station, 0 if unknown*/
+    ReceiveCallback receiver; /*!< @brief registered receive callback*/
+    Stats stats; /*!< @brief transmit statistics*/
+    portMUX_TYPE statsLock; /*!< @brief Spinlock for stats and channel*/
+    SemaphoreHandle_t peerMutex; /*!< @brief Mutex for the peer table*/
+    StaticSemaphore_t peerMutexBuffer; /*!< @brief Storage of peerMutex*/
+    uint8_t peers[CONFIG_WIFICLIENT_ESPNOW_MAX_PEERS][ESP_NOW_ETH_ALEN]; /*!< @brief registered peers*/
+    size_t peerCount; /*!< @brief number of registered peers*/
+    QueueHandle_t freeMessages; /*!< @brief indices of unused pool messages*/
+    StaticQueue_t freeMessagesBuffer; /*!< @brief control block of freeMessages*/
+    QueueHandle_t pendingMessages; /*!< @brief indices of messages to transmit*/
+    StaticQueue_t pendingMessagesBuffer; /*!< @brief control block of pendingMessages*/
+    EventGroupHandle_t linkState; /*!< @brief LINK_READY bit*/
+    StaticEventGroup_t linkStateBuffer; /*!< @brief control block of linkState*/
+    TaskHandle_t task; /*!< @brief transmit task*/
+    StaticTask_t taskBuffer; /*!< @brief control block of the transmit task*/
+
+/** *****************/
+/** PUBLIC METHODS **/
+/** *****************/
+public:
+    /*!
+     * @brief   Initializes ESP-NOW with the passed config
+     *
+     *          WifiClient has to be initialized first, ESP-NOW uses
+     *          the station interface.
+     *
+     * @param   config Config object
+     * @throws  runtime_error if initialization failed.
+     */
+    void init(Config const& config);
+
+    /*!
+     * @brief   Adds a peer on the current channel
+     *
+     * @param   mac address of the peer
+     * @throws  runtime_error if the peer table is full or the peer could not be added
+     */
+    void addPeer(const uint8_t* mac);
+
+    /*!
+     * @brief   Removes a peer
+     *
+     * @param   mac address of the peer
+     * @throws  runtime_error if the peer could not be removed
+     */
+    void removePeer(const uint8_t* mac);
+
+    /*!
+     * @brief   Queues a message for transmission
+     *
+     *          The payload is copied into the message pool, method does
+     *          not block.
+     *
+     * @param   mac address of the peer
+     * @param   data payload
+     * @param   length payload length, max ESP_NOW_MAX_DATA_LEN
+     * @return  true if the message was queued
+     * @return  false if the message pool is exhausted
+     * @throws  invalid_argument if length is 0 or too big
+     * @throws  runtime_error if not initialized
+     */
+    bool send(const uint8_t* mac, const uint8_t* data, size_t length);
+
+    /*!
+     * @brief   Sets the callback for received messages
+     *
+     * @param   callback called in the wifi task, nullptr to remove
+     */
+    void setReceiveCallback(ReceiveCallback callback);
+
+    /*!
+     * @brief   Returns the home channel ESP-NOW currently uses
+     *
+     * @return  uint8_t channel, 0 if the station was not connected yet
+     */
+    uint8_t getChannel() const;
+
+    /*!
+     * @brief   Returns the transmit statistics
+     *
+     * @return  Stats copy of the statistics
+     */
+    Stats getStats() const;
+};
+
+#endif /* WifiEspNow_H_ */
@@ -0,0 +1,436 @@
+/*!
+ * @file 	    WifiHistory.h
+ * @brief 	    Singleton log-structured connectivity history in a flash partition
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#ifndef WifiHistory_H_
+#define WifiHistory_H_
+
+#include <stdexcept>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_partition.h"
+
+/*!
+ * @brief   Event Handler for the station connection events
+ *
+ *          Queues a record for every connect (with time to ip) and
+ *          every loss of an established connection (with reason).
+ */
+extern "C" void WifiHistory_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data);
+
+/*!
+ * @class   WifiHistory
+ * @brief   Singleton Class which keeps months of connectivity history in flash
+ *
+ *          The partition is split in a raw ring and an aggregate ring of
+ *          4 KB sectors. Connect and disconnect records (6 bytes, time as
+ *          16 bit delta to the previous record) are appended to the raw
+ *          ring, a gap of more than 18 hours is bridged by a time record
+ *          which carries the full time. Before the raw ring wraps, its oldest sector is compacted
+ *          into daily aggregates which are appended to the aggregate ring,
+ *          the oldest aggregates are dropped when that ring wraps. Every
+ *          record is written once and compacted once, no sector is
+ *          rewritten, so write amplification stays bounded (see Stats).
+ *
+ *          Days are counted since the epoch. Records made before the system
+ *          time is set (SNTP) are held back in RAM (HELD_EVENTS) and written
+ *          once the time is valid, with their time derived from esp_timer.
+ *          They are lost on a reset before the time is set.
+ */
+class WifiHistory {
+
+/*!
+ * @brief   Event Handler as friend function
+ */
+friend void WifiHistory_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data);
+
+/** ******************/
+/** PUBLIC TYPEDEFS **/
+/** ******************/
+public:
+    /*!
+     * @brief   Enum Class which groups disconnect reasons
+     */
+    enum class Reason{
+        BEACON_TIMEOUT, /*!< @brief AP lost (beacon timeout)*/
+        NO_AP_FOUND,    /*!< @brief AP not found on reconnect*/
+        AUTH,           /*!< @brief authentication or handshake failed*/
+        INACTIVITY,     /*!< @brief AP disassociated the idle station*/
+        AP_LEAVE,       /*!< @brief AP left or deauthenticated*/
+        OTHER,          /*!< @brief all other reasons*/
+        COUNT           /*!< @brief number of groups*/
+    };
+
+    /*!
+     * @brief   Number of time to ip histogram buckets
+     */
+    static const size_t TIME_TO_IP_BUCKETS = 8;
+
+    /*!
+     * @brief   Struct which containes the statistics of one day
+     */
+    struct DayStats{
+        uint32_t day = 0;           /*!< @brief days since epoch*/
+        uint32_t connects = 0;      /*!< @brief connects (got ip)*/
+        uint32_t disconnects = 0;   /*!< @brief losses of an established connection*/
+        uint32_t reasons[(size_t)Reason::COUNT] = {0};  /*!< @brief disconnects per Reason*/
+        uint32_t timeToIpP50Ms = 0; /*!< @brief median time to ip, upper bound of its bucket*/
+        uint32_t timeToIpP90Ms = 0; /*!< @brief 90th percentile time to ip, upper bound of its bucket*/
+        uint32_t timeToIpP99Ms = 0; /*!< @brief 99th percentile time to ip, upper bound of its bucket*/
+    };
+
+    /*!
+     * @brief   Struct which containes the flash usage statistics
+     *
+     *          bytesWritten / payloadBytes is the write amplification.
+     */
+    struct Stats{
+        uint32_t recordsAppended = 0;   /*!< @brief raw records written*/
+        uint32_t aggregatesWritten = 0; /*!< @brief daily aggregates written by compaction*/
+        uint32_t payloadBytes = 0;      /*!< @brief bytes of raw records*/
+        uint32_t bytesWritten = 0;      /*!< @brief all bytes written incl. aggregates and sector headers*/
+        uint32_t sectorsErased = 0;     /*!< @brief erased sectors*/
+        uint32_t compactions = 0;       /*!< @brief compacted raw sectors*/
+        uint32_t dropped = 0;           /*!< @brief records lost because the queue or the held records were full*/
+        uint32_t held = 0;              /*!< @brief records waiting for a valid system time*/
+        uint32_t flashErrors = 0;       /*!< @brief failed flash operations of the writer task*/
+    };
+
+/** *******************/
+/** PRIVATE TYPEDEFS **/
+/** *******************/
+private:
+    /*!
+     * @brief   Struct which containes a sector header
+     */
+    struct SectorHeader{
+        uint32_t magic;     /*!< @brief marks a used sector*/
+        uint32_t sequence;  /*!< @brief increasing per ring, highest is the head*/
+        uint32_t baseTime;  /*!< @brief time the first record delta refers to*/
+        uint32_t reserved;  /*!< @brief keeps entries 8 byte aligned*/
+    };
+
+    /*!
+     * @brief   Struct which containes a raw record
+     */
+    struct Record{
+        uint8_t type;       /*!< @brief record type, 0xFF if erased*/
+        uint8_t reason;     /*!< @brief wifi disconnect reason*/
+        uint16_t timeToIp;  /*!< @brief time to ip in 10 ms, 0xFFFF if unknown*/
+        uint16_t delta;     /*!< @brief seconds since the previous record or baseTime*/
+    };
+
+    /*!
+     * @brief   Struct which containes a time record, same size as Record
+     *
+     *          Written in front of a record whose delta does not fit 16 bit,
+     *          the deltas of the following records refer to its time.
+     */
+    struct TimeRecord{
+        uint8_t type;       /*!< @brief record type, 0xFF if erased*/
+        uint8_t reserved;   /*!< @brief padding*/
+        uint16_t timeLow;   /*!< @brief lower half of the time*/
+        uint16_t timeHigh;  /*!< @brief upper half of the time*/
+    };
+
+    /*!
+     * @brief   Struct which containes a daily aggregate
+     */
+    struct Aggregate{
+        uint8_t type;           /*!< @brief record type, 0xFF if erased*/
+        uint8_t reserved;       /*!< @brief padding*/
+        uint16_t connects;      /*!< @brief connects*/
+        uint32_t day;           /*!< @brief days since epoch*/
+        uint32_t source;        /*!< @brief sequence of the compacted raw sector*/
+        uint16_t disconnects;   /*!< @brief disconnects*/
+        uint16_t reasons[(size_t)Reason::COUNT];    /*!< @brief disconnects per Reason*/
+        uint16_t timeToIp[TIME_TO_IP_BUCKETS];      /*!< @brief time to ip histogram*/
+    };
+
+    /*!
+     * @brief   Struct which containes the state of one ring
+     */
+    struct Ring{
+        uint32_t firstSector;   /*!< @brief first sector of the ring in the partition*/
+        uint32_t sectors;       /*!< @brief number of sectors*/
+        uint32_t entrySize;     /*!< @brief size of one entry*/
+        uint32_t head;          /*!< @brief sector written to*/
+        uint32_t offset;        /*!< @brief write offset in head*/
+        uint32_t sequence;      /*!< @brief sequence of head*/
+        bool empty;             /*!< @brief no sector used yet*/
+    };
+
+    /*!
+     * @brief   Struct which containes a queued event
+     */
+    struct Event{
+        uint8_t type;           /*!< @brief record type*/
+        uint8_t reason;         /*!< @brief wifi disconnect reason*/
+        uint16_t timeToIp;      /*!< @brief time to ip in 10 ms*/
+        uint32_t time;          /*!< @brief system time*/
+        int64_t uptime;         /*!< @brief esp_timer time, dates held records*/
+    };
+
+    /*!
+     * @brief   Callback for every entry of a sector
+     *
+     * @param   context passed to readEntries
+     * @param   entry entrySize bytes
+     */
+    typedef void (*EntryVisitor)(void* context, const uint8_t* entry);
+
+/** ****************************/
+/** PRIVATE STATIC ATTRIBUTES **/
+/** ****************************/
+private:
+    static WifiHistory Singleton;   /*!< @brief Singleton Instance */
+    static const uint32_t TASK_STACK_SIZE = 3072;   /*!< @brief stack size of the writer task*/
+    static const uint32_t EVENT_QUEUE_SIZE = 8;     /*!< @brief queued events*/
+    static const uint32_t HELD_EVENTS = 16;         /*!< @brief events held back until the system time is set*/
+    static const uint32_t TIME_POLL_MS = 1000;      /*!< @brief check interval of the system time while events are held*/
+    static StackType_t taskStack[TASK_STACK_SIZE];  /*!< @brief stack of the writer task*/
+    static uint8_t eventStorage[EVENT_QUEUE_SIZE * sizeof(Event)];  /*!< @brief storage of the event queue*/
+    static uint8_t readBuffer[396]; /*!< @brief flash read buffer, multiple of both entry sizes, internal: flash reads into PSRAM need a bounce buffer*/
+
+/** ************************/
+/** PUBLIC STATIC METHODS **/
+/** ************************/
+public:
+    /*!
+     * @brief   Get the Singleton Instance
+     *
+     * @return  WifiHistory& Singleton Instance
+     */
+    static WifiHistory& getInstance();
+
+/** *************************/
+/** PRIVATE STATIC METHODS **/
+/** *************************/
+private:
+    /*!
+     * @brief   Writer task, appends queued events to flash
+     *
+     * @param   arg unused
+     */
+    static void writerTask(void* arg);
+
+    /*!
+     * @brief   Maps a wifi disconnect reason to a Reason group
+     *
+     * @param   reason wifi_err_reason_t
+     * @return  Reason group
+     */
+    static Reason groupReason(uint8_t reason);
+
+    /*!
+     * @brief   Adds a raw record to an aggregate
+     *
+     * @param   aggregate to add to
+     * @param   record raw record
+     */
+    static void addToAggregate(Aggregate& aggregate, Record const& record);
+
+    /*!
+     * @brief   Returns the time of a raw record
+     *
+     * @param   previous time of the previous record or the base time of the sector
+     * @param   record raw record or time record
+     * @return  uint32_t time of the record
+     */
+    static uint32_t timeOf(uint32_t previous, Record const& record);
+
+/** **************/
+/** CONSTRUCTOR **/
+/** **************/
+private:
+    /*!
+     * @brief   Construct a new Wifi History object
+     */
+    WifiHistory();
+
+/** *************/
+/** ATTRIBUTES **/
+/** *************/
+private:
+    bool initalized; /*!< @brief partition mounted and writer started*/
+    const esp_partition_t* partition; /*!< @brief history partition*/
+    Ring rawRing; /*!< @brief ring of raw records*/
+    Ring aggregateRing; /*!< @brief ring of daily aggregates*/
+    uint32_t lastTime; /*!< @brief time of the last raw record*/
+    uint32_t compactedSequence; /*!< @brief sequence of the last compacted raw sector*/
+    Event held[HELD_EVENTS]; /*!< @brief events made before the system time was set, writer task only*/
+    uint32_t heldCount; /*!< @brief number of held events*/
+    bool compactedValid; /*!< @brief compactedSequence is known*/
+    Stats stats; /*!< @brief flash usage statistics*/
+    bool linkUp; /*!< @brief station has an ip*/
+    int64_t attemptStart; /*!< @brief start of the current connect phase, 0 if unknown*/
+    SemaphoreHandle_t mutex; /*!< @brief Mutex for flash access and rings*/
+    StaticSemaphore_t mutexBuffer; /*!< @brief Storage of mutex*/
+    QueueHandle_t events; /*!< @brief events for the writer task*/
+    StaticQueue_t eventsBuffer; /*!< @brief control block of events*/
+    StaticTask_t taskBuffer; /*!< @brief control block of the writer task*/
+    portMUX_TYPE lock; /*!< @brief Spinlock for stats and link state*/
+
+/** *****************/
+/** PUBLIC METHODS **/
+/** *****************/
+public:
+    /*!
+     * @brief   Mounts the history partition and starts recording
+     *
+     *          The data partition needs at least 4 sectors, a quarter of
+     *          it but at least 2 sectors are used for aggregates, so a
+     *          wrap of the aggregate ring only drops its oldest sector. Has to be called before
+     *          WifiClient::connect to see the first connect.
+     *
+     * @param   partitionLabel label of the partition
+     * @param   taskPriority priority of the writer task
+     * @throws  runtime_error if the partition is missing, too small or can't be read
+     */
+    void init(const char* partitionLabel = "wifihist", UBaseType_t taskPriority = 2);
+
+    /*!
+     * @brief   Returns the statistics of one day
+     *
+     *          Merges aggregates and not yet compacted records.
+     *
+     * @param   day days since epoch (time / 86400)
+     * @param   stats returns the statistics
+     * @return  true if records of the day were found
+     * @throws  runtime_error if not initialized or reading failed
+     */
+    bool getDay(uint32_t day, DayStats& stats) const;
+
+    /*!
+     * @brief   Returns the flash usage statistics
+     *
+     * @return  Stats copy of the statistics
+     */
+    Stats getStats() const;
+
+    /*!
+     * @brief   Erases the whole history
+     *
+     * @throws  runtime_error if not initialized or erasing failed
+     */
+    void clear();
+
+/** ******************/
+/** PRIVATE METHODS **/
+/** ******************/
+private:
+    /*!
+     * @brief   Finds head and write offset of a ring
+     *
+     * @param   ring to mount
+     * @return  esp_err_t result of the flash reads
+     */
+    esp_err_t mount(Ring& ring);
+
+    /*!
+     * @brief   Reads a sector header
+     *
+     * @param   ring of the sector
+     * @param   sector index in the ring
+     * @param   header returns the header
+     * @return  esp_err_t ESP_ERR_NOT_FOUND if the sector is unused
+     */
+    esp_err_t readHeader(Ring const& ring, uint32_t sector, SectorHeader& header) const;
+
+    /*!
+     * @brief   Calls visitor for every entry of a sector
+     *
+     * @param   ring of the sector
+     * @param   sector index in the ring
+     * @param   visitor called for every entry
+     * @param   context of visitor
+     * @param   end returns the offset behind the last entry, can be NULL
+     * @return  esp_err_t result of the flash reads
+     */
+    esp_err_t readEntries(Ring const& ring, uint32_t sector, EntryVisitor visitor, void* context, uint32_t* end) const;
+
+    /*!
+     * @brief   Opens the next sector of a ring
+     *
+     *          The oldest raw sector is compacted before it is erased.
+     *
+     * @param   ring to advance
+     * @param   time base time of the new sector
+     * @return  esp_err_t result of the flash operations
+     */
+    esp_err_t nextSector(Ring& ring, uint32_t time);
+
+    /*!
+     * @brief   Writes an entry at the write offset of a ring
+     *
+     * @param   ring to write to, head must have space
+     * @param   entry entrySize bytes
+     * @return  esp_err_t result of the flash write
+     */
+    esp_err_t writeEntry(Ring& ring, const void* entry);
+
+    /*!
+     * @brief   Compacts a raw sector into daily aggregates
+     *
+     * @param   sector index in the raw ring
+     * @return  esp_err_t result of the flash operations
+     */
+    esp_err_t compact(uint32_t sector);
+
+    /*!
+     * @brief   Appends an aggregate to the aggregate ring
+     *
+     * @param   aggregate daily aggregate
+     * @param   time base time if a new sector is opened
+     * @return  esp_err_t result of the flash operations
+     */
+    esp_err_t appendAggregate(Aggregate const& aggregate, uint32_t time);
+
+    /*!
+     * @brief   Appends a raw record for an event
+     *
+     * @param   event queued event
+     * @return  esp_err_t result of the flash operations
+     */
+    esp_err_t appendEvent(Event const& event);
+
+    /*!
+     * @brief   Appends an event under the mutex, counts flash errors
+     *
+     * @param   event event with valid time
+     */
+    void writeEvent(Event const& event);
+
+    /*!
+     * @brief   Writes the held events once the system time is valid
+     *
+     *          The time of every held event is the current time minus
+     *          the esp_timer time passed since the event.
+     */
+    void releaseHeld();
+
+    /*!
+     * @brief   Returns if a raw sector was already compacted
+     *
+     *          Happens if power was lost between compaction and erase.
+     *
+     * @param   sequence of the raw sector
+     * @return  true if its aggregates exist
+     */
+    bool isCompacted(uint32_t sequence) const;
+};
+
+#endif /* WifiHistory_H_ */
@@ -0,0 +1,219 @@
+/*!
+ * @file 	    WifiIngressFilter.h
+ * @brief 	    Singleton early drop filter for broadcast noise on the station netif
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#ifndef WifiIngressFilter_H_
+#define WifiIngressFilter_H_
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "esp_event.h"
+
+/*!
+ * @brief   Event Handler for the station start and connected events
+ *
+ *          The driver registers lwIP as receiver on these events,
+ *          the filter is registered again behind it.
+ */
+extern "C" void WifiIngressFilter_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data);
+
+/*!
+ * @class   WifiIngressFilter
+ * @brief   Singleton Class which drops unwanted broadcast/multicast frames before lwIP
+ *
+ *          The filter replaces the receive callback of the station
+ *          interface. Unicast frames are passed after a single byte check.
+ *          Group addressed UDP datagrams (IPv4 and IPv6) are matched by
+ *          destination port against a compiled table and dropped without
+ *          allocating a pbuf or waking the lwIP thread, everything else is
+ *          handed to the netif created by WifiClient::init. Under critical
+ *          memory pressure all group addressed UDP except DHCP is dropped.
+ *
+ *          Unicast frames are passed before any lock is taken, the counters
+ *          are atomics. The spinlock only guards the rule table while a
+ *          group addressed frame is matched.
+ *
+ *          The filter relies on esp_wifi_internal_reg_rxcb from
+ *          esp_private/wifi.h, a private driver API without stability
+ *          guarantees. It is verified with ESP-IDF 5.2.1 and can be
+ *          compiled out with CONFIG_WIFICLIENT_INGRESS_FILTER.
+ */
+class WifiIngressFilter {
+
+/*!
+ * @brief   Event Handler as friend function
+ */
+friend void WifiIngressFilter_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data);
+
+/** ******************/
+/** PUBLIC TYPEDEFS **/
+/** ******************/
+public:
+    /*!
+     * @brief   Maximum number of rules
+     */
+    static const size_t MAX_RULES = 16;
+
+    /*!
+     * @brief   Struct which containes a drop rule
+     */
+    struct Rule{
+        uint16_t port;      /*!< @brief UDP destination port of group addressed datagrams*/
+        const char* name;   /*!< @brief name for the statistics, must stay valid*/
+    };
+
+    /*!
+     * @brief   Struct which containes the statistics of one rule
+     */
+    struct RuleStats{
+        uint16_t port = 0;          /*!< @brief UDP destination port*/
+        const char* name = nullptr; /*!< @brief name of the rule*/
+        uint32_t hits = 0;          /*!< @brief dropped frames*/
+        uint32_t bytes = 0;         /*!< @brief dropped bytes*/
+    };
+
+    /*!
+     * @brief   Struct which containes the filter statistics
+     */
+    struct Stats{
+        uint32_t inspected = 0;     /*!< @brief received frames*/
+        uint32_t passed = 0;        /*!< @brief frames handed to lwIP*/
+        uint32_t dropped = 0;       /*!< @brief frames dropped by a rule*/
+        uint32_t droppedBytes = 0;  /*!< @brief bytes dropped by a rule*/
+        uint32_t pressureDropped = 0;   /*!< @brief frames dropped under critical memory pressure*/
+    };
+
+/** ****************************/
+/** PRIVATE STATIC ATTRIBUTES **/
+/** ****************************/
+private:
+    static WifiIngressFilter Singleton; /*!< @brief Singleton Instance */
+    static const Rule DEFAULT_RULES[];  /*!< @brief mDNS, SSDP, NetBIOS, LLMNR*/
+
+/** ************************/
+/** PUBLIC STATIC METHODS **/
+/** ************************/
+public:
+    /*!
+     * @brief   Get the Singleton Instance
+     *
+     * @return  WifiIngressFilter& Singleton Instance
+     */
+    static WifiIngressFilter& getInstance();
+
+/** *************************/
+/** PRIVATE STATIC METHODS **/
+/** *************************/
+private:
+    /*!
+     * @brief   Receive callback of the station interface, runs in the wifi task
+     *
+     * @param   buffer frame
+     * @param   length frame length
+     * @param   eb driver rx buffer
+     * @return  esp_err_t result of esp_netif_receive, ESP_OK if dropped
+     */
+    static esp_err_t receive(void* buffer, uint16_t length, void* eb);
+
+    /*!
+     * @brief   Registers receive as callback of the station interface
+     *
+     * @return  esp_err_t result of esp_wifi_internal_reg_rxcb, ESP_ERR_NOT_SUPPORTED if compiled out
+     */
+    static esp_err_t hook();
+
+/** **************/
+/** CONSTRUCTOR **/
+/** **************/
+private:
+    /*!
+     * @brief   Construct a new Wifi Ingress Filter object
+     */
+    WifiIngressFilter();
+
+/** *************/
+/** ATTRIBUTES **/
+/** *************/
+private:
+    bool initalized; /*!< @brief event handler is registered*/
+    bool enabled; /*!< @brief rules are applied*/
+    uint16_t ports[MAX_RULES]; /*!< @brief compiled table, destination ports of the rules*/
+    size_t ruleCount; /*!< @brief used entries of ports*/
+    const char* names[MAX_RULES]; /*!< @brief names of the rules*/
+    std::atomic<uint32_t> hits[MAX_RULES]; /*!< @brief dropped frames per rule*/
+    std::atomic<uint32_t> hitBytes[MAX_RULES]; /*!< @brief dropped bytes per rule*/
+    std::atomic<uint32_t> inspected; /*!< @brief received frames*/
+    std::atomic<uint32_t> passed; /*!< @brief frames handed to lwIP*/
+    std::atomic<uint32_t> dropped; /*!< @brief frames dropped by a rule*/
+    std::atomic<uint32_t> droppedBytes; /*!< @brief bytes dropped by a rule*/
+    std::atomic<uint32_t> pressureDropped; /*!< @brief frames dropped under critical memory pressure*/
+    portMUX_TYPE lock; /*!< @brief Spinlock for the rule table*/
+
+/** *****************/
+/** PUBLIC METHODS **/
+/** *****************/
+public:
+    /*!
+     * @brief   Compiles the rules and hooks the filter into the station interface
+     *
+     *          WifiClient has to be initialized first. Without rules the
+     *          default rules (mDNS 5353, SSDP 1900, NetBIOS 137/138,
+     *          LLMNR 5355) are used, drop mDNS only if it is not used.
+     *
+     * @param   rules drop rules, nullptr for the default rules
+     * @param   count number of rules
+     * @throws  invalid_argument if count is above MAX_RULES
+     * @throws  runtime_error if hooking failed or CONFIG_WIFICLIENT_INGRESS_FILTER is disabled
+     */
+    void init(const Rule* rules = nullptr, size_t count = 0);
+
+    /*!
+     * @brief   Enables or disables the rules, frames are counted either way
+     *
+     * @param   enabled true applies the rules
+     */
+    void setEnabled(bool enabled);
+
+    /*!
+     * @brief   Copies the statistics of all rules
+     *
+     * @param   ruleStats buffer for the statistics
+     * @param   maxRules size of ruleStats
+     * @return  size_t number of copied rules
+     */
+    size_t getRuleStats(RuleStats* ruleStats, size_t maxRules) const;
+
+    /*!
+     * @brief   Returns the filter statistics
+     *
+     * @return  Stats copy of the statistics
+     */
+    Stats getStats() const;
+
+/** ******************/
+/** PRIVATE METHODS **/
+/** ******************/
+private:
+    /*!
+     * @brief   Returns the rule a frame matches
+     *
+     * @param   frame ethernet frame
+     * @param   length frame length
+     * @param   strict drops all group addressed UDP except DHCP
+     * @return  int index of the rule, MAX_RULES if dropped by strict, -1 if the frame is passed
+     */
+    int match(const uint8_t* frame, uint16_t length, bool strict) const;
+};
+
+#endif /* WifiIngressFilter_H_ */
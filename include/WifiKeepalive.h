@@ -0,0 +1,181 @@
+/*!
+ * @file 	    WifiKeepalive.h
+ * @brief 	    Singleton keepalive scheduler which avoids idle disassociations
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#ifndef WifiKeepalive_H_
+#define WifiKeepalive_H_
+
+#include <stdexcept>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_wifi.h"
+#include "esp_timer.h"
+#include "lwip/ip4_addr.h"
+
+/*!
+ * @brief   Event Handler for the station connection events
+ *
+ *          Learns the idle timeout of the AP from inactivity
+ *          disconnects and starts/stops the keepalive timer.
+ */
+extern "C" void WifiKeepalive_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data);
+
+/*!
+ * @class   WifiKeepalive
+ * @brief   Singleton Class which sends keepalives just before the AP idle timeout
+ *
+ *          Many APs disassociate stations which were idle for some minutes,
+ *          the following reconnect costs more energy than a keepalive. The
+ *          idle timeout is learned from inactivity disconnects (or
+ *          configured), a minimal ARP request to the gateway is sent
+ *          before it expires. Keepalives are aligned to the wake interval
+ *          (DTIM/listen interval) grid starting at the association, so they
+ *          are sent while the radio is awake anyway.
+ */
+class WifiKeepalive {
+
+/*!
+ * @brief   Event Handler as friend function
+ */
+friend void WifiKeepalive_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data);
+
+/** ******************/
+/** PUBLIC TYPEDEFS **/
+/** ******************/
+public:
+    /*!
+     * @brief   Struct which containes the Configuration values
+     */
+    struct Config{
+        uint32_t idleTimeoutMs = 0;     /*!< @brief idle timeout of the AP, 0 learns it from disconnect reasons*/
+        uint8_t marginPercent = 80;     /*!< @brief keepalive is due at this percentage of the idle timeout*/
+        uint32_t wakeIntervalMs = 307;  /*!< @brief wake interval of the station (beacon interval * DTIM/listen interval), 0 disables alignment*/
+        uint32_t minTimeoutMs = 10000;  /*!< @brief shorter idle times are not learned as timeout*/
+    };
+
+    /*!
+     * @brief   Struct which containes the keepalive statistics
+     */
+    struct Stats{
+        uint32_t timeoutMs = 0;     /*!< @brief idle timeout in use, 0 if unknown*/
+        uint32_t keepalives = 0;    /*!< @brief sent keepalives*/
+        uint32_t idleKicks = 0;     /*!< @brief observed inactivity disconnects*/
+        uint32_t sendErrors = 0;    /*!< @brief keepalives which could not be sent*/
+    };
+
+/** ****************************/
+/** PRIVATE STATIC ATTRIBUTES **/
+/** ****************************/
+private:
+    static WifiKeepalive Singleton; /*!< @brief Singleton Instance */
+
+/** ************************/
+/** PUBLIC STATIC METHODS **/
+/** ************************/
+public:
+    /*!
+     * @brief   Get the Singleton Instance
+     *
+     * @return  WifiKeepalive& Singleton Instance
+     */
+    static WifiKeepalive& getInstance();
+
+/** *************************/
+/** PRIVATE STATIC METHODS **/
+/** *************************/
+private:
+    /*!
+     * @brief   Timer callback, sends the keepalive if it is due
+     *
+     * @param   arg unused
+     */
+    static void keepaliveTimer(void* arg);
+
+    /*!
+     * @brief   Sends the ARP request, runs in the lwIP thread
+     *
+     * @param   arg unused
+     */
+    static void sendKeepalive(void* arg);
+
+    /*!
+     * @brief   Arms the timer for the next due keepalive
+     */
+    static void schedule();
+
+    /*!
+     * @brief   Returns the due time of the next keepalive
+     *
+     * @return  int64_t esp_timer time, 0 if no keepalive is needed
+     */
+    static int64_t dueTime();
+
+/** **************/
+/** CONSTRUCTOR **/
+/** **************/
+private:
+    /*!
+     * @brief   Construct a new Wifi Keepalive object
+     */
+    WifiKeepalive();
+
+/** *************/
+/** ATTRIBUTES **/
+/** *************/
+private:
+    Config config;  /*!< @brief active configuration*/
+    bool running; /*!< @brief scheduler started*/
+    bool linkUp; /*!< @brief station has an ip*/
+    int64_t associated; /*!< @brief time of the association, start of the wake grid*/
+    int64_t lastActivity; /*!< @brief time of the last transmission*/
+    ip4_addr_t gateway; /*!< @brief keepalive destination*/
+    Stats stats; /*!< @brief keepalive statistics*/
+    esp_timer_handle_t timer; /*!< @brief keepalive timer*/
+    portMUX_TYPE lock; /*!< @brief Spinlock for all attributes*/
+
+/** *****************/
+/** PUBLIC METHODS **/
+/** *****************/
+public:
+    /*!
+     * @brief   Starts the keepalive scheduler with the passed config
+     *
+     *          WifiClient has to be initialized first.
+     *
+     * @param   config Config object
+     * @throws  invalid_argument if marginPercent is not between 1 and 100
+     * @throws  runtime_error if starting failed.
+     */
+    void start(Config const& config);
+
+    /*!
+     * @brief   Stops the keepalive scheduler
+     */
+    void stop();
+
+    /*!
+     * @brief   Notifies a transmission, which resets the idle time
+     *
+     *          Method is cheap, it does not touch the timer.
+     */
+    void notifyActivity();
+
+    /*!
+     * @brief   Returns the keepalive statistics
+     *
+     * @return  Stats copy of the statistics
+     */
+    Stats getStats() const;
+};
+
+#endif /* WifiKeepalive_H_ */
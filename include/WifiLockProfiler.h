@@ -0,0 +1,158 @@
+/*!
+ * @file 	    WifiLockProfiler.h
+ * @brief 	    Singleton contention profiler for the mutexes of the component
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#ifndef WifiLockProfiler_H_
+#define WifiLockProfiler_H_
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+
+/*!
+ * @brief   Takes a component mutex, profiled with CONFIG_WIFICLIENT_LOCK_PROFILER
+ *
+ * @param   mutex SemaphoreHandle_t to take
+ * @param   wait ticks to wait
+ * @param   lock name of the WifiLockProfiler::Lock value
+ */
+#if CONFIG_WIFICLIENT_LOCK_PROFILER
+#define WIFICLIENT_TAKE(mutex, wait, lock) \
+    WifiLockProfiler::getInstance().take(mutex, wait, WifiLockProfiler::Lock::lock)
+#else
+#define WIFICLIENT_TAKE(mutex, wait, lock) xSemaphoreTake(mutex, wait)
+#endif
+
+/*!
+ * @class   WifiLockProfiler
+ * @brief   Singleton Class which records how often and how long the component mutexes block
+ *
+ *          With CONFIG_WIFICLIENT_LOCK_PROFILER every mutex take of the
+ *          component goes through take(). An uncontended take costs one
+ *          extra xSemaphoreTake with zero wait. A contended take measures
+ *          the wait and, if it exceeds the threshold, records the handle
+ *          of the task which held the mutex. The spinlocks of the component
+ *          only guard a few instructions and are not profiled.
+ */
+class WifiLockProfiler {
+
+/** ******************/
+/** PUBLIC TYPEDEFS **/
+/** ******************/
+public:
+    /*!
+     * @brief   Enum Class which stores the profiled mutexes
+     */
+    enum class Lock : uint8_t{
+        CLIENT_CONNECTED,   /*!< @brief WifiClient connectedMutex*/
+        DOWNLOADER,         /*!< @brief WifiDownloader mutex*/
+        ESPNOW_PEERS,       /*!< @brief WifiEspNow peerMutex*/
+        HISTORY,            /*!< @brief WifiHistory mutex*/
+        OUTBOX,             /*!< @brief WifiOutbox mutex*/
+        SCANNER_RESULTS,    /*!< @brief WifiScanner resultMutex*/
+        STAGE_GRAPH,        /*!< @brief WifiStageGraph mutex*/
+        TCP_TUNER,          /*!< @brief WifiTcpTuner mutex*/
+        TX_BATCH            /*!< @brief WifiTxBatch mutex*/
+    };
+
+    /*!
+     * @brief   Number of profiled mutexes
+     */
+    static const size_t LOCK_COUNT = 9;
+
+    /*!
+     * @brief   Struct which containes the statistics of one mutex
+     */
+    struct LockStats{
+        const char* name = "";          /*!< @brief name of the mutex*/
+        uint32_t takes = 0;             /*!< @brief successful takes*/
+        uint32_t contended = 0;         /*!< @brief takes which found the mutex taken, failed takes without wait included*/
+        uint32_t timeouts = 0;          /*!< @brief takes which gave up*/
+        uint64_t totalWaitUs = 0;       /*!< @brief sum of all waits*/
+        uint32_t maxWaitUs = 0;         /*!< @brief longest wait*/
+        uint32_t slowWaits = 0;         /*!< @brief waits above the threshold*/
+        uint32_t lastSlowWaitUs = 0;    /*!< @brief last wait above the threshold*/
+        TaskHandle_t lastHolder = NULL; /*!< @brief task which held the mutex during the last slow wait, may be deleted since, compare it with known handles*/
+    };
+
+/** ****************************/
+/** PRIVATE STATIC ATTRIBUTES **/
+/** ****************************/
+private:
+    static WifiLockProfiler Singleton; /*!< @brief Singleton Instance */
+
+/** ************************/
+/** PUBLIC STATIC METHODS **/
+/** ************************/
+public:
+    /*!
+     * @brief   Get the Singleton Instance
+     *
+     * @return  WifiLockProfiler& Singleton Instance
+     */
+    static WifiLockProfiler& getInstance();
+
+/** **************/
+/** CONSTRUCTOR **/
+/** **************/
+private:
+    /*!
+     * @brief   Construct a new Wifi Lock Profiler object
+     */
+    WifiLockProfiler();
+
+/** *************/
+/** ATTRIBUTES **/
+/** *************/
+private:
+    uint32_t thresholdUs; /*!< @brief waits above are slow and record the holder*/
+    LockStats stats[LOCK_COUNT]; /*!< @brief statistics per mutex*/
+    portMUX_TYPE lock; /*!< @brief Spinlock for the statistics*/
+
+/** *****************/
+/** PUBLIC METHODS **/
+/** *****************/
+public:
+    /*!
+     * @brief   Takes a mutex and records the wait
+     *
+     *          Use WIFICLIENT_TAKE, which falls back to xSemaphoreTake
+     *          without CONFIG_WIFICLIENT_LOCK_PROFILER.
+     *
+     * @param   mutex mutex to take
+     * @param   wait ticks to wait
+     * @param   id profiled mutex
+     * @return  BaseType_t result of xSemaphoreTake
+     */
+    BaseType_t take(SemaphoreHandle_t mutex, TickType_t wait, Lock id);
+
+    /*!
+     * @brief   Sets the wait from which the holding task is recorded
+     *
+     * @param   thresholdUs wait in us, default 1000
+     */
+    void setThreshold(uint32_t thresholdUs);
+
+    /*!
+     * @brief   Copies the statistics of all mutexes
+     *
+     * @param   snapshot buffer for the statistics, indexed by Lock
+     * @param   maxLocks size of snapshot
+     * @return  size_t number of copied entries
+     */
+    size_t snapshot(LockStats* snapshot, size_t maxLocks) const;
+
+    /*!
+     * @brief   Clears all statistics
+     */
+    void reset();
+};
+
+#endif /* WifiLockProfiler_H_ */
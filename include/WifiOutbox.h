@@ -0,0 +1,334 @@
+/*!
+ * @file 	    WifiOutbox.h
+ * @brief 	    Singleton store-and-forward outbox for messages produced while offline
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#ifndef WifiOutbox_H_
+#define WifiOutbox_H_
+
+#include <stdexcept>
+#include <string>
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_partition.h"
+
+/*!
+ * @brief   Event Handler for the station connection events
+ *
+ *          Starts the flush on the ip and stops it on a disconnect.
+ */
+extern "C" void WifiOutbox_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data);
+
+/*!
+ * @class   WifiOutbox
+ * @brief   Singleton Class which holds messages of several services until the station is online
+ *
+ *          Messages are copied into a pre-allocated pool with a priority
+ *          and an expiry. While the station has an ip, the flush task hands
+ *          them to the delivery callback of their channel, highest priority
+ *          first and rate limited by a token bucket, so a reconnect does not
+ *          saturate the link. If the pool is full, the least important
+ *          message is spilled into an optional data partition and comes
+ *          back into the pool when slots are free again. Spilled messages
+ *          do not survive a reboot.
+ */
+class WifiOutbox {
+
+/*!
+ * @brief   Event Handler as friend function
+ */
+friend void WifiOutbox_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data);
+
+/** ******************/
+/** PUBLIC TYPEDEFS **/
+/** ******************/
+public:
+    /*!
+     * @brief   Maximum number of channels
+     */
+    static const size_t MAX_CHANNELS = 4;
+
+    /*!
+     * @brief   Delivers a message, called from the flush task
+     *
+     * @param   context context passed to addChannel()
+     * @param   data payload
+     * @param   length payload length
+     * @return  false if the message could not be delivered, it is retried after Config::retryMs
+     */
+    typedef bool (*Deliver)(void* context, const void* data, size_t length);
+
+    /*!
+     * @brief   Enum Class which stores the result of post()
+     */
+    enum class Result{
+        QUEUED,     /*!< @brief message is in the RAM pool*/
+        SPILLED,    /*!< @brief message or a less important one was spilled to flash*/
+        DROPPED     /*!< @brief pool and spill are full, message was dropped*/
+    };
+
+    /*!
+     * @brief   Struct which containes the Configuration values
+     */
+    struct Config{
+        uint32_t flushRate = 20;    /*!< @brief delivered messages per second while online*/
+        uint32_t flushBurst = 4;    /*!< @brief messages delivered at once after an idle time*/
+        uint32_t retryMs = 1000;    /*!< @brief pause after a failed delivery*/
+        uint32_t highWater = CONFIG_WIFICLIENT_OUTBOX_SLOTS * 3 / 4;    /*!< @brief used slots from which isBackpressured() is true*/
+        const char* spillPartition = nullptr;   /*!< @brief label of the spill data partition (at least 2 sectors), nullptr disables spilling*/
+        UBaseType_t taskPriority = 4;   /*!< @brief priority of the flush task*/
+    };
+
+    /*!
+     * @brief   Struct which containes the outbox statistics
+     */
+    struct Stats{
+        uint32_t posted = 0;            /*!< @brief post() calls*/
+        uint32_t delivered = 0;         /*!< @brief delivered messages*/
+        uint32_t deliverFailures = 0;   /*!< @brief failed deliveries, retried*/
+        uint32_t spilled = 0;           /*!< @brief messages written to the spill partition*/
+        uint32_t restored = 0;          /*!< @brief messages read back from the spill partition*/
+        uint32_t droppedFull = 0;       /*!< @brief messages dropped, pool and spill were full*/
+        uint32_t droppedExpired = 0;    /*!< @brief messages dropped after their expiry*/
+        uint32_t spillErrors = 0;       /*!< @brief failed flash operations, the message was dropped*/
+        uint32_t backpressured = 0;     /*!< @brief post() calls above the high water mark*/
+        uint16_t queued = 0;            /*!< @brief messages in the pool*/
+        uint16_t maxQueued = 0;         /*!< @brief most messages in the pool*/
+        uint32_t spillQueued = 0;       /*!< @brief messages in the spill partition*/
+    };
+
+/** *******************/
+/** PRIVATE TYPEDEFS **/
+/** *******************/
+private:
+    /*!
+     * @brief   Enum Class which stores the state of a pooled message
+     */
+    enum class State : uint8_t{
+        FREE,       /*!< @brief unused*/
+        PENDING,    /*!< @brief waiting for delivery*/
+        SENDING     /*!< @brief taken by the flush task*/
+    };
+
+    /*!
+     * @brief   Struct which containes one message, also the record in the spill partition
+     */
+    struct Message{
+        State state;            /*!< @brief state of the slot*/
+        uint8_t channel;        /*!< @brief channel of the message*/
+        uint8_t priority;       /*!< @brief higher is delivered first*/
+        uint8_t reserved;       /*!< @brief padding*/
+        uint16_t length;        /*!< @brief payload length*/
+        uint32_t sequence;      /*!< @brief post order, older first within a priority*/
+        int64_t expiry;         /*!< @brief esp_timer time of expiry, INT64_MAX never expires*/
+        uint8_t data[CONFIG_WIFICLIENT_OUTBOX_PAYLOAD];     /*!< @brief payload*/
+    };
+
+    /*!
+     * @brief   Struct which containes a delivery channel
+     */
+    struct Channel{
+        Deliver deliver = nullptr;  /*!< @brief delivery callback, nullptr if unused*/
+        void* context = nullptr;    /*!< @brief context of the callback*/
+    };
+
+    /*!
+     * @brief   Struct which containes the position of the spill ring
+     */
+    struct Spill{
+        const esp_partition_t* partition = nullptr; /*!< @brief spill partition, nullptr if disabled*/
+        uint32_t slotsPerSector = 0;    /*!< @brief records per flash sector*/
+        uint32_t slots = 0;     /*!< @brief records in the partition*/
+        uint32_t read = 0;      /*!< @brief slot of the oldest record*/
+        uint32_t count = 0;     /*!< @brief stored records*/
+    };
+
+/** ****************************/
+/** PRIVATE STATIC ATTRIBUTES **/
+/** ****************************/
+private:
+    static WifiOutbox Singleton;   /*!< @brief Singleton Instance */
+    static const uint32_t TASK_STACK_SIZE = 3072;   /*!< @brief stack size of the flush task*/
+    static Message messagePool[CONFIG_WIFICLIENT_OUTBOX_SLOTS]; /*!< @brief pre-allocated messages*/
+    static StackType_t taskStack[TASK_STACK_SIZE];  /*!< @brief stack of the flush task*/
+
+/** ************************/
+/** PUBLIC STATIC METHODS **/
+/** ************************/
+public:
+    /*!
+     * @brief   Get the Singleton Instance
+     *
+     * @return  WifiOutbox& Singleton Instance
+     */
+    static WifiOutbox& getInstance();
+
+/** *************************/
+/** PRIVATE STATIC METHODS **/
+/** *************************/
+private:
+    /*!
+     * @brief   Flush task, delivers the pooled messages while online
+     *
+     * @param   arg unused
+     */
+    static void flushTask(void* arg);
+
+/** **************/
+/** CONSTRUCTOR **/
+/** **************/
+private:
+    /*!
+     * @brief   Construct a new Wifi Outbox object
+     */
+    WifiOutbox();
+
+/** *************/
+/** ATTRIBUTES **/
+/** *************/
+private:
+    bool initalized; /*!< @brief flush task is running*/
+    Config config; /*!< @brief active configuration*/
+    Channel channels[MAX_CHANNELS]; /*!< @brief delivery channels*/
+    Spill spill; /*!< @brief spill ring*/
+    Message scratch; /*!< @brief message being posted when the pool is full*/
+    bool linkUp; /*!< @brief station has an ip*/
+    uint32_t sequence; /*!< @brief sequence of the next message*/
+    uint32_t tokens; /*!< @brief token bucket of the flush rate*/
+    int64_t lastRefill; /*!< @brief time of the last token refill*/
+    Stats stats; /*!< @brief outbox statistics*/
+    TaskHandle_t task; /*!< @brief flush task*/
+    StaticTask_t taskBuffer; /*!< @brief control block of the flush task*/
+    SemaphoreHandle_t mutex; /*!< @brief Mutex for the pool, the spill ring and all attributes*/
+    StaticSemaphore_t mutexBuffer; /*!< @brief Storage of mutex*/
+
+/** *****************/
+/** PUBLIC METHODS **/
+/** *****************/
+public:
+    /*!
+     * @brief   Starts the flush task
+     *
+     *          WifiClient has to be initialized first.
+     *
+     * @param   config Config object
+     * @throws  invalid_argument if flushRate or flushBurst is 0
+     * @throws  runtime_error if the spill partition is missing or too small, or starting failed
+     */
+    void init(Config const& config);
+
+    /*!
+     * @brief   Adds a delivery channel, e.g. one per service or connection
+     *
+     * @param   deliver delivery callback
+     * @param   context passed to the callback
+     * @return  int channel for post()
+     * @throws  invalid_argument if deliver is nullptr
+     * @throws  runtime_error if no channel is left
+     */
+    int addChannel(Deliver deliver, void* context);
+
+    /*!
+     * @brief   Copies a message into the outbox
+     *
+     *          Method does not block on the network. If the pool is full,
+     *          the message with the lowest priority (newest first) is
+     *          spilled to flash, which blocks for the flash write.
+     *
+     * @param   channel channel of addChannel()
+     * @param   data payload
+     * @param   length payload length
+     * @param   priority higher is delivered first
+     * @param   ttlMs time after which the message is dropped, 0 never expires
+     * @return  Result where the message went
+     * @throws  invalid_argument if channel is invalid or length is 0 or above CONFIG_WIFICLIENT_OUTBOX_PAYLOAD
+     * @throws  runtime_error if not initialized
+     */
+    Result post(int channel, const void* data, size_t length, uint8_t priority = 0, uint32_t ttlMs = 0);
+
+    /*!
+     * @brief   Returns if producers should slow down
+     *
+     * @return  true if the used slots reached Config::highWater or messages are spilled
+     */
+    bool isBackpressured() const;
+
+    /*!
+     * @brief   Returns the outbox statistics
+     *
+     * @return  Stats copy of the statistics
+     */
+    Stats getStats() const;
+
+    /*!
+     * @brief   Returns the size of the message pool placed in PSRAM
+     *
+     *          Internal RAM saved by CONFIG_WIFICLIENT_PSRAM_POOLS.
+     *
+     * @return  size_t bytes in PSRAM, 0 if the pool is internal
+     */
+    size_t getExternalBytes() const;
+
+/** ******************/
+/** PRIVATE METHODS **/
+/** ******************/
+private:
+    /*!
+     * @brief   Drops expired messages from the pool
+     *
+     *          mutex has to be taken.
+     *
+     * @param   now esp_timer time
+     */
+    void dropExpired(int64_t now);
+
+    /*!
+     * @brief   Returns the pending message to deliver next
+     *
+     *          mutex has to be taken.
+     *
+     * @return  size_t index in the pool, CONFIG_WIFICLIENT_OUTBOX_SLOTS if none
+     */
+    size_t next() const;
+
+    /*!
+     * @brief   Returns the pending message to give up first
+     *
+     *          mutex has to be taken.
+     *
+     * @return  size_t index in the pool, CONFIG_WIFICLIENT_OUTBOX_SLOTS if none
+     */
+    size_t victim() const;
+
+    /*!
+     * @brief   Appends a message to the spill ring
+     *
+     *          mutex has to be taken.
+     *
+     * @param   message message to spill
+     * @return  false if the ring is full or disabled or the write failed
+     */
+    bool spillWrite(Message const& message);
+
+    /*!
+     * @brief   Moves spilled messages back into free pool slots
+     *
+     *          mutex has to be taken.
+     *
+     * @param   now esp_timer time
+     */
+    void restore(int64_t now);
+};
+
+#endif /* WifiOutbox_H_ */
@@ -0,0 +1,206 @@
+/*!
+ * @file 	    WifiScanner.h
+ * @brief 	    Singleton background scanner which scans one channel per slice
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#ifndef WifiScanner_H_
+#define WifiScanner_H_
+
+#include <stdexcept>
+#include <string>
+#include <cstring>
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_wifi.h"
+#include "esp_timer.h"
+
+/*!
+ * @brief   Event Handler for esp_wifi scan done events
+ *
+ *          Merges the records of a finished slice into the result cache
+ *          and schedules the next slice.
+ */
+extern "C" void WifiScanner_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data);
+
+/*!
+ * @class   WifiScanner
+ * @brief   Singleton Class for background scanning while connected
+ *
+ *          A full scan takes the radio off the home channel for the whole
+ *          scan. The scanner only scans one channel per slice with a short
+ *          dwell time, the radio returns to the home channel between
+ *          slices. Slices only run while the WifiClient is connected,
+ *          without memory pressure and no latency critical activity is
+ *          signaled. Over time the slices assemble a complete result
+ *          set for roaming and AP selection.
+ */
+class WifiScanner {
+
+/*!
+ * @brief   Event Handler as friend function
+ */
+friend void WifiScanner_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data);
+
+/** ******************/
+/** PUBLIC TYPEDEFS **/
+/** ******************/
+public:
+    /*!
+     * @brief   Struct which containes the Configuration values
+     */
+    struct Config{
+        uint16_t dwellMs = 30;              /*!< @brief off-channel time of a slice*/
+        uint32_t sliceIntervalMs = 2000;    /*!< @brief time on the home channel between slices*/
+        bool passive = false;               /*!< @brief passive instead of active scan*/
+        uint16_t channelMask = 0x3FFE;      /*!< @brief bit n set scans channel n, default 1-13*/
+        uint32_t resultMaxAgeMs = 120000;   /*!< @brief results not seen for this time are removed*/
+    };
+
+    /*!
+     * @brief   Struct which containes one scan result
+     */
+    struct Result{
+        uint8_t bssid[6];           /*!< @brief BSSID of the AP*/
+        char ssid[33];              /*!< @brief SSID of the AP*/
+        uint8_t channel;            /*!< @brief primary channel*/
+        int8_t rssi;                /*!< @brief RSSI of the last slice which saw the AP*/
+        wifi_auth_mode_t authmode;  /*!< @brief auth mode of the AP*/
+        int64_t lastSeen;           /*!< @brief esp_timer time of the last slice which saw the AP*/
+    };
+
+/** ****************************/
+/** PRIVATE STATIC ATTRIBUTES **/
+/** ****************************/
+private:
+    static WifiScanner Singleton;   /*!< @brief Singleton Instance */
+    static Result results[CONFIG_WIFICLIENT_SCAN_CACHE_SIZE];   /*!< @brief result cache*/
+    static const uint16_t RECORDS_PER_SLICE = 8;    /*!< @brief max records fetched per slice*/
+    static wifi_ap_record_t records[RECORDS_PER_SLICE]; /*!< @brief buffer for the records of one slice*/
+
+/** ************************/
+/** PUBLIC STATIC METHODS **/
+/** ************************/
+public:
+    /*!
+     * @brief   Get the Singleton Instance
+     *
+     * @return  WifiScanner& Singleton Instance
+     */
+    static WifiScanner& getInstance();
+
+/** *************************/
+/** PRIVATE STATIC METHODS **/
+/** *************************/
+private:
+    /*!
+     * @brief   Timer callback, starts the next slice
+     *
+     * @param   arg unused
+     */
+    static void sliceTimer(void* arg);
+
+    /*!
+     * @brief   Merges the records of the finished slice into the cache
+     *
+     * @param   success false if the slice was aborted
+     */
+    static void sliceDone(bool success);
+
+    /*!
+     * @brief   Arms the timer for the next slice
+     */
+    static void scheduleSlice();
+
+/** **************/
+/** CONSTRUCTOR **/
+/** **************/
+private:
+    /*!
+     * @brief   Construct a new Wifi Scanner object
+     */
+    WifiScanner();
+
+/** *************/
+/** ATTRIBUTES **/
+/** *************/
+private:
+    Config config;  /*!< @brief active configuration*/
+    bool running; /*!< @brief scanner started*/
+    bool latencyCritical; /*!< @brief application signaled latency critical activity*/
+    bool scanning; /*!< @brief slice in progress*/
+    uint8_t channel; /*!< @brief channel of the current or next slice*/
+    int64_t sliceStart; /*!< @brief begin of the current slice*/
+    bool complete; /*!< @brief all channels were scanned at least once*/
+    size_t resultCount; /*!< @brief used entries in results*/
+    SemaphoreHandle_t resultMutex; /*!< @brief Mutex for the result cache*/
+    StaticSemaphore_t resultMutexBuffer; /*!< @brief Storage of resultMutex*/
+    esp_timer_handle_t timer; /*!< @brief slice timer*/
+    portMUX_TYPE stateLock; /*!< @brief Spinlock for the state attributes*/
+
+/** *****************/
+/** PUBLIC METHODS **/
+/** *****************/
+public:
+    /*!
+     * @brief   Starts background scanning with the passed config
+     *
+     *          WifiClient has to be initialized first.
+     *
+     * @param   config Config object
+     * @throws  invalid_argument if no channel is selected
+     * @throws  runtime_error if starting failed.
+     */
+    void start(Config const& config);
+
+    /*!
+     * @brief   Stops background scanning, results are kept
+     */
+    void stop();
+
+    /*!
+     * @brief   Signals latency critical activity
+     *
+     *          While set no slice is started, a running slice is aborted.
+     *
+     * @param   critical true to pause scanning
+     */
+    void setLatencyCritical(bool critical);
+
+    /*!
+     * @brief   Copies the current results, strongest first
+     *
+     * @param   results buffer for the results
+     * @param   maxResults size of results
+     * @return  size_t number of copied results
+     */
+    size_t getResults(Result* results, size_t maxResults) const;
+
+    /*!
+     * @brief   Returns the size of the result cache placed in PSRAM
+     *
+     *          Internal RAM saved by CONFIG_WIFICLIENT_PSRAM_POOLS.
+     *
+     * @return  size_t bytes in PSRAM, 0 if the cache is internal
+     */
+    size_t getExternalBytes() const;
+
+    /*!
+     * @brief   Returns if all channels were scanned at least once
+     *
+     * @return  true if the result set is complete
+     * @return  false if channels are missing
+     */
+    bool isComplete() const;
+};
+
+#endif /* WifiScanner_H_ */
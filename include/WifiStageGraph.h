@@ -0,0 +1,223 @@
+/*!
+ * @file 	    WifiStageGraph.h
+ * @brief 	    Singleton graph of post-connect stages which run concurrently
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#ifndef WifiStageGraph_H_
+#define WifiStageGraph_H_
+
+#include <stdexcept>
+#include <string>
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+
+/*!
+ * @class   WifiStageGraph
+ * @brief   Singleton Class which runs post-connect stages on a worker pool
+ *
+ *          Stages (DNS prefetch, SNTP, MQTT connect, ...) are registered with
+ *          the stages they depend on. On every WifiClient CONNECTED event a
+ *          new run starts: each stage is handed to a worker as soon as all
+ *          its dependencies are done, independent stages run concurrently.
+ *          If a stage fails, its dependents are skipped. On DISCONNECTED the
+ *          run is cancelled, queued stages are not started and running
+ *          stages see isCancelled() return true.
+ */
+class WifiStageGraph {
+
+/** ******************/
+/** PUBLIC TYPEDEFS **/
+/** ******************/
+public:
+    /*!
+     * @brief   Stage function, runs in a worker task
+     *
+     *          Long running stages should poll isCancelled(run) and return
+     *          false if it returns true.
+     *
+     * @param   arg argument passed to addStage
+     * @param   run id of the run, pass to isCancelled
+     * @return  true if the stage succeeded
+     */
+    typedef bool (*StageFunction)(void* arg, uint32_t run);
+
+    /*!
+     * @brief   Enum Class which stores the state of a stage in the current run
+     */
+    enum class State{
+        IDLE,       /*!< @brief no run started yet*/
+        PENDING,    /*!< @brief waiting for dependencies*/
+        QUEUED,     /*!< @brief waiting for a worker*/
+        RUNNING,    /*!< @brief running in a worker*/
+        DONE,       /*!< @brief returned true*/
+        FAILED,     /*!< @brief returned false*/
+        SKIPPED,    /*!< @brief a dependency failed or was skipped*/
+        CANCELLED   /*!< @brief link dropped before the stage finished*/
+    };
+
+    /*!
+     * @brief   Struct which containes the timing of one stage in the current run
+     */
+    struct StageTiming{
+        const char* name = nullptr; /*!< @brief name passed to addStage*/
+        State state = State::IDLE;  /*!< @brief state in the current run*/
+        uint32_t queuedUs = 0;      /*!< @brief time from CONNECTED until the dependencies were done*/
+        uint32_t startUs = 0;       /*!< @brief time from CONNECTED until a worker started the stage*/
+        uint32_t durationUs = 0;    /*!< @brief run time of the stage function*/
+    };
+
+/** *******************/
+/** PRIVATE TYPEDEFS **/
+/** *******************/
+private:
+    /*!
+     * @brief   Struct which containes a registered stage
+     */
+    struct Stage{
+        const char* name;       /*!< @brief name for the timing report*/
+        StageFunction function; /*!< @brief stage function*/
+        void* arg;              /*!< @brief argument of function*/
+        uint32_t dependencies;  /*!< @brief bit n set depends on stage n*/
+        StageTiming timing;     /*!< @brief timing of the current run*/
+    };
+
+    /*!
+     * @brief   Struct which containes a job for the workers
+     */
+    struct Job{
+        uint8_t stage;  /*!< @brief stage id*/
+        uint32_t run;   /*!< @brief run the job belongs to*/
+    };
+
+/** ****************************/
+/** PRIVATE STATIC ATTRIBUTES **/
+/** ****************************/
+private:
+    static WifiStageGraph Singleton; /*!< @brief Singleton Instance */
+    static const uint32_t CONTROL_STACK_SIZE = 2560;    /*!< @brief stack size of the control task*/
+    static StackType_t controlStack[CONTROL_STACK_SIZE];    /*!< @brief stack of the control task*/
+    static StackType_t workerStacks[CONFIG_WIFICLIENT_STAGE_WORKERS][CONFIG_WIFICLIENT_STAGE_STACK_SIZE]; /*!< @brief stacks of the workers*/
+    static uint8_t jobStorage[CONFIG_WIFICLIENT_MAX_STAGES * sizeof(Job)]; /*!< @brief storage of jobs, every stage is queued once per run*/
+
+/** ************************/
+/** PUBLIC STATIC METHODS **/
+/** ************************/
+public:
+    /*!
+     * @brief   Get the Singleton Instance
+     *
+     * @return  WifiStageGraph& Singleton Instance
+     */
+    static WifiStageGraph& getInstance();
+
+/** *************************/
+/** PRIVATE STATIC METHODS **/
+/** *************************/
+private:
+    /*!
+     * @brief   Control task, starts and cancels runs on WifiClient events
+     *
+     * @param   arg unused
+     */
+    static void controlTask(void* arg);
+
+    /*!
+     * @brief   Worker task, runs queued stages
+     *
+     * @param   arg unused
+     */
+    static void workerTask(void* arg);
+
+/** **************/
+/** CONSTRUCTOR **/
+/** **************/
+private:
+    /*!
+     * @brief   Construct a new Wifi Stage Graph object
+     */
+    WifiStageGraph();
+
+/** *************/
+/** ATTRIBUTES **/
+/** *************/
+private:
+    bool started; /*!< @brief workers are running, no stages can be added*/
+    Stage stages[CONFIG_WIFICLIENT_MAX_STAGES]; /*!< @brief registered stages*/
+    size_t stageCount; /*!< @brief number of registered stages*/
+    uint32_t run; /*!< @brief id of the current run, 0 if none*/
+    bool cancelled; /*!< @brief current run was cancelled*/
+    int64_t runStart; /*!< @brief time of the CONNECTED event of the current run*/
+    QueueHandle_t eventQueue; /*!< @brief WifiClient event receiver*/
+    QueueHandle_t jobs; /*!< @brief stages ready for a worker*/
+    StaticQueue_t jobsBuffer; /*!< @brief control block of jobs*/
+    SemaphoreHandle_t mutex; /*!< @brief Mutex for stages and run state*/
+    StaticSemaphore_t mutexBuffer; /*!< @brief Storage of mutex*/
+    StaticTask_t controlTaskBuffer; /*!< @brief control block of the control task*/
+    StaticTask_t workerTaskBuffers[CONFIG_WIFICLIENT_STAGE_WORKERS]; /*!< @brief control blocks of the workers*/
+
+/** *****************/
+/** PUBLIC METHODS **/
+/** *****************/
+public:
+    /*!
+     * @brief   Registers a stage
+     *
+     *          All stages have to be added before start().
+     *
+     * @param   name for the timing report, must stay valid
+     * @param   function stage function
+     * @param   arg argument of function
+     * @param   dependencies bit n set depends on the stage with id n
+     * @return  uint8_t id of the stage
+     * @throws  invalid_argument if a dependency is not registered yet
+     * @throws  runtime_error if started or too many stages
+     */
+    uint8_t addStage(const char* name, StageFunction function, void* arg = nullptr, uint32_t dependencies = 0);
+
+    /*!
+     * @brief   Starts the workers and subscribes to WifiClient events
+     *
+     * @param   taskPriority priority of control and worker tasks
+     * @throws  runtime_error if starting failed
+     */
+    void start(UBaseType_t taskPriority = 5);
+
+    /*!
+     * @brief   Returns if a run was cancelled or replaced by a newer run
+     *
+     * @param   run id passed to the stage function
+     * @return  true if the stage should stop, always true before start()
+     */
+    bool isCancelled(uint32_t run) const;
+
+    /*!
+     * @brief   Copies the timing of all stages in the current run
+     *
+     * @param   timings buffer for the timings, index is the stage id
+     * @param   maxTimings size of timings
+     * @return  size_t number of copied timings
+     */
+    size_t getTimings(StageTiming* timings, size_t maxTimings) const;
+
+/** ******************/
+/** PRIVATE METHODS **/
+/** ******************/
+private:
+    /*!
+     * @brief   Skips stages with failed dependencies and queues ready stages
+     *
+     *          mutex has to be taken.
+     */
+    void dispatchReady();
+};
+
+#endif /* WifiStageGraph_H_ */
@@ -0,0 +1,227 @@
+/*!
+ * @file 	    WifiTcpTuner.h
+ * @brief 	    Singleton TCP socket tuning driven by the WifiClient link quality
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#ifndef WifiTcpTuner_H_
+#define WifiTcpTuner_H_
+
+#include <stdexcept>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+
+/*!
+ * @class   WifiTcpTuner
+ * @brief   Singleton Class which adapts the options of registered TCP sockets to the link
+ *
+ *          Every WifiClient link quality (GOOD, FAIR, POOR) has a Profile
+ *          of socket options. On a LINK_QUALITY_CHANGED event the profile
+ *          of the new level is applied to all registered sockets, sockets
+ *          get the current profile on registration. lwIP has no per
+ *          socket send buffer or retransmission timeout, the profiles
+ *          cover what lwIP offers per socket: Nagle, keepalive probing
+ *          and the send timeout. A socket is only tuned in the options
+ *          it was registered for, all other options keep the value the
+ *          application set.
+ *
+ *          The link quality is only sampled if WifiClient runs with
+ *          Config::linkCheckMs above 0, otherwise it stays GOOD.
+ */
+class WifiTcpTuner {
+
+/** ******************/
+/** PUBLIC TYPEDEFS **/
+/** ******************/
+public:
+    /*!
+     * @brief   Maximum number of registered sockets
+     */
+    static const size_t MAX_SOCKETS = 8;
+
+    /*!
+     * @brief   Option bits, combined per socket in add()
+     */
+    static const uint8_t NO_DELAY = 0x01;       /*!< @brief TCP_NODELAY*/
+    static const uint8_t KEEPALIVE = 0x02;      /*!< @brief SO_KEEPALIVE, TCP_KEEPIDLE, TCP_KEEPINTVL, TCP_KEEPCNT*/
+    static const uint8_t SEND_TIMEOUT = 0x04;   /*!< @brief SO_SNDTIMEO*/
+    static const uint8_t ALL_OPTIONS = NO_DELAY | KEEPALIVE | SEND_TIMEOUT; /*!< @brief all tunable options*/
+
+    /*!
+     * @brief   Struct which containes the socket options of one link quality
+     *
+     *          A 0 leaves the value of the application. Sockets registered
+     *          for KEEPALIVE get SO_KEEPALIVE enabled.
+     */
+    struct Profile{
+        bool noDelay;               /*!< @brief TCP_NODELAY, disables Nagle*/
+        uint16_t keepIdleS;         /*!< @brief TCP_KEEPIDLE, idle time before the first probe*/
+        uint16_t keepIntervalS;     /*!< @brief TCP_KEEPINTVL, time between probes*/
+        uint8_t keepCount;          /*!< @brief TCP_KEEPCNT, lost probes before the connection is dropped*/
+        uint32_t sendTimeoutMs;     /*!< @brief SO_SNDTIMEO, longest blocking send*/
+    };
+
+    /*!
+     * @brief   Struct which containes the Configuration values
+     *
+     *          On a good link small writes go out at once and dead peers
+     *          are found fast. On a poor link Nagle coalesces writes into
+     *          fewer frames, probes are more patient and sends may block
+     *          longer while lwIP retransmits.
+     */
+    struct Config{
+        Profile good = {true, 30, 5, 3, 5000};      /*!< @brief profile for LinkQuality::GOOD*/
+        Profile fair = {true, 45, 10, 4, 10000};    /*!< @brief profile for LinkQuality::FAIR*/
+        Profile poor = {false, 60, 20, 6, 20000};   /*!< @brief profile for LinkQuality::POOR*/
+        UBaseType_t taskPriority = 3;   /*!< @brief priority of the tuning task*/
+    };
+
+    /*!
+     * @brief   Struct which containes the tuning statistics
+     */
+    struct Stats{
+        uint32_t changes = 0;       /*!< @brief applied link quality changes*/
+        uint32_t applied = 0;       /*!< @brief profiles applied to a socket*/
+        uint32_t optionErrors = 0;  /*!< @brief rejected socket options*/
+        int lastQuality = 0;        /*!< @brief last applied WifiClient::LinkQuality*/
+    };
+
+/** *******************/
+/** PRIVATE TYPEDEFS **/
+/** *******************/
+private:
+    /*!
+     * @brief   Struct which containes a registered socket
+     */
+    struct Socket{
+        int socket = -1;        /*!< @brief socket, -1 if unused*/
+        uint8_t options = 0;    /*!< @brief option bits the socket is tuned in*/
+    };
+
+/** ****************************/
+/** PRIVATE STATIC ATTRIBUTES **/
+/** ****************************/
+private:
+    static WifiTcpTuner Singleton; /*!< @brief Singleton Instance */
+    static const uint32_t TASK_STACK_SIZE = 2560; /*!< @brief stack size of the tuning task*/
+    static StackType_t taskStack[TASK_STACK_SIZE]; /*!< @brief stack of the tuning task*/
+
+/** ************************/
+/** PUBLIC STATIC METHODS **/
+/** ************************/
+public:
+    /*!
+     * @brief   Get the Singleton Instance
+     *
+     * @return  WifiTcpTuner& Singleton Instance
+     */
+    static WifiTcpTuner& getInstance();
+
+/** *************************/
+/** PRIVATE STATIC METHODS **/
+/** *************************/
+private:
+    /*!
+     * @brief   Tuning task, applies the profile on link quality changes
+     *
+     * @param   arg unused
+     */
+    static void tuneTask(void* arg);
+
+/** **************/
+/** CONSTRUCTOR **/
+/** **************/
+private:
+    /*!
+     * @brief   Construct a new Wifi Tcp Tuner object
+     */
+    WifiTcpTuner();
+
+/** *************/
+/** ATTRIBUTES **/
+/** *************/
+private:
+    bool initalized; /*!< @brief tuning task is running*/
+    Config config; /*!< @brief active configuration*/
+    Socket sockets[MAX_SOCKETS]; /*!< @brief registered sockets*/
+    Stats stats; /*!< @brief tuning statistics*/
+    QueueHandle_t eventQueue; /*!< @brief WifiClient event receiver*/
+    TaskHandle_t task; /*!< @brief tuning task*/
+    StaticTask_t taskBuffer; /*!< @brief control block of the tuning task*/
+    SemaphoreHandle_t mutex; /*!< @brief Mutex for sockets and statistics*/
+    StaticSemaphore_t mutexBuffer; /*!< @brief Storage of mutex*/
+
+/** *****************/
+/** PUBLIC METHODS **/
+/** *****************/
+public:
+    /*!
+     * @brief   Registers the WifiClient event receiver and starts the tuning task
+     *
+     *          WifiClient has to be initialized with linkCheckMs above 0,
+     *          it is 0 by default and the profiles would never change.
+     *
+     * @param   config Config object
+     * @throws  runtime_error if starting failed
+     */
+    void init(Config const& config);
+
+    /*!
+     * @brief   Registers a connected TCP socket and applies the current profile
+     *
+     *          Only the options in options are set, now and on every
+     *          link quality change. Registering a socket again replaces
+     *          its options.
+     *
+     * @param   socket lwIP TCP socket
+     * @param   options option bits to tune, e.g. NO_DELAY | KEEPALIVE
+     * @throws  invalid_argument if options is 0 or has unknown bits
+     * @throws  runtime_error if not initialized or no socket slot is left
+     */
+    void add(int socket, uint8_t options);
+
+    /*!
+     * @brief   Unregisters a socket, call before closing it
+     *
+     * @param   socket lwIP TCP socket
+     */
+    void remove(int socket);
+
+    /*!
+     * @brief   Returns the tuning statistics
+     *
+     * @return  Stats copy of the statistics
+     */
+    Stats getStats() const;
+
+/** ******************/
+/** PRIVATE METHODS **/
+/** ******************/
+private:
+    /*!
+     * @brief   Returns the profile of the current link quality
+     *
+     * @return  Profile const& profile
+     */
+    Profile const& currentProfile() const;
+
+    /*!
+     * @brief   Sets the options of a profile on a socket
+     *
+     *          mutex has to be taken.
+     *
+     * @param   socket registered socket
+     * @param   profile options to set
+     */
+    void apply(Socket const& socket, Profile const& profile);
+};
+
+#endif /* WifiTcpTuner_H_ */
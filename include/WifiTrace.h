@@ -0,0 +1,250 @@
+/*!
+ * @file 	    WifiTrace.h
+ * @brief 	    Singleton span recorder with Chrome trace event export
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#ifndef WifiTrace_H_
+#define WifiTrace_H_
+
+#include <stdexcept>
+#include <string>
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+
+/*!
+ * @class   WifiTrace
+ * @brief   Singleton Class which records timestamped spans in a ring buffer
+ *
+ *          With CONFIG_WIFICLIENT_TRACE the component records its phases
+ *          (driver start, scan slices, association, DHCP), the execution
+ *          of the event handler and the delivery to every event receiver.
+ *          User code adds own spans on own tracks to the same buffer.
+ *          The buffer is exported as Chrome trace event JSON (opens in
+ *          chrome://tracing and Perfetto) or dumped in binary form, which
+ *          tools/wifitrace2json.py converts on the host.
+ *
+ *          Names are copied into the span, the oldest spans are
+ *          overwritten when the buffer is full.
+ */
+class WifiTrace {
+
+/** ******************/
+/** PUBLIC TYPEDEFS **/
+/** ******************/
+public:
+    /*!
+     * @brief   Maximum name length incl. terminating zero
+     */
+    static const size_t NAME_LENGTH = 24;
+
+    /*!
+     * @brief   Enum Class which stores the tracks (threads in the trace viewer)
+     *
+     *          User tracks start at USER, any value up to 0xFFFF can be used.
+     */
+    enum class Track : uint16_t{
+        CONNECTION = 1, /*!< @brief driver start, scan, association, DHCP*/
+        HANDLER = 2,    /*!< @brief WifiClient event handler*/
+        DELIVERY = 3,   /*!< @brief event delivery to the receivers*/
+        USER = 16       /*!< @brief first user track*/
+    };
+
+    /*!
+     * @brief   Writer for the export, called with consecutive pieces
+     *
+     * @param   context passed to the export method
+     * @param   data piece of the export
+     * @param   length length of data
+     */
+    typedef void (*Writer)(void* context, const char* data, size_t length);
+
+    /*!
+     * @brief   Struct which containes one span, also the binary dump format
+     */
+    struct Span{
+        int64_t startUs;        /*!< @brief esp_timer time of the begin*/
+        uint32_t durationUs;    /*!< @brief duration, OPEN if not ended, 0 for instants*/
+        uint32_t id;            /*!< @brief sequence number of the span*/
+        uint32_t arg;           /*!< @brief argument, shown as args.arg*/
+        uint16_t track;         /*!< @brief Track or user track*/
+        uint8_t instant;        /*!< @brief 1 for an instant event*/
+        uint8_t reserved;       /*!< @brief padding*/
+        char name[NAME_LENGTH]; /*!< @brief zero terminated name*/
+    };
+
+    /*!
+     * @brief   Duration of a span which was not ended yet
+     */
+    static const uint32_t OPEN = UINT32_MAX;
+
+    /*!
+     * @brief   Magic of the binary dump header ("WTRC")
+     */
+    static const uint32_t DUMP_MAGIC = 0x43525457;
+
+    /*!
+     * @brief   Struct which containes the header of the binary dump
+     */
+    struct DumpHeader{
+        uint32_t magic;     /*!< @brief DUMP_MAGIC*/
+        uint16_t version;   /*!< @brief format version, 1*/
+        uint16_t spanSize;  /*!< @brief sizeof(Span)*/
+        uint32_t count;     /*!< @brief number of spans following the header*/
+        uint32_t dropped;   /*!< @brief overwritten spans*/
+    };
+
+/** ****************************/
+/** PRIVATE STATIC ATTRIBUTES **/
+/** ****************************/
+private:
+    static WifiTrace Singleton; /*!< @brief Singleton Instance */
+    static Span spans[CONFIG_WIFICLIENT_TRACE_SPANS]; /*!< @brief ring buffer of spans*/
+
+/** ************************/
+/** PUBLIC STATIC METHODS **/
+/** ************************/
+public:
+    /*!
+     * @brief   Get the Singleton Instance
+     *
+     * @return  WifiTrace& Singleton Instance
+     */
+    static WifiTrace& getInstance();
+
+/** **************/
+/** CONSTRUCTOR **/
+/** **************/
+private:
+    /*!
+     * @brief   Construct a new Wifi Trace object
+     */
+    WifiTrace();
+
+/** *************/
+/** ATTRIBUTES **/
+/** *************/
+private:
+    bool enabled; /*!< @brief spans are recorded*/
+    uint32_t nextId; /*!< @brief id of the next span, slot is id % CONFIG_WIFICLIENT_TRACE_SPANS*/
+    portMUX_TYPE lock; /*!< @brief Spinlock for the ring buffer*/
+
+/** *****************/
+/** PUBLIC METHODS **/
+/** *****************/
+public:
+    /*!
+     * @brief   Enables or disables recording, enabled by default
+     *
+     * @param   enabled true records spans
+     */
+    void setEnabled(bool enabled);
+
+    /*!
+     * @brief   Begins a span
+     *
+     * @param   name name of the span, truncated to NAME_LENGTH - 1
+     * @param   track Track or user track
+     * @param   arg argument of the span
+     * @return  uint32_t id for end(), 0 if not recorded
+     */
+    uint32_t begin(const char* name, uint16_t track, uint32_t arg = 0);
+
+    /*!
+     * @brief   Ends a span, ignored if it was overwritten already
+     *
+     * @param   id returned by begin()
+     */
+    void end(uint32_t id);
+
+    /*!
+     * @brief   Adds a finished span
+     *
+     * @param   name name of the span
+     * @param   track Track or user track
+     * @param   startUs esp_timer time of the begin
+     * @param   durationUs duration
+     * @param   arg argument of the span
+     */
+    void add(const char* name, uint16_t track, int64_t startUs, uint32_t durationUs, uint32_t arg = 0);
+
+    /*!
+     * @brief   Adds an instant event
+     *
+     * @param   name name of the event
+     * @param   track Track or user track
+     * @param   arg argument of the event
+     */
+    void instant(const char* name, uint16_t track, uint32_t arg = 0);
+
+    /*!
+     * @brief   Removes all spans
+     */
+    void clear();
+
+    /*!
+     * @brief   Writes all spans as Chrome trace event JSON
+     *
+     *          Spans are copied in small pieces, recording continues
+     *          during the export.
+     *
+     * @param   writer called with consecutive pieces of the JSON
+     * @param   context passed to writer
+     * @return  size_t number of exported spans
+     */
+    size_t exportJson(Writer writer, void* context) const;
+
+    /*!
+     * @brief   Writes a DumpHeader followed by all spans, oldest first
+     *
+     * @param   writer called with header and spans
+     * @param   context passed to writer
+     * @return  size_t number of dumped spans
+     */
+    size_t dump(Writer writer, void* context) const;
+
+    /*!
+     * @brief   Returns the size of the span ring placed in PSRAM
+     *
+     *          Internal RAM saved by CONFIG_WIFICLIENT_PSRAM_POOLS.
+     *
+     * @return  size_t bytes in PSRAM, 0 if the ring is internal
+     */
+    size_t getExternalBytes() const;
+
+/** ******************/
+/** PRIVATE METHODS **/
+/** ******************/
+private:
+    /*!
+     * @brief   Stores a span in the next slot
+     *
+     * @return  uint32_t id of the span, 0 if disabled
+     */
+    uint32_t record(const char* name, uint16_t track, int64_t startUs, uint32_t durationUs, uint32_t arg, bool instant);
+
+    /*!
+     * @brief   Copies the span with the passed id
+     *
+     * @param   id of the span
+     * @param   span returns the copy
+     * @return  false if the span was overwritten
+     */
+    bool copy(uint32_t id, Span& span) const;
+
+    /*!
+     * @brief   Returns the id of the oldest span and the end of the ids
+     *
+     * @param   first returns the id of the oldest span
+     * @param   dropped returns the number of overwritten spans, can be NULL
+     * @return  uint32_t id of the next span
+     */
+    uint32_t range(uint32_t& first, uint32_t* dropped) const;
+};
+
+#endif /* WifiTrace_H_ */
@@ -0,0 +1,214 @@
+/*!
+ * @file 	    WifiTraffic.h
+ * @brief 	    Singleton traffic classes with DSCP/WMM tagging
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#ifndef WifiTraffic_H_
+#define WifiTraffic_H_
+
+#include <stdexcept>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "lwip/sockets.h"
+
+/*!
+ * @class   WifiTraffic
+ * @brief   Singleton Class which maps application traffic classes to WMM access categories
+ *
+ *          With WMM the driver queues a frame by the 802.11 user priority,
+ *          which is the IP precedence (upper 3 bits of the DSCP). Every
+ *          traffic class has a DSCP, sockets get it as IP_TOS and WifiUdp
+ *          endpoints as TOS of their pcb. The defaults map CONTROL to
+ *          AC_VO, TELEMETRY to AC_VI, BEST_EFFORT to AC_BE and BULK to
+ *          AC_BK. Sends through send()/sendTo() and WifiUdp are counted per
+ *          class. Access points without WMM queue everything as best effort.
+ */
+class WifiTraffic {
+
+/*!
+ * @brief   WifiUdp counts its sends per class
+ */
+friend class WifiUdp;
+
+/** ******************/
+/** PUBLIC TYPEDEFS **/
+/** ******************/
+public:
+    /*!
+     * @brief   Enum Class which stores the traffic classes
+     */
+    enum class TrafficClass : uint8_t{
+        CONTROL,        /*!< @brief small latency critical messages, AC_VO*/
+        TELEMETRY,      /*!< @brief periodic measurements, AC_VI*/
+        BEST_EFFORT,    /*!< @brief untagged traffic, AC_BE*/
+        BULK            /*!< @brief uploads and downloads, AC_BK*/
+    };
+
+    /*!
+     * @brief   Number of traffic classes
+     */
+    static const size_t CLASS_COUNT = 4;
+
+    /*!
+     * @brief   Maximum number of registered sockets
+     */
+    static const size_t MAX_SOCKETS = 16;
+
+    /*!
+     * @brief   Struct which containes the Configuration values
+     */
+    struct Config{
+        uint8_t dscp[CLASS_COUNT] = {48, 32, 0, 8};    /*!< @brief DSCP per class: CS6 (AC_VO), CS4 (AC_VI), default (AC_BE), CS1 (AC_BK)*/
+    };
+
+    /*!
+     * @brief   Struct which containes the transmit statistics of one class
+     */
+    struct ClassStats{
+        uint32_t packets = 0;   /*!< @brief sent packets*/
+        uint64_t bytes = 0;     /*!< @brief sent payload bytes*/
+        uint32_t errors = 0;    /*!< @brief failed sends*/
+    };
+
+/** *******************/
+/** PRIVATE TYPEDEFS **/
+/** *******************/
+private:
+    /*!
+     * @brief   Struct which containes a registered socket
+     */
+    struct Socket{
+        int socket = -1;    /*!< @brief socket, -1 if unused*/
+        TrafficClass trafficClass = TrafficClass::BEST_EFFORT; /*!< @brief class of the socket*/
+    };
+
+/** ****************************/
+/** PRIVATE STATIC ATTRIBUTES **/
+/** ****************************/
+private:
+    static WifiTraffic Singleton; /*!< @brief Singleton Instance */
+
+/** ************************/
+/** PUBLIC STATIC METHODS **/
+/** ************************/
+public:
+    /*!
+     * @brief   Get the Singleton Instance
+     *
+     * @return  WifiTraffic& Singleton Instance
+     */
+    static WifiTraffic& getInstance();
+
+/** **************/
+/** CONSTRUCTOR **/
+/** **************/
+private:
+    /*!
+     * @brief   Construct a new Wifi Traffic object
+     */
+    WifiTraffic();
+
+/** *************/
+/** ATTRIBUTES **/
+/** *************/
+private:
+    Config config; /*!< @brief active configuration*/
+    Socket sockets[MAX_SOCKETS]; /*!< @brief registered sockets*/
+    ClassStats stats[CLASS_COUNT]; /*!< @brief transmit statistics per class*/
+    portMUX_TYPE lock; /*!< @brief Spinlock for sockets and statistics*/
+
+/** *****************/
+/** PUBLIC METHODS **/
+/** *****************/
+public:
+    /*!
+     * @brief   Sets the DSCP of the classes, already tagged sockets keep their TOS
+     *
+     * @param   config Config object
+     * @throws  invalid_argument if a DSCP is above 63
+     */
+    void init(Config const& config);
+
+    /*!
+     * @brief   Returns the IP TOS byte of a class
+     *
+     * @param   trafficClass class
+     * @return  uint8_t DSCP shifted into the TOS byte
+     */
+    uint8_t getTos(TrafficClass trafficClass) const;
+
+    /*!
+     * @brief   Tags an IPv4 socket with a class and registers it for the statistics
+     *
+     *          The slot is claimed before IP_TOS is set and given back if
+     *          that fails.
+     *
+     * @param   socket lwIP socket
+     * @param   trafficClass class
+     * @throws  runtime_error if IP_TOS could not be set or no socket slot is left
+     */
+    void setClass(int socket, TrafficClass trafficClass);
+
+    /*!
+     * @brief   Unregisters a socket, call before closing it
+     *
+     * @param   socket lwIP socket
+     */
+    void forget(int socket);
+
+    /*!
+     * @brief   send() which counts for the class of the socket
+     *
+     *          Unregistered sockets are counted as BEST_EFFORT.
+     *
+     * @return  int result of send
+     */
+    int send(int socket, const void* data, size_t length, int flags = 0);
+
+    /*!
+     * @brief   sendto() which counts for the class of the socket
+     *
+     *          Unregistered sockets are counted as BEST_EFFORT.
+     *
+     * @return  int result of sendto
+     */
+    int sendTo(int socket, const void* data, size_t length, int flags,
+        const struct sockaddr* address, socklen_t addressLength);
+
+    /*!
+     * @brief   Returns the transmit statistics of a class
+     *
+     * @param   trafficClass class
+     * @return  ClassStats copy of the statistics
+     */
+    ClassStats getStats(TrafficClass trafficClass) const;
+
+/** ******************/
+/** PRIVATE METHODS **/
+/** ******************/
+private:
+    /*!
+     * @brief   Returns the class of a registered socket
+     *
+     * @param   socket lwIP socket
+     * @return  TrafficClass class, BEST_EFFORT if not registered
+     */
+    TrafficClass classOf(int socket) const;
+
+    /*!
+     * @brief   Counts a send
+     *
+     * @param   trafficClass class of the send
+     * @param   length payload length
+     * @param   success false counts an error
+     */
+    void record(TrafficClass trafficClass, size_t length, bool success);
+};
+
+#endif /* WifiTraffic_H_ */
@@ -0,0 +1,222 @@
+/*!
+ * @file 	    WifiTxBatch.h
+ * @brief 	    Singleton transmit batching aligned to the station wake windows
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#ifndef WifiTxBatch_H_
+#define WifiTxBatch_H_
+
+#include <stdexcept>
+#include <string>
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+#include "esp_event.h"
+#include "lwip/ip4_addr.h"
+
+#include "WifiTraffic.h"
+
+/*!
+ * @brief   Event Handler for the station connection events
+ *
+ *          Anchors the wake grid at the association and holds
+ *          batches back while the station has no ip.
+ */
+extern "C" void WifiTxBatch_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data);
+
+/*!
+ * @class   WifiTxBatch
+ * @brief   Singleton Class which batches small UDP sends into shared wake windows
+ *
+ *          In modem sleep every single send wakes the radio. Payloads of
+ *          several producers are copied into a pre-allocated pool and held
+ *          until the wake window before the earliest deadline, then all
+ *          pooled messages are sent together. Wake windows are a grid of
+ *          Config::wakeIntervalMs (DTIM/listen interval) starting at the
+ *          association, so the flush falls into a window where the radio
+ *          is awake anyway.
+ */
+class WifiTxBatch {
+
+/*!
+ * @brief   Event Handler as friend function
+ */
+friend void WifiTxBatch_event_handler(void* arg, esp_event_base_t event_base,
+    int32_t event_id, void* event_data);
+
+/** ******************/
+/** PUBLIC TYPEDEFS **/
+/** ******************/
+public:
+    /*!
+     * @brief   Struct which containes the Configuration values
+     */
+    struct Config{
+        uint32_t wakeIntervalMs = 307;  /*!< @brief wake interval of the station (beacon interval * DTIM/listen interval), 0 disables alignment*/
+        UBaseType_t taskPriority = 5;   /*!< @brief priority of the flush task*/
+        WifiTraffic::TrafficClass trafficClass = WifiTraffic::TrafficClass::BEST_EFFORT;   /*!< @brief class of the batched messages*/
+    };
+
+    /*!
+     * @brief   Struct which containes the batching statistics
+     */
+    struct Stats{
+        uint32_t messages = 0;      /*!< @brief sent messages*/
+        uint32_t flushes = 0;       /*!< @brief flushes, each one radio wakeup*/
+        uint32_t wakeupsSaved = 0;  /*!< @brief messages which shared the wakeup of another one*/
+        uint32_t poolExhausted = 0; /*!< @brief send() calls rejected, pool was full*/
+        uint32_t sendErrors = 0;    /*!< @brief messages lwIP did not accept*/
+        uint32_t maxAddedLatencyUs = 0;     /*!< @brief max time from send() to transmission*/
+        uint64_t totalAddedLatencyUs = 0;   /*!< @brief sum of all times from send() to transmission*/
+    };
+
+/** *******************/
+/** PRIVATE TYPEDEFS **/
+/** *******************/
+private:
+    /*!
+     * @brief   Enum Class which stores the state of a pooled message
+     */
+    enum class State{
+        FREE,       /*!< @brief unused*/
+        PENDING,    /*!< @brief waiting for its wake window*/
+        SENDING     /*!< @brief taken by the flush task*/
+    };
+
+    /*!
+     * @brief   Struct which containes one pooled message
+     */
+    struct Message{
+        State state;            /*!< @brief state of the slot*/
+        ip4_addr_t address;     /*!< @brief destination address*/
+        uint16_t port;          /*!< @brief destination port*/
+        uint16_t length;        /*!< @brief payload length*/
+        int64_t enqueued;       /*!< @brief time of send()*/
+        int64_t deadline;       /*!< @brief latest transmission time*/
+        uint8_t data[CONFIG_WIFICLIENT_TXBATCH_PAYLOAD];    /*!< @brief payload*/
+    };
+
+/** ****************************/
+/** PRIVATE STATIC ATTRIBUTES **/
+/** ****************************/
+private:
+    static WifiTxBatch Singleton;   /*!< @brief Singleton Instance */
+    static const uint32_t TASK_STACK_SIZE = 3072;   /*!< @brief stack size of the flush task*/
+    static Message messagePool[CONFIG_WIFICLIENT_TXBATCH_POOL]; /*!< @brief pre-allocated messages*/
+    static StackType_t taskStack[TASK_STACK_SIZE];  /*!< @brief stack of the flush task*/
+
+/** ************************/
+/** PUBLIC STATIC METHODS **/
+/** ************************/
+public:
+    /*!
+     * @brief   Get the Singleton Instance
+     *
+     * @return  WifiTxBatch& Singleton Instance
+     */
+    static WifiTxBatch& getInstance();
+
+/** *************************/
+/** PRIVATE STATIC METHODS **/
+/** *************************/
+private:
+    /*!
+     * @brief   Flush task, sends all pooled messages in the due wake window
+     *
+     * @param   arg unused
+     */
+    static void flushTask(void* arg);
+
+/** **************/
+/** CONSTRUCTOR **/
+/** **************/
+private:
+    /*!
+     * @brief   Construct a new Wifi Tx Batch object
+     */
+    WifiTxBatch();
+
+/** *************/
+/** ATTRIBUTES **/
+/** *************/
+private:
+    bool initalized; /*!< @brief flush task is running*/
+    Config config; /*!< @brief active configuration*/
+    int udpSocket; /*!< @brief UDP socket for all messages*/
+    bool linkUp; /*!< @brief station has an ip*/
+    bool flushRequested; /*!< @brief flush() was called or the pool is full*/
+    int64_t associated; /*!< @brief time of the association, start of the wake grid*/
+    Stats stats; /*!< @brief batching statistics*/
+    TaskHandle_t task; /*!< @brief flush task*/
+    StaticTask_t taskBuffer; /*!< @brief control block of the flush task*/
+    SemaphoreHandle_t mutex; /*!< @brief Mutex for the pool and all attributes*/
+    StaticSemaphore_t mutexBuffer; /*!< @brief Storage of mutex*/
+
+/** *****************/
+/** PUBLIC METHODS **/
+/** *****************/
+public:
+    /*!
+     * @brief   Creates the socket and starts the flush task
+     *
+     *          WifiClient has to be initialized first.
+     *
+     * @param   config Config object
+     * @throws  runtime_error if starting failed
+     */
+    void init(Config const& config);
+
+    /*!
+     * @brief   Queues a UDP datagram for the next wake window
+     *
+     *          The payload is copied into the pool, method does not
+     *          block. The message is sent in the last wake window before
+     *          its deadline, together with all other pooled messages.
+     *          While the station has no ip, messages are held back.
+     *
+     * @param   address destination address
+     * @param   port destination port
+     * @param   data payload
+     * @param   length payload length
+     * @param   maxDelayMs longest time the message may be held
+     * @return  false if the message pool is exhausted
+     * @throws  invalid_argument if length is 0 or above CONFIG_WIFICLIENT_TXBATCH_PAYLOAD
+     * @throws  runtime_error if not initialized
+     */
+    bool send(ip4_addr_t address, uint16_t port, const void* data, size_t length, uint32_t maxDelayMs);
+
+    /*!
+     * @brief   Sends all pooled messages now
+     */
+    void flush();
+
+    /*!
+     * @brief   Returns the batching statistics
+     *
+     * @return  Stats copy of the statistics
+     */
+    Stats getStats() const;
+
+/** ******************/
+/** PRIVATE METHODS **/
+/** ******************/
+private:
+    /*!
+     * @brief   Returns when the next batch is due
+     *
+     *          mutex has to be taken.
+     *
+     * @return  int64_t esp_timer time, INT64_MAX if nothing is due
+     */
+    int64_t dueTime() const;
+};
+
+#endif /* WifiTxBatch_H_ */
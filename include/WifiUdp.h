@@ -0,0 +1,306 @@
+/*!
+ * @file 	    WifiUdp.h
+ * @brief 	    Singleton zero-copy UDP endpoints on the station netif
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ */
+
+#ifndef WifiUdp_H_
+#define WifiUdp_H_
+
+#include <stdexcept>
+#include <string>
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+#include "lwip/udp.h"
+#include "lwip/tcpip.h"
+
+#include "WifiTraffic.h"
+
+/*!
+ * @class   WifiUdp
+ * @brief   Singleton Class for UDP without copies between application and lwIP
+ *
+ *          The BSD socket path copies every datagram from the application
+ *          buffer into a pbuf. Here producers take a pbuf from a
+ *          pre-allocated pool, write the payload in place and hand the
+ *          pbuf to the lwIP raw API bound to the WifiClient netif. The
+ *          buffer returns to the pool once lwIP and the driver released
+ *          it. Received datagrams are handed to a callback as the pbuf
+ *          lwIP received, the callback may keep it and release it later.
+ */
+class WifiUdp {
+
+/** ******************/
+/** PUBLIC TYPEDEFS **/
+/** ******************/
+public:
+    /*!
+     * @brief   Maximum number of open endpoints
+     */
+    static const size_t MAX_ENDPOINTS = 4;
+
+    /*!
+     * @brief   Receive callback, runs in the lwIP thread
+     *
+     *          The callback must not block. It returns true to keep the
+     *          datagram, kept datagrams are returned with release().
+     *
+     * @param   context passed to open()
+     * @param   datagram payload, can be a chain (check len and tot_len)
+     * @param   address source address
+     * @param   port source port
+     * @return  true if the datagram is kept
+     */
+    typedef bool (*ReceiveCallback)(void* context, struct pbuf* datagram, const ip_addr_t* address, uint16_t port);
+
+    /*!
+     * @brief   Struct which containes the Configuration values
+     */
+    struct Config{
+        uint8_t txBuffers = CONFIG_WIFICLIENT_UDP_TX_BUFFERS;   /*!< @brief usable transmit buffers, at most CONFIG_WIFICLIENT_UDP_TX_BUFFERS*/
+        uint8_t maxHeldRx = 4;  /*!< @brief received datagrams the application may keep at once, further ones are dropped*/
+    };
+
+    /*!
+     * @brief   Struct which containes the UDP statistics
+     */
+    struct Stats{
+        uint32_t sent = 0;          /*!< @brief datagrams handed to lwIP*/
+        uint32_t sendErrors = 0;    /*!< @brief datagrams lwIP did not accept*/
+        uint32_t poolExhausted = 0; /*!< @brief acquire() calls without free buffer*/
+        uint32_t received = 0;      /*!< @brief datagrams handed to a callback*/
+        uint32_t receiveDropped = 0;    /*!< @brief datagrams dropped, maxHeldRx reached*/
+        uint8_t txInUse = 0;        /*!< @brief transmit buffers in use*/
+        uint8_t rxHeld = 0;         /*!< @brief received datagrams kept by the application*/
+    };
+
+/** *******************/
+/** PRIVATE TYPEDEFS **/
+/** *******************/
+private:
+    /*!
+     * @brief   Room for the headers lwIP prepends in place
+     */
+    static const size_t HEADROOM = PBUF_LINK_ENCAPSULATION_HLEN + PBUF_LINK_HLEN + PBUF_IP_HLEN + PBUF_TRANSPORT_HLEN;
+
+    /*!
+     * @brief   Struct which containes one transmit buffer
+     *
+     *          storage has to follow the pbuf, lwIP only prepends headers
+     *          behind the pbuf struct.
+     */
+    struct TxBuffer{
+        struct pbuf_custom custom;  /*!< @brief pbuf handed to lwIP*/
+        bool used;                  /*!< @brief taken from the pool*/
+        int endpoint;               /*!< @brief sending endpoint, its pcb is looked up in the lwIP thread*/
+        ip_addr_t address;          /*!< @brief destination address*/
+        uint16_t port;              /*!< @brief destination port*/
+        WifiTraffic::TrafficClass trafficClass; /*!< @brief class of the sending endpoint*/
+        uint8_t tos;                /*!< @brief IP TOS of the class*/
+        uint8_t storage[MEM_ALIGNMENT + HEADROOM + CONFIG_WIFICLIENT_UDP_PAYLOAD];  /*!< @brief headers and payload*/
+    };
+
+    /*!
+     * @brief   Struct which containes an open endpoint
+     */
+    struct Endpoint{
+        bool used = false;              /*!< @brief slot is taken*/
+        struct udp_pcb* pcb = nullptr;  /*!< @brief lwIP pcb, nullptr until bound*/
+        ReceiveCallback callback = nullptr; /*!< @brief receive callback*/
+        void* context = nullptr;    /*!< @brief passed to callback*/
+        WifiTraffic::TrafficClass trafficClass = WifiTraffic::TrafficClass::BEST_EFFORT; /*!< @brief class of sent datagrams*/
+    };
+
+    /*!
+     * @brief   Struct which containes the arguments of a call into the lwIP thread
+     */
+    struct Call{
+        struct tcpip_api_call_data base;    /*!< @brief lwIP call header*/
+        Endpoint* endpoint;     /*!< @brief endpoint to open or close*/
+        uint16_t port;          /*!< @brief local port*/
+    };
+
+/** ****************************/
+/** PRIVATE STATIC ATTRIBUTES **/
+/** ****************************/
+private:
+    static WifiUdp Singleton; /*!< @brief Singleton Instance */
+    static TxBuffer txPool[CONFIG_WIFICLIENT_UDP_TX_BUFFERS]; /*!< @brief pre-allocated transmit buffers*/
+
+/** ************************/
+/** PUBLIC STATIC METHODS **/
+/** ************************/
+public:
+    /*!
+     * @brief   Get the Singleton Instance
+     *
+     * @return  WifiUdp& Singleton Instance
+     */
+    static WifiUdp& getInstance();
+
+/** *************************/
+/** PRIVATE STATIC METHODS **/
+/** *************************/
+private:
+    /*!
+     * @brief   Creates and binds the pcb, runs in the lwIP thread
+     *
+     * @param   call Call with endpoint and port
+     * @return  err_t lwIP result
+     */
+    static err_t openInCore(struct tcpip_api_call_data* call);
+
+    /*!
+     * @brief   Removes the pcb, runs in the lwIP thread
+     *
+     * @param   call Call with endpoint
+     * @return  err_t ERR_ARG if a concurrent close() removed it already
+     */
+    static err_t closeInCore(struct tcpip_api_call_data* call);
+
+    /*!
+     * @brief   Sends a transmit buffer, runs in the lwIP thread
+     *
+     * @param   arg TxBuffer
+     */
+    static void sendInCore(void* arg);
+
+    /*!
+     * @brief   lwIP receive callback, hands the pbuf to the endpoint callback
+     */
+    static void receive(void* arg, struct udp_pcb* pcb, struct pbuf* p, const ip_addr_t* address, uint16_t port);
+
+    /*!
+     * @brief   Custom free function, returns a transmit buffer to the pool
+     *
+     * @param   p pbuf of the buffer
+     */
+    static void freeTxBuffer(struct pbuf* p);
+
+    /*!
+     * @brief   Returns the transmit buffer of a pbuf
+     *
+     *          Received pbufs of the driver are custom pbufs as well, only
+     *          the free function tells a pool buffer apart.
+     *
+     * @param   p pbuf
+     * @return  TxBuffer* buffer, nullptr if p was not taken from the pool
+     */
+    static TxBuffer* txBufferOf(struct pbuf* p);
+
+/** **************/
+/** CONSTRUCTOR **/
+/** **************/
+private:
+    /*!
+     * @brief   Construct a new Wifi Udp object
+     */
+    WifiUdp();
+
+/** *************/
+/** ATTRIBUTES **/
+/** *************/
+private:
+    bool initalized; /*!< @brief init was called*/
+    Config config; /*!< @brief active configuration*/
+    Endpoint endpoints[MAX_ENDPOINTS]; /*!< @brief open endpoints*/
+    Stats stats; /*!< @brief UDP statistics*/
+    portMUX_TYPE lock; /*!< @brief Spinlock for pool, endpoints and statistics*/
+
+/** *****************/
+/** PUBLIC METHODS **/
+/** *****************/
+public:
+    /*!
+     * @brief   Applies the pool sizes
+     *
+     *          WifiClient has to be initialized first.
+     *
+     * @param   config Config object
+     * @throws  invalid_argument if txBuffers is 0 or above CONFIG_WIFICLIENT_UDP_TX_BUFFERS
+     * @throws  runtime_error if WifiClient is not initialized
+     */
+    void init(Config const& config);
+
+    /*!
+     * @brief   Opens an endpoint bound to a local port on the station netif
+     *
+     * @param   port local port, 0 picks a free one
+     * @param   callback receive callback, nullptr drops received datagrams
+     * @param   context passed to callback
+     * @return  int endpoint for send() and close()
+     * @throws  runtime_error if not initialized, no endpoint is left or lwIP failed
+     */
+    int open(uint16_t port, ReceiveCallback callback = nullptr, void* context = nullptr);
+
+    /*!
+     * @brief   Closes an endpoint
+     *
+     * @param   endpoint returned by open()
+     * @throws  invalid_argument if the endpoint is not open or closed concurrently
+     */
+    void close(int endpoint);
+
+    /*!
+     * @brief   Sets the traffic class of the datagrams an endpoint sends
+     *
+     *          Sends are tagged with the DSCP of the class and counted in
+     *          the WifiTraffic statistics, the default is BEST_EFFORT.
+     *
+     * @param   endpoint returned by open()
+     * @param   trafficClass class
+     * @throws  invalid_argument if the endpoint is not open
+     */
+    void setTrafficClass(int endpoint, WifiTraffic::TrafficClass trafficClass);
+
+    /*!
+     * @brief   Takes a transmit buffer from the pool, does not block
+     *
+     *          Write the payload to datagram->payload, then pass the
+     *          buffer to send() or release().
+     *
+     * @param   length payload length
+     * @return  struct pbuf* buffer with length bytes payload, nullptr if the pool is exhausted
+     * @throws  invalid_argument if length is 0 or above CONFIG_WIFICLIENT_UDP_PAYLOAD
+     */
+    struct pbuf* acquire(uint16_t length);
+
+    /*!
+     * @brief   Hands an acquired buffer to lwIP, does not block
+     *
+     *          The buffer is owned by lwIP afterwards, also on errors.
+     *          A pbuf which was not returned by acquire() is rejected
+     *          and stays with the caller.
+     *
+     * @param   endpoint returned by open()
+     * @param   datagram buffer returned by acquire()
+     * @param   address destination address
+     * @param   port destination port
+     * @return  false if the lwIP thread could not take the datagram
+     * @throws  invalid_argument if the endpoint is not open or datagram is not a pool buffer
+     */
+    bool send(int endpoint, struct pbuf* datagram, ip4_addr_t address, uint16_t port);
+
+    /*!
+     * @brief   Returns a kept received datagram or an unsent transmit buffer
+     *
+     * @param   datagram pbuf to release
+     */
+    void release(struct pbuf* datagram);
+
+    /*!
+     * @brief   Returns the UDP statistics
+     *
+     * @return  Stats copy of the statistics
+     */
+    Stats getStats() const;
+};
+
+#endif /* WifiUdp_H_ */
@@ -0,0 +1,220 @@
+/*!
+ * @file 	    test_iram_latency.cpp
+ * @brief 	    On-target tests of isConnected() and the event latency around flash writes
+ * @author 	    Tom Christ
+ * @date 	    2026-10-18
+ * @copyright   Copyright (c) 2024 Tom Christ; MIT License
+ * @version	    0.1		Initial Version
+ *
+ *              Needs the partition "flash_test" of the unit-test-app, the
+ *              IRAM test needs CONFIG_WIFICLIENT_IRAM_SAFE and
+ *              CONFIG_GPTIMER_ISR_IRAM_SAFE.
+ */
+
+#include <cstring>
+
+#include "unity.h"
+#include "WifiClient.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "esp_partition.h"
+#include "nvs_flash.h"
+#include "driver/gptimer.h"
+#include "esp_private/cache_utils.h"
+
+#define SECTOR_SIZE 4096
+#define IDLE_LATENCY_US 2000
+//slack on top of the erase for the event loop and the receiver task
+#define ERASE_SLACK_US 5000
+#define ISR_PERIOD_US 50
+
+struct IsrProbe{
+    volatile uint32_t calls;            //callbacks
+    volatile uint32_t cacheDisabled;    //callbacks while the flash cache was off
+    volatile bool connected;            //last result of isConnected()
+};
+
+static IsrProbe probe;
+static QueueHandle_t triggerQueue = NULL;
+static QueueHandle_t eventQueue = NULL;
+
+static void setUpClient()
+{
+    static bool initialized = false;
+    if (initialized) {
+        return;
+    }
+    esp_err_t result = nvs_flash_init();
+    if (result == ESP_ERR_NVS_NO_FREE_PAGES || result == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        TEST_ESP_OK(nvs_flash_erase());
+        result = nvs_flash_init();
+    }
+    TEST_ESP_OK(result);
+
+    WifiClient::Config config;
+    config.ssid = "unit-test";
+    config.storage = WifiClient::Storage::RAM;
+    WifiClient& client = WifiClient::getInstance();
+    client.registerEventReceiver(eventQueue, 4, WifiClient::eventBit(WifiClient::Event::CONNECTED));
+    client.init(config);
+    //no access point, attempts fail but the handlers are registered
+    client.connect();
+    initialized = true;
+}
+
+static const esp_partition_t* testPartition()
+{
+    const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "flash_test");
+    TEST_ASSERT_NOT_NULL_MESSAGE(partition, "unit-test-app partition flash_test missing");
+    return partition;
+}
+
+static bool IRAM_ATTR probeIsr(gptimer_handle_t timer, const gptimer_alarm_event_data_t* data, void* arg)
+{
+    probe.calls++;
+    probe.connected = WifiClient::getInstance().isConnected();
+    if (!spi_flash_cache_enabled()) {
+        probe.cacheDisabled++;
+    }
+    return false;
+}
+
+static bool IRAM_ATTR triggerIsr(gptimer_handle_t timer, const gptimer_alarm_event_data_t* data, void* arg)
+{
+    BaseType_t woken = pdFALSE;
+    int64_t now = esp_timer_get_time();
+    xQueueSendFromISR(triggerQueue, &now, &woken);
+    return woken == pdTRUE;
+}
+
+//posts the got ip event for every trigger of the ISR, like the netif would
+static void relayTask(void* arg)
+{
+    int64_t trigger;
+    while (true) {
+        if (xQueueReceive(triggerQueue, &trigger, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        ip_event_got_ip_t gotIp;
+        memset(&gotIp, 0, sizeof(gotIp));
+        gotIp.esp_netif = WifiClient::getInstance().getNetif();
+        esp_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &gotIp, sizeof(gotIp), portMAX_DELAY);
+    }
+}
+
+static gptimer_handle_t createTimer(gptimer_alarm_cb_t callback, uint64_t alarmUs, bool reload)
+{
+    gptimer_handle_t timer = NULL;
+    gptimer_config_t timerConfig;
+    memset(&timerConfig, 0, sizeof(timerConfig));
+    timerConfig.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+    timerConfig.direction = GPTIMER_COUNT_UP;
+    timerConfig.resolution_hz = 1000000;
+    TEST_ESP_OK(gptimer_new_timer(&timerConfig, &timer));
+
+    gptimer_event_callbacks_t callbacks;
+    memset(&callbacks, 0, sizeof(callbacks));
+    callbacks.on_alarm = callback;
+    TEST_ESP_OK(gptimer_register_event_callbacks(timer, &callbacks, NULL));
+
+    gptimer_alarm_config_t alarm;
+    memset(&alarm, 0, sizeof(alarm));
+    alarm.alarm_count = alarmUs;
+    alarm.reload_count = 0;
+    alarm.flags.auto_reload_on_alarm = reload;
+    TEST_ESP_OK(gptimer_set_alarm_action(timer, &alarm));
+    TEST_ESP_OK(gptimer_enable(timer));
+    return timer;
+}
+
+static void deleteTimer(gptimer_handle_t timer)
+{
+    gptimer_stop(timer);
+    TEST_ESP_OK(gptimer_disable(timer));
+    TEST_ESP_OK(gptimer_del_timer(timer));
+}
+
+//fires a disconnect so the next got ip fires CONNECTED again
+static void resetLink()
+{
+    wifi_event_sta_disconnected_t disconnected;
+    memset(&disconnected, 0, sizeof(disconnected));
+    disconnected.reason = WIFI_REASON_BEACON_TIMEOUT;
+    TEST_ESP_OK(esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &disconnected, sizeof(disconnected), portMAX_DELAY));
+    vTaskDelay(pdMS_TO_TICKS(20));
+    xQueueReset(eventQueue);
+}
+
+//time from the ISR trigger to the CONNECTED event in the receiver queue
+static int64_t measureConnected(const esp_partition_t* erase)
+{
+    resetLink();
+    gptimer_handle_t timer = createTimer(&triggerIsr, 1000, false);
+    TEST_ESP_OK(gptimer_start(timer));
+    if (erase != NULL) {
+        //the alarm fires during the erase
+        TEST_ESP_OK(esp_partition_erase_range(erase, 0, SECTOR_SIZE));
+    }
+    WifiClient::Event event;
+    TEST_ASSERT_EQUAL(pdTRUE, xQueueReceive(eventQueue, &event, pdMS_TO_TICKS(1000)));
+    int64_t received = esp_timer_get_time();
+    deleteTimer(timer);
+    TEST_ASSERT_EQUAL((int)WifiClient::Event::CONNECTED, (int)event);
+    return received;
+}
+
+TEST_CASE("isConnected runs from an IRAM ISR while the flash cache is disabled", "[wificlient][iram]")
+{
+#if !CONFIG_WIFICLIENT_IRAM_SAFE || !CONFIG_GPTIMER_ISR_IRAM_SAFE
+    TEST_IGNORE_MESSAGE("needs CONFIG_WIFICLIENT_IRAM_SAFE and CONFIG_GPTIMER_ISR_IRAM_SAFE");
+#else
+    setUpClient();
+    const esp_partition_t* partition = testPartition();
+    memset((void*)&probe, 0, sizeof(probe));
+
+    gptimer_handle_t timer = createTimer(&probeIsr, ISR_PERIOD_US, true);
+    TEST_ESP_OK(gptimer_start(timer));
+    TEST_ESP_OK(esp_partition_erase_range(partition, 0, SECTOR_SIZE * 4));
+    deleteTimer(timer);
+
+    printf("isConnected ISR calls: %lu, with cache disabled: %lu\n",
+        (unsigned long)probe.calls, (unsigned long)probe.cacheDisabled);
+    TEST_ASSERT_TRUE(probe.cacheDisabled > 0);
+    TEST_ASSERT_EQUAL(WifiClient::getInstance().isConnected(), probe.connected);
+#endif
+}
+
+TEST_CASE("event latency idle and during a flash erase", "[wificlient][latency]")
+{
+    setUpClient();
+    const esp_partition_t* partition = testPartition();
+    triggerQueue = xQueueCreate(2, sizeof(int64_t));
+    TEST_ASSERT_NOT_NULL(triggerQueue);
+    TaskHandle_t relay = NULL;
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(&relayTask, "relay", 3072, NULL, configMAX_PRIORITIES - 2, &relay));
+
+    //the trigger ISR fires 1 ms after the timer start
+    int64_t start = esp_timer_get_time();
+    int64_t idleUs = measureConnected(NULL) - start - 1000;
+
+    int64_t eraseStart = esp_timer_get_time();
+    TEST_ESP_OK(esp_partition_erase_range(partition, 0, SECTOR_SIZE));
+    int64_t eraseUs = esp_timer_get_time() - eraseStart;
+
+    start = esp_timer_get_time();
+    int64_t flashUs = measureConnected(partition) - start - 1000;
+
+    vTaskDelete(relay);
+    vQueueDelete(triggerQueue);
+    triggerQueue = NULL;
+
+    printf("event latency idle: %lld us, during erase: %lld us (erase %lld us)\n", idleUs, flashUs, eraseUs);
+    TEST_ASSERT_TRUE(idleUs < IDLE_LATENCY_US);
+    //delivery runs from flash and waits for the erase, but not longer
+    TEST_ASSERT_TRUE(flashUs < eraseUs + ERASE_SLACK_US);
+}
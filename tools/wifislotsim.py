@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""Simulates the association load of a fleet waking at the same time.
+
+usage: wifislotsim.py [nodes] [window_ms] [slot_count]
+
+Every node wakes within a small boot jitter and associates for a few
+hundred ms. Without slotting all attempts hit the AP at once, with
+slotting each node waits for its slot, derived from the MAC address
+like WifiClient does (FNV-1a % slot_count).
+"""
+
+import random
+import sys
+
+BOOT_JITTER_MS = 50
+ASSOCIATION_MS = 400
+BUCKET_MS = 100
+
+
+def mac_slot(mac, count):
+    value = 2166136261
+    for byte in mac:
+        value = ((value ^ byte) * 16777619) & 0xFFFFFFFF
+    return value % count
+
+
+def fleet(nodes, rng):
+    # one production lot, consecutive addresses
+    base = rng.randrange(0, 1 << 24)
+    return [bytes([0x24, 0x0A, 0xC4]) + ((base + i * 4) & 0xFFFFFF).to_bytes(3, "big") for i in range(nodes)]
+
+
+def peak_load(starts):
+    events = []
+    for start in starts:
+        events.append((start, 1))
+        events.append((start + ASSOCIATION_MS, -1))
+    concurrent = peak = 0
+    for _, step in sorted(events):
+        concurrent += step
+        peak = max(peak, concurrent)
+    buckets = {}
+    for start in starts:
+        buckets[start // BUCKET_MS] = buckets.get(start // BUCKET_MS, 0) + 1
+    return peak, max(buckets.values()), max(starts) + ASSOCIATION_MS
+
+
+def main():
+    nodes = int(sys.argv[1]) if len(sys.argv) > 1 else 300
+    window_ms = int(sys.argv[2]) if len(sys.argv) > 2 else 10000
+    slot_count = int(sys.argv[3]) if len(sys.argv) > 3 else 32
+
+    rng = random.Random(1)
+    macs = fleet(nodes, rng)
+    wakes = [rng.randrange(0, BOOT_JITTER_MS) for _ in macs]
+    slotted = [wake + mac_slot(mac, slot_count) * window_ms // slot_count for mac, wake in zip(macs, wakes)]
+
+    print("%d nodes, window %d ms, %d slots" % (nodes, window_ms, slot_count))
+    print("%-12s %16s %20s %14s" % ("", "peak concurrent", "peak per %d ms" % BUCKET_MS, "all done ms"))
+    for name, starts in (("unslotted", wakes), ("slotted", slotted)):
+        peak, bucket, done = peak_load(starts)
+        print("%-12s %16d %20d %14d" % (name, peak, bucket, done))
+
+
+if __name__ == "__main__":
+    main()
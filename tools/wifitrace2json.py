@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""Converts a WifiTrace::dump binary into Chrome trace event JSON.
+
+usage: wifitrace2json.py dump.bin [trace.json]
+
+The JSON opens in chrome://tracing and https://ui.perfetto.dev.
+"""
+
+import json
+import struct
+import sys
+
+DUMP_MAGIC = 0x43525457
+HEADER = struct.Struct("<IHHII")
+SPAN = struct.Struct("<qIIIHBB24s")
+OPEN = 0xFFFFFFFF
+TRACKS = {1: "connection", 2: "handler", 3: "delivery"}
+
+
+def convert(data):
+    magic, version, span_size, count, dropped = HEADER.unpack_from(data, 0)
+    if magic != DUMP_MAGIC or version != 1:
+        raise ValueError("not a WifiTrace dump")
+    if span_size != SPAN.size:
+        raise ValueError("span size %d, expected %d" % (span_size, SPAN.size))
+
+    events = [{"ph": "M", "pid": 1, "name": "process_name", "args": {"name": "WifiClient"}}]
+    for tid, name in TRACKS.items():
+        events.append({"ph": "M", "pid": 1, "tid": tid, "name": "thread_name", "args": {"name": name}})
+
+    for i in range(count):
+        start, duration, span_id, arg, track, instant, _, name = SPAN.unpack_from(data, HEADER.size + i * SPAN.size)
+        if span_id == 0:
+            # overwritten while dumping
+            continue
+        event = {"pid": 1, "tid": track, "name": name.split(b"\0", 1)[0].decode(errors="replace"),
+                 "ts": start, "args": {"arg": arg}}
+        if instant:
+            event.update(ph="i", s="t")
+        elif duration == OPEN:
+            event["ph"] = "B"
+        else:
+            event.update(ph="X", dur=duration)
+        events.append(event)
+
+    return {"displayTimeUnit": "ms", "traceEvents": events, "otherData": {"dropped": dropped}}
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.exit(__doc__)
+    with open(sys.argv[1], "rb") as source:
+        trace = convert(source.read())
+    output = open(sys.argv[2], "w") if len(sys.argv) == 3 else sys.stdout
+    json.dump(trace, output)
+    output.write("\n")
+
+
+if __name__ == "__main__":
+    main()